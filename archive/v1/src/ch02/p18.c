@@ -1,16 +1,19 @@
+// gcc -std=c23 -O2 -I../ch10 p18.c ../ch10/fastout.c -o p18 -lm
 #include <stdio.h>
 #include <string.h>
+#include "fastout.h"
 
 int main(void) {
     char name[50];
-    printf("Enter your name: ");
-    scanf("%49s", name);
+    static FastOut out;
+    fo_init(&out, 1);
+    fo_str(&out, "Enter your name: ", 0);
+    fo_flush(&out);
+    if (scanf("%49s", name) != 1) return 1;
 
     size_t w = strlen(name) + 4; // "* " + name + " *"
-    for (size_t i = 0; i < w; ++i) putchar('*');
-    putchar('\n');
-    printf("* %s *\n", name);
-    for (size_t i = 0; i < w; ++i) putchar('*');
-    putchar('\n');
-    return 0;
+    fo_fill(&out, '*', w); fo_char(&out, '\n');
+    fo_write(&out, "* ", 2); fo_str(&out, name, 0); fo_write(&out, " *\n", 3);
+    fo_fill(&out, '*', w); fo_char(&out, '\n');
+    return fo_flush(&out) ? 0 : 1;
 }
@@ -1,10 +1,16 @@
+// gcc -std=c23 -O2 -I../ch10 p10.c ../ch10/fastout.c -o p10 -lm
 #include <stdio.h>
+#include "fastout.h"
 
 int main(void) {
     int n;
-    scanf("%d", &n);
+    if (scanf("%d", &n) != 1) return 1;
+    static FastOut out;
+    fo_init(&out, 1);
     for (int i = 1; i <= 10; i++) {
-        printf("%d x %d = %d\n", n, i, n * i);
+        fo_i64(&out, n, 0); fo_write(&out, " x ", 3);
+        fo_i64(&out, i, 0); fo_write(&out, " = ", 3);
+        fo_i64(&out, (long long)n * i, 0); fo_char(&out, '\n');
     }
-    return 0;
+    return fo_flush(&out) ? 0 : 1;
 }
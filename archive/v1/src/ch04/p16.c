@@ -1,13 +1,15 @@
+// gcc -std=c23 -O2 -I../ch10 p16.c ../ch10/fastout.c -o p16 -lm
 #include <stdio.h>
+#include "fastout.h"
 
 int main(void) {
     int n;
-    scanf("%d", &n);
+    if (scanf("%d", &n) != 1) return 1;
+    static FastOut out;
+    fo_init(&out, 1);
     for (int r = 1; r <= n; r++) {
-        for (int c = 1; c <= r; c++) {
-            putchar('*');
-        }
-        putchar('\n');
+        fo_fill(&out, '*', (size_t)r);
+        fo_char(&out, '\n');
     }
-    return 0;
+    return fo_flush(&out) ? 0 : 1;
 }
@@ -1,11 +1,15 @@
+// gcc -std=c23 -O2 -I../ch10 p17.c ../ch10/fastout.c -o p17 -lm
 #include <stdio.h>
+#include "fastout.h"
 
 int main(void) {
     int rows, cols;
-    scanf("%d %d", &rows, &cols);
+    if (scanf("%d %d", &rows, &cols) != 2) return 1;
+    static FastOut out;
+    fo_init(&out, 1);
     for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < cols; c++) putchar('*');
-        putchar('\n');
+        if (cols > 0) fo_fill(&out, '*', (size_t)cols);
+        fo_char(&out, '\n');
     }
-    return 0;
+    return fo_flush(&out) ? 0 : 1;
 }
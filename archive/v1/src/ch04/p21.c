@@ -0,0 +1,55 @@
+// p20's trial division next to the primes.c queries, on larger inputs.
+// gcc -std=c23 -O2 -pthread p21.c primes.c -o p21 -lm
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "primes.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static bool trial(unsigned long long n) {
+    if (n < 2) return false;
+    for (unsigned long long i = 2; i * i <= n; i++)
+        if (n % i == 0) return false;
+    return true;
+}
+
+int main(void) {
+    unsigned long long n;
+    if (scanf("%llu", &n) != 1) return 1;
+    printf("%llu: %s\n", n, is_prime_u64(n) ? "Prime" : "Not prime");
+
+    // Counting primes below 10^6 by trial division vs. the sieve.
+    unsigned long long lim = 1000000, c = 0;
+    double t0 = now_ms();
+    for (unsigned long long k = 0; k <= lim; k++) c += trial(k);
+    double t1 = now_ms();
+    unsigned long long s = prime_count(0, lim);
+    double t2 = now_ms();
+    printf("pi(%llu): trial %llu in %.1f ms, sieve %llu in %.1f ms\n", lim, c, t1 - t0, s, t2 - t1);
+
+    t0 = now_ms();
+    s = prime_count(0, 1000000000);
+    printf("pi(10^9) = %llu in %.1f ms\n", s, now_ms() - t0);
+
+    // Random 64-bit values: too spread out to sieve, so Miller-Rabin each.
+    enum { M = 1 << 20 };
+    unsigned long long *v = malloc(M * sizeof *v);
+    bool *out = malloc(M * sizeof *out);
+    if (!v || !out) { puts("out of memory"); return 1; }
+    srand(7);
+    for (int i = 0; i < M; i++)
+        v[i] = (unsigned long long)rand() << 33 ^ (unsigned long long)rand() << 11 ^ (unsigned long long)rand();
+    t0 = now_ms();
+    is_prime_n(v, out, M);
+    c = 0;
+    for (int i = 0; i < M; i++) c += out[i];
+    printf("%d random 64-bit values: %llu prime in %.1f ms\n", M, c, now_ms() - t0);
+
+    free(v); free(out);
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "primes.h"
+
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+#define SEG_BITS  (32 * 1024 * 8)  // one 32 KB segment of odd numbers fits in L1
+#define ROOT_MAX  (1u << 26)       // largest sqrt(hi) we build base primes for
+#define MAX_PARTS 64
+
+// ---- Miller-Rabin ---------------------------------------------------------
+
+// Montgomery arithmetic mod an odd n with R = 2^64: values are kept as
+// x*R mod n, so each product needs two multiplies instead of a division.
+typedef struct { u64 n, inv, one, r2; } Mont;
+
+static Mont mont_init(u64 n) {
+    Mont m = {.n = n};
+    u64 inv = n;                            // Newton: 5 steps reach 64 bits
+    for (int i = 0; i < 5; i++) inv *= 2 - n * inv;
+    m.inv = inv;
+    m.one = (0 - n) % n;                    // R mod n
+    m.r2 = (u64)((u128)m.one * m.one % n);  // R^2 mod n
+    return m;
+}
+
+// t*R^-1 mod n for t < n*R.
+static inline u64 redc(const Mont *m, u128 t) {
+    u64 k = (u64)t * m->inv;
+    u64 hi = (u64)(t >> 64), sub = (u64)(((u128)k * m->n) >> 64);
+    return hi >= sub ? hi - sub : hi - sub + m->n;
+}
+static inline u64 mont_mul(const Mont *m, u64 a, u64 b) { return redc(m, (u128)a * b); }
+static inline u64 to_mont(const Mont *m, u64 a) { return mont_mul(m, a % m->n, m->r2); }
+
+static bool mr_round(const Mont *m, u64 a, u64 d, int s) {
+    u64 n = m->n, minus_one = n - m->one;
+    if (a % n == 0) return true;
+    u64 x = m->one, b = to_mont(m, a);
+    for (u64 e = d; e; e >>= 1) {
+        if (e & 1) x = mont_mul(m, x, b);
+        b = mont_mul(m, b, b);
+    }
+    if (x == m->one || x == minus_one) return true;
+    for (int i = 1; i < s; i++) {
+        x = mont_mul(m, x, x);
+        if (x == minus_one) return true;
+    }
+    return false;
+}
+
+static const unsigned small_primes[] = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+
+bool is_prime_u64(u64 n) {
+    if (n < 2) return false;
+    if (n % 2 == 0) return n == 2;
+    for (size_t i = 0; i < sizeof small_primes / sizeof *small_primes; i++) {
+        unsigned p = small_primes[i];
+        if (n % p == 0) return n == p;
+    }
+    if (n < 59 * 59) return true;
+
+    u64 d = n - 1;
+    int s = 0;
+    while (d % 2 == 0) { d /= 2; s++; }
+    Mont m = mont_init(n);
+
+    // Smallest base sets known to be exact below each bound.
+    static const u64 b32[] = {2, 7, 61};
+    static const u64 b64[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    const u64 *bases = n < 4294967296ULL ? b32 : b64;
+    size_t nb = n < 4294967296ULL ? 3 : 7;
+    for (size_t i = 0; i < nb; i++)
+        if (!mr_round(&m, bases[i], d, s)) return false;
+    return true;
+}
+
+// ---- threads ----------------------------------------------------------------
+
+static int thread_setting = 0;
+
+void primes_set_threads(int n) { thread_setting = n; }
+
+static int thread_count(void) {
+    long t = thread_setting > 0 ? thread_setting : sysconf(_SC_NPROCESSORS_ONLN);
+    return t < 1 ? 1 : t > MAX_PARTS ? MAX_PARTS : (int)t;
+}
+
+typedef void (*part_fn)(void *ctx, size_t lo, size_t hi, int k);
+typedef struct { part_fn fn; void *ctx; size_t lo, hi; int k; } PartJob;
+
+static void *part_main(void *arg) {
+    PartJob *j = arg;
+    j->fn(j->ctx, j->lo, j->hi, j->k);
+    return NULL;
+}
+
+// Split [0, n) into `parts` runs whose boundaries are multiples of `align`.
+static void run_parts(size_t n, int parts, size_t align, part_fn fn, void *ctx) {
+    PartJob job[MAX_PARTS];
+    pthread_t tid[MAX_PARTS];
+    int started[MAX_PARTS] = {0};
+    size_t step = (n / (size_t)parts + align - 1) / align * align;
+    for (int k = 0; k < parts; k++) {
+        size_t lo = step * (size_t)k, hi = lo + step;
+        if (lo > n) lo = n;
+        if (hi > n || k == parts - 1) hi = n;
+        job[k] = (PartJob){fn, ctx, lo, hi, k};
+    }
+    for (int k = 1; k < parts; k++) {
+        started[k] = pthread_create(&tid[k], NULL, part_main, &job[k]) == 0;
+        if (!started[k]) part_main(&job[k]);
+    }
+    part_main(&job[0]);
+    for (int k = 1; k < parts; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+}
+
+// ---- segmented sieve ----------------------------------------------------------
+
+static u64 isqrt(u64 n) {
+    u64 r = (u64)sqrtl((long double)n);
+    while (r * r > n) r--;
+    while ((r + 1) * (r + 1) <= n) r++;
+    return r;
+}
+
+// Odd primes up to limit (limit < 2^32), by a plain sieve of odd numbers.
+static unsigned *base_primes(u64 limit, size_t *count) {
+    size_t half = (size_t)(limit / 2) + 1;  // index i stands for 2i+1
+    unsigned char *comp = calloc(half, 1);
+    unsigned *ps = malloc((half / 2 + 16) * sizeof *ps);
+    if (!comp || !ps) { free(comp); free(ps); *count = 0; return NULL; }
+    size_t n = 0;
+    for (size_t i = 1; i < half; i++) {
+        if (comp[i]) continue;
+        u64 p = 2 * i + 1;
+        if (p > limit) break;
+        ps[n++] = (unsigned)p;
+        for (u64 j = p * p / 2; j < half; j += p) comp[j] = 1;
+    }
+    free(comp);
+    *count = n;
+    return ps;
+}
+
+// Bit j of w stands for lo + 2j (lo odd); set bits are primes. Handles at
+// most SEG_BITS bits so the whole segment stays in L1 while it is sieved.
+static void sieve_segment(u64 lo, size_t nbits, const unsigned *bp, size_t nbp, u64 *w) {
+    size_t nw = (nbits + 63) / 64;
+    memset(w, 0xff, nw * sizeof *w);
+    if (nbits % 64) w[nw - 1] = (1ULL << (nbits % 64)) - 1;
+    if (lo == 1) w[0] &= ~1ULL;                  // 1 is not prime
+    u64 hi = lo + 2 * (u64)(nbits - 1);
+    for (size_t i = 0; i < nbp; i++) {
+        u64 p = bp[i];
+        if (p * p > hi) break;
+        u64 start = p * p;                       // smaller multiples have a smaller factor
+        if (start < lo) {
+            start = (lo + p - 1) / p * p;
+            if (start % 2 == 0) start += p;      // odd multiples only
+        }
+        for (u64 j = (start - lo) / 2; j < nbits; j += p) w[j / 64] &= ~(1ULL << (j % 64));
+    }
+}
+
+static u64 popcount_words(const u64 *w, size_t nw) {
+    u64 c = 0;
+    for (size_t i = 0; i < nw; i++) c += (u64)__builtin_popcountll(w[i]);
+    return c;
+}
+
+typedef struct {
+    u64 lo;                  // first odd number covered
+    const unsigned *bp; size_t nbp;
+    u64 *bits;               // whole-range bitmap, or NULL to count only
+    u64 count[MAX_PARTS];
+} SieveJob;
+
+static void sieve_part(void *ctx, size_t a, size_t b, int k) {
+    SieveJob *s = ctx;
+    u64 scratch[SEG_BITS / 64];
+    u64 c = 0;
+    for (size_t j = a; j < b; j += SEG_BITS) {
+        size_t nb = b - j < SEG_BITS ? b - j : SEG_BITS;
+        u64 *w = s->bits ? s->bits + j / 64 : scratch;
+        sieve_segment(s->lo + 2 * (u64)j, nb, s->bp, s->nbp, w);
+        if (!s->bits) c += popcount_words(w, (nb + 63) / 64);
+    }
+    s->count[k] = c;
+}
+
+// Sieve the odd numbers lo, lo+2, ... (nbits of them, lo odd) on threads.
+// With bits == NULL counts the primes into *count; otherwise fills bits.
+// Returns false if the base primes could not be allocated.
+static bool sieve_range(u64 lo, size_t nbits, u64 *bits, u64 *count) {
+    u64 hi = lo + 2 * (u64)(nbits - 1);
+    SieveJob s = {.lo = lo, .bits = bits};
+    unsigned *bp = base_primes(isqrt(hi), &s.nbp);
+    if (!bp) return false;
+    s.bp = bp;
+    int parts = thread_count();
+    size_t segs = (nbits + SEG_BITS - 1) / SEG_BITS;
+    if ((size_t)parts > segs) parts = (int)segs;
+    run_parts(nbits, parts, SEG_BITS, sieve_part, &s);
+    free(bp);
+    *count = 0;
+    for (int k = 0; k < parts; k++) *count += s.count[k];
+    return true;
+}
+
+// Sieving pays off once the range is at least as wide as sqrt(hi), the
+// cost of building the base primes; below that, test each candidate.
+static bool want_sieve(u64 lo, u64 hi) {
+    u64 root = isqrt(hi);
+    return root <= ROOT_MAX && hi - lo >= root;
+}
+
+// ---- public entry points --------------------------------------------------------
+
+typedef struct { u64 lo; u64 count[MAX_PARTS]; } TestJob;
+
+static void test_part(void *ctx, size_t a, size_t b, int k) {
+    TestJob *t = ctx;
+    u64 c = 0;
+    for (size_t j = a; j < b; j++) c += is_prime_u64(t->lo + 2 * (u64)j);
+    t->count[k] = c;
+}
+
+u64 prime_count(u64 lo, u64 hi) {
+    if (hi < 2 || lo > hi) return 0;
+    u64 c = lo <= 2;                              // the only even prime
+    u64 first = lo <= 3 ? 3 : lo | 1;
+    if (first > hi) return c;
+    u64 nbits = (hi - first) / 2 + 1;
+
+    u64 sieved;
+    if (want_sieve(first, hi) && sieve_range(first, (size_t)nbits, NULL, &sieved)) return c + sieved;
+
+    TestJob t = {.lo = first};
+    int parts = nbits < 4096 ? 1 : thread_count();
+    run_parts((size_t)nbits, parts, 1, test_part, &t);
+    for (int k = 0; k < parts; k++) c += t.count[k];
+    return c;
+}
+
+typedef struct { const u64 *v; bool *out; } BatchJob;
+
+static void batch_part(void *ctx, size_t a, size_t b, int k) {
+    BatchJob *j = ctx;
+    (void)k;
+    for (size_t i = a; i < b; i++) j->out[i] = is_prime_u64(j->v[i]);
+}
+
+void is_prime_n(const u64 *v, bool *out, size_t n) {
+    if (n == 0) return;
+    u64 mn = v[0], mx = v[0];
+    for (size_t i = 1; i < n; i++) { if (v[i] < mn) mn = v[i]; if (v[i] > mx) mx = v[i]; }
+
+    // Dense input: one bitmap over [mn, mx], at most a byte per input value.
+    u64 first = mn <= 3 ? 3 : mn | 1, unused;
+    if (mx >= first && (mx - mn) / 16 <= n && want_sieve(first, mx)) {
+        size_t nbits = (size_t)((mx - first) / 2 + 1);
+        u64 *bits = malloc((nbits + 63) / 64 * sizeof *bits);
+        if (bits && sieve_range(first, nbits, bits, &unused)) {
+            for (size_t i = 0; i < n; i++) {
+                u64 x = v[i];
+                if (x < first || x % 2 == 0) out[i] = x == 2;
+                else { u64 j = (x - first) / 2; out[i] = bits[j / 64] >> (j % 64) & 1; }
+            }
+            free(bits);
+            return;
+        }
+        free(bits);
+    }
+
+    BatchJob j = {v, out};
+    run_parts(n, n < 4096 ? 1 : thread_count(), 1, batch_part, &j);
+}
@@ -0,0 +1,22 @@
+#ifndef PRIMES_H
+#define PRIMES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Deterministic for every 64-bit n: trial division by small primes, then
+// Miller-Rabin with Montgomery multiplication on a proven base set.
+bool is_prime_u64(unsigned long long n);
+
+// Number of primes p with lo <= p <= hi. Wide ranges use a segmented
+// odd-only sieve split across threads; narrow ones test each candidate.
+unsigned long long prime_count(unsigned long long lo, unsigned long long hi);
+
+// out[i] = is_prime_u64(v[i]). Values packed into a narrow range are
+// answered from one sieve of that range, others by Miller-Rabin.
+void is_prime_n(const unsigned long long *v, bool *out, size_t n);
+
+// 0 (the default) means one thread per online CPU; 1 never spawns threads.
+void primes_set_threads(int n);
+
+#endif
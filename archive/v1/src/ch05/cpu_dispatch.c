@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+
+// XCR0 tells us which register files the OS saves on a context switch.
+static unsigned long long xgetbv0(void) {
+    unsigned lo, hi;
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+static isa_level probe(void) {
+    unsigned a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(d & bit_SSE2)) return ISA_SCALAR;
+    if (!(c & bit_OSXSAVE) || !(c & bit_AVX)) return ISA_SSE2;
+
+    unsigned long long xcr0 = xgetbv0();
+    if ((xcr0 & 0x6) != 0x6) return ISA_SSE2;          // XMM + YMM state
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d) || !(b & bit_AVX2)) return ISA_SSE2;
+    if ((b & bit_AVX512F) && (xcr0 & 0xe6) == 0xe6)    // + opmask, ZMM state
+        return ISA_AVX512;
+    return ISA_AVX2;
+}
+#else
+static isa_level probe(void) { return ISA_SCALAR; }
+#endif
+
+static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+const char *isa_name(isa_level isa) { return names[isa]; }
+
+isa_level cpu_isa_detected(void) {
+    static int done = 0;
+    static isa_level level;
+    if (!done) { level = probe(); done = 1; }
+    return level;
+}
+
+isa_level cpu_isa(void) {
+    static int done = 0;
+    static isa_level level;
+    if (done) return level;
+
+    level = cpu_isa_detected();
+    const char *force = getenv("FORCE_ISA");
+    if (force && *force) {
+        int want = -1;
+        for (int i = 0; i < 4; i++)
+            if (strcmp(force, names[i]) == 0) want = i;
+        if (want < 0)
+            fprintf(stderr, "FORCE_ISA=%s not recognised, using %s\n", force, names[level]);
+        else if ((isa_level)want > level)
+            fprintf(stderr, "FORCE_ISA=%s not supported here, using %s\n", force, names[level]);
+        else
+            level = (isa_level)want;
+    }
+    done = 1;
+    return level;
+}
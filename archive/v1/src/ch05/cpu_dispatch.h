@@ -0,0 +1,17 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+// Instruction-set levels, ordered so a higher level implies the lower ones.
+typedef enum { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512 } isa_level;
+
+// Best level this CPU and OS support, from cpuid/xgetbv (probed once).
+isa_level cpu_isa_detected(void);
+
+// Level the batch kernels should use: the detected level, lowered by
+// FORCE_ISA=scalar|sse2|avx2|avx512 in the environment. A forced level
+// above what the CPU supports is clamped down with a warning on stderr.
+isa_level cpu_isa(void);
+
+const char *isa_name(isa_level isa);
+
+#endif
@@ -0,0 +1,359 @@
+#include <limits.h>
+#include "mathlib_batch.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// Scalar reference. Every vector kernel below must give these exact results.
+static inline int s_add(int a, int b) { return (int)((unsigned)a + (unsigned)b); }
+static inline int s_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }
+static inline int s_mul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }
+static inline int s_div(int a, int b) {
+    if (b == 0) return 0;
+    if (a == INT_MIN && b == -1) return INT_MIN;  // wraps like the hardware would
+    return a / b;
+}
+
+static inline int clamp_ll(long long v) {
+    return v > INT_MAX ? INT_MAX : v < INT_MIN ? INT_MIN : (int)v;
+}
+static inline int s_add_sat(int a, int b) { return clamp_ll((long long)a + b); }
+static inline int s_sub_sat(int a, int b) { return clamp_ll((long long)a - b); }
+static inline int s_mul_sat(int a, int b) { return clamp_ll((long long)a * b); }
+
+static inline int out_of_range(long long v) { return v > INT_MAX || v < INT_MIN; }
+static inline int s_add_ovf(int a, int b) { return out_of_range((long long)a + b); }
+static inline int s_sub_ovf(int a, int b) { return out_of_range((long long)a - b); }
+static inline int s_mul_ovf(int a, int b) { return out_of_range((long long)a * b); }
+static inline int s_div_ovf(int a, int b) { return b == 0 || (a == INT_MIN && b == -1); }
+
+#define DEFINE_SCALAR(op) \
+static void op##_scalar(const int *a, const int *b, int *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) out[i] = s_##op(a[i], b[i]); \
+}
+
+#define DEFINE_SCALAR_CHECKED(op) \
+static size_t op##_checked_scalar(const int *a, const int *b, int *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) { \
+        if (s_##op##_ovf(a[i], b[i])) return i; \
+        out[i] = s_##op(a[i], b[i]); \
+    } \
+    return n; \
+}
+
+DEFINE_SCALAR(add) DEFINE_SCALAR(sub) DEFINE_SCALAR(mul) DEFINE_SCALAR(div)
+DEFINE_SCALAR(add_sat) DEFINE_SCALAR(sub_sat) DEFINE_SCALAR(mul_sat)
+DEFINE_SCALAR_CHECKED(add) DEFINE_SCALAR_CHECKED(sub)
+DEFINE_SCALAR_CHECKED(mul) DEFINE_SCALAR_CHECKED(div)
+
+// Vector kernels share one loop shape: W lanes at a time, scalar tail.
+// Each ISA provides isa##_t, isa##_load/store, the ops and *_ovf tests.
+#define DEFINE_VECTOR(isa, W, op) \
+static void op##_##isa(const int *a, const int *b, int *out, size_t n) { \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) \
+        isa##_store(out + i, isa##_##op(isa##_load(a + i), isa##_load(b + i))); \
+    for (; i < n; i++) out[i] = s_##op(a[i], b[i]); \
+}
+
+// On a lane that overflows, hand over to the scalar loop to find the index.
+#define DEFINE_VECTOR_CHECKED(isa, W, op) \
+static size_t op##_checked_##isa(const int *a, const int *b, int *out, size_t n) { \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) { \
+        isa##_t va = isa##_load(a + i), vb = isa##_load(b + i); \
+        if (isa##_##op##_ovf(va, vb)) break; \
+        isa##_store(out + i, isa##_##op(va, vb)); \
+    } \
+    return i + op##_checked_scalar(a + i, b + i, out + i, n - i); \
+}
+
+#define DEFINE_VECTOR_ALL(isa, W) \
+    DEFINE_VECTOR(isa, W, add) DEFINE_VECTOR(isa, W, sub) \
+    DEFINE_VECTOR(isa, W, mul) DEFINE_VECTOR(isa, W, div) \
+    DEFINE_VECTOR(isa, W, add_sat) DEFINE_VECTOR(isa, W, sub_sat) \
+    DEFINE_VECTOR(isa, W, mul_sat) \
+    DEFINE_VECTOR_CHECKED(isa, W, add) DEFINE_VECTOR_CHECKED(isa, W, sub) \
+    DEFINE_VECTOR_CHECKED(isa, W, mul) DEFINE_VECTOR_CHECKED(isa, W, div)
+
+// Each ISA section is compiled for its own target, so the file itself can
+// be built for a generic baseline and still carry every variant.
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("sse2")
+typedef __m128i sse2_t;
+
+static inline sse2_t sse2_load(const int *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline void sse2_store(int *p, sse2_t v) { _mm_storeu_si128((__m128i *)p, v); }
+static inline sse2_t sse2_select(sse2_t m, sse2_t x, sse2_t y) {
+    return _mm_or_si128(_mm_and_si128(m, x), _mm_andnot_si128(m, y));
+}
+
+static inline sse2_t sse2_add(sse2_t a, sse2_t b) { return _mm_add_epi32(a, b); }
+static inline sse2_t sse2_sub(sse2_t a, sse2_t b) { return _mm_sub_epi32(a, b); }
+
+// SSE2 has no 32-bit mullo: multiply even and odd lanes to 64 bits, keep low halves.
+static inline sse2_t sse2_mul(sse2_t a, sse2_t b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0,0,2,0)));
+}
+
+// Doubles hold every int exactly, so a correctly rounded quotient truncates
+// to the exact C quotient, and a product clamps exactly before conversion.
+static inline __m128d sse2_lo_pd(sse2_t v) { return _mm_cvtepi32_pd(v); }
+static inline __m128d sse2_hi_pd(sse2_t v) { return _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,3,2))); }
+static inline sse2_t sse2_from_pd(__m128d lo, __m128d hi) {
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+static inline sse2_t sse2_div(sse2_t a, sse2_t b) {
+    sse2_t q = sse2_from_pd(_mm_div_pd(sse2_lo_pd(a), sse2_lo_pd(b)),
+                            _mm_div_pd(sse2_hi_pd(a), sse2_hi_pd(b)));
+    return _mm_andnot_si128(_mm_cmpeq_epi32(b, _mm_setzero_si128()), q);
+}
+
+// Sign bit of each lane is set where the wrapped result overflowed.
+static inline sse2_t sse2_add_mask(sse2_t a, sse2_t b) {
+    sse2_t s = _mm_add_epi32(a, b);
+    return _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, s), _mm_xor_si128(b, s)), 31);
+}
+static inline sse2_t sse2_sub_mask(sse2_t a, sse2_t b) {
+    sse2_t d = _mm_sub_epi32(a, b);
+    return _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, d)), 31);
+}
+// INT_MAX where a >= 0, INT_MIN where a < 0.
+static inline sse2_t sse2_bound(sse2_t a) {
+    return _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT_MAX));
+}
+
+static inline sse2_t sse2_add_sat(sse2_t a, sse2_t b) {
+    return sse2_select(sse2_add_mask(a, b), sse2_bound(a), _mm_add_epi32(a, b));
+}
+static inline sse2_t sse2_sub_sat(sse2_t a, sse2_t b) {
+    return sse2_select(sse2_sub_mask(a, b), sse2_bound(a), _mm_sub_epi32(a, b));
+}
+static inline __m128d sse2_clamp_pd(__m128d p) {
+    return _mm_min_pd(_mm_max_pd(p, _mm_set1_pd(INT_MIN)), _mm_set1_pd(INT_MAX));
+}
+static inline sse2_t sse2_mul_sat(sse2_t a, sse2_t b) {
+    return sse2_from_pd(sse2_clamp_pd(_mm_mul_pd(sse2_lo_pd(a), sse2_lo_pd(b))),
+                        sse2_clamp_pd(_mm_mul_pd(sse2_hi_pd(a), sse2_hi_pd(b))));
+}
+
+static inline int sse2_add_ovf(sse2_t a, sse2_t b) { return _mm_movemask_epi8(sse2_add_mask(a, b)); }
+static inline int sse2_sub_ovf(sse2_t a, sse2_t b) { return _mm_movemask_epi8(sse2_sub_mask(a, b)); }
+static inline int sse2_range_pd(__m128d p) {
+    return _mm_movemask_pd(_mm_or_pd(_mm_cmpgt_pd(p, _mm_set1_pd(INT_MAX)),
+                                     _mm_cmplt_pd(p, _mm_set1_pd(INT_MIN))));
+}
+static inline int sse2_mul_ovf(sse2_t a, sse2_t b) {
+    return sse2_range_pd(_mm_mul_pd(sse2_lo_pd(a), sse2_lo_pd(b))) |
+           sse2_range_pd(_mm_mul_pd(sse2_hi_pd(a), sse2_hi_pd(b)));
+}
+static inline int sse2_div_ovf(sse2_t a, sse2_t b) {
+    sse2_t zero = _mm_cmpeq_epi32(b, _mm_setzero_si128());
+    sse2_t wrap = _mm_and_si128(_mm_cmpeq_epi32(a, _mm_set1_epi32(INT_MIN)),
+                                _mm_cmpeq_epi32(b, _mm_set1_epi32(-1)));
+    return _mm_movemask_epi8(_mm_or_si128(zero, wrap));
+}
+
+DEFINE_VECTOR_ALL(sse2, 4)
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+typedef __m256i avx2_t;
+
+static inline avx2_t avx2_load(const int *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline void avx2_store(int *p, avx2_t v) { _mm256_storeu_si256((__m256i *)p, v); }
+
+static inline avx2_t avx2_add(avx2_t a, avx2_t b) { return _mm256_add_epi32(a, b); }
+static inline avx2_t avx2_sub(avx2_t a, avx2_t b) { return _mm256_sub_epi32(a, b); }
+static inline avx2_t avx2_mul(avx2_t a, avx2_t b) { return _mm256_mullo_epi32(a, b); }
+
+static inline __m256d avx2_lo_pd(avx2_t v) { return _mm256_cvtepi32_pd(_mm256_castsi256_si128(v)); }
+static inline __m256d avx2_hi_pd(avx2_t v) { return _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)); }
+static inline avx2_t avx2_from_pd(__m256d lo, __m256d hi) {
+    return _mm256_set_m128i(_mm256_cvttpd_epi32(hi), _mm256_cvttpd_epi32(lo));
+}
+
+static inline avx2_t avx2_div(avx2_t a, avx2_t b) {
+    avx2_t q = avx2_from_pd(_mm256_div_pd(avx2_lo_pd(a), avx2_lo_pd(b)),
+                            _mm256_div_pd(avx2_hi_pd(a), avx2_hi_pd(b)));
+    return _mm256_andnot_si256(_mm256_cmpeq_epi32(b, _mm256_setzero_si256()), q);
+}
+
+static inline avx2_t avx2_add_mask(avx2_t a, avx2_t b) {
+    avx2_t s = _mm256_add_epi32(a, b);
+    return _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, s), _mm256_xor_si256(b, s)), 31);
+}
+static inline avx2_t avx2_sub_mask(avx2_t a, avx2_t b) {
+    avx2_t d = _mm256_sub_epi32(a, b);
+    return _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, d)), 31);
+}
+static inline avx2_t avx2_bound(avx2_t a) {
+    return _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(INT_MAX));
+}
+
+static inline avx2_t avx2_add_sat(avx2_t a, avx2_t b) {
+    return _mm256_blendv_epi8(_mm256_add_epi32(a, b), avx2_bound(a), avx2_add_mask(a, b));
+}
+static inline avx2_t avx2_sub_sat(avx2_t a, avx2_t b) {
+    return _mm256_blendv_epi8(_mm256_sub_epi32(a, b), avx2_bound(a), avx2_sub_mask(a, b));
+}
+static inline __m256d avx2_clamp_pd(__m256d p) {
+    return _mm256_min_pd(_mm256_max_pd(p, _mm256_set1_pd(INT_MIN)), _mm256_set1_pd(INT_MAX));
+}
+static inline avx2_t avx2_mul_sat(avx2_t a, avx2_t b) {
+    return avx2_from_pd(avx2_clamp_pd(_mm256_mul_pd(avx2_lo_pd(a), avx2_lo_pd(b))),
+                        avx2_clamp_pd(_mm256_mul_pd(avx2_hi_pd(a), avx2_hi_pd(b))));
+}
+
+static inline int avx2_add_ovf(avx2_t a, avx2_t b) { return _mm256_movemask_epi8(avx2_add_mask(a, b)); }
+static inline int avx2_sub_ovf(avx2_t a, avx2_t b) { return _mm256_movemask_epi8(avx2_sub_mask(a, b)); }
+static inline int avx2_range_pd(__m256d p) {
+    return _mm256_movemask_pd(_mm256_or_pd(_mm256_cmp_pd(p, _mm256_set1_pd(INT_MAX), _CMP_GT_OQ),
+                                           _mm256_cmp_pd(p, _mm256_set1_pd(INT_MIN), _CMP_LT_OQ)));
+}
+static inline int avx2_mul_ovf(avx2_t a, avx2_t b) {
+    return avx2_range_pd(_mm256_mul_pd(avx2_lo_pd(a), avx2_lo_pd(b))) |
+           avx2_range_pd(_mm256_mul_pd(avx2_hi_pd(a), avx2_hi_pd(b)));
+}
+static inline int avx2_div_ovf(avx2_t a, avx2_t b) {
+    avx2_t zero = _mm256_cmpeq_epi32(b, _mm256_setzero_si256());
+    avx2_t wrap = _mm256_and_si256(_mm256_cmpeq_epi32(a, _mm256_set1_epi32(INT_MIN)),
+                                   _mm256_cmpeq_epi32(b, _mm256_set1_epi32(-1)));
+    return _mm256_movemask_epi8(_mm256_or_si256(zero, wrap));
+}
+
+DEFINE_VECTOR_ALL(avx2, 8)
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+typedef __m512i avx512_t;
+
+static inline avx512_t avx512_load(const int *p) { return _mm512_loadu_si512(p); }
+static inline void avx512_store(int *p, avx512_t v) { _mm512_storeu_si512(p, v); }
+
+static inline avx512_t avx512_add(avx512_t a, avx512_t b) { return _mm512_add_epi32(a, b); }
+static inline avx512_t avx512_sub(avx512_t a, avx512_t b) { return _mm512_sub_epi32(a, b); }
+static inline avx512_t avx512_mul(avx512_t a, avx512_t b) { return _mm512_mullo_epi32(a, b); }
+
+static inline __m512d avx512_lo_pd(avx512_t v) { return _mm512_cvtepi32_pd(_mm512_castsi512_si256(v)); }
+static inline __m512d avx512_hi_pd(avx512_t v) { return _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(v, 1)); }
+static inline avx512_t avx512_from_pd(__m512d lo, __m512d hi) {
+    return _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvttpd_epi32(lo)), _mm512_cvttpd_epi32(hi), 1);
+}
+
+static inline avx512_t avx512_div(avx512_t a, avx512_t b) {
+    avx512_t q = avx512_from_pd(_mm512_div_pd(avx512_lo_pd(a), avx512_lo_pd(b)),
+                                _mm512_div_pd(avx512_hi_pd(a), avx512_hi_pd(b)));
+    return _mm512_maskz_mov_epi32(_mm512_test_epi32_mask(b, b), q);
+}
+
+// AVX-512 compares straight into a lane mask, so no sign smearing is needed.
+static inline __mmask16 avx512_add_mask(avx512_t a, avx512_t b) {
+    avx512_t s = _mm512_add_epi32(a, b);
+    avx512_t t = _mm512_and_si512(_mm512_xor_si512(a, s), _mm512_xor_si512(b, s));
+    return _mm512_cmplt_epi32_mask(t, _mm512_setzero_si512());
+}
+static inline __mmask16 avx512_sub_mask(avx512_t a, avx512_t b) {
+    avx512_t d = _mm512_sub_epi32(a, b);
+    avx512_t t = _mm512_and_si512(_mm512_xor_si512(a, b), _mm512_xor_si512(a, d));
+    return _mm512_cmplt_epi32_mask(t, _mm512_setzero_si512());
+}
+static inline avx512_t avx512_bound(avx512_t a) {
+    return _mm512_xor_si512(_mm512_srai_epi32(a, 31), _mm512_set1_epi32(INT_MAX));
+}
+
+static inline avx512_t avx512_add_sat(avx512_t a, avx512_t b) {
+    return _mm512_mask_blend_epi32(avx512_add_mask(a, b), _mm512_add_epi32(a, b), avx512_bound(a));
+}
+static inline avx512_t avx512_sub_sat(avx512_t a, avx512_t b) {
+    return _mm512_mask_blend_epi32(avx512_sub_mask(a, b), _mm512_sub_epi32(a, b), avx512_bound(a));
+}
+static inline __m512d avx512_clamp_pd(__m512d p) {
+    return _mm512_min_pd(_mm512_max_pd(p, _mm512_set1_pd(INT_MIN)), _mm512_set1_pd(INT_MAX));
+}
+static inline avx512_t avx512_mul_sat(avx512_t a, avx512_t b) {
+    return avx512_from_pd(avx512_clamp_pd(_mm512_mul_pd(avx512_lo_pd(a), avx512_lo_pd(b))),
+                          avx512_clamp_pd(_mm512_mul_pd(avx512_hi_pd(a), avx512_hi_pd(b))));
+}
+
+static inline int avx512_add_ovf(avx512_t a, avx512_t b) { return avx512_add_mask(a, b); }
+static inline int avx512_sub_ovf(avx512_t a, avx512_t b) { return avx512_sub_mask(a, b); }
+static inline int avx512_range_pd(__m512d p) {
+    return _mm512_cmp_pd_mask(p, _mm512_set1_pd(INT_MAX), _CMP_GT_OQ) |
+           _mm512_cmp_pd_mask(p, _mm512_set1_pd(INT_MIN), _CMP_LT_OQ);
+}
+static inline int avx512_mul_ovf(avx512_t a, avx512_t b) {
+    return avx512_range_pd(_mm512_mul_pd(avx512_lo_pd(a), avx512_lo_pd(b))) |
+           avx512_range_pd(_mm512_mul_pd(avx512_hi_pd(a), avx512_hi_pd(b)));
+}
+static inline int avx512_div_ovf(avx512_t a, avx512_t b) {
+    __mmask16 zero = _mm512_testn_epi32_mask(b, b);
+    __mmask16 wrap = _mm512_cmpeq_epi32_mask(a, _mm512_set1_epi32(INT_MIN)) &
+                     _mm512_cmpeq_epi32_mask(b, _mm512_set1_epi32(-1));
+    return zero | wrap;
+}
+
+DEFINE_VECTOR_ALL(avx512, 16)
+#pragma GCC pop_options
+#endif
+
+// One table per ISA, in the spirit of the ops[] table in ch07/p11.c.
+typedef struct {
+    void (*add)(const int*, const int*, int*, size_t);
+    void (*sub)(const int*, const int*, int*, size_t);
+    void (*mul)(const int*, const int*, int*, size_t);
+    void (*div)(const int*, const int*, int*, size_t);
+    void (*add_sat)(const int*, const int*, int*, size_t);
+    void (*sub_sat)(const int*, const int*, int*, size_t);
+    void (*mul_sat)(const int*, const int*, int*, size_t);
+    size_t (*add_checked)(const int*, const int*, int*, size_t);
+    size_t (*sub_checked)(const int*, const int*, int*, size_t);
+    size_t (*mul_checked)(const int*, const int*, int*, size_t);
+    size_t (*div_checked)(const int*, const int*, int*, size_t);
+} batch_kernels;
+
+#define KERNEL_TABLE(isa) { \
+    add_##isa, sub_##isa, mul_##isa, div_##isa, \
+    add_sat_##isa, sub_sat_##isa, mul_sat_##isa, \
+    add_checked_##isa, sub_checked_##isa, mul_checked_##isa, div_checked_##isa }
+
+static const batch_kernels tables[] = {
+    KERNEL_TABLE(scalar),
+#ifdef HAVE_X86
+    KERNEL_TABLE(sse2), KERNEL_TABLE(avx2), KERNEL_TABLE(avx512),
+#endif
+};
+
+// Start on the scalar table so calls made before the constructor runs
+// (from another constructor, say) are still correct.
+static const batch_kernels *k = &tables[ISA_SCALAR];
+
+__attribute__((constructor))
+static void select_kernels(void) { k = &tables[cpu_isa()]; }
+
+void add_n(const int *a, const int *b, int *out, size_t n) { k->add(a, b, out, n); }
+void sub_n(const int *a, const int *b, int *out, size_t n) { k->sub(a, b, out, n); }
+void mul_n(const int *a, const int *b, int *out, size_t n) { k->mul(a, b, out, n); }
+void div_int_n(const int *a, const int *b, int *out, size_t n) { k->div(a, b, out, n); }
+void square_n(const int *a, int *out, size_t n) { k->mul(a, a, out, n); }
+
+void add_sat_n(const int *a, const int *b, int *out, size_t n) { k->add_sat(a, b, out, n); }
+void sub_sat_n(const int *a, const int *b, int *out, size_t n) { k->sub_sat(a, b, out, n); }
+void mul_sat_n(const int *a, const int *b, int *out, size_t n) { k->mul_sat(a, b, out, n); }
+void square_sat_n(const int *a, int *out, size_t n) { k->mul_sat(a, a, out, n); }
+
+size_t add_checked_n(const int *a, const int *b, int *out, size_t n) { return k->add_checked(a, b, out, n); }
+size_t sub_checked_n(const int *a, const int *b, int *out, size_t n) { return k->sub_checked(a, b, out, n); }
+size_t mul_checked_n(const int *a, const int *b, int *out, size_t n) { return k->mul_checked(a, b, out, n); }
+size_t div_int_checked_n(const int *a, const int *b, int *out, size_t n) { return k->div_checked(a, b, out, n); }
+size_t square_checked_n(const int *a, int *out, size_t n) { return k->mul_checked(a, a, out, n); }
@@ -0,0 +1,28 @@
+#ifndef MATHLIB_BATCH_H
+#define MATHLIB_BATCH_H
+
+#include <stddef.h>
+
+// Batch companions to mathlib.h: out[i] = op(a[i], b[i]) for i < n.
+// Results wrap like two's-complement hardware; dividing by 0 gives 0.
+void add_n(const int *a, const int *b, int *out, size_t n);
+void sub_n(const int *a, const int *b, int *out, size_t n);
+void mul_n(const int *a, const int *b, int *out, size_t n);
+void div_int_n(const int *a, const int *b, int *out, size_t n);
+void square_n(const int *a, int *out, size_t n);
+
+// Saturating: results clamp to INT_MIN..INT_MAX instead of wrapping.
+void add_sat_n(const int *a, const int *b, int *out, size_t n);
+void sub_sat_n(const int *a, const int *b, int *out, size_t n);
+void mul_sat_n(const int *a, const int *b, int *out, size_t n);
+void square_sat_n(const int *a, int *out, size_t n);
+
+// Checked: stop at the first overflow (or division by 0) and return its
+// index; out[0..index) is filled. Returns n when every element succeeded.
+size_t add_checked_n(const int *a, const int *b, int *out, size_t n);
+size_t sub_checked_n(const int *a, const int *b, int *out, size_t n);
+size_t mul_checked_n(const int *a, const int *b, int *out, size_t n);
+size_t div_int_checked_n(const int *a, const int *b, int *out, size_t n);
+size_t square_checked_n(const int *a, int *out, size_t n);
+
+#endif
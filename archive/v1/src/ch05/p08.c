@@ -1,8 +1,15 @@
+// gcc -std=c23 -O2 -I../ch10 p08.c ../ch10/numparse.c -o p08 -lm
 #include <stdio.h>
+#include "numparse.h"
 
 double area_circle(double r) { return 3.14159 * r * r; }
 
+static void print_areas(void *ctx, const double *r, size_t n) {
+    (void)ctx;
+    for (size_t i = 0; i < n; i++) printf("r=%.3f area=%.5f\n", r[i], area_circle(r[i]));
+}
+
 int main(void) {
-    double r; while (scanf("%lf", &r) == 1) printf("r=%.3f area=%.5f\n", r, area_circle(r));
+    double r[256]; fscan_f64(stdin, r, sizeof r / sizeof *r, print_areas, NULL);
     return 0;
 }
@@ -1,8 +1,15 @@
+// gcc -std=c23 -O2 -I../ch10 p09.c ../ch10/numparse.c -o p09 -lm
 #include <stdio.h>
+#include "numparse.h"
 
 double c_to_f(double c) { return c * 9.0 / 5.0 + 32.0; }
 
+static void print_temps(void *ctx, const double *c, size_t n) {
+    (void)ctx;
+    for (size_t i = 0; i < n; i++) printf("%.2f C = %.2f F\n", c[i], c_to_f(c[i]));
+}
+
 int main(void) {
-    double c; while (scanf("%lf", &c) == 1) printf("%.2f C = %.2f F\n", c, c_to_f(c));
+    double c[256]; fscan_f64(stdin, c, sizeof c / sizeof *c, print_temps, NULL);
     return 0;
 }
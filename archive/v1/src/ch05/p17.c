@@ -1,4 +1,5 @@
-#include <stdio.h>
+// gcc -std=c23 -O2 -I../ch10 p17.c ../ch10/fastout.c -o p17 -lm
+#include "fastout.h"
 
 unsigned long long factorial(int n) {
     unsigned long long f = 1ULL;
@@ -7,6 +8,11 @@ unsigned long long factorial(int n) {
 }
 
 int main(void) {
-    for (int i = 1; i <= 10; i++) printf("%2d! = %llu\n", i, factorial(i));
-    return 0;
+    static FastOut out;
+    fo_init(&out, 1);
+    for (int i = 1; i <= 10; i++) {
+        fo_i64(&out, i, 2); fo_write(&out, "! = ", 4);
+        fo_u64(&out, factorial(i), 0); fo_char(&out, '\n');
+    }
+    return fo_flush(&out) ? 0 : 1;
 }
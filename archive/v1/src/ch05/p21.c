@@ -0,0 +1,58 @@
+// Batch mathlib vs the per-call loop from p19.c.
+// gcc -std=c23 -O2 p21.c mathlib.c mathlib_batch.c cpu_dispatch.c -o p21
+// FORCE_ISA=scalar|sse2|avx2|avx512 ./p21 times one kernel set on purpose.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "mathlib.h"
+#include "mathlib_batch.h"
+#include "cpu_dispatch.h"
+
+#define N    (1 << 20)
+#define REPS 50
+
+static double ms_since(clock_t t0) { return 1000.0 * (clock() - t0) / CLOCKS_PER_SEC; }
+
+int main(void) {
+    int *a = malloc(N * sizeof *a), *b = malloc(N * sizeof *b);
+    int *ref = malloc(N * sizeof *ref), *out = malloc(N * sizeof *out);
+    if (!a || !b || !ref || !out) { puts("out of memory"); return 1; }
+
+    srand(42);
+    for (int i = 0; i < N; i++) {
+        a[i] = rand() % 20001 - 10000;        // small enough that mul never overflows
+        b[i] = rand() % 2000 + 1;             // never 0, so div_int is defined
+    }
+
+    printf("cpu: %s, kernels: %s\n", isa_name(cpu_isa_detected()), isa_name(cpu_isa()));
+
+    const char *names[4] = {"add", "sub", "mul", "div"};
+    int (*scalar[4])(int,int) = {add, sub, mul, div_int};
+    void (*batch[4])(const int*, const int*, int*, size_t) = {add_n, sub_n, mul_n, div_int_n};
+
+    for (int k = 0; k < 4; k++) {
+        clock_t t0 = clock();
+        for (int r = 0; r < REPS; r++)
+            for (int i = 0; i < N; i++) ref[i] = scalar[k](a[i], b[i]);
+        double t_scalar = ms_since(t0);
+
+        t0 = clock();
+        for (int r = 0; r < REPS; r++) batch[k](a, b, out, N);
+        double t_batch = ms_since(t0);
+
+        int same = memcmp(ref, out, N * sizeof *out) == 0;
+        printf("%-4s scalar %8.2f ms  batch %8.2f ms  x%.1f  %s\n", names[k],
+               t_scalar, t_batch, t_scalar / t_batch, same ? "match" : "MISMATCH");
+    }
+
+    // Saturating and checked variants on values that do overflow.
+    int big[4] = {7, 100000, INT_MAX, INT_MIN}, sat[4];
+    mul_sat_n(big, big, sat, 4);
+    printf("mul_sat: %d %d %d %d\n", sat[0], sat[1], sat[2], sat[3]);
+    printf("first overflow at index %zu\n", square_checked_n(big, sat, 4));
+
+    free(a); free(b); free(ref); free(out);
+    return 0;
+}
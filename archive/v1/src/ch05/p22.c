@@ -0,0 +1,78 @@
+// p20's one-shape-per-call functions vs the SoA batch kernels.
+// gcc -std=c23 -O2 p22.c shapes.c shapes_batch.c cpu_dispatch.c -o p22
+// FORCE_ISA=scalar|sse2|avx2|avx512 ./p22 times one kernel set on purpose.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "shapes.h"
+#include "shapes_batch.h"
+#include "cpu_dispatch.h"
+
+#define N    (1 << 22)
+#define REPS 20
+
+static double ms_since(clock_t t0) { return 1000.0 * (clock() - t0) / CLOCKS_PER_SEC; }
+
+static void report(const char *name, double ms) {
+    printf("%-22s %8.1f ms  %7.0f Mshapes/s\n", name, ms, (double)N * REPS / ms / 1000.0);
+}
+
+int main(void) {
+    Rect *aos = malloc(N * sizeof *aos);
+    RectF *aosf = malloc(N * sizeof *aosf);
+    double *ref = malloc(N * sizeof *ref), *out = malloc(N * sizeof *out);
+    float *outf = malloc(N * sizeof *outf);
+    RectBatch rb; RectBatchF rbf; CircleBatch cb;
+    if (!aos || !aosf || !ref || !out || !outf ||
+        !rect_batch_init(&rb, N) || !rect_batchf_init(&rbf, N) || !circle_batch_init(&cb, N)) {
+        puts("out of memory");
+        return 1;
+    }
+
+    srand(42);
+    for (int i = 0; i < N; i++) {
+        aos[i] = (Rect){rand() % 1000 / 10.0, rand() % 1000 / 10.0};
+        aosf[i] = (RectF){(float)aos[i].w, (float)aos[i].h};
+    }
+    printf("cpu: %s, kernels: %s\n", isa_name(cpu_isa_detected()), isa_name(cpu_isa()));
+
+    clock_t t0 = clock();
+    for (int r = 0; r < REPS; r++)
+        for (int i = 0; i < N; i++) ref[i] = area_rectangle(aos[i].w, aos[i].h);
+    report("per-call area", ms_since(t0));
+
+    t0 = clock();
+    for (int r = 0; r < REPS; r++) rect_batch_from_aos(&rb, aos);
+    report("AoS -> SoA (double)", ms_since(t0));
+    rect_batchf_from_aos(&rbf, aosf);
+
+    t0 = clock();
+    for (int r = 0; r < REPS; r++) rect_area_n(&rb, out);
+    report("rect_area_n", ms_since(t0));
+    printf("  matches per-call: %s\n", memcmp(ref, out, N * sizeof *out) == 0 ? "yes" : "NO");
+
+    t0 = clock();
+    for (int r = 0; r < REPS; r++) rect_area_nf(&rbf, outf);
+    report("rect_area_nf", ms_since(t0));
+
+    for (int i = 0; i < N; i++) cb.r[i] = rb.w[i];
+    t0 = clock();
+    for (int r = 0; r < REPS; r++)
+        for (int i = 0; i < N; i++) ref[i] = area_circle(cb.r[i]);
+    report("per-call circle area", ms_since(t0));
+
+    t0 = clock();
+    for (int r = 0; r < REPS; r++) circle_area_n(&cb, out);
+    report("circle_area_n", ms_since(t0));
+    printf("  matches per-call: %s\n", memcmp(ref, out, N * sizeof *out) == 0 ? "yes" : "NO");
+
+    rect_perimeter_n(&rb, out);
+    circle_perimeter_n(&cb, ref);
+    printf("first rect: area=%.2f perim=%.2f, first circle perim=%.2f\n",
+           area_rectangle(aos[0].w, aos[0].h), out[0], ref[0]);
+
+    rect_batch_free(&rb); rect_batchf_free(&rbf); circle_batch_free(&cb);
+    free(aos); free(aosf); free(ref); free(out); free(outf);
+    return 0;
+}
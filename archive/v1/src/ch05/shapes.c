@@ -2,4 +2,5 @@
 
 double area_rectangle(double w, double h) { return w * h; }
 double perimeter_rectangle(double w, double h) { return 2.0 * (w + h); }
-double area_circle(double r) { return 3.14159 * r * r; }
+double area_circle(double r) { return SHAPES_PI * r * r; }
+double perimeter_circle(double r) { return 2.0 * SHAPES_PI * r; }
@@ -1,8 +1,11 @@
 #ifndef SHAPES_H
 #define SHAPES_H
 
+#define SHAPES_PI 3.14159265358979323846
+
 double area_rectangle(double w, double h);
 double perimeter_rectangle(double w, double h);
 double area_circle(double r);
+double perimeter_circle(double r);
 
 #endif
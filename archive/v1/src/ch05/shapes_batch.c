@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include "shapes.h"
+#include "shapes_batch.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#define ALIGN 64
+
+// ---- storage ----------------------------------------------------------------
+
+// aligned_alloc wants a size that is a multiple of the alignment.
+static void *alloc_array(size_t n, size_t size) {
+    size_t bytes = (n * size + ALIGN - 1) / ALIGN * ALIGN;
+    return aligned_alloc(ALIGN, bytes ? bytes : ALIGN);
+}
+
+bool rect_batch_init(RectBatch *b, size_t n) {
+    b->w = alloc_array(n, sizeof *b->w);
+    b->h = alloc_array(n, sizeof *b->h);
+    b->n = n;
+    if (!b->w || !b->h) { rect_batch_free(b); return false; }
+    return true;
+}
+bool rect_batchf_init(RectBatchF *b, size_t n) {
+    b->w = alloc_array(n, sizeof *b->w);
+    b->h = alloc_array(n, sizeof *b->h);
+    b->n = n;
+    if (!b->w || !b->h) { rect_batchf_free(b); return false; }
+    return true;
+}
+bool circle_batch_init(CircleBatch *b, size_t n) {
+    b->r = alloc_array(n, sizeof *b->r);
+    b->n = b->r ? n : 0;
+    return b->r != NULL;
+}
+bool circle_batchf_init(CircleBatchF *b, size_t n) {
+    b->r = alloc_array(n, sizeof *b->r);
+    b->n = b->r ? n : 0;
+    return b->r != NULL;
+}
+
+void rect_batch_free(RectBatch *b) { free(b->w); free(b->h); b->w = b->h = NULL; b->n = 0; }
+void rect_batchf_free(RectBatchF *b) { free(b->w); free(b->h); b->w = b->h = NULL; b->n = 0; }
+void circle_batch_free(CircleBatch *b) { free(b->r); b->r = NULL; b->n = 0; }
+void circle_batchf_free(CircleBatchF *b) { free(b->r); b->r = NULL; b->n = 0; }
+
+// ---- kernels ----------------------------------------------------------------
+
+// Scalar reference: the shapes.c expressions, evaluated in type T.
+#define DEFINE_SCALAR(sfx, T) \
+static void rect_area_##sfx##_scalar(const T *w, const T *h, T *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) out[i] = w[i] * h[i]; \
+} \
+static void rect_perimeter_##sfx##_scalar(const T *w, const T *h, T *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) out[i] = (T)2 * (w[i] + h[i]); \
+} \
+static void circle_area_##sfx##_scalar(const T *r, T *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) out[i] = (T)SHAPES_PI * r[i] * r[i]; \
+} \
+static void circle_perimeter_##sfx##_scalar(const T *r, T *out, size_t n) { \
+    for (size_t i = 0; i < n; i++) out[i] = (T)(2 * SHAPES_PI) * r[i]; \
+}
+
+DEFINE_SCALAR(f64, double)
+DEFINE_SCALAR(f32, float)
+
+// Vector kernels: W lanes of V at a time with the same operation order as
+// the scalar loops, which then finish the tail.
+#define DEFINE_VECTOR(isa, sfx, T, V, W, LD, ST, ADD, MUL, SET1) \
+static void rect_area_##sfx##_##isa(const T *w, const T *h, T *out, size_t n) { \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) ST(out + i, MUL(LD(w + i), LD(h + i))); \
+    rect_area_##sfx##_scalar(w + i, h + i, out + i, n - i); \
+} \
+static void rect_perimeter_##sfx##_##isa(const T *w, const T *h, T *out, size_t n) { \
+    V two = SET1((T)2); \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) ST(out + i, MUL(two, ADD(LD(w + i), LD(h + i)))); \
+    rect_perimeter_##sfx##_scalar(w + i, h + i, out + i, n - i); \
+} \
+static void circle_area_##sfx##_##isa(const T *r, T *out, size_t n) { \
+    V pi = SET1((T)SHAPES_PI); \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) { V x = LD(r + i); ST(out + i, MUL(MUL(pi, x), x)); } \
+    circle_area_##sfx##_scalar(r + i, out + i, n - i); \
+} \
+static void circle_perimeter_##sfx##_##isa(const T *r, T *out, size_t n) { \
+    V tau = SET1((T)(2 * SHAPES_PI)); \
+    size_t i = 0; \
+    for (; i + W <= n; i += W) ST(out + i, MUL(tau, LD(r + i))); \
+    circle_perimeter_##sfx##_scalar(r + i, out + i, n - i); \
+}
+
+// AoS -> SoA transposes. The scalar loop also finishes the vector tails.
+static void from_aos_f64_scalar(double *w, double *h, const Rect *r, size_t n) {
+    for (size_t i = 0; i < n; i++) { w[i] = r[i].w; h[i] = r[i].h; }
+}
+static void from_aos_f32_scalar(float *w, float *h, const RectF *r, size_t n) {
+    for (size_t i = 0; i < n; i++) { w[i] = r[i].w; h[i] = r[i].h; }
+}
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("sse2")
+DEFINE_VECTOR(sse2, f64, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_add_pd, _mm_mul_pd, _mm_set1_pd)
+DEFINE_VECTOR(sse2, f32, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps, _mm_mul_ps, _mm_set1_ps)
+
+// (w0 h0)(w1 h1) -> (w0 w1)(h0 h1)
+static void from_aos_f64_sse2(double *w, double *h, const Rect *r, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d a = _mm_loadu_pd(&r[i].w), b = _mm_loadu_pd(&r[i + 1].w);
+        _mm_storeu_pd(w + i, _mm_unpacklo_pd(a, b));
+        _mm_storeu_pd(h + i, _mm_unpackhi_pd(a, b));
+    }
+    from_aos_f64_scalar(w + i, h + i, r + i, n - i);
+}
+// (w0 h0 w1 h1)(w2 h2 w3 h3) -> even lanes are widths, odd lanes heights.
+static void from_aos_f32_sse2(float *w, float *h, const RectF *r, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(&r[i].w), b = _mm_loadu_ps(&r[i + 2].w);
+        _mm_storeu_ps(w + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+        _mm_storeu_ps(h + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+    }
+    from_aos_f32_scalar(w + i, h + i, r + i, n - i);
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+DEFINE_VECTOR(avx2, f64, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_add_pd, _mm256_mul_pd, _mm256_set1_pd)
+DEFINE_VECTOR(avx2, f32, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps, _mm256_mul_ps, _mm256_set1_ps)
+
+// The 256-bit unpacks and shuffles work within 128-bit halves, leaving
+// the 64-bit chunks in order 0 2 1 3; one cross-lane permute fixes that.
+static void from_aos_f64_avx2(double *w, double *h, const Rect *r, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d a = _mm256_loadu_pd(&r[i].w), b = _mm256_loadu_pd(&r[i + 2].w);
+        _mm256_storeu_pd(w + i, _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), _MM_SHUFFLE(3,1,2,0)));
+        _mm256_storeu_pd(h + i, _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), _MM_SHUFFLE(3,1,2,0)));
+    }
+    from_aos_f64_scalar(w + i, h + i, r + i, n - i);
+}
+static inline __m256 avx2_fix_order(__m256 v) {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3,1,2,0)));
+}
+static void from_aos_f32_avx2(float *w, float *h, const RectF *r, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 a = _mm256_loadu_ps(&r[i].w), b = _mm256_loadu_ps(&r[i + 4].w);
+        _mm256_storeu_ps(w + i, avx2_fix_order(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0))));
+        _mm256_storeu_ps(h + i, avx2_fix_order(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1))));
+    }
+    from_aos_f32_scalar(w + i, h + i, r + i, n - i);
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+DEFINE_VECTOR(avx512, f64, double, __m512d, 8, _mm512_loadu_pd, _mm512_storeu_pd, _mm512_add_pd, _mm512_mul_pd, _mm512_set1_pd)
+DEFINE_VECTOR(avx512, f32, float, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_add_ps, _mm512_mul_ps, _mm512_set1_ps)
+#pragma GCC pop_options
+
+// The transposes are bound by memory, not shuffles; AVX-512 reuses AVX2's.
+#define from_aos_f64_avx512 from_aos_f64_avx2
+#define from_aos_f32_avx512 from_aos_f32_avx2
+#endif
+
+// One table per ISA, selected once like the mathlib_batch.c kernels.
+typedef struct {
+    void (*rect_area)(const double*, const double*, double*, size_t);
+    void (*rect_perimeter)(const double*, const double*, double*, size_t);
+    void (*circle_area)(const double*, double*, size_t);
+    void (*circle_perimeter)(const double*, double*, size_t);
+    void (*rect_area_f)(const float*, const float*, float*, size_t);
+    void (*rect_perimeter_f)(const float*, const float*, float*, size_t);
+    void (*circle_area_f)(const float*, float*, size_t);
+    void (*circle_perimeter_f)(const float*, float*, size_t);
+    void (*from_aos)(double*, double*, const Rect*, size_t);
+    void (*from_aos_f)(float*, float*, const RectF*, size_t);
+} shape_kernels;
+
+#define KERNEL_TABLE(isa) { \
+    rect_area_f64_##isa, rect_perimeter_f64_##isa, circle_area_f64_##isa, circle_perimeter_f64_##isa, \
+    rect_area_f32_##isa, rect_perimeter_f32_##isa, circle_area_f32_##isa, circle_perimeter_f32_##isa, \
+    from_aos_f64_##isa, from_aos_f32_##isa }
+
+static const shape_kernels tables[] = {
+    KERNEL_TABLE(scalar),
+#ifdef HAVE_X86
+    KERNEL_TABLE(sse2), KERNEL_TABLE(avx2), KERNEL_TABLE(avx512),
+#endif
+};
+
+static const shape_kernels *k = &tables[ISA_SCALAR];
+
+__attribute__((constructor))
+static void select_kernels(void) { k = &tables[cpu_isa()]; }
+
+void rect_batch_from_aos(RectBatch *b, const Rect *r) { k->from_aos(b->w, b->h, r, b->n); }
+void rect_batchf_from_aos(RectBatchF *b, const RectF *r) { k->from_aos_f(b->w, b->h, r, b->n); }
+
+void rect_area_n(const RectBatch *b, double *out) { k->rect_area(b->w, b->h, out, b->n); }
+void rect_perimeter_n(const RectBatch *b, double *out) { k->rect_perimeter(b->w, b->h, out, b->n); }
+void circle_area_n(const CircleBatch *b, double *out) { k->circle_area(b->r, out, b->n); }
+void circle_perimeter_n(const CircleBatch *b, double *out) { k->circle_perimeter(b->r, out, b->n); }
+
+void rect_area_nf(const RectBatchF *b, float *out) { k->rect_area_f(b->w, b->h, out, b->n); }
+void rect_perimeter_nf(const RectBatchF *b, float *out) { k->rect_perimeter_f(b->w, b->h, out, b->n); }
+void circle_area_nf(const CircleBatchF *b, float *out) { k->circle_area_f(b->r, out, b->n); }
+void circle_perimeter_nf(const CircleBatchF *b, float *out) { k->circle_perimeter_f(b->r, out, b->n); }
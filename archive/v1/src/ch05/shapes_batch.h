@@ -0,0 +1,46 @@
+#ifndef SHAPES_BATCH_H
+#define SHAPES_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Structure-of-arrays batches: shape i is (w[i], h[i]) or r[i], so the
+// kernels below read whole vectors of one field at a time.
+typedef struct { double *w, *h; size_t n; } RectBatch;
+typedef struct { float  *w, *h; size_t n; } RectBatchF;
+typedef struct { double *r; size_t n; } CircleBatch;
+typedef struct { float  *r; size_t n; } CircleBatchF;
+
+// One rectangle per struct, the array-of-structs layout callers start from.
+typedef struct { double w, h; } Rect;
+typedef struct { float  w, h; } RectF;
+
+// Allocate n uninitialised shapes with 64-byte aligned arrays.
+// Return false (and leave the batch empty) when out of memory.
+bool rect_batch_init(RectBatch *b, size_t n);
+bool rect_batchf_init(RectBatchF *b, size_t n);
+bool circle_batch_init(CircleBatch *b, size_t n);
+bool circle_batchf_init(CircleBatchF *b, size_t n);
+void rect_batch_free(RectBatch *b);
+void rect_batchf_free(RectBatchF *b);
+void circle_batch_free(CircleBatch *b);
+void circle_batchf_free(CircleBatchF *b);
+
+// AoS -> SoA: b->w[i] = r[i].w and b->h[i] = r[i].h for i < b->n.
+void rect_batch_from_aos(RectBatch *b, const Rect *r);
+void rect_batchf_from_aos(RectBatchF *b, const RectF *r);
+
+// out[i] for every shape in the batch, with the shapes.c formulas.
+// Each lane is computed exactly like the scalar expression, so results
+// match area_rectangle() and friends bit for bit in double precision.
+void rect_area_n(const RectBatch *b, double *out);
+void rect_perimeter_n(const RectBatch *b, double *out);
+void circle_area_n(const CircleBatch *b, double *out);
+void circle_perimeter_n(const CircleBatch *b, double *out);
+
+void rect_area_nf(const RectBatchF *b, float *out);
+void rect_perimeter_nf(const RectBatchF *b, float *out);
+void circle_area_nf(const CircleBatchF *b, float *out);
+void circle_perimeter_nf(const CircleBatchF *b, float *out);
+
+#endif
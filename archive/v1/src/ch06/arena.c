@@ -0,0 +1,70 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#define ALIGN 16
+
+struct ArenaChunk {
+    ArenaChunk *next;
+    size_t used, cap;
+    _Alignas(ALIGN) char data[];
+};
+
+void arena_init(Arena *a, size_t chunk) {
+    *a = (Arena){NULL, chunk ? chunk : (size_t)64 << 10, NULL};
+}
+
+void arena_free(Arena *a) {
+    for (ArenaChunk *c = a->head, *next; c; c = next) { next = c->next; free(c); }
+    a->head = NULL;
+    a->last = NULL;
+}
+
+static size_t round_up(size_t n) { return (n + ALIGN - 1) & ~(size_t)(ALIGN - 1); }
+
+// Requests bigger than a quarter chunk get a chunk of their own behind
+// the current one, which keeps filling.
+static void *take(Arena *a, size_t n, size_t align) {
+    ArenaChunk *c = a->head;
+    size_t at = c ? (c->used + align - 1) & ~(align - 1) : 0;
+    if (!c || at > c->cap || c->cap - at < n) {
+        size_t cap = n > a->chunk / 4 ? n : a->chunk;
+        ArenaChunk *nc = malloc(sizeof *nc + cap);
+        if (!nc) return NULL;
+        nc->used = 0;
+        nc->cap = cap;
+        if (c && cap != a->chunk) { nc->next = c->next; c->next = nc; }
+        else { nc->next = c; a->head = nc; }
+        c = nc;
+        at = 0;
+    }
+    void *p = c->data + at;
+    c->used = at + n;
+    a->last = c == a->head ? p : NULL;
+    return p;
+}
+
+void *arena_alloc(Arena *a, size_t n) {
+    if (n > SIZE_MAX - sizeof(ArenaChunk) - ALIGN) return NULL;
+    return take(a, round_up(n ? n : 1), ALIGN);
+}
+
+void *arena_alloc_bytes(Arena *a, size_t n) {
+    if (n > SIZE_MAX - sizeof(ArenaChunk)) return NULL;
+    return take(a, n ? n : 1, 1);
+}
+
+void *arena_grow(Arena *a, void *p, size_t old, size_t n) {
+    ArenaChunk *c = a->head;
+    if (p && p == a->last && n <= SIZE_MAX - ALIGN) {
+        size_t start = (size_t)((char *)p - c->data), want = round_up(n ? n : 1);
+        if (want <= c->cap - start) {
+            c->used = start + want;
+            return p;
+        }
+    }
+    void *q = arena_alloc(a, n);
+    if (q && p) memcpy(q, p, old < n ? old : n);
+    return q;
+}
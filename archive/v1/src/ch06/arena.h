@@ -0,0 +1,30 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// A bump allocator: memory comes from large chunks and is given back all
+// at once by arena_free. Allocations are 16-byte aligned unless they come
+// from arena_alloc_bytes.
+typedef struct ArenaChunk ArenaChunk;
+
+typedef struct {
+    ArenaChunk *head;                 // the chunk being filled
+    size_t chunk;                     // usual chunk size
+    void *last;                       // latest allocation, which may grow in place
+} Arena;
+
+// chunk: bytes per chunk, 0 for 64 KB.
+void arena_init(Arena *a, size_t chunk);
+void arena_free(Arena *a);
+
+// NULL when out of memory.
+void *arena_alloc(Arena *a, size_t n);
+// The same with no alignment, so strings pack end to end.
+void *arena_alloc_bytes(Arena *a, size_t n);
+// Resize p (old bytes, from this arena) to n bytes. The latest allocation
+// is extended in place while its chunk has room; anything else is copied
+// to a new allocation and the old space stays unused until arena_free.
+void *arena_grow(Arena *a, void *p, size_t old, size_t n);
+
+#endif
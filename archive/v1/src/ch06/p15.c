@@ -1,10 +1,13 @@
+// gcc -std=c23 -O2 p15.c strbuf.c arena.c -o p15
 #include <stdio.h>
-#include <string.h>
+#include "strbuf.h"
 
 int main(void) {
-    char a[32] = "Hello";
-    char b[] = "World";
-    strcat(a, b);
-    printf("%s\n", a);
+    StrBuf a;
+    sb_init(&a);
+    sb_puts(&a, "Hello");
+    sb_puts(&a, "World");
+    printf("%s\n", a.p);
+    sb_free(&a);
     return 0;
 }
@@ -1,13 +1,20 @@
+// gcc -std=c23 -O2 -I../ch05 p18.c tokenize.c ../ch05/cpu_dispatch.c -o p18
 #include <stdio.h>
 #include <string.h>
+#include "tokenize.h"
 
 int main(void) {
     char line[256];
     if (!fgets(line, sizeof(line), stdin)) return 0;
 
+    TokDelims ws;
+    tok_delims(&ws, " \t\r\n", 4);
+    Tokenizer t;
+    tok_init(&t, &ws, line, strlen(line));
+
     int count = 0;
-    char *tok = strtok(line, " \t\r\n");
-    while (tok) { count++; tok = strtok(NULL, " \t\r\n"); }
+    Tok tok;
+    while (tok_next(&t, &tok)) count++;
     printf("%d\n", count);
     return 0;
 }
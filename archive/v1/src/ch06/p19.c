@@ -1,19 +1,21 @@
+// gcc -std=c23 -O2 -I../ch05 p19.c tokenize.c ../ch05/cpu_dispatch.c -o p19
 #include <stdio.h>
 #include <string.h>
+#include "tokenize.h"
 
 int main(void) {
     char line[256];
     if (!fgets(line, sizeof(line), stdin)) return 0;
 
-    char longest[256] = "";
-    char *tok = strtok(line, " \t\r\n");
-    while (tok) {
-        if (strlen(tok) > strlen(longest)) {
-            strncpy(longest, tok, sizeof(longest) - 1);
-            longest[sizeof(longest) - 1] = '\0';
-        }
-        tok = strtok(NULL, " \t\r\n");
-    }
-    printf("%s\n", longest);
+    TokDelims ws;
+    tok_delims(&ws, " \t\r\n", 4);
+    Tokenizer t;
+    tok_init(&t, &ws, line, strlen(line));
+
+    // The longest token is a view into line; nothing is copied.
+    Tok tok, longest = {"", 0};
+    while (tok_next(&t, &tok))
+        if (tok.len > longest.len) longest = tok;
+    printf("%.*s\n", (int)longest.len, longest.p);
     return 0;
 }
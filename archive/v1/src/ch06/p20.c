@@ -1,38 +1,35 @@
+// Word frequencies of stdin, most frequent first: p20 [N] prints the top N.
+// gcc -std=c23 -O2 -pthread p20.c wordcount.c arena.c -o p20
+#include <stdint.h>
 #include <stdio.h>
-#include <string.h>
+#include <stdlib.h>
+#include "wordcount.h"
 
-#define MAX_WORDS 100
-#define MAX_LEN   32
-
-int main(void) {
-    char line[512];
-    if (!fgets(line, sizeof(line), stdin)) return 0;
-
-    char words[MAX_WORDS][MAX_LEN];
-    int counts[MAX_WORDS] = {0};
-    int total = 0;
-
-    for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
-        // truncate token if too long for storage
-        char key[MAX_LEN];
-        strncpy(key, tok, MAX_LEN - 1);
-        key[MAX_LEN - 1] = '\0';
-
-        int idx = -1;
-        for (int i = 0; i < total; i++) {
-            if (strcmp(words[i], key) == 0) { idx = i; break; }
-        }
-        if (idx >= 0) {
-            counts[idx]++;
-        } else if (total < MAX_WORDS) {
-            strcpy(words[total], key);
-            counts[total] = 1;
-            total++;
-        }
+static void print_words(const WordFreq *w, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        fwrite(w[i].word, 1, w[i].len, stdout);
+        printf(" %llu\n", w[i].count);
     }
+}
+
+int main(int argc, char **argv) {
+    WordCount *wc = wc_new(0);
+    if (!wc) { perror("wc_new"); return 1; }
+    if (!wc_add_fd(wc, 0)) { perror("stdin"); wc_free(wc); return 1; }
 
-    for (int i = 0; i < total; i++) {
-        printf("%s %d\n", words[i], counts[i]);
+    if (argc > 1) {
+        size_t k = strtoull(argv[1], NULL, 10);
+        WordFreq *top = malloc((k ? k : 1) * sizeof *top);
+        if (!top) { perror("malloc"); wc_free(wc); return 1; }
+        print_words(top, wc_top(wc, top, k));
+        free(top);
+    } else {
+        size_t n = SIZE_MAX;           // left as is when out of memory
+        WordFreq *all = wc_sorted(wc, &n);
+        if (!all && n) { fputs("wc_sorted: out of memory\n", stderr); wc_free(wc); return 1; }
+        print_words(all, n);
+        free(all);
     }
+    wc_free(wc);
     return 0;
 }
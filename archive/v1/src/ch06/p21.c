@@ -0,0 +1,59 @@
+// The p02/p03/p05/p07 loops on a large array, next to the reduce.c kernels.
+// gcc -std=c23 -O2 -I../ch05 -pthread p21.c reduce.c ../ch05/cpu_dispatch.c -o p21
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "reduce.h"
+
+#define N    (1 << 24)
+#define REPS 10
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int main(void) {
+    int *a = malloc(N * sizeof *a), *pre = malloc(N * sizeof *pre);
+    if (!a || !pre) { puts("out of memory"); return 1; }
+    srand(7);
+    for (int i = 0; i < N; i++) a[i] = rand() % 2001 - 1000;
+
+    // Element-at-a-time loops, as in the small programs.
+    double t0 = now_ms();
+    long long sum = 0, sq = 0; int mx = a[0], even = 0;
+    for (int r = 0; r < REPS; r++) {
+        sum = 0; sq = 0; mx = a[0]; even = 0;
+        for (int i = 0; i < N; i++) sum += a[i];
+        for (int i = 1; i < N; i++) if (a[i] > mx) mx = a[i];
+        for (int i = 0; i < N; i++) if (a[i] % 2 == 0) even++;
+        for (int i = 0; i < N; i++) sq += (long long)a[i] * a[i];
+    }
+    double t1 = now_ms();
+
+    long long ksum = 0, ksq = 0; size_t kmx = 0, keven = 0;
+    for (int r = 0; r < REPS; r++) {
+        ksum = sum_i32(a, N);
+        kmx = argmax_i32(a, N);
+        keven = count_if_i32(a, N, PRED_EVEN, 0);
+        ksq = sumsq_i32(a, N);
+    }
+    double t2 = now_ms();
+
+    printf("loops   %8.1f ms  sum=%lld max=%d even=%d sumsq=%lld\n", t1 - t0, sum, mx, even, sq);
+    printf("kernels %8.1f ms  sum=%lld max=%d even=%zu sumsq=%lld\n", t2 - t1, ksum, a[kmx], keven, ksq);
+    printf("average %.3f\n", (double)ksum / N);
+    bool ok = ksum == sum && a[kmx] == mx && keven == (size_t)even && ksq == sq;
+
+    t0 = now_ms();
+    scan_incl_i32(a, pre, N);
+    printf("prefix scan %.1f ms, last=%d\n", now_ms() - t0, pre[N - 1]);
+    long long run = 0;
+    for (int i = 0; i < N; i++) ok &= pre[i] == (run += a[i]);
+
+    puts(ok ? "kernels match the loops" : "MISMATCH");
+    free(a); free(pre);
+    return !ok;
+}
@@ -0,0 +1,129 @@
+// wordcount.c on a generated 256 MB corpus: one thread, all threads, and
+// the same text through a pipe, next to just reading the file.
+// gcc -std=c23 -O2 -pthread p22.c wordcount.c arena.c -o p22 -lm
+#define _POSIX_C_SOURCE 200809L   // fileno, fork
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "wordcount.h"
+
+#define MB    (1 << 20)
+#define SIZE  (256 * MB)
+#define VOCAB 200000
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Words 1-20 letters long with roughly Zipf frequencies: the index is
+// VOCAB^u for uniform u, so word i comes up about as often as 1/i.
+static FILE *make_corpus(void) {
+    static char vocab[VOCAB][24];
+    for (int i = 0; i < VOCAB; i++) {
+        int len = 1 + (int)(next_rand() % 20);
+        for (int j = 0; j < len; j++) vocab[i][j] = 'a' + (char)(next_rand() % 26);
+        vocab[i][len] = '\0';
+    }
+    FILE *f = tmpfile();
+    if (!f) return NULL;
+    char *buf = malloc(MB + 64);
+    for (size_t written = 0; written < SIZE;) {
+        size_t n = 0;
+        while (n < MB) {
+            unsigned long long r = next_rand();
+            int i = (int)pow(VOCAB, (double)(r >> 11) / (1ULL << 53)) - 1;
+            size_t len = strlen(vocab[i]);
+            memcpy(buf + n, vocab[i], len);
+            n += len;
+            buf[n++] = r % 12 == 0 ? '\n' : ' ';
+        }
+        fwrite(buf, 1, n, f);
+        written += n;
+    }
+    free(buf);
+    fflush(f);
+    return f;
+}
+
+static void report(const char *what, double ms, WordCount *wc, long size) {
+    printf("  %-22s %7.1f ms  %7.1f MB/s", what, ms, size / ms / 1e3);
+    if (wc) printf("  %llu words, %zu distinct", wc_total(wc), wc_distinct(wc));
+    putchar('\n');
+}
+
+// Top ten must agree between runs.
+static int same_top(WordCount *a, WordCount *b) {
+    WordFreq ta[10], tb[10];
+    size_t n = wc_top(a, ta, 10);
+    if (wc_top(b, tb, 10) != n || wc_total(a) != wc_total(b) || wc_distinct(a) != wc_distinct(b)) return 0;
+    for (size_t i = 0; i < n; i++)
+        if (ta[i].count != tb[i].count || ta[i].len != tb[i].len || memcmp(ta[i].word, tb[i].word, ta[i].len)) return 0;
+    return 1;
+}
+
+int main(void) {
+    FILE *f = make_corpus();
+    if (!f) { perror("tmpfile"); return 1; }
+    int fd = fileno(f);
+    long size = ftell(f);
+    printf("corpus %.1f MB\n", size / 1e6);
+
+    char *buf = malloc(MB);
+    lseek(fd, 0, SEEK_SET);
+    double t0 = now_ms();
+    while (read(fd, buf, MB) > 0) {}
+    report("read() only", now_ms() - t0, NULL, size);
+    free(buf);
+
+    WordCount *one = wc_new(1), *all = wc_new(0), *piped = wc_new(0);
+    if (!one || !all || !piped) { perror("wc_new"); return 1; }
+
+    lseek(fd, 0, SEEK_SET);
+    t0 = now_ms();
+    wc_add_fd(one, fd);
+    report("wc_add_fd, 1 thread", now_ms() - t0, one, size);
+
+    lseek(fd, 0, SEEK_SET);
+    t0 = now_ms();
+    wc_add_fd(all, fd);
+    report("wc_add_fd, all threads", now_ms() - t0, all, size);
+
+    int p[2];
+    if (pipe(p) != 0) { perror("pipe"); return 1; }
+    lseek(fd, 0, SEEK_SET);
+    t0 = now_ms();
+    pid_t child = fork();
+    if (child == 0) {
+        close(p[0]);
+        static char block[MB];
+        ssize_t n;
+        while ((n = read(fd, block, sizeof block)) > 0)
+            if (write(p[1], block, (size_t)n) != n) _exit(1);
+        _exit(0);
+    }
+    close(p[1]);
+    wc_add_fd(piped, p[0]);
+    waitpid(child, NULL, 0);
+    report("through a pipe", now_ms() - t0, piped, size);
+    close(p[0]);
+
+    printf("results agree: %s\n", same_top(one, all) && same_top(one, piped) ? "yes" : "NO");
+    WordFreq top[5];
+    size_t n = wc_top(all, top, 5);
+    for (size_t i = 0; i < n; i++) printf("  %.*s %llu\n", (int)top[i].len, top[i].word, top[i].count);
+    wc_free(one); wc_free(all); wc_free(piped);
+    fclose(f);
+    return 0;
+}
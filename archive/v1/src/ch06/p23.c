@@ -0,0 +1,122 @@
+// tokenize.c against strtok on a generated 64 MB text: the same tokens
+// from one buffer, from odd-sized chunks and in batches, and the speed.
+// gcc -std=c23 -O2 -I../ch05 p23.c tokenize.c ../ch05/cpu_dispatch.c -o p23
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tokenize.h"
+
+#define MB   (1 << 20)
+#define SIZE (64 * MB)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Words of 1-12 letters separated by runs of 1-3 delimiters from seps.
+static char *make_text(const char *seps) {
+    char *s = malloc(SIZE + 1);
+    if (!s) return NULL;
+    size_t n = 0, ns = strlen(seps);
+    while (n < SIZE) {
+        unsigned long long r = next_rand();
+        for (int k = (int)(r % 12) + 1; k-- && n < SIZE;) s[n++] = (char)('a' + (r >> (8 + k)) % 26);
+        for (int k = (int)(r >> 40) % 3 + 1; k-- && n < SIZE;) s[n++] = seps[(r >> (44 + 4 * k)) % ns];
+    }
+    s[n] = '\0';
+    return s;
+}
+
+// Tokens are compared by where they start and how long they are, so
+// streams are checked against offsets rather than pointers.
+typedef struct { size_t off, len; } Span;
+
+static size_t ref_spans(char *text, const char *delims, Span *out) {
+    size_t n = 0;
+    for (char *t = strtok(text, delims); t; t = strtok(NULL, delims))
+        out[n++] = (Span){(size_t)(t - text), strlen(t)};
+    return n;
+}
+
+static bool same(const Tok *t, const Span *want, size_t n, size_t k, const char *text) {
+    return k < n && t->len == want[k].len && !memcmp(t->p, text + want[k].off, t->len);
+}
+
+static bool report(const char *name, bool ok, size_t k, size_t n, double ms) {
+    if (!ok || k != n) printf("  %s: %zu tokens, strtok found %zu, or a token differs\n", name, k, n);
+    printf("  %-12s %8.1f ms  %6.0f MB/s\n", name, ms, SIZE / MB / ms * 1e3);
+    return ok && k == n;
+}
+
+static bool run(const char *title, const char *delims, const TokDelims *d) {
+    char *text = make_text(delims), *copy = malloc(SIZE + 1);
+    Span *want = malloc(SIZE / 2 * sizeof *want);
+    if (!text || !copy || !want) { perror("malloc"); exit(1); }
+    memcpy(copy, text, SIZE + 1);
+
+    printf("%s\n", title);
+    double t0 = now_ms();
+    size_t n = ref_spans(copy, delims, want);
+    double ms = now_ms() - t0;
+    printf("  %-12s %8.1f ms  %6.0f MB/s  (%zu tokens)\n", "strtok", ms, SIZE / MB / ms * 1e3, n);
+
+    Tokenizer t;
+    Tok tk, batch[256];
+    size_t k = 0;
+    bool ok = true, eq = true;
+    tok_init(&t, d, text, SIZE);
+    t0 = now_ms();
+    for (; tok_next(&t, &tk); k++) eq &= same(&tk, want, n, k, text);
+    ok = report("tok_next", eq, k, n, now_ms() - t0) && ok;
+
+    tok_init(&t, d, text, SIZE);
+    k = 0, eq = true;
+    t0 = now_ms();
+    for (size_t m; (m = tok_fill(&t, batch, 256));)
+        for (size_t i = 0; i < m; i++, k++) eq &= same(&batch[i], want, n, k, text);
+    ok = report("tok_fill", eq, k, n, now_ms() - t0) && ok;
+
+    // Chunks of 1..4096 bytes; tokens held across a chunk end come back
+    // as copies, so they are checked by their bytes.
+    TokStream s;
+    tok_stream_init(&s, d);
+    k = 0, eq = true;
+    t0 = now_ms();
+    for (size_t pos = 0, c; pos < SIZE; pos += c) {
+        c = next_rand() % 4096 + 1;
+        if (c > SIZE - pos) c = SIZE - pos;
+        tok_feed(&s, text + pos, c);
+        for (size_t m; (m = tok_stream_fill(&s, batch, 256));)
+            for (size_t i = 0; i < m; i++, k++) eq &= same(&batch[i], want, n, k, text);
+    }
+    for (; tok_finish(&s, &tk); k++) eq &= same(&tk, want, n, k, text);
+    ok = report("tok_stream", eq && !s.oom, k, n, now_ms() - t0) && ok;
+    tok_stream_free(&s);
+
+    free(text); free(copy); free(want);
+    return ok;
+}
+
+int main(void) {
+    TokDelims ws, punct, space;
+    tok_delims(&ws, " \t\r\n", 4);
+    tok_delims(&punct, " ,.;:!?()[]{}\"'-", 16);
+    tok_class(&space, isspace);
+
+    bool ok = run("4 delimiters (compare)", " \t\r\n", &ws);
+    ok = run("16 delimiters (nibble table)", " ,.;:!?()[]{}\"'-", &punct) && ok;
+    ok = run("isspace class", " \t\n\v\f\r", &space) && ok;
+    puts(ok ? "all tokens match strtok" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,73 @@
+// strbuf.c against strncat(buf, s, sizeof buf - strlen(buf) - 1) for
+// growing strings: the same text, and the time as the string gets longer.
+// gcc -std=c23 -O2 p24.c strbuf.c arena.c -o p24
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "strbuf.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *words[] = {"alpha", " ", "beta", ", ", "gamma-delta", "\n", "x"};
+#define NWORDS (sizeof words / sizeof *words)
+
+int main(void) {
+    bool ok = true;
+    printf("%10s %12s %12s %12s %12s\n", "appends", "strncat ms", "sb ms", "arena ms", "fmt ms");
+    for (size_t n = 1000; n <= 64000; n *= 4) {
+        size_t size = n * 12;
+        char *buf = malloc(size);
+        buf[0] = '\0';
+        double t0 = now_ms();
+        for (size_t i = 0; i < n; i++) strncat(buf, words[i % NWORDS], size - strlen(buf) - 1);
+        double t_cat = now_ms() - t0;
+
+        StrBuf sb;
+        sb_init(&sb);
+        t0 = now_ms();
+        for (size_t i = 0; i < n; i++) sb_puts(&sb, words[i % NWORDS]);
+        double t_sb = now_ms() - t0;
+        ok &= sb.len == strlen(buf) && memcmp(sb.p, buf, sb.len) == 0;
+        sb_free(&sb);
+
+        Arena a;
+        arena_init(&a, 0);
+        StrBuf sa;
+        sb_init_arena(&sa, &a);
+        t0 = now_ms();
+        for (size_t i = 0; i < n; i++) sb_puts(&sa, words[i % NWORDS]);
+        double t_arena = now_ms() - t0;
+        ok &= sa.len == strlen(buf) && memcmp(sa.p, buf, sa.len) == 0;
+        arena_free(&a);
+
+        sb_init(&sb);
+        t0 = now_ms();
+        for (size_t i = 0; i < n; i++) sb_append_fmt(&sb, "%s", words[i % NWORDS]);
+        double t_fmt = now_ms() - t0;
+        ok &= sb.len == strlen(buf) && memcmp(sb.p, buf, sb.len) == 0;
+        sb_free(&sb);
+
+        printf("%10zu %12.2f %12.2f %12.2f %12.2f\n", n, t_cat, t_sb, t_arena, t_fmt);
+        free(buf);
+    }
+
+    // Linear growth: ten times the appends take about ten times as long.
+    for (size_t n = 1000000; n <= 100000000; n *= 10) {
+        StrBuf sb;
+        sb_init(&sb);
+        double t0 = now_ms();
+        for (size_t i = 0; i < n; i++) sb_puts(&sb, words[i % NWORDS]);
+        double ms = now_ms() - t0;
+        printf("%10zu appends, %zu MB: %.1f ms, %.2f ns per append\n", n, sb.len >> 20, ms, ms * 1e6 / n);
+        ok &= !sb.oom;
+        sb_free(&sb);
+    }
+    puts(ok ? "all texts match strncat" : "MISMATCH");
+    return !ok;
+}
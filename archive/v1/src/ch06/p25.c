@@ -0,0 +1,180 @@
+// strsort.c against qsort + strcmp on 2M generated contact names: the
+// same order, stability, and the time with one thread and with all.
+// gcc -std=c23 -O2 -pthread p25.c strsort.c -o p25
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "strsort.h"
+
+#define N (2 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *last[] = {
+    "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller", "Davis",
+    "Rodriguez", "Martinez", "Hernandez", "Lopez", "Gonzalez", "Wilson", "Anderson",
+    "Thomas", "Taylor", "Moore", "Jackson", "Martin", "Lee", "Perez", "Thompson",
+    "White", "Harris", "Sanchez", "Clark", "Ramirez", "Lewis", "Robinson", "Walker",
+    "Young", "Allen", "King", "Wright", "Scott", "Torres", "Nguyen", "Hill", "Flores",
+    "Green", "Adams", "Nelson", "Baker", "Hall", "Rivera", "Campbell", "Mitchell",
+    "Carter", "Roberts", "Schmidt", "Schneider", "Fischer", "Weber", "Meyer", "Wagner",
+    "Becker", "Schulz", "Hoffmann", "Kowalski", "Nowak", "Wang", "Li", "Zhang", "Chen",
+    "Liu", "Yang", "Huang", "Zhao", "Wu", "Sato", "Suzuki", "Takahashi", "Tanaka",
+    "Watanabe", "Ito", "Yamamoto", "Nakamura", "Kobayashi", "Kim", "Park", "Choi",
+    "Jung", "Kang", "Cho", "Yoon", "Jang", "Lim", "Singh", "Kumar", "Sharma", "Patel",
+    "Gupta", "Khan", "Ali", "Silva", "Santos", "Oliveira", "Souza", "Pereira",
+};
+static const char *first[] = {
+    "James", "Mary", "Robert", "Patricia", "John", "Jennifer", "Michael", "Linda",
+    "David", "Elizabeth", "William", "Barbara", "Richard", "Susan", "Joseph", "Jessica",
+    "Thomas", "Sarah", "Charles", "Karen", "Christopher", "Lisa", "Daniel", "Nancy",
+    "Matthew", "Betty", "Anthony", "Margaret", "Mark", "Sandra", "Donald", "Ashley",
+    "Steven", "Kimberly", "Paul", "Emily", "Andrew", "Donna", "Joshua", "Michelle",
+    "Wei", "Fang", "Hiroshi", "Yuki", "Min-jun", "Seo-yeon", "Arjun", "Priya",
+    "Lukas", "Anna", "Jan", "Maria", "Mohammed", "Fatima", "Joao", "Ana",
+};
+#define COUNT(a) (sizeof a / sizeof *a)
+
+// Roughly Zipf: index min(i, j) of two uniform draws favours the front.
+static size_t pick(size_t n) {
+    size_t i = next_rand() % n, j = next_rand() % n;
+    return i < j ? i : j;
+}
+
+// "Last, First M." with a middle initial on half of them, and sometimes
+// a number as a duplicate contact would get. mixed: random letter case.
+static const char **make_names(bool mixed) {
+    const char **s = malloc(N * sizeof *s);
+    char buf[96];
+    for (size_t i = 0; i < N; i++) {
+        int len = snprintf(buf, sizeof buf, "%s, %s", last[pick(COUNT(last))], first[pick(COUNT(first))]);
+        unsigned long long r = next_rand();
+        if (r & 1) len += snprintf(buf + len, sizeof buf - len, " %c.", (char)('A' + (r >> 8) % 26));
+        if ((r >> 16) % 8 == 0) len += snprintf(buf + len, sizeof buf - len, " %llu", (r >> 24) % 1000);
+        if (mixed)
+            for (int k = 0; k < len; k++)
+                if ((r >> (k % 60)) & 1 && buf[k] >= 'a' && buf[k] <= 'z') buf[k] -= 32;
+        s[i] = strdup(buf);
+    }
+    return s;
+}
+
+static int cmp_str(const void *a, const void *b) { return strcmp(*(char *const *)a, *(char *const *)b); }
+static int cmp_case(const void *a, const void *b) { return strcasecmp(*(char *const *)a, *(char *const *)b); }
+
+// Sorted, a permutation of the input (same multiset of pointers), and
+// for stable sorts equal names in input order (pos: input index by rank).
+static const char **input;
+static size_t *rank_of;
+static int cmp_ptr(const void *a, const void *b) {
+    const char *x = *(const char *const *)a, *y = *(const char *const *)b;
+    return (x > y) - (x < y);
+}
+
+static bool check(const char **s, const char **by_ptr, bool nocase, bool stable) {
+    for (size_t i = 1; i < N; i++) {
+        int c = nocase ? strcasecmp(s[i - 1], s[i]) : strcmp(s[i - 1], s[i]);
+        if (c > 0) return false;
+        if (stable && c == 0) {
+            const char **x = bsearch(&s[i - 1], by_ptr, N, sizeof *by_ptr, cmp_ptr);
+            const char **y = bsearch(&s[i], by_ptr, N, sizeof *by_ptr, cmp_ptr);
+            if (!x || !y || rank_of[x - by_ptr] > rank_of[y - by_ptr]) return false;
+        }
+    }
+    return true;
+}
+
+static bool run(const char *title, bool mixed) {
+    input = make_names(mixed);
+    const char **s = malloc(N * sizeof *s), **by_ptr = malloc(N * sizeof *by_ptr);
+    rank_of = malloc(N * sizeof *rank_of);
+    // by_ptr: the input pointers in address order, rank_of: their input index.
+    memcpy(by_ptr, input, N * sizeof *s);
+    qsort(by_ptr, N, sizeof *by_ptr, cmp_ptr);
+    for (size_t i = 0; i < N; i++) {
+        const char **p = bsearch(&input[i], by_ptr, N, sizeof *by_ptr, cmp_ptr);
+        rank_of[p - by_ptr] = i;
+    }
+
+    printf("%s, %d names\n", title, N);
+    bool ok = true;
+    unsigned nocase = mixed ? STRSORT_NOCASE : 0;
+    memcpy(s, input, N * sizeof *s);
+    double t0 = now_ms();
+    qsort(s, N, sizeof *s, mixed ? cmp_case : cmp_str);
+    double t_q = now_ms() - t0;
+    printf("  %-26s %8.1f ms\n", mixed ? "qsort + strcasecmp" : "qsort + strcmp", t_q);
+
+    struct { const char *name; unsigned flags; int threads; } v[] = {
+        {"strsort, 1 thread", nocase, 1},
+        {"strsort, all threads", nocase, 0},
+        {"strsort stable, 1 thread", nocase | STRSORT_STABLE, 1},
+    };
+    for (size_t k = 0; k < COUNT(v); k++) {
+        memcpy(s, input, N * sizeof *s);
+        strsort_set_threads(v[k].threads);
+        t0 = now_ms();
+        if (!strsort(s, N, v[k].flags)) { perror("strsort"); exit(1); }
+        double ms = now_ms() - t0;
+        bool good = check(s, by_ptr, mixed, v[k].flags & STRSORT_STABLE);
+        ok &= good;
+        printf("  %-26s %8.1f ms  %4.1fx%s\n", v[k].name, ms, t_q / ms, good ? "" : "  WRONG ORDER");
+    }
+
+    for (size_t i = 0; i < N; i++) free((char *)input[i]);
+    free(input); free(s); free(by_ptr); free(rank_of);
+    return ok;
+}
+
+// DEEP strings "a...ab" with 1 to DEEP a's, shuffled: every byte is one
+// more pass over nearly all of them, which must not nest a call per byte.
+#define DEEP 3000
+
+static bool deep(void) {
+    const char **s = malloc(DEEP * sizeof *s), **want = malloc(DEEP * sizeof *want);
+    for (size_t i = 0; i < DEEP; i++) {
+        char *p = malloc(i + 3);
+        memset(p, 'a', i + 1);
+        p[i + 1] = 'b';
+        p[i + 2] = '\0';
+        s[i] = p;
+    }
+    for (size_t i = DEEP - 1; i > 0; i--) {
+        size_t j = next_rand() % (i + 1);
+        const char *t = s[i]; s[i] = s[j]; s[j] = t;
+    }
+    memcpy(want, s, DEEP * sizeof *s);
+    qsort(want, DEEP, sizeof *want, cmp_str);
+    bool ok = true;
+    for (unsigned flags = 0; flags <= STRSORT_STABLE; flags += STRSORT_STABLE) {
+        const char **t = malloc(DEEP * sizeof *t);
+        memcpy(t, s, DEEP * sizeof *s);
+        ok &= strsort(t, DEEP, flags) && memcmp(t, want, DEEP * sizeof *t) == 0;
+        free(t);
+    }
+    printf("%d strings sharing prefixes of up to %d bytes: %s\n", DEEP, DEEP, ok ? "ok" : "WRONG ORDER");
+    for (size_t i = 0; i < DEEP; i++) free((char *)s[i]);
+    free(s); free(want);
+    return ok;
+}
+
+int main(void) {
+    bool ok = deep();
+    ok = run("case-sensitive", false) && ok;
+    ok = run("mixed case, STRSORT_NOCASE", true) && ok;
+    puts(ok ? "all orders checked" : "MISMATCH");
+    return !ok;
+}
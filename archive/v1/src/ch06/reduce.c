@@ -0,0 +1,540 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "reduce.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+#define MAX_PARTS 64
+
+typedef unsigned long long ull;
+
+// ---- scalar kernels ----------------------------------------------------
+// Four independent accumulators break the loop-carried add chain, and
+// unsigned integer accumulators make wrap-around well defined.
+
+#define DEFINE_SUMS_SCALAR(sfx, T, ACC, R) \
+static R sum_##sfx##_scalar(const T *a, size_t n) { \
+    ACC s0 = 0, s1 = 0, s2 = 0, s3 = 0; \
+    size_t i = 0; \
+    for (; i + 4 <= n; i += 4) { \
+        s0 += (ACC)a[i]; s1 += (ACC)a[i+1]; s2 += (ACC)a[i+2]; s3 += (ACC)a[i+3]; \
+    } \
+    for (; i < n; i++) s0 += (ACC)a[i]; \
+    return (R)((s0 + s1) + (s2 + s3)); \
+} \
+static R sumsq_##sfx##_scalar(const T *a, size_t n) { \
+    ACC s0 = 0, s1 = 0, s2 = 0, s3 = 0; \
+    size_t i = 0; \
+    for (; i + 4 <= n; i += 4) { \
+        s0 += (ACC)a[i]   * (ACC)a[i];   s1 += (ACC)a[i+1] * (ACC)a[i+1]; \
+        s2 += (ACC)a[i+2] * (ACC)a[i+2]; s3 += (ACC)a[i+3] * (ACC)a[i+3]; \
+    } \
+    for (; i < n; i++) s0 += (ACC)a[i] * (ACC)a[i]; \
+    return (R)((s0 + s1) + (s2 + s3)); \
+}
+
+// Serial arg kernels assume n >= 1. Finding the value first keeps that
+// loop free of index bookkeeping, so the compiler can vectorize it.
+#define DEFINE_ARGS_SCALAR(sfx, T) \
+static size_t argmin_##sfx##_scalar(const T *a, size_t n) { \
+    T best = a[0]; \
+    for (size_t i = 1; i < n; i++) best = a[i] < best ? a[i] : best; \
+    for (size_t i = 0; i < n; i++) if (a[i] == best) return i; \
+    return 0; \
+} \
+static size_t argmax_##sfx##_scalar(const T *a, size_t n) { \
+    T best = a[0]; \
+    for (size_t i = 1; i < n; i++) best = a[i] > best ? a[i] : best; \
+    for (size_t i = 0; i < n; i++) if (a[i] == best) return i; \
+    return 0; \
+}
+
+// Scans carry a running total in and return it; in may equal out.
+#define DEFINE_SCAN_SCALAR(sfx, T, ACC) \
+static T scan_##sfx##_scalar(const T *in, T *out, size_t n, T carry, int excl) { \
+    ACC s = (ACC)carry; \
+    for (size_t i = 0; i < n; i++) { \
+        ACC v = (ACC)in[i]; \
+        out[i] = (T)(excl ? s : s + v); \
+        s += v; \
+    } \
+    return (T)s; \
+}
+
+DEFINE_SUMS_SCALAR(i32, int, ull, long long)
+DEFINE_SUMS_SCALAR(i64, long long, ull, long long)
+DEFINE_SUMS_SCALAR(f64, double, double, double)
+DEFINE_ARGS_SCALAR(i32, int)
+DEFINE_ARGS_SCALAR(i64, long long)
+DEFINE_ARGS_SCALAR(f64, double)
+DEFINE_SCAN_SCALAR(i32, int, unsigned)
+DEFINE_SCAN_SCALAR(i64, long long, ull)
+DEFINE_SCAN_SCALAR(f64, double, double)
+
+// Integer counts handle EQ, LT, GT and EVEN; the public wrapper counts
+// NE, GE, LE and ODD as the complement.
+// 32-bit block counters vectorize better than a size_t running count.
+#define COUNT_BLOCKS(test) \
+    for (size_t i = 0; i < n;) { \
+        size_t stop = n - i > ((size_t)1 << 30) ? i + ((size_t)1 << 30) : n; \
+        unsigned b = 0; \
+        for (; i < stop; i++) b += (test); \
+        c += b; \
+    }
+
+#define DEFINE_COUNT_SCALAR(sfx, T) \
+static size_t count_##sfx##_scalar(const T *a, size_t n, Pred p, T k) { \
+    size_t c = 0; \
+    switch (p) { \
+    case PRED_EQ: COUNT_BLOCKS(a[i] == k) break; \
+    case PRED_LT: COUNT_BLOCKS(a[i] < k) break; \
+    case PRED_GT: COUNT_BLOCKS(a[i] > k) break; \
+    default:      COUNT_BLOCKS((a[i] & 1) == 0) break; \
+    } \
+    return c; \
+}
+DEFINE_COUNT_SCALAR(i32, int)
+DEFINE_COUNT_SCALAR(i64, long long)
+
+// Doubles get every comparison directly: with NaNs, LE is not "not GT".
+static size_t count_f64_scalar(const double *a, size_t n, Pred p, double k) {
+    size_t c = 0;
+    switch (p) {
+    case PRED_EQ: COUNT_BLOCKS(a[i] == k) break;
+    case PRED_NE: COUNT_BLOCKS(a[i] != k) break;
+    case PRED_LT: COUNT_BLOCKS(a[i] < k) break;
+    case PRED_LE: COUNT_BLOCKS(a[i] <= k) break;
+    case PRED_GT: COUNT_BLOCKS(a[i] > k) break;
+    case PRED_GE: COUNT_BLOCKS(a[i] >= k) break;
+    default: break;
+    }
+    return c;
+}
+
+// ---- AVX2 kernels --------------------------------------------------------
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+static ull hsum_epi64(__m256i v) {
+    ull t[4];
+    _mm256_storeu_si256((__m256i *)t, v);
+    return t[0] + t[1] + t[2] + t[3];
+}
+static double hsum_pd(__m256d v) {
+    double t[4];
+    _mm256_storeu_pd(t, v);
+    return (t[0] + t[1]) + (t[2] + t[3]);
+}
+
+static long long sum_i32_avx2(const int *a, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(a + i + 8));
+        s0 = _mm256_add_epi64(s0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v0)));
+        s1 = _mm256_add_epi64(s1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v0, 1)));
+        s2 = _mm256_add_epi64(s2, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v1)));
+        s3 = _mm256_add_epi64(s3, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v1, 1)));
+    }
+    __m256i s = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+    return (long long)(hsum_epi64(s) + (ull)sum_i32_scalar(a + i, n - i));
+}
+
+// mul_epi32 squares the even lanes into 64 bits; shifting right by 32
+// brings the odd lanes down to be squared too.
+static long long sumsq_i32_avx2(const int *a, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(a + i + 8));
+        __m256i o0 = _mm256_srli_epi64(v0, 32), o1 = _mm256_srli_epi64(v1, 32);
+        s0 = _mm256_add_epi64(s0, _mm256_mul_epi32(v0, v0));
+        s1 = _mm256_add_epi64(s1, _mm256_mul_epi32(o0, o0));
+        s2 = _mm256_add_epi64(s2, _mm256_mul_epi32(v1, v1));
+        s3 = _mm256_add_epi64(s3, _mm256_mul_epi32(o1, o1));
+    }
+    __m256i s = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+    return (long long)(hsum_epi64(s) + (ull)sumsq_i32_scalar(a + i, n - i));
+}
+
+static long long sum_i64_avx2(const long long *a, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_epi64(s0, _mm256_loadu_si256((const __m256i *)(a + i)));
+        s1 = _mm256_add_epi64(s1, _mm256_loadu_si256((const __m256i *)(a + i + 4)));
+        s2 = _mm256_add_epi64(s2, _mm256_loadu_si256((const __m256i *)(a + i + 8)));
+        s3 = _mm256_add_epi64(s3, _mm256_loadu_si256((const __m256i *)(a + i + 12)));
+    }
+    __m256i s = _mm256_add_epi64(_mm256_add_epi64(s0, s1), _mm256_add_epi64(s2, s3));
+    return (long long)(hsum_epi64(s) + (ull)sum_i64_scalar(a + i, n - i));
+}
+
+static double sum_f64_avx2(const double *a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_loadu_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_loadu_pd(a + i + 12));
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    return hsum_pd(s) + sum_f64_scalar(a + i, n - i);
+}
+
+static double sumsq_f64_avx2(const double *a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d v0 = _mm256_loadu_pd(a + i),     v1 = _mm256_loadu_pd(a + i + 4);
+        __m256d v2 = _mm256_loadu_pd(a + i + 8), v3 = _mm256_loadu_pd(a + i + 12);
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(v0, v0));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(v1, v1));
+        s2 = _mm256_add_pd(s2, _mm256_mul_pd(v2, v2));
+        s3 = _mm256_add_pd(s3, _mm256_mul_pd(v3, v3));
+    }
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    return hsum_pd(s) + sumsq_f64_scalar(a + i, n - i);
+}
+
+// Arg kernels make two passes: a branch-free min/max over the data, then
+// a compare-and-movemask scan for the first lane holding that value.
+#define DEFINE_ARG_I32_AVX2(name, vop, better) \
+static size_t name##_i32_avx2(const int *a, size_t n) { \
+    if (n < 16) return name##_i32_scalar(a, n); \
+    __m256i m0 = _mm256_loadu_si256((const __m256i *)a); \
+    __m256i m1 = _mm256_loadu_si256((const __m256i *)(a + 8)); \
+    size_t i = 16; \
+    for (; i + 16 <= n; i += 16) { \
+        m0 = vop(m0, _mm256_loadu_si256((const __m256i *)(a + i))); \
+        m1 = vop(m1, _mm256_loadu_si256((const __m256i *)(a + i + 8))); \
+    } \
+    int t[8]; \
+    _mm256_storeu_si256((__m256i *)t, vop(m0, m1)); \
+    int best = t[0]; \
+    for (int j = 1; j < 8; j++) if (t[j] better best) best = t[j]; \
+    for (; i < n; i++) if (a[i] better best) best = a[i]; \
+    __m256i b = _mm256_set1_epi32(best); \
+    for (i = 0; i + 8 <= n; i += 8) { \
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(a + i)), b); \
+        int m = _mm256_movemask_ps(_mm256_castsi256_ps(eq)); \
+        if (m) return i + (size_t)__builtin_ctz(m); \
+    } \
+    while (a[i] != best) i++; \
+    return i; \
+}
+DEFINE_ARG_I32_AVX2(argmin, _mm256_min_epi32, <)
+DEFINE_ARG_I32_AVX2(argmax, _mm256_max_epi32, >)
+
+#define DEFINE_ARG_F64_AVX2(name, vop, better) \
+static size_t name##_f64_avx2(const double *a, size_t n) { \
+    if (n < 8) return name##_f64_scalar(a, n); \
+    __m256d m0 = _mm256_loadu_pd(a), m1 = _mm256_loadu_pd(a + 4); \
+    size_t i = 8; \
+    for (; i + 8 <= n; i += 8) { \
+        m0 = vop(m0, _mm256_loadu_pd(a + i)); \
+        m1 = vop(m1, _mm256_loadu_pd(a + i + 4)); \
+    } \
+    double t[4]; \
+    _mm256_storeu_pd(t, vop(m0, m1)); \
+    double best = t[0]; \
+    for (int j = 1; j < 4; j++) if (t[j] better best) best = t[j]; \
+    for (; i < n; i++) if (a[i] better best) best = a[i]; \
+    __m256d b = _mm256_set1_pd(best); \
+    for (i = 0; i + 4 <= n; i += 4) { \
+        int m = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(a + i), b, _CMP_EQ_OQ)); \
+        if (m) return i + (size_t)__builtin_ctz(m); \
+    } \
+    for (; i < n; i++) if (a[i] == best) return i; \
+    return name##_f64_scalar(a, n);   /* only reachable with NaNs */ \
+}
+DEFINE_ARG_F64_AVX2(argmin, _mm256_min_pd, <)
+DEFINE_ARG_F64_AVX2(argmax, _mm256_max_pd, >)
+
+// Compare masks are -1 per matching lane, so subtracting them counts.
+// Lane totals are flushed before they could reach 2^31.
+#define COUNT_LOOP(mask_expr) \
+    while (i + 8 <= n) { \
+        __m256i acc = _mm256_setzero_si256(); \
+        size_t stop = n - i > ((size_t)1 << 30) ? i + ((size_t)1 << 30) : n; \
+        for (; i + 8 <= stop; i += 8) { \
+            __m256i v = _mm256_loadu_si256((const __m256i *)(a + i)); \
+            acc = _mm256_sub_epi32(acc, mask_expr); \
+        } \
+        int t[8]; \
+        _mm256_storeu_si256((__m256i *)t, acc); \
+        for (int j = 0; j < 8; j++) c += (unsigned)t[j]; \
+    }
+
+static size_t count_i32_avx2(const int *a, size_t n, Pred p, int k) {
+    __m256i kv = _mm256_set1_epi32(k), one = _mm256_set1_epi32(1), zero = _mm256_setzero_si256();
+    size_t c = 0, i = 0;
+    switch (p) {
+    case PRED_EQ: COUNT_LOOP(_mm256_cmpeq_epi32(v, kv)) break;
+    case PRED_LT: COUNT_LOOP(_mm256_cmpgt_epi32(kv, v)) break;
+    case PRED_GT: COUNT_LOOP(_mm256_cmpgt_epi32(v, kv)) break;
+    default:      COUNT_LOOP(_mm256_cmpeq_epi32(_mm256_and_si256(v, one), zero)) break;
+    }
+    return c + count_i32_scalar(a + i, n - i, p, k);
+}
+
+// In-register scan: log-step shifts within each 128-bit half, then the
+// low half's total is added to the high half, then the running carry.
+static int scan_i32_avx2(const int *in, int *out, size_t n, int carry, int excl) {
+    __m256i c = _mm256_set1_epi32(carry), last = _mm256_set1_epi32(7);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i)), x = v;
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        x = _mm256_add_epi32(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08),
+                                                     _MM_SHUFFLE(3,3,3,3)));
+        x = _mm256_add_epi32(x, c);
+        c = _mm256_permutevar8x32_epi32(x, last);
+        _mm256_storeu_si256((__m256i *)(out + i), excl ? _mm256_sub_epi32(x, v) : x);
+    }
+    return scan_i32_scalar(in + i, out + i, n - i, _mm256_cvtsi256_si32(c), excl);
+}
+
+static long long scan_i64_avx2(const long long *in, long long *out, size_t n, long long carry, int excl) {
+    __m256i c = _mm256_set1_epi64x(carry);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i)), x = v;
+        x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+        x = _mm256_add_epi64(x, _mm256_shuffle_epi32(_mm256_permute2x128_si256(x, x, 0x08),
+                                                     _MM_SHUFFLE(3,2,3,2)));
+        x = _mm256_add_epi64(x, c);
+        c = _mm256_permute4x64_epi64(x, 0xFF);
+        _mm256_storeu_si256((__m256i *)(out + i), excl ? _mm256_sub_epi64(x, v) : x);
+    }
+    long long t[4];
+    _mm256_storeu_si256((__m256i *)t, c);
+    return scan_i64_scalar(in + i, out + i, n - i, t[0], excl);
+}
+
+#pragma GCC pop_options
+#endif
+
+// ---- kernel choice -------------------------------------------------------
+
+static int use_avx2;
+
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar or sse2
+// keeps the scalar path.
+__attribute__((constructor))
+static void pick_kernels(void) {
+#ifdef HAVE_X86
+    use_avx2 = cpu_isa() >= ISA_AVX2;
+#endif
+}
+
+#ifdef HAVE_X86
+#define PICK(fn, ...) (use_avx2 ? fn##_avx2(__VA_ARGS__) : fn##_scalar(__VA_ARGS__))
+#else
+#define PICK(fn, ...) fn##_scalar(__VA_ARGS__)
+#endif
+
+static long long sum_i32_one(const int *a, size_t n)         { return PICK(sum_i32, a, n); }
+static long long sum_i64_one(const long long *a, size_t n)   { return PICK(sum_i64, a, n); }
+static double    sum_f64_one(const double *a, size_t n)      { return PICK(sum_f64, a, n); }
+static long long sumsq_i32_one(const int *a, size_t n)       { return PICK(sumsq_i32, a, n); }
+static long long sumsq_i64_one(const long long *a, size_t n) { return sumsq_i64_scalar(a, n); }
+static double    sumsq_f64_one(const double *a, size_t n)    { return PICK(sumsq_f64, a, n); }
+static size_t argmin_i32_one(const int *a, size_t n)         { return PICK(argmin_i32, a, n); }
+static size_t argmax_i32_one(const int *a, size_t n)         { return PICK(argmax_i32, a, n); }
+static size_t argmin_i64_one(const long long *a, size_t n)   { return argmin_i64_scalar(a, n); }
+static size_t argmax_i64_one(const long long *a, size_t n)   { return argmax_i64_scalar(a, n); }
+static size_t argmin_f64_one(const double *a, size_t n)      { return PICK(argmin_f64, a, n); }
+static size_t argmax_f64_one(const double *a, size_t n)      { return PICK(argmax_f64, a, n); }
+static size_t count_i32_one(const int *a, size_t n, Pred p, int k) { return PICK(count_i32, a, n, p, k); }
+static size_t count_i64_one(const long long *a, size_t n, Pred p, long long k) { return count_i64_scalar(a, n, p, k); }
+static size_t count_f64_one(const double *a, size_t n, Pred p, double k) { return count_f64_scalar(a, n, p, k); }
+static int scan_i32_one(const int *in, int *out, size_t n, int c, int excl) { return PICK(scan_i32, in, out, n, c, excl); }
+static long long scan_i64_one(const long long *in, long long *out, size_t n, long long c, int excl) { return PICK(scan_i64, in, out, n, c, excl); }
+static double scan_f64_one(const double *in, double *out, size_t n, double c, int excl) { return scan_f64_scalar(in, out, n, c, excl); }
+
+// ---- threading -----------------------------------------------------------
+
+static int thread_setting = 0;
+
+void reduce_set_threads(int n) { thread_setting = n; }
+
+// Large arrays get one part per thread, but never parts so small that
+// starting a thread costs more than the work it saves.
+static int part_count(size_t n) {
+    if (n < REDUCE_MT_MIN) return 1;
+    long t = thread_setting > 0 ? thread_setting : sysconf(_SC_NPROCESSORS_ONLN);
+    size_t most = n / (REDUCE_MT_MIN / 2);
+    if (t < 1) t = 1;
+    if (t > MAX_PARTS) t = MAX_PARTS;
+    if ((size_t)t > most) t = (long)most;
+    return (int)t;
+}
+
+typedef void (*part_fn)(void *ctx, size_t lo, size_t hi, int k);
+typedef struct { part_fn fn; void *ctx; size_t lo, hi; int k; } PartJob;
+
+static void *part_main(void *arg) {
+    PartJob *j = arg;
+    j->fn(j->ctx, j->lo, j->hi, j->k);
+    return NULL;
+}
+
+// Split [0, n) into contiguous parts; part 0 runs on the calling thread,
+// and a part whose thread cannot be started runs inline instead.
+static void run_parts(size_t n, int parts, part_fn fn, void *ctx) {
+    PartJob job[MAX_PARTS];
+    pthread_t tid[MAX_PARTS];
+    int started[MAX_PARTS] = {0};
+    size_t step = n / (size_t)parts;
+    for (int k = 0; k < parts; k++)
+        job[k] = (PartJob){fn, ctx, step * (size_t)k, k == parts - 1 ? n : step * (size_t)(k + 1), k};
+    for (int k = 1; k < parts; k++) {
+        started[k] = pthread_create(&tid[k], NULL, part_main, &job[k]) == 0;
+        if (!started[k]) part_main(&job[k]);
+    }
+    part_main(&job[0]);
+    for (int k = 1; k < parts; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+}
+
+// ---- public entry points -------------------------------------------------
+
+#define WRAP_ADD(x, y) (long long)((ull)(x) + (ull)(y))
+#define F64_ADD(x, y)  ((x) + (y))
+
+#define DEFINE_REDUCE(name, T, R, COMBINE) \
+typedef struct { const T *a; R part[MAX_PARTS]; } name##_ctx; \
+static void name##_part(void *c, size_t lo, size_t hi, int k) { \
+    name##_ctx *x = c; \
+    x->part[k] = name##_one(x->a + lo, hi - lo); \
+} \
+R name(const T *a, size_t n) { \
+    int parts = part_count(n); \
+    if (parts == 1) return name##_one(a, n); \
+    name##_ctx x = {.a = a}; \
+    run_parts(n, parts, name##_part, &x); \
+    R r = x.part[0]; \
+    for (int k = 1; k < parts; k++) r = COMBINE(r, x.part[k]); \
+    return r; \
+}
+
+DEFINE_REDUCE(sum_i32, int, long long, WRAP_ADD)
+DEFINE_REDUCE(sum_i64, long long, long long, WRAP_ADD)
+DEFINE_REDUCE(sum_f64, double, double, F64_ADD)
+DEFINE_REDUCE(sumsq_i32, int, long long, WRAP_ADD)
+DEFINE_REDUCE(sumsq_i64, long long, long long, WRAP_ADD)
+DEFINE_REDUCE(sumsq_f64, double, double, F64_ADD)
+
+// Parts are in order, so keeping the earlier winner on ties keeps the
+// first index overall.
+#define DEFINE_ARG(name, T, better) \
+typedef struct { const T *a; size_t part[MAX_PARTS]; } name##_ctx; \
+static void name##_part(void *c, size_t lo, size_t hi, int k) { \
+    name##_ctx *x = c; \
+    x->part[k] = lo + name##_one(x->a + lo, hi - lo); \
+} \
+size_t name(const T *a, size_t n) { \
+    if (n == 0) return (size_t)-1; \
+    int parts = part_count(n); \
+    if (parts == 1) return name##_one(a, n); \
+    name##_ctx x = {.a = a}; \
+    run_parts(n, parts, name##_part, &x); \
+    size_t b = x.part[0]; \
+    for (int k = 1; k < parts; k++) if (a[x.part[k]] better a[b]) b = x.part[k]; \
+    return b; \
+}
+
+DEFINE_ARG(argmin_i32, int, <)
+DEFINE_ARG(argmax_i32, int, >)
+DEFINE_ARG(argmin_i64, long long, <)
+DEFINE_ARG(argmax_i64, long long, >)
+DEFINE_ARG(argmin_f64, double, <)
+DEFINE_ARG(argmax_f64, double, >)
+
+#define DEFINE_COUNT(name, one, T) \
+typedef struct { const T *a; Pred p; T k; size_t part[MAX_PARTS]; } name##_ctx; \
+static void name##_part(void *c, size_t lo, size_t hi, int k) { \
+    name##_ctx *x = c; \
+    x->part[k] = one(x->a + lo, hi - lo, x->p, x->k); \
+} \
+static size_t name(const T *a, size_t n, Pred p, T k) { \
+    int parts = part_count(n); \
+    if (parts == 1) return one(a, n, p, k); \
+    name##_ctx x = {.a = a, .p = p, .k = k}; \
+    run_parts(n, parts, name##_part, &x); \
+    size_t c = 0; \
+    for (int j = 0; j < parts; j++) c += x.part[j]; \
+    return c; \
+}
+
+DEFINE_COUNT(count_i32, count_i32_one, int)
+DEFINE_COUNT(count_i64, count_i64_one, long long)
+DEFINE_COUNT(count_f64, count_f64_one, double)
+
+// Integer NE/LE/GE/ODD are counted as n minus EQ/GT/LT/EVEN.
+static int complement(Pred *p) {
+    switch (*p) {
+    case PRED_NE:  *p = PRED_EQ;   return 1;
+    case PRED_LE:  *p = PRED_GT;   return 1;
+    case PRED_GE:  *p = PRED_LT;   return 1;
+    case PRED_ODD: *p = PRED_EVEN; return 1;
+    default: return 0;
+    }
+}
+
+size_t count_if_i32(const int *a, size_t n, Pred p, int k) {
+    int inv = complement(&p);
+    size_t c = count_i32(a, n, p, k);
+    return inv ? n - c : c;
+}
+size_t count_if_i64(const long long *a, size_t n, Pred p, long long k) {
+    int inv = complement(&p);
+    size_t c = count_i64(a, n, p, k);
+    return inv ? n - c : c;
+}
+size_t count_if_f64(const double *a, size_t n, Pred p, double k) { return count_f64(a, n, p, k); }
+
+// Threaded scans take two passes: each part sums its slice, the part
+// totals are scanned serially into offsets, then each part scans its
+// slice starting from its offset.
+#define I32_ADD(x, y) (int)((unsigned)(x) + (unsigned)(y))
+
+#define DEFINE_SCAN(name, one, sum, T, ADD, EXCL) \
+typedef struct { const T *in; T *out; T off[MAX_PARTS]; } name##_ctx; \
+static void name##_sum(void *c, size_t lo, size_t hi, int k) { \
+    name##_ctx *x = c; \
+    x->off[k] = (T)sum(x->in + lo, hi - lo); \
+} \
+static void name##_scan(void *c, size_t lo, size_t hi, int k) { \
+    name##_ctx *x = c; \
+    one(x->in + lo, x->out + lo, hi - lo, x->off[k], EXCL); \
+} \
+void name(const T *in, T *out, size_t n) { \
+    int parts = part_count(n); \
+    if (parts == 1) { one(in, out, n, 0, EXCL); return; } \
+    name##_ctx x = {.in = in, .out = out}; \
+    run_parts(n, parts, name##_sum, &x); \
+    T carry = 0; \
+    for (int k = 0; k < parts; k++) { T s = x.off[k]; x.off[k] = carry; carry = ADD(carry, s); } \
+    run_parts(n, parts, name##_scan, &x); \
+}
+
+DEFINE_SCAN(scan_incl_i32, scan_i32_one, sum_i32_one, int, I32_ADD, 0)
+DEFINE_SCAN(scan_excl_i32, scan_i32_one, sum_i32_one, int, I32_ADD, 1)
+DEFINE_SCAN(scan_incl_i64, scan_i64_one, sum_i64_one, long long, WRAP_ADD, 0)
+DEFINE_SCAN(scan_excl_i64, scan_i64_one, sum_i64_one, long long, WRAP_ADD, 1)
+DEFINE_SCAN(scan_incl_f64, scan_f64_one, sum_f64_one, double, F64_ADD, 0)
+DEFINE_SCAN(scan_excl_f64, scan_f64_one, sum_f64_one, double, F64_ADD, 1)
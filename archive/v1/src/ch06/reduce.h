@@ -0,0 +1,49 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <stddef.h>
+
+// Arrays with at least this many elements are split across threads.
+#define REDUCE_MT_MIN ((size_t)1 << 18)
+
+// 0 (the default) means one thread per online CPU; 1 never spawns threads.
+void reduce_set_threads(int n);
+
+// Integer sums wrap on overflow. Floating-point sums use several
+// accumulators, so the last bits can differ from a left-to-right loop.
+long long sum_i32(const int *a, size_t n);
+long long sum_i64(const long long *a, size_t n);
+double    sum_f64(const double *a, size_t n);
+
+long long sumsq_i32(const int *a, size_t n);
+long long sumsq_i64(const long long *a, size_t n);
+double    sumsq_f64(const double *a, size_t n);
+
+// Index of the first smallest/largest element, (size_t)-1 when n == 0.
+// NaNs in the f64 versions give an unspecified index.
+size_t argmin_i32(const int *a, size_t n);
+size_t argmax_i32(const int *a, size_t n);
+size_t argmin_i64(const long long *a, size_t n);
+size_t argmax_i64(const long long *a, size_t n);
+size_t argmin_f64(const double *a, size_t n);
+size_t argmax_f64(const double *a, size_t n);
+
+// Count elements x with `x op k`. EVEN and ODD ignore k and only make
+// sense for integers; count_if_f64 counts nothing for them.
+typedef enum { PRED_EQ, PRED_NE, PRED_LT, PRED_LE, PRED_GT, PRED_GE, PRED_EVEN, PRED_ODD } Pred;
+size_t count_if_i32(const int *a, size_t n, Pred p, int k);
+size_t count_if_i64(const long long *a, size_t n, Pred p, long long k);
+size_t count_if_f64(const double *a, size_t n, Pred p, double k);
+
+// Prefix sums. Inclusive: out[i] = in[0] + ... + in[i].
+// Exclusive: out[0] = 0, out[i] = in[0] + ... + in[i-1].
+// out may be the same array as in; integer scans wrap on overflow.
+// Threaded f64 scans add per-part offsets, so the last bits can differ.
+void scan_incl_i32(const int *in, int *out, size_t n);
+void scan_excl_i32(const int *in, int *out, size_t n);
+void scan_incl_i64(const long long *in, long long *out, size_t n);
+void scan_excl_i64(const long long *in, long long *out, size_t n);
+void scan_incl_f64(const double *in, double *out, size_t n);
+void scan_excl_f64(const double *in, double *out, size_t n);
+
+#endif
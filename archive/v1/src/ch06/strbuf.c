@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "strbuf.h"
+
+void sb_init(StrBuf *sb) { sb_init_arena(sb, NULL); }
+
+void sb_init_arena(StrBuf *sb, Arena *a) {
+    sb->p = sb->small;
+    sb->p[0] = '\0';
+    sb->len = 0;
+    sb->cap = SB_INLINE - 1;
+    sb->arena = a;
+    sb->oom = false;
+}
+
+void sb_free(StrBuf *sb) {
+    if (sb->p != sb->small && !sb->arena) free(sb->p);
+    sb_init_arena(sb, sb->arena);
+}
+
+void sb_clear(StrBuf *sb) {
+    sb->len = 0;
+    sb->p[0] = '\0';
+    sb->oom = false;
+}
+
+// Doubling, so appends are amortized O(1) per byte.
+bool sb_reserve(StrBuf *sb, size_t n) {
+    if (sb->oom) return false;
+    if (n <= sb->cap - sb->len) return true;
+    if (n > SIZE_MAX / 2 - sb->len) { sb->oom = true; return false; }
+    size_t cap = sb->cap * 2 + 1;
+    while (cap - 1 < sb->len + n) cap *= 2;
+    char *q;
+    if (sb->arena)
+        q = arena_grow(sb->arena, sb->p == sb->small ? NULL : sb->p, sb->len + 1, cap);
+    else
+        q = realloc(sb->p == sb->small ? NULL : sb->p, cap);
+    if (!q) { sb->oom = true; return false; }
+    if (sb->p == sb->small) memcpy(q, sb->small, sb->len + 1);
+    sb->p = q;
+    sb->cap = cap - 1;
+    return true;
+}
+
+bool sb_append_slow(StrBuf *sb, const char *s, size_t n) {
+    if (!sb_reserve(sb, n)) return false;
+    memcpy(sb->p + sb->len, s, n);
+    sb->len += n;
+    sb->p[sb->len] = '\0';
+    return true;
+}
+
+// Straight into the spare room; only output that does not fit is
+// formatted a second time.
+bool sb_append_vfmt(StrBuf *sb, const char *fmt, va_list ap) {
+    if (sb->oom) return false;
+    va_list again;
+    va_copy(again, ap);
+    int n = vsnprintf(sb->p + sb->len, sb->cap - sb->len + 1, fmt, ap);
+    if (n >= 0 && (size_t)n > sb->cap - sb->len) {
+        if (sb_reserve(sb, (size_t)n)) vsnprintf(sb->p + sb->len, (size_t)n + 1, fmt, again);
+        else n = -1;
+    }
+    va_end(again);
+    if (n < 0) { sb->p[sb->len] = '\0'; return false; }
+    sb->len += (size_t)n;
+    return true;
+}
+
+bool sb_append_fmt(StrBuf *sb, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    bool ok = sb_append_vfmt(sb, fmt, ap);
+    va_end(ap);
+    return ok;
+}
+
+char *sb_detach(StrBuf *sb, size_t *len) {
+    if (sb->oom) return NULL;
+    char *s = sb->p;
+    if (s == sb->small) {
+        s = sb->arena ? arena_alloc(sb->arena, sb->len + 1) : malloc(sb->len + 1);
+        if (!s) return NULL;
+        memcpy(s, sb->small, sb->len + 1);
+    }
+    if (len) *len = sb->len;
+    sb_init_arena(sb, sb->arena);
+    return s;
+}
@@ -0,0 +1,59 @@
+#ifndef STRBUF_H
+#define STRBUF_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "arena.h"
+
+// A growing string that knows its length, for the places that appended
+// with strcat/strncat: each append copies only the new bytes, and the
+// capacity doubles as needed, so n appends cost O(total length). The text
+// is always NUL-terminated; it may contain NULs of its own.
+//
+// Short strings live in the StrBuf itself, so a StrBuf must not be copied
+// by value. Longer ones go to malloc, or to an arena when one is given.
+#define SB_INLINE 40
+
+typedef struct {
+    char *p;                          // text, p[len] == '\0'
+    size_t len, cap;                  // cap: bytes p can hold before its NUL
+    Arena *arena;                     // NULL: malloc
+    bool oom;                         // an append failed; later ones do nothing
+    char small[SB_INLINE];
+} StrBuf;
+
+void sb_init(StrBuf *sb);
+void sb_init_arena(StrBuf *sb, Arena *a);
+// Frees a malloc'd buffer; arena memory goes with its arena.
+void sb_free(StrBuf *sb);
+void sb_clear(StrBuf *sb);
+
+// Room for n more bytes without another allocation. When memory runs
+// out, this and every append return false and leave the text unchanged;
+// oom then stays set until sb_clear, and later appends do nothing.
+bool sb_reserve(StrBuf *sb, size_t n);
+bool sb_append_slow(StrBuf *sb, const char *s, size_t n);
+bool sb_append_fmt(StrBuf *sb, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+bool sb_append_vfmt(StrBuf *sb, const char *fmt, va_list ap);
+
+static inline bool sb_append(StrBuf *sb, const char *s, size_t n) {
+    if (n > sb->cap - sb->len || sb->oom) return sb_append_slow(sb, s, n);
+    memcpy(sb->p + sb->len, s, n);
+    sb->len += n;
+    sb->p[sb->len] = '\0';
+    return true;
+}
+
+static inline bool sb_puts(StrBuf *sb, const char *s) { return sb_append(sb, s, strlen(s)); }
+
+static inline bool sb_putc(StrBuf *sb, char c) { return sb_append(sb, &c, 1); }
+
+// The text as a string the caller keeps, and the StrBuf starts over
+// empty. From malloc (free it) or, with an arena, from the arena. NULL if
+// an append had failed.
+char *sb_detach(StrBuf *sb, size_t *len);
+
+#endif
@@ -0,0 +1,231 @@
+#define _POSIX_C_SOURCE 200809L   // sysconf
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "strsort.h"
+
+#define MAX_PARTS 64
+#define MKQS_MAX  64      // buckets this small leave radix sort
+#define INS_MAX   12      // and these go to insertion sort
+#define MSD_LEVELS 64     // msd calls nest less deep than this
+
+typedef unsigned long long u64;
+
+// key: bytes depth .. depth + 7 of s, big-endian, so keys compare as the
+// bytes do; bytes after the NUL are 0. A key whose low byte is 0 covers
+// the end of its string.
+typedef struct { u64 key; const char *s; } Item;
+
+typedef struct { bool nocase, stable; } Sort;
+
+static inline unsigned char fold(unsigned char c, bool nocase) {
+    return nocase && (unsigned)(c - 'A') < 26 ? (unsigned char)(c | 0x20) : c;
+}
+
+static inline u64 load_key(const char *s, bool nocase) {
+    u64 k = 0;
+    int i = 0;
+    for (; i < 8 && s[i]; i++) k = k << 8 | fold((unsigned char)s[i], nocase);
+    return i ? k << (8 * (8 - i)) : 0;
+}
+
+static void reload(Item *a, size_t n, size_t depth, bool nocase) {
+    for (size_t i = 0; i < n; i++) a[i].key = load_key(a[i].s + depth, nocase);
+}
+
+static inline bool ends(u64 key) { return (key & 0xff) == 0; }
+
+// Order of two strings that agree on bytes before depth.
+static inline int compare(const Item *x, const Item *y, size_t depth, bool nocase) {
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    if (ends(x->key)) return 0;
+    const unsigned char *p = (const unsigned char *)x->s + depth + 8;
+    const unsigned char *q = (const unsigned char *)y->s + depth + 8;
+    for (;; p++, q++) {
+        unsigned char c = fold(*p, nocase), d = fold(*q, nocase);
+        if (c != d) return c < d ? -1 : 1;
+        if (!c) return 0;
+    }
+}
+
+// Stable, so it also finishes STRSORT_STABLE buckets.
+static void insertion(Item *a, size_t n, size_t depth, bool nocase) {
+    for (size_t i = 1; i < n; i++) {
+        Item x = a[i];
+        size_t j = i;
+        for (; j > 0 && compare(&a[j - 1], &x, depth, nocase) > 0; j--) a[j] = a[j - 1];
+        a[j] = x;
+    }
+}
+
+static inline void swap(Item *a, size_t i, size_t j) { Item t = a[i]; a[i] = a[j]; a[j] = t; }
+
+// Multikey quicksort with 8-byte characters: three-way partition on the
+// key, and the middle part moves on to the next 8 bytes.
+static void mkqs(Item *a, size_t n, size_t depth, bool nocase) {
+    while (n > INS_MAX) {
+        u64 x = a[0].key, y = a[n / 2].key, z = a[n - 1].key;
+        u64 pivot = x < y ? (y < z ? y : x < z ? z : x) : (x < z ? x : y < z ? z : y);
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            if (a[i].key < pivot) swap(a, lt++, i++);
+            else if (a[i].key > pivot) swap(a, i, --gt);
+            else i++;
+        }
+        mkqs(a, lt, depth, nocase);
+        mkqs(a + gt, n - gt, depth, nocase);
+        if (ends(pivot)) return;
+        a += lt;
+        n = gt - lt;
+        depth += 8;
+        reload(a, n, depth, nocase);
+    }
+    insertion(a, n, depth, nocase);
+}
+
+// One byte (byte 0 = the top of the key) per pass, distributed through
+// tmp, which keeps equal bytes in order. Bucket 0 holds strings that have
+// ended, which are all equal. The largest bucket goes round the loop and
+// the others recurse, so each call has at most half the strings of its
+// caller and calls nest fewer than MSD_LEVELS deep however long a prefix
+// the strings share. end holds the bucket ends, 256 for each level.
+static void msd(Item *a, Item *tmp, size_t n, size_t depth, int byte, const Sort *o, size_t *end) {
+    for (;;) {
+        if (n <= MKQS_MAX) {
+            if (o->stable) insertion(a, n, depth, o->nocase);
+            else mkqs(a, n, depth, o->nocase);
+            return;
+        }
+        int shift = 56 - 8 * byte;
+        memset(end, 0, 256 * sizeof *end);
+        for (size_t i = 0; i < n; i++) end[a[i].key >> shift & 0xff]++;
+        int big = 0;
+        for (int c = 1; c < 256; c++)
+            if (end[c] > end[big]) big = c;
+
+        size_t next_depth = byte < 7 ? depth : depth + 8;
+        int next_byte = byte < 7 ? byte + 1 : 0;
+        bool split = end[big] < n;
+        if (split) {
+            size_t at = 0;
+            for (int c = 0; c < 256; c++) { size_t k = end[c]; end[c] = at; at += k; }
+            for (size_t i = 0; i < n; i++) tmp[end[a[i].key >> shift & 0xff]++] = a[i];
+            memcpy(a, tmp, n * sizeof *a);
+            for (int c = 1; c < 256; c++) {
+                size_t lo = end[c - 1], m = end[c] - lo;
+                if (!m || c == big) continue;
+                if (!next_byte) reload(a + lo, m, next_depth, o->nocase);
+                msd(a + lo, tmp + lo, m, next_depth, next_byte, o, end + 256);
+            }
+        }
+        // The largest bucket, or every string if they all have the same
+        // byte here, goes on to the next byte without a call.
+        if (big == 0) return;
+        if (split) {
+            a += end[big - 1];
+            tmp += end[big - 1];
+            n = end[big] - end[big - 1];
+        }
+        depth = next_depth;
+        byte = next_byte;
+        if (!byte) reload(a, n, depth, o->nocase);
+    }
+}
+
+// ---- threading -----------------------------------------------------------
+
+static int thread_setting = 0;
+
+void strsort_set_threads(int n) { thread_setting = n; }
+
+static int part_count(size_t n) {
+    if (n < STRSORT_MT_MIN) return 1;
+    long t = thread_setting > 0 ? thread_setting : sysconf(_SC_NPROCESSORS_ONLN);
+    if (t < 1) t = 1;
+    if (t > MAX_PARTS) t = MAX_PARTS;
+    return (int)t;
+}
+
+typedef struct {
+    Item *a, *tmp;
+    const size_t *lo, *count;
+    int bucket[256], nb;
+    const Sort *o;
+    size_t *end;           // MSD_LEVELS * 256 of its own
+} PartJob;
+
+static void *part_main(void *arg) {
+    PartJob *j = arg;
+    for (int b = 0; b < j->nb; b++) {
+        int c = j->bucket[b];
+        msd(j->a + j->lo[c], j->tmp + j->lo[c], j->count[c], 0, 1, j->o, j->end);
+    }
+    return NULL;
+}
+
+// The first byte splits the array into up to 255 buckets to sort; they
+// are dealt out largest first, each to the part with the least work so
+// far. Part 0 runs on the calling thread, and a part whose thread cannot
+// be started runs inline instead.
+static void sort_top(Item *a, Item *tmp, size_t n, const Sort *o, int parts, size_t *end) {
+    size_t count[256] = {0}, lo[256], at = 0;
+    for (size_t i = 0; i < n; i++) count[a[i].key >> 56]++;
+    for (int c = 0; c < 256; c++) { lo[c] = at; at += count[c]; }
+    size_t pos[256];
+    memcpy(pos, lo, sizeof pos);
+    for (size_t i = 0; i < n; i++) tmp[pos[a[i].key >> 56]++] = a[i];
+    memcpy(a, tmp, n * sizeof *a);
+
+    int order[255], m = 0;
+    for (int c = 1; c < 256; c++)
+        if (count[c]) order[m++] = c;
+    for (int i = 1; i < m; i++)
+        for (int j = i; j > 0 && count[order[j - 1]] < count[order[j]]; j--) {
+            int t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+        }
+
+    PartJob job[MAX_PARTS];
+    size_t load[MAX_PARTS] = {0};
+    for (int k = 0; k < parts; k++) job[k] = (PartJob){a, tmp, lo, count, {0}, 0, o, end + (size_t)k * MSD_LEVELS * 256};
+    for (int i = 0; i < m; i++) {
+        int k = 0;
+        for (int q = 1; q < parts; q++)
+            if (load[q] < load[k]) k = q;
+        job[k].bucket[job[k].nb++] = order[i];
+        load[k] += count[order[i]];
+    }
+
+    pthread_t tid[MAX_PARTS];
+    int started[MAX_PARTS] = {0};
+    for (int k = 1; k < parts; k++) {
+        if (!job[k].nb) continue;
+        started[k] = pthread_create(&tid[k], NULL, part_main, &job[k]) == 0;
+        if (!started[k]) part_main(&job[k]);
+    }
+    part_main(&job[0]);
+    for (int k = 1; k < parts; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+}
+
+// ---- public entry point ----------------------------------------------------
+
+bool strsort(const char **s, size_t n, unsigned flags) {
+    if (n < 2) return true;
+    int parts = part_count(n);
+    Item *a = malloc(n * sizeof *a), *tmp = malloc(n * sizeof *tmp);
+    size_t *end = malloc((size_t)parts * MSD_LEVELS * 256 * sizeof *end);
+    if (!a || !tmp || !end) { free(a); free(tmp); free(end); return false; }
+    Sort o = {flags & STRSORT_NOCASE, flags & STRSORT_STABLE};
+    for (size_t i = 0; i < n; i++) a[i] = (Item){load_key(s[i], o.nocase), s[i]};
+
+    if (parts > 1) sort_top(a, tmp, n, &o, parts, end);
+    else msd(a, tmp, n, 0, 0, &o, end);
+
+    for (size_t i = 0; i < n; i++) s[i] = a[i].s;
+    free(a);
+    free(tmp);
+    free(end);
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef STRSORT_H
+#define STRSORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sorting arrays of C strings without a comparison callback: MSD radix
+// sort on the bytes, with multikey quicksort once a bucket is small. The
+// next 8 bytes of every string are cached next to its pointer, so most
+// passes never touch the strings themselves.
+
+// Arrays with at least this many strings sort their top-level buckets on
+// several threads.
+#define STRSORT_MT_MIN ((size_t)1 << 16)
+
+enum {
+    STRSORT_STABLE = 1,   // equal strings keep their input order
+    STRSORT_NOCASE = 2    // ASCII letters compare as lower case, as
+                          // strcasecmp does in the "C" locale
+};
+
+// 0 (the default) means one thread per online CPU; 1 never spawns threads.
+void strsort_set_threads(int n);
+
+// Reorder s[0..n) into strcmp order (bytes compared as unsigned char).
+// false if out of memory, with s unchanged.
+bool strsort(const char **s, size_t n, unsigned flags);
+
+#endif
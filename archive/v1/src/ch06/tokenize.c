@@ -0,0 +1,226 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tokenize.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef unsigned long long u64;
+
+// ---- delimiter sets -----------------------------------------------------
+
+static void add_byte(TokDelims *d, unsigned char c) {
+    d->bits[c >> 6] |= 1ULL << (c & 63);
+    d->lo[c >> 7][c & 15] |= (unsigned char)(1u << (c >> 4 & 7));
+}
+
+bool tok_delims(TokDelims *d, const char *chars, size_t n) {
+    if (n > 16) return false;
+    memset(d, 0, sizeof *d);
+    for (size_t i = 0; i < n; i++) add_byte(d, (unsigned char)chars[i]);
+    // Repeats only cost compares; keep each byte once.
+    for (int c = 0; c < 256; c++)
+        if (d->bits[c >> 6] >> (c & 63) & 1) d->set[d->n++] = (unsigned char)c;
+    return true;
+}
+
+void tok_class(TokDelims *d, int (*is_delim)(int c)) {
+    memset(d, 0, sizeof *d);
+    for (int c = 0; c < 256; c++)
+        if (is_delim(c)) add_byte(d, (unsigned char)c);
+}
+
+// ---- 64-byte delimiter masks -----------------------------------------------
+// Bit i of the result is set when p[i] is a delimiter.
+
+static u64 mask_bits(const TokDelims *d, const char *p) {
+    u64 m = 0;
+    for (int i = 0; i < 64; i++) {
+        unsigned char c = (unsigned char)p[i];
+        m |= (d->bits[c >> 6] >> (c & 63) & 1) << i;
+    }
+    return m;
+}
+
+#ifdef __SSE2__
+// One compare per set byte and 16 input bytes; wins for a handful.
+static u64 mask_cmp(const TokDelims *d, const char *p) {
+    u64 m = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 16 * i)), hit = _mm_setzero_si128();
+        for (int k = 0; k < d->n; k++) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(b, _mm_set1_epi8((char)d->set[k])));
+        m |= (u64)(unsigned)_mm_movemask_epi8(hit) << (16 * i);
+    }
+    return m;
+}
+#endif
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("ssse3")
+// Any set in a fixed number of steps: the low nibble picks a row of
+// lo[0] or lo[1] (by the top bit), the rest of the high nibble a bit in it.
+static u64 mask_nibble(const TokDelims *d, const char *p) {
+    const __m128i t0 = _mm_loadu_si128((const __m128i *)d->lo[0]);
+    const __m128i t1 = _mm_loadu_si128((const __m128i *)d->lo[1]);
+    const __m128i bit = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i low4 = _mm_set1_epi8(0x0f), seven = _mm_set1_epi8(7), zero = _mm_setzero_si128();
+    u64 m = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        __m128i lo = _mm_and_si128(b, low4), hi = _mm_and_si128(_mm_srli_epi16(b, 4), low4);
+        __m128i upper = _mm_cmpgt_epi8(hi, seven);
+        __m128i row = _mm_or_si128(_mm_and_si128(upper, _mm_shuffle_epi8(t1, lo)),
+                                   _mm_andnot_si128(upper, _mm_shuffle_epi8(t0, lo)));
+        __m128i miss = _mm_cmpeq_epi8(_mm_and_si128(row, _mm_shuffle_epi8(bit, hi)), zero);
+        m |= (u64)(~(unsigned)_mm_movemask_epi8(miss) & 0xffff) << (16 * i);
+    }
+    return m;
+}
+#pragma GCC pop_options
+
+#endif
+
+static int use_sse2, use_ssse3;
+
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar keeps the
+// bitmap and sse2 the byte compares. Its levels have no SSSE3 of its own;
+// every AVX2 CPU has it.
+__attribute__((constructor))
+static void pick_kernels(void) {
+    isa_level isa = cpu_isa();
+    use_sse2 = isa >= ISA_SSE2;
+    use_ssse3 = isa >= ISA_AVX2;
+}
+
+static inline u64 delim_mask(const TokDelims *d, const char *p) {
+#ifdef __SSE2__
+    if (use_sse2 && d->n && d->n <= 4) return mask_cmp(d, p);
+#endif
+#ifdef HAVE_X86
+    if (use_ssse3) return mask_nibble(d, p);
+#endif
+    return mask_bits(d, p);
+}
+
+// ---- one buffer -----------------------------------------------------------
+
+void tok_init(Tokenizer *t, const TokDelims *d, const char *buf, size_t len) {
+    *t = (Tokenizer){d, buf, len, 0, SIZE_MAX, 0};
+}
+
+// The block at base; past the end of the buffer everything is a delimiter.
+static void load(Tokenizer *t, size_t base) {
+    size_t n = t->len - base;
+    t->base = base;
+    if (n >= 64) { t->mask = delim_mask(t->d, t->buf + base); return; }
+    char tail[64] = {0};
+    memcpy(tail, t->buf + base, n);
+    t->mask = delim_mask(t->d, tail) | ~0ULL << n;
+}
+
+// First position from t->pos that is (delim) or is not (!delim) a
+// delimiter, or len.
+static inline size_t seek(Tokenizer *t, bool delim) {
+    for (size_t pos = t->pos; pos < t->len;) {
+        size_t base = pos & ~(size_t)63;
+        if (base != t->base) load(t, base);
+        u64 m = (delim ? t->mask : ~t->mask) & ~0ULL << (pos - base);
+        if (m) {
+            pos = base + (size_t)__builtin_ctzll(m);
+            return pos < t->len ? pos : t->len;
+        }
+        pos = base + 64;
+    }
+    return t->len;
+}
+
+static inline bool next_token(Tokenizer *t, Tok *out) {
+    size_t s = seek(t, false);
+    if (s == t->len) { t->pos = s; return false; }
+    t->pos = s;
+    t->pos = seek(t, true);
+    *out = (Tok){t->buf + s, t->pos - s};
+    return true;
+}
+
+bool tok_next(Tokenizer *t, Tok *out) { return next_token(t, out); }
+
+size_t tok_fill(Tokenizer *t, Tok *out, size_t cap) {
+    size_t n = 0;
+    while (n < cap && next_token(t, &out[n])) n++;
+    return n;
+}
+
+// ---- streams ------------------------------------------------------------
+
+void tok_stream_init(TokStream *s, const TokDelims *d) {
+    *s = (TokStream){0};
+    tok_init(&s->it, d, NULL, 0);
+}
+
+void tok_stream_free(TokStream *s) {
+    free(s->carry[0]);
+    free(s->carry[1]);
+}
+
+// Once a copy fails, the rest of that token is skipped too.
+static void carry_add(TokStream *s, const char *p, size_t n) {
+    if (s->dropping) return;
+    int c = s->cur;
+    if (s->carry_len + n > s->cap[c]) {
+        size_t cap = s->cap[c] ? s->cap[c] : 64;
+        while (cap < s->carry_len + n) cap *= 2;
+        char *g = realloc(s->carry[c], cap);
+        if (!g) { s->oom = s->dropping = true; s->carry_len = 0; return; }
+        s->carry[c] = g;
+        s->cap[c] = cap;
+    }
+    memcpy(s->carry[c] + s->carry_len, p, n);
+    s->carry_len += n;
+}
+
+// A held-back token continues up to the first delimiter of the chunk; if
+// there is none it swallows the whole chunk and is still open.
+void tok_feed(TokStream *s, const char *chunk, size_t len) {
+    tok_init(&s->it, s->it.d, chunk, len);
+    if (!s->carry_len && !s->dropping) return;
+    size_t end = seek(&s->it, true);
+    carry_add(s, chunk, end);
+    s->it.pos = end;
+    if (end < len) s->dropping = false;
+    s->ready = end < len && s->carry_len;
+}
+
+static Tok hand_out(TokStream *s) {
+    Tok t = {s->carry[s->cur], s->carry_len};
+    s->ready = false;
+    s->carry_len = 0;
+    s->cur ^= 1;
+    return t;
+}
+
+bool tok_stream_next(TokStream *s, Tok *out) {
+    if (s->ready) { *out = hand_out(s); return true; }
+    if (!next_token(&s->it, out)) return false;
+    if (out->p + out->len < s->it.buf + s->it.len) return true;
+    carry_add(s, out->p, out->len);
+    return false;
+}
+
+size_t tok_stream_fill(TokStream *s, Tok *out, size_t cap) {
+    size_t n = 0;
+    while (n < cap && tok_stream_next(s, &out[n])) n++;
+    return n;
+}
+
+bool tok_finish(TokStream *s, Tok *out) {
+    s->dropping = false;
+    if (!s->carry_len) return false;
+    *out = hand_out(s);
+    return true;
+}
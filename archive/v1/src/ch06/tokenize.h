@@ -0,0 +1,68 @@
+#ifndef TOKENIZE_H
+#define TOKENIZE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A reentrant strtok that leaves the text alone: tokens are (pointer,
+// length) views into the caller's buffer, maximal runs of bytes that are
+// not delimiters. As with strtok, empty tokens between delimiters are
+// skipped. Delimiters are found 64 bytes at a time as a bitmask.
+typedef struct { const char *p; size_t len; } Tok;
+
+// A delimiter set, built once and shared read-only by any number of
+// tokenizers. Small sets are compared byte against byte, 16 at a time;
+// larger ones and classes go through nibble lookup tables (SSSE3 when
+// the CPU has it, otherwise a 256-bit bitmap per byte).
+typedef struct {
+    int n;                            // bytes in set, 0 for a class
+    unsigned char set[16];
+    unsigned char lo[2][16];          // by low nibble: bit (hi & 7) set for each hi nibble in the set
+    unsigned long long bits[4];
+} TokDelims;
+
+// Any set of up to 16 bytes (false if n > 16); NUL is allowed.
+bool tok_delims(TokDelims *d, const char *chars, size_t n);
+// Every byte c in 0..255 for which is_delim(c) is true, e.g. isspace.
+void tok_class(TokDelims *d, int (*is_delim)(int c));
+
+// Iteration over one buffer.
+typedef struct {
+    const TokDelims *d;
+    const char *buf;
+    size_t len, pos, base;            // base: start of the block in mask
+    unsigned long long mask;          // delimiters in buf[base .. base + 64)
+} Tokenizer;
+
+void tok_init(Tokenizer *t, const TokDelims *d, const char *buf, size_t len);
+bool tok_next(Tokenizer *t, Tok *out);
+// Batch mode: up to cap next tokens into out; 0 once the buffer is done.
+size_t tok_fill(Tokenizer *t, Tok *out, size_t cap);
+
+// Iteration over a stream fed in chunks. A token that reaches the end of
+// a chunk may continue in the next one, so it is held back; only such
+// tokens are copied, into a buffer owned by the stream. Views are valid
+// until the next tok_feed, which comes after tok_stream_next has returned
+// false (a chunk is not abandoned half way).
+typedef struct {
+    Tokenizer it;
+    char *carry[2];                   // one collects, the other was handed out
+    size_t cap[2], carry_len;
+    int cur;
+    bool ready;                       // carry[cur] is a finished token
+    bool oom;
+    bool dropping;                    // the held-back token was lost; skip the rest of it
+} TokStream;
+
+void tok_stream_init(TokStream *s, const TokDelims *d);
+void tok_stream_free(TokStream *s);
+void tok_feed(TokStream *s, const char *chunk, size_t len);
+// false when the chunk is used up; at the end of the input, call
+// tok_finish to get the token held back from the last chunk, if any.
+// A token that cannot be copied for lack of memory sets oom and is lost:
+// no part of it is returned.
+bool tok_stream_next(TokStream *s, Tok *out);
+size_t tok_stream_fill(TokStream *s, Tok *out, size_t cap);
+bool tok_finish(TokStream *s, Tok *out);
+
+#endif
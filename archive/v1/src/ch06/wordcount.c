@@ -0,0 +1,426 @@
+#define _POSIX_C_SOURCE 200809L   // posix_madvise
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "arena.h"
+#include "wordcount.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_PARTS   64
+#define TABLE_MIN   (1u << 12)
+#define ARENA_CHUNK ((size_t)1 << 20)
+#define READ_BLOCK  ((size_t)64 << 20)
+
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+// ---- per-thread tables --------------------------------------------------
+
+// An empty slot has key == NULL; words are never empty.
+typedef struct { const char *key; size_t len; u64 hash, count; } Slot;
+
+// One cache line apart, so threads counting into neighbours do not share.
+typedef struct {
+    _Alignas(64) Slot *slot;
+    size_t mask, used;
+    u64 total;
+    Arena arena;               // the words' bytes
+    bool oom;
+} Table;
+
+struct WordCount {
+    int parts;
+    Table tab[];
+};
+
+static inline u64 load8(const char *p) { u64 w; memcpy(&w, p, 8); return w; }
+static inline u64 load4(const char *p) { unsigned w; memcpy(&w, p, 4); return w; }
+static inline u64 mix(u64 a, u64 b) { u128 r = (u128)a * b; return (u64)r ^ (u64)(r >> 64); }
+
+// Multiply-fold hashing in the style of wyhash: 16 bytes per multiply,
+// and short words with two overlapping loads instead of a byte loop.
+static inline u64 hash_bytes(const char *s, size_t n) {
+    const u64 k1 = 0xa0761d6478bd642fULL, k2 = 0xe7037ed1a0b428dbULL;
+    u64 h = 0x9e3779b97f4a7c15ULL ^ n;
+    for (; n > 16; s += 16, n -= 16) h = mix(load8(s) ^ k1, load8(s + 8) ^ h);
+    u64 a, b;
+    if (n >= 8) { a = load8(s); b = load8(s + n - 8); }
+    else if (n >= 4) { a = load4(s); b = load4(s + n - 4); }
+    else { a = (u64)(unsigned char)s[0] << 16 | (u64)(unsigned char)s[n >> 1] << 8 | (unsigned char)s[n - 1]; b = 0; }
+    return mix(mix(a ^ k1, b ^ h), k2);
+}
+
+static bool table_init(Table *t) {
+    *t = (Table){0};
+    t->slot = calloc(TABLE_MIN, sizeof *t->slot);
+    t->mask = TABLE_MIN - 1;
+    arena_init(&t->arena, ARENA_CHUNK);
+    return t->slot != NULL;
+}
+
+static void table_free(Table *t) {
+    free(t->slot);
+    arena_free(&t->arena);
+}
+
+// Rehash into at least 4/3 * want slots, keeping the load under 3/4.
+static bool reserve(Table *t, size_t want) {
+    size_t n = t->mask + 1;
+    while (want * 4 > n * 3) n *= 2;
+    if (n == t->mask + 1) return true;
+    Slot *s = calloc(n, sizeof *s);
+    if (!s) return false;
+    for (size_t i = 0; i <= t->mask; i++) {
+        if (!t->slot[i].key) continue;
+        size_t j = t->slot[i].hash & (n - 1);
+        while (s[j].key) j = (j + 1) & (n - 1);
+        s[j] = t->slot[i];
+    }
+    free(t->slot);
+    t->slot = s;
+    t->mask = n - 1;
+    return true;
+}
+
+// Copy a new word into the arena, packed against the one before.
+static const char *keep(Table *t, const char *s, size_t n) {
+    char *k = arena_alloc_bytes(&t->arena, n);
+    if (k) memcpy(k, s, n);
+    return k;
+}
+
+// Slot holding word s, or the empty slot where it would go.
+static inline Slot *find(Table *t, const char *s, size_t n, u64 h) {
+    size_t i = h & t->mask;
+    for (;;) {
+        Slot *e = &t->slot[i];
+        if (!e->key || (e->hash == h && e->len == n && memcmp(e->key, s, n) == 0)) return e;
+        i = (i + 1) & t->mask;
+    }
+}
+
+static inline bool count_word(Table *t, const char *s, size_t n) {
+    u64 h = hash_bytes(s, n);
+    Slot *e = find(t, s, n, h);
+    if (e->key) { e->count++; return true; }
+    if ((t->used + 1) * 4 > (t->mask + 1) * 3) {
+        if (!reserve(t, t->used + 1)) return false;
+        e = find(t, s, n, h);
+    }
+    const char *k = keep(t, s, n);
+    if (!k) return false;
+    *e = (Slot){k, n, h, 1};
+    t->used++;
+    return true;
+}
+
+// ---- word boundaries ----------------------------------------------------
+
+static inline bool is_space(char c) { return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t'; }
+
+// Bit i set when p[i] is whitespace.
+static inline u64 space_mask64(const char *p) {
+#ifdef __SSE2__
+    const __m128i tab = _mm_set1_epi8('\t'), span = _mm_set1_epi8('\r' - '\t'), sp = _mm_set1_epi8(' ');
+    u64 m = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        __m128i x = _mm_sub_epi8(b, tab);
+        __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x, span), x), _mm_cmpeq_epi8(b, sp));
+        m |= (u64)(unsigned)_mm_movemask_epi8(ws) << (16 * i);
+    }
+    return m;
+#else
+    u64 m = 0;
+    for (int i = 0; i < 64; i++) m |= (u64)is_space(p[i]) << i;
+    return m;
+#endif
+}
+
+// 64 bytes at a time: word starts and ends come out of the whitespace
+// mask as bit transitions, so the loop runs once per word, not per byte.
+// The last partial block is copied into a space-padded buffer, which also
+// ends a word that runs to the end of the text.
+static void count_text(Table *t, const char *p, size_t len) {
+    char tail[64];
+    u64 in_word = 0, total = 0;
+    size_t open = SIZE_MAX;                       // start of a word not yet ended
+    for (size_t base = 0; base < len; base += 64) {
+        const char *b = p + base;
+        if (len - base < 64) {
+            memset(tail, ' ', sizeof tail);
+            memcpy(tail, b, len - base);
+            b = tail;
+        }
+        u64 word = ~space_mask64(b), prev = word << 1 | in_word;
+        u64 starts = word & ~prev, ends = ~word & prev;
+        for (; ends; ends &= ends - 1) {
+            size_t e = base + (size_t)__builtin_ctzll(ends), s;
+            if (open != SIZE_MAX) { s = open; open = SIZE_MAX; }
+            else { s = base + (size_t)__builtin_ctzll(starts); starts &= starts - 1; }
+            if (!count_word(t, p + s, e - s)) { t->oom = true; t->total += total; return; }
+            total++;
+        }
+        if (starts) open = base + (size_t)__builtin_ctzll(starts);
+        in_word = word >> 63;
+    }
+    if (open != SIZE_MAX) {
+        if (count_word(t, p + open, len - open)) total++;
+        else t->oom = true;
+    }
+    t->total += total;
+}
+
+// ---- threads ----------------------------------------------------------------
+
+typedef struct { Table *t; const char *p; size_t len; } PartJob;
+
+static void *part_main(void *arg) {
+    PartJob *j = arg;
+    count_text(j->t, j->p, j->len);
+    return NULL;
+}
+
+static int part_count(const WordCount *wc, size_t n) {
+    if (n < WC_MT_MIN) return 1;
+    size_t most = n / (WC_MT_MIN / 2);
+    return (size_t)wc->parts > most ? (int)most : wc->parts;
+}
+
+// Part k counts into table k. Cuts move forward to just after whitespace,
+// so no word is split; part 0 runs on the calling thread, and a part whose
+// thread cannot be started runs inline instead.
+static void run_parts(WordCount *wc, const char *p, size_t n, int parts) {
+    PartJob job[MAX_PARTS] = {0};
+    pthread_t tid[MAX_PARTS];
+    int started[MAX_PARTS] = {0};
+    size_t step = n / (size_t)parts, lo = 0;
+    for (int k = 0; k < parts; k++) {
+        size_t hi = k == parts - 1 ? n : step * (size_t)(k + 1);
+        if (hi < lo) hi = lo;
+        while (hi < n && !is_space(p[hi - 1])) hi++;
+        job[k] = (PartJob){&wc->tab[k], p + lo, hi - lo};
+        lo = hi;
+    }
+    for (int k = 1; k < parts; k++) {
+        started[k] = pthread_create(&tid[k], NULL, part_main, &job[k]) == 0;
+        if (!started[k]) part_main(&job[k]);
+    }
+    part_main(&job[0]);
+    for (int k = 1; k < parts; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+}
+
+// ---- public entry points -------------------------------------------------
+
+WordCount *wc_new(int threads) {
+    long t = threads > 0 ? threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (t < 1) t = 1;
+    if (t > MAX_PARTS) t = MAX_PARTS;
+    size_t size = (sizeof(WordCount) + (size_t)t * sizeof(Table) + 63) / 64 * 64;
+    WordCount *wc = aligned_alloc(64, size);
+    if (!wc) return NULL;
+    wc->parts = (int)t;
+    for (int k = 0; k < wc->parts; k++) {
+        if (!table_init(&wc->tab[k])) {
+            wc->parts = k + 1;
+            wc_free(wc);
+            return NULL;
+        }
+    }
+    return wc;
+}
+
+void wc_free(WordCount *wc) {
+    if (!wc) return;
+    for (int k = 0; k < wc->parts; k++) table_free(&wc->tab[k]);
+    free(wc);
+}
+
+bool wc_add(WordCount *wc, const char *buf, size_t len) {
+    int parts = part_count(wc, len);
+    if (parts == 1) count_text(&wc->tab[0], buf, len);
+    else run_parts(wc, buf, len, parts);
+    bool ok = true;
+    for (int k = 0; k < parts; k++) ok &= !wc->tab[k].oom;
+    return ok;
+}
+
+typedef struct { WordCount *wc; const char *p; size_t len; bool ok; } AddJob;
+
+static void *add_main(void *arg) {
+    AddJob *j = arg;
+    j->ok = wc_add(j->wc, j->p, j->len);
+    return NULL;
+}
+
+// Two blocks: one is counted on a helper thread while the next is read.
+// A block is cut after its last whitespace and the rest carried into the
+// other block; a block holding no whitespace at all grows.
+static bool add_stream(WordCount *wc, int fd) {
+    char *buf[2] = {malloc(READ_BLOCK), malloc(READ_BLOCK)};
+    size_t cap[2] = {READ_BLOCK, READ_BLOCK}, have = 0;
+    int cur = 0, err = 0;
+    bool ok = buf[0] && buf[1], busy = false, eof = false;
+    AddJob job = {wc, NULL, 0, true};
+    pthread_t tid;
+    while (ok && !eof) {
+        ssize_t r = read(fd, buf[cur] + have, cap[cur] - have);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) { err = errno; ok = false; break; }
+        have += (size_t)r;
+        eof = r == 0;
+        if (!eof && have < cap[cur]) continue;
+
+        size_t cut = have;
+        if (!eof) while (cut && !is_space(buf[cur][cut - 1])) cut--;
+        if (cut == 0 && !eof) {
+            char *g = realloc(buf[cur], cap[cur] * 2);
+            if (!g) { ok = false; break; }
+            buf[cur] = g;
+            cap[cur] *= 2;
+            continue;
+        }
+        if (busy) { pthread_join(tid, NULL); busy = false; ok &= job.ok; }
+        size_t rest = have - cut;
+        if (rest > cap[!cur]) {
+            char *g = realloc(buf[!cur], cap[cur]);
+            if (!g) { ok = false; break; }
+            buf[!cur] = g;
+            cap[!cur] = cap[cur];
+        }
+        memcpy(buf[!cur], buf[cur] + cut, rest);
+        job = (AddJob){wc, buf[cur], cut, true};
+        busy = pthread_create(&tid, NULL, add_main, &job) == 0;
+        if (!busy) add_main(&job);
+        ok &= busy || job.ok;
+        cur = !cur;
+        have = rest;
+    }
+    if (busy) { pthread_join(tid, NULL); ok &= job.ok; }
+    free(buf[0]);
+    free(buf[1]);
+    if (err) errno = err;
+    return ok;
+}
+
+bool wc_add_fd(WordCount *wc, int fd) {
+    struct stat st;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= pos
+        || (uintmax_t)(st.st_size - pos) > SIZE_MAX / 2)
+        return add_stream(wc, fd);
+
+    long page = sysconf(_SC_PAGESIZE);
+    off_t base = page > 0 ? pos / page * page : 0;
+    size_t len = (size_t)(st.st_size - base);
+    char *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, base);
+    if (map == MAP_FAILED) return add_stream(wc, fd);
+    posix_madvise(map, len, POSIX_MADV_SEQUENTIAL);
+    bool ok = wc_add(wc, map + (pos - base), len - (size_t)(pos - base));
+    munmap(map, len);
+    lseek(fd, st.st_size, SEEK_SET);
+    return ok;
+}
+
+// Fold tables 1.. into table 0. The merged slots keep pointing into the
+// other tables' arenas, which live until wc_free.
+static bool merge(WordCount *wc) {
+    Table *t = &wc->tab[0];
+    size_t want = t->used;
+    for (int k = 1; k < wc->parts; k++) want += wc->tab[k].used;
+    if (want == t->used) return true;
+    if (!reserve(t, want)) { t->oom = true; return false; }
+    for (int k = 1; k < wc->parts; k++) {
+        Table *u = &wc->tab[k];
+        if (!u->used) continue;
+        for (size_t i = 0; i <= u->mask; i++) {
+            Slot *s = &u->slot[i];
+            if (!s->key) continue;
+            Slot *e = find(t, s->key, s->len, s->hash);
+            if (e->key) e->count += s->count;
+            else { *e = *s; t->used++; }
+        }
+        t->total += u->total;
+        memset(u->slot, 0, (u->mask + 1) * sizeof *u->slot);
+        u->used = 0;
+        u->total = 0;
+    }
+    return true;
+}
+
+size_t wc_distinct(WordCount *wc) { merge(wc); return wc->tab[0].used; }
+
+unsigned long long wc_total(WordCount *wc) {
+    u64 n = 0;
+    for (int k = 0; k < wc->parts; k++) n += wc->tab[k].total;
+    return n;
+}
+
+// ---- ranking ------------------------------------------------------------------
+
+static inline bool ranks_before(const WordFreq *a, const WordFreq *b) {
+    if (a->count != b->count) return a->count > b->count;
+    int c = memcmp(a->word, b->word, a->len < b->len ? a->len : b->len);
+    return c < 0 || (c == 0 && a->len < b->len);
+}
+
+static int cmp_rank(const void *x, const void *y) {
+    const WordFreq *a = x, *b = y;
+    return ranks_before(a, b) ? -1 : ranks_before(b, a);
+}
+
+WordFreq *wc_sorted(WordCount *wc, size_t *n) {
+    if (!merge(wc)) return NULL;
+    Table *t = &wc->tab[0];
+    if (!t->used) { *n = 0; return NULL; }
+    WordFreq *out = malloc(t->used * sizeof *out);
+    if (!out) return NULL;
+    size_t m = 0;
+    for (size_t i = 0; i <= t->mask; i++)
+        if (t->slot[i].key) out[m++] = (WordFreq){t->slot[i].key, t->slot[i].len, t->slot[i].count};
+    qsort(out, m, sizeof *out, cmp_rank);
+    *n = m;
+    return out;
+}
+
+// h[0..m) is a heap with the lowest-ranked word at the root.
+static void sift_down(WordFreq *h, size_t m, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, w = i;
+        if (l < m && ranks_before(&h[w], &h[l])) w = l;
+        if (l + 1 < m && ranks_before(&h[w], &h[l + 1])) w = l + 1;
+        if (w == i) return;
+        WordFreq x = h[i]; h[i] = h[w]; h[w] = x;
+        i = w;
+    }
+}
+
+// One pass over the table with a k-entry heap, then a sort of the k.
+size_t wc_top(WordCount *wc, WordFreq *out, size_t k) {
+    if (!merge(wc) || k == 0) return 0;
+    Table *t = &wc->tab[0];
+    size_t m = 0;
+    for (size_t i = 0; i <= t->mask; i++) {
+        const Slot *s = &t->slot[i];
+        if (!s->key) continue;
+        WordFreq w = {s->key, s->len, s->count};
+        if (m < k) {
+            out[m++] = w;
+            if (m == k) for (size_t j = k / 2; j-- > 0;) sift_down(out, m, j);
+        } else if (ranks_before(&w, &out[0])) {
+            out[0] = w;
+            sift_down(out, m, 0);
+        }
+    }
+    qsort(out, m, sizeof *out, cmp_rank);
+    return m;
+}
@@ -0,0 +1,48 @@
+#ifndef WORDCOUNT_H
+#define WORDCOUNT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Word frequencies over text of any size. A word is a maximal run of bytes
+// other than ASCII whitespace (space, \t, \n, \v, \f, \r), compared byte
+// for byte, of any length. Each thread counts its part of the input into
+// its own open-addressing table with the words copied into an arena; the
+// tables are merged when results are first asked for.
+
+// Inputs with at least this many bytes are split across threads.
+#define WC_MT_MIN ((size_t)1 << 20)
+
+typedef struct WordCount WordCount;
+
+typedef struct {
+    const char *word;              // not NUL-terminated; valid until wc_free
+    size_t len;
+    unsigned long long count;
+} WordFreq;
+
+// threads: 0 means one per online CPU; 1 never spawns threads.
+// NULL when out of memory.
+WordCount *wc_new(int threads);
+void wc_free(WordCount *wc);
+
+// Count the words in buf; a word is never continued across calls. false
+// if memory ran out, in which case some words were not counted.
+bool wc_add(WordCount *wc, const char *buf, size_t len);
+
+// Count everything readable from fd. Regular files are mapped and split
+// across threads; pipes and terminals are read in large blocks, cut after
+// the last whitespace. false on a read error (errno set) or out of memory.
+bool wc_add_fd(WordCount *wc, int fd);
+
+size_t wc_distinct(WordCount *wc);
+unsigned long long wc_total(WordCount *wc);
+
+// Most frequent first, equal counts in byte order of the words. wc_sorted
+// returns all of them in a malloc'd array, or NULL: with *n = 0 if there
+// are none, with *n untouched if out of memory. wc_top writes the first
+// min(k, distinct) to out and returns how many.
+WordFreq *wc_sorted(WordCount *wc, size_t *n);
+size_t wc_top(WordCount *wc, WordFreq *out, size_t k);
+
+#endif
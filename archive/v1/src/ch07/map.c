@@ -0,0 +1,25 @@
+#include <stdbool.h>
+#include <string.h>
+#include "map.h"
+
+void map_run(const void *in, void *out, size_t n, size_t size,
+             const MapStage *stages, int nstages) {
+    if (size > MAP_MAX_SIZE || nstages < 1) return;
+    _Alignas(64) unsigned char buf[2][MAP_BLOCK * MAP_MAX_SIZE];
+    const unsigned char *src = in;
+    unsigned char *dst = out;
+    bool same = in == out;
+    for (size_t at = 0; at < n; at += MAP_BLOCK) {
+        size_t m = n - at < MAP_BLOCK ? n - at : MAP_BLOCK;
+        const void *from = src + at * size;
+        // Stages in between go buffer to buffer; the last writes out,
+        // except that a lone stage on in == out also goes through a buffer.
+        for (int s = 0; s < nstages; s++) {
+            bool last = s == nstages - 1;
+            void *to = last && !(same && s == 0) ? (void *)(dst + at * size) : buf[s & 1];
+            stages[s].f(from, to, m, stages[s].ctx);
+            from = to;
+        }
+        if (same && nstages == 1) memcpy(dst + at * size, buf[0], m * size);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <stddef.h>
+
+// Array loops generated per expression, for the places that passed a
+// function pointer and called it once per element. The expression is
+// pasted into a static inline function, so it is inlined into the loop,
+// and the loops run in blocks of MAP_BLOCK with a fixed trip count, which
+// -O2 vectorizes without further flags.
+//
+//   MAP_DEFINE(name, T, expr)        expr of T x
+//     void name(const T *in, T *out, size_t n)        out[i] = expr
+//     void name##_inplace(T *a, size_t n)             a[i] = expr
+//     void name##_block(const void *in, void *out, size_t n, void *ctx)
+//                                                     name as a MapBlockFn
+//   ZIP_DEFINE(name, T, expr)        expr of T x, T y
+//     void name(const T *xs, const T *ys, T *out, size_t n)
+//   FILTER_DEFINE(name, T, pred)     pred of T x
+//     size_t name(const T *in, T *out, size_t n)      keeps the x where
+//                                                     pred holds, in order;
+//                                                     returns how many
+//   MAPREDUCE_DEFINE(name, T, R, expr, combine, init)
+//                                    expr of T x, combine of R a, R b
+//     R name(const T *in, size_t n)   combine over expr of every element
+//
+// in and out must not overlap (use the _inplace form instead). The reduce
+// keeps MAP_LANES partial results, so combine must be associative and
+// commutative with init as its identity; for floating point that means
+// the rounding differs from a left-to-right loop.
+
+#define MAP_BLOCK 64
+#define MAP_LANES 8
+
+#define MAP_DEFINE(name, T, expr)                                              \
+    static inline T name##_f(T x) { return (expr); }                           \
+    static inline void name(const T *restrict in, T *restrict out, size_t n) { \
+        size_t i = 0;                                                          \
+        for (; i + MAP_BLOCK <= n; i += MAP_BLOCK)                             \
+            for (size_t j = 0; j < MAP_BLOCK; j++) out[i + j] = name##_f(in[i + j]); \
+        for (size_t j = 0; j < n - i; j++) out[i + j] = name##_f(in[i + j]);   \
+    }                                                                          \
+    static inline void name##_inplace(T *a, size_t n) {                        \
+        size_t i = 0;                                                          \
+        for (; i + MAP_BLOCK <= n; i += MAP_BLOCK)                             \
+            for (size_t j = 0; j < MAP_BLOCK; j++) a[i + j] = name##_f(a[i + j]); \
+        for (size_t j = 0; j < n - i; j++) a[i + j] = name##_f(a[i + j]);     \
+    }                                                                          \
+    static inline void name##_block(const void *in, void *out, size_t n, void *ctx) { \
+        (void)ctx;                                                             \
+        name(in, out, n);                                                      \
+    }
+
+#define ZIP_DEFINE(name, T, expr)                                              \
+    static inline T name##_f(T x, T y) { return (expr); }                      \
+    static inline void name(const T *restrict xs, const T *restrict ys,        \
+                            T *restrict out, size_t n) {                       \
+        size_t i = 0;                                                          \
+        for (; i + MAP_BLOCK <= n; i += MAP_BLOCK)                             \
+            for (size_t j = 0; j < MAP_BLOCK; j++)                             \
+                out[i + j] = name##_f(xs[i + j], ys[i + j]);                   \
+        for (size_t j = 0; j < n - i; j++) out[i + j] = name##_f(xs[i + j], ys[i + j]); \
+    }
+
+// Every element is stored and the count advances only past kept ones, so
+// there is no branch on pred to mispredict.
+#define FILTER_DEFINE(name, T, pred)                                           \
+    static inline int name##_p(T x) { return (pred) != 0; }                    \
+    static inline size_t name(const T *restrict in, T *restrict out, size_t n) { \
+        size_t k = 0;                                                          \
+        for (size_t i = 0; i < n; i++) {                                       \
+            T x = in[i];                                                       \
+            out[k] = x;                                                        \
+            k += (size_t)name##_p(x);                                          \
+        }                                                                      \
+        return k;                                                              \
+    }
+
+#define MAPREDUCE_DEFINE(name, T, R, expr, combine, init)                      \
+    static inline R name##_f(T x) { return (expr); }                           \
+    static inline R name##_op(R a, R b) { return (combine); }                  \
+    static inline R name(const T *in, size_t n) {                              \
+        R lane[MAP_LANES];                                                     \
+        for (size_t j = 0; j < MAP_LANES; j++) lane[j] = (init);               \
+        size_t i = 0;                                                          \
+        for (; i + MAP_LANES <= n; i += MAP_LANES)                             \
+            for (size_t j = 0; j < MAP_LANES; j++)                             \
+                lane[j] = name##_op(lane[j], name##_f(in[i + j]));             \
+        R acc = lane[0];                                                       \
+        for (size_t j = 1; j < MAP_LANES; j++) acc = name##_op(acc, lane[j]);  \
+        for (size_t j = 0; j < n - i; j++) acc = name##_op(acc, name##_f(in[i + j])); \
+        return acc;                                                            \
+    }
+
+// ---- chosen at run time -------------------------------------------------------
+
+// Maps n elements of in to out, none of them more than MAP_BLOCK.
+typedef void (*MapBlockFn)(const void *in, void *out, size_t n, void *ctx);
+
+typedef struct { MapBlockFn f; void *ctx; } MapStage;
+
+// Largest element map_run handles.
+#define MAP_MAX_SIZE 16
+
+// Runs the stages one after another on each block of MAP_BLOCK elements
+// of size bytes, so a block stays in L1 across the whole pipeline and
+// each stage costs one indirect call per block rather than per element.
+// Every stage maps elements of that size to the same size; in and out may
+// be the same array. Does nothing if size > MAP_MAX_SIZE or nstages < 1.
+void map_run(const void *in, void *out, size_t n, size_t size,
+             const MapStage *stages, int nstages);
+
+#endif
@@ -0,0 +1,159 @@
+#define _POSIX_C_SOURCE 200809L   // sysconf
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "numsort.h"
+
+#define MAX_PARTS 64
+
+typedef unsigned long long u64;
+
+// ---- sorting network ------------------------------------------------------
+
+// Batcher's odd-even merge sort for 16 inputs. Leaving out the
+// comparators with an index >= n sorts n < 16, as if the missing inputs
+// were larger than any element.
+#define NET_N     16
+#define NET_PAIRS 63
+static const unsigned char net[NET_PAIRS][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7}, {8, 9}, {10, 11}, {12, 13}, {14, 15},
+    {0, 2}, {1, 3}, {4, 6}, {5, 7}, {8, 10}, {9, 11}, {12, 14}, {13, 15},
+    {1, 2}, {5, 6}, {9, 10}, {13, 14},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}, {8, 12}, {9, 13}, {10, 14}, {11, 15},
+    {2, 4}, {3, 5}, {10, 12}, {11, 13},
+    {1, 2}, {3, 4}, {5, 6}, {9, 10}, {11, 12}, {13, 14},
+    {0, 8}, {1, 9}, {2, 10}, {3, 11}, {4, 12}, {5, 13}, {6, 14}, {7, 15},
+    {4, 8}, {5, 9}, {6, 10}, {7, 11},
+    {2, 4}, {3, 5}, {6, 8}, {7, 9}, {10, 12}, {11, 13},
+    {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}, {13, 14},
+};
+
+// ---- threading -----------------------------------------------------------
+
+static int thread_setting = 0;
+
+void sort_set_threads(int n) { thread_setting = n; }
+
+// Large arrays get one part per thread, but never parts so small that
+// starting a thread costs more than the work it saves.
+static int part_count(size_t n) {
+    if (n < SORT_MT_MIN) return 1;
+    long t = thread_setting > 0 ? thread_setting : sysconf(_SC_NPROCESSORS_ONLN);
+    size_t most = n / (SORT_MT_MIN / 2);
+    if (t < 1) t = 1;
+    if (t > MAX_PARTS) t = MAX_PARTS;
+    if ((size_t)t > most) t = (long)most;
+    return (int)t;
+}
+
+typedef void (*part_fn)(void *ctx, int k);
+typedef struct { part_fn fn; void *ctx; int k; } PartJob;
+
+static void *part_main(void *arg) {
+    PartJob *j = arg;
+    j->fn(j->ctx, j->k);
+    return NULL;
+}
+
+// Part 0 runs on the calling thread, and a part whose thread cannot be
+// started runs inline instead.
+static void run_parts(int parts, part_fn fn, void *ctx) {
+    PartJob job[MAX_PARTS];
+    pthread_t tid[MAX_PARTS];
+    int started[MAX_PARTS] = {0};
+    for (int k = 0; k < parts; k++) job[k] = (PartJob){fn, ctx, k};
+    for (int k = 1; k < parts; k++) {
+        started[k] = pthread_create(&tid[k], NULL, part_main, &job[k]) == 0;
+        if (!started[k]) part_main(&job[k]);
+    }
+    part_main(&job[0]);
+    for (int k = 1; k < parts; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+}
+
+// ---- keys -------------------------------------------------------------------
+
+// Unsigned keys that order as the elements do: the sign bit flipped for
+// integers; for doubles also every other bit of a negative value.
+static inline uint32_t key_i32(int32_t x) { return (uint32_t)x ^ 0x80000000u; }
+static inline u64 key_i64(int64_t x) { return (u64)x ^ (1ULL << 63); }
+static inline u64 key_f64(double x) {
+    u64 b;
+    memcpy(&b, &x, sizeof b);
+    return b ^ ((u64)((int64_t)b >> 63) | 1ULL << 63);
+}
+
+// ---- one instance per type ------------------------------------------------------
+
+#define NS_NAME i32
+#define NS_T int32_t
+#define NS_K uint32_t
+#define NS_KEY(x) key_i32(x)
+#define NS_LT(x, y) ((x) < (y))
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
+
+#define NS_NAME u32
+#define NS_T uint32_t
+#define NS_K uint32_t
+#define NS_KEY(x) (x)
+#define NS_LT(x, y) ((x) < (y))
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
+
+#define NS_NAME i64
+#define NS_T int64_t
+#define NS_K u64
+#define NS_KEY(x) key_i64(x)
+#define NS_LT(x, y) ((x) < (y))
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
+
+#define NS_NAME f64
+#define NS_T double
+#define NS_K u64
+#define NS_KEY(x) key_f64(x)
+#define NS_LT(x, y) (key_f64(x) < key_f64(y))
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
+
+#define NS_NAME kv32
+#define NS_T KV32
+#define NS_K uint32_t
+#define NS_KEY(x) key_i32((x).key)
+#define NS_LT(x, y) ((x).key < (y).key)
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
+
+#define NS_NAME kv64
+#define NS_T KV64
+#define NS_K u64
+#define NS_KEY(x) key_i64((x).key)
+#define NS_LT(x, y) ((x).key < (y).key)
+#include "numsort_impl.h"
+#undef NS_NAME
+#undef NS_T
+#undef NS_K
+#undef NS_KEY
+#undef NS_LT
@@ -0,0 +1,46 @@
+#ifndef NUMSORT_H
+#define NUMSORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Ascending sorts specialized per element type, for the places that
+// called qsort with a comparison function. Every type gets three:
+//   sort_T         unstable and in place: introsort with branchless
+//                  partitioning, a sorting network for 16 elements or
+//                  fewer, and heapsort if partitions keep coming out
+//                  lopsided. Runs of equal elements cost one pass.
+//   sort_T_stable  stable: LSD radix sort, 8 bits per pass, skipping
+//                  passes where every key has the same byte.
+//   psort_T        stable: one part per thread is radix sorted, then the
+//                  runs are merged pairwise in parallel.
+// The stable sorts need n elements of scratch and return false, with the
+// array unchanged, when it cannot be allocated.
+//
+// Doubles are ordered as IEEE 754 totalOrder: -NaN < -inf < ... < -0.0
+// < +0.0 < ... < inf < NaN, so NaNs never break a sort.
+
+// Arrays with at least this many elements are split across threads.
+#define SORT_MT_MIN ((size_t)1 << 16)
+
+// 0 (the default) means one thread per online CPU; 1 never spawns threads.
+void sort_set_threads(int n);
+
+// Key-value pairs, ordered by key alone; the value moves with its key.
+typedef struct { int32_t key; uint32_t val; } KV32;
+typedef struct { int64_t key; uint64_t val; } KV64;
+
+#define DECLARE_SORTS(name, T)                 \
+    void sort_##name(T *a, size_t n);          \
+    bool sort_##name##_stable(T *a, size_t n); \
+    bool psort_##name(T *a, size_t n);
+
+DECLARE_SORTS(i32, int32_t)
+DECLARE_SORTS(u32, uint32_t)
+DECLARE_SORTS(i64, int64_t)
+DECLARE_SORTS(f64, double)
+DECLARE_SORTS(kv32, KV32)
+DECLARE_SORTS(kv64, KV64)
+
+#endif
@@ -0,0 +1,239 @@
+// Sort bodies for numsort.c, which includes this file once per element
+// type with NS_NAME (name suffix), NS_T (element), NS_K (unsigned radix
+// key), NS_KEY(x) (the key, ordered as the elements) and NS_LT(x, y)
+// defined. Everything here is static; the public functions are at the end.
+
+#define NS_CAT2(a, b) a##_##b
+#define NS_CAT(a, b) NS_CAT2(a, b)
+#define F(name) NS_CAT(name, NS_NAME)
+#define T NS_T
+
+// ---- small pieces -------------------------------------------------------------
+
+// Compare-exchange without a branch: min to a[i], max to a[j].
+static inline void F(ce)(T *a, size_t i, size_t j) {
+    T x = a[i], y = a[j];
+    bool s = NS_LT(y, x);
+    a[i] = s ? y : x;
+    a[j] = s ? x : y;
+}
+
+static inline void F(swap)(T *a, size_t i, size_t j) { T t = a[i]; a[i] = a[j]; a[j] = t; }
+
+// Batcher's network for 16, leaving out comparators that reach past n.
+static void F(network)(T *a, size_t n) {
+    for (size_t c = 0; c < NET_PAIRS; c++)
+        if (net[c][1] < n) F(ce)(a, net[c][0], net[c][1]);
+}
+
+static void F(sift)(T *a, size_t n, size_t i) {
+    T x = a[i];
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= n) break;
+        if (c + 1 < n && NS_LT(a[c], a[c + 1])) c++;
+        if (!NS_LT(x, a[c])) break;
+        a[i] = a[c];
+        i = c;
+    }
+    a[i] = x;
+}
+
+static void F(heapsort)(T *a, size_t n) {
+    for (size_t i = n / 2; i-- > 0;) F(sift)(a, n, i);
+    for (size_t e = n; e-- > 1;) {
+        F(swap)(a, 0, e);
+        F(sift)(a, e, 0);
+    }
+}
+
+// ---- introsort ----------------------------------------------------------------
+
+// The pivot is a[0]. Branchless Lomuto: every element is written, and
+// the ones below the pivot (or not above it) end up in a[1..k); returns k.
+static inline size_t F(part_lt)(T *a, size_t n) {
+    T p = a[0];
+    size_t k = 1;
+    for (size_t i = 1; i < n; i++) {
+        T x = a[i];
+        bool s = NS_LT(x, p);
+        a[i] = a[k];
+        a[k] = x;
+        k += s;
+    }
+    return k;
+}
+
+static inline size_t F(part_le)(T *a, size_t n) {
+    T p = a[0];
+    size_t k = 1;
+    for (size_t i = 1; i < n; i++) {
+        T x = a[i];
+        bool s = !NS_LT(p, x);
+        a[i] = a[k];
+        a[k] = x;
+        k += s;
+    }
+    return k;
+}
+
+// Median of three, or of three medians above 128 elements, moved to a[0].
+static inline void F(pick_pivot)(T *a, size_t n) {
+    size_t h = n / 2;
+    F(ce)(a, 0, h); F(ce)(a, h, n - 1); F(ce)(a, 0, h);
+    if (n > 128) {
+        F(ce)(a, 1, h - 1); F(ce)(a, h - 1, n - 2); F(ce)(a, 1, h - 1);
+        F(ce)(a, 2, h + 1); F(ce)(a, h + 1, n - 3); F(ce)(a, 2, h + 1);
+        F(ce)(a, h - 1, h); F(ce)(a, h, h + 1); F(ce)(a, h - 1, h);
+    }
+    F(swap)(a, 0, h);
+}
+
+// Unless a is leftmost, a[-1] is no greater than any element. A pivot
+// equal to it means every element not above the pivot equals it: those
+// are done in one pass, so runs of duplicates cost O(n).
+static void F(intro)(T *a, size_t n, int budget, bool leftmost) {
+    while (n > NET_N) {
+        if (budget-- == 0) { F(heapsort)(a, n); return; }
+        F(pick_pivot)(a, n);
+        if (!leftmost && !NS_LT(a[-1], a[0])) {
+            size_t k = F(part_le)(a, n);
+            a += k;
+            n -= k;
+            continue;
+        }
+        size_t k = F(part_lt)(a, n);
+        F(swap)(a, 0, k - 1);
+        // Recurse into the smaller side, loop on the larger.
+        if (k - 1 < n - k) {
+            F(intro)(a, k - 1, budget, leftmost);
+            a += k;
+            n -= k;
+            leftmost = false;
+        } else {
+            F(intro)(a + k, n - k, budget, false);
+            n = k - 1;
+        }
+    }
+    F(network)(a, n);
+}
+
+// ---- radix sort -----------------------------------------------------------------
+
+static void F(insertion)(T *a, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        T x = a[i];
+        size_t j = i;
+        for (; j > 0 && NS_LT(x, a[j - 1]); j--) a[j] = a[j - 1];
+        a[j] = x;
+    }
+}
+
+// All byte histograms come from one pass over the keys; a byte that is
+// the same in every key needs no pass of its own.
+static void F(radix)(T *a, T *tmp, size_t n) {
+    enum { B = sizeof(NS_K) };
+    size_t count[B][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        NS_K k = NS_KEY(a[i]);
+        for (int b = 0; b < B; b++) count[b][k >> (8 * b) & 0xff]++;
+    }
+    T *src = a, *dst = tmp;
+    for (int b = 0; b < B; b++) {
+        size_t *c = count[b];
+        if (c[NS_KEY(src[0]) >> (8 * b) & 0xff] == n) continue;
+        for (size_t d = 0, at = 0; d < 256; d++) { size_t m = c[d]; c[d] = at; at += m; }
+        for (size_t i = 0; i < n; i++) {
+            T x = src[i];
+            dst[c[NS_KEY(x) >> (8 * b) & 0xff]++] = x;
+        }
+        T *t = src; src = dst; dst = t;
+    }
+    if (src != a) memcpy(a, src, n * sizeof *a);
+}
+
+// Stable: on equal keys the left run goes first.
+static void F(merge)(const T *x, size_t nx, const T *y, size_t ny, T *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < nx && j < ny) {
+        bool s = NS_LT(y[j], x[i]);
+        out[k++] = s ? y[j] : x[i];
+        j += s;
+        i += !s;
+    }
+    memcpy(out + k, x + i, (nx - i) * sizeof *x);
+    memcpy(out + k + nx - i, y + j, (ny - j) * sizeof *y);
+}
+
+// ---- parallel sort ----------------------------------------------------------------
+
+// Runs [at[r], at[r + 1]) of src; part k first radix sorts run k, then in
+// each round merges runs 2k and 2k + 1 into dst.
+typedef struct { T *src, *dst; size_t at[MAX_PARTS + 1]; int runs; } F(Runs);
+
+static void F(sort_run)(void *ctx, int k) {
+    F(Runs) *r = ctx;
+    F(radix)(r->src + r->at[k], r->dst + r->at[k], r->at[k + 1] - r->at[k]);
+}
+
+static void F(merge_pair)(void *ctx, int k) {
+    F(Runs) *r = ctx;
+    size_t lo = r->at[2 * k], mid = r->at[2 * k + 1];
+    size_t hi = 2 * k + 2 <= r->runs ? r->at[2 * k + 2] : mid;
+    F(merge)(r->src + lo, mid - lo, r->src + mid, hi - mid, r->dst + lo);
+}
+
+// ---- public entry points ------------------------------------------------------------
+
+// Stops at the first pair out of order, so on unsorted input it is cheap.
+static bool F(is_sorted)(const T *a, size_t n) {
+    for (size_t i = 1; i < n; i++)
+        if (NS_LT(a[i], a[i - 1])) return false;
+    return true;
+}
+
+void F(sort)(T *a, size_t n) {
+    if (n < 2 || F(is_sorted)(a, n)) return;
+    int budget = 0;
+    for (size_t m = n; m > 1; m >>= 1) budget += 2;
+    F(intro)(a, n, budget, true);
+}
+
+bool NS_CAT(F(sort), stable)(T *a, size_t n) {
+    if (n <= 32) { F(insertion)(a, n); return true; }
+    if (F(is_sorted)(a, n)) return true;
+    T *tmp = malloc(n * sizeof *tmp);
+    if (!tmp) return false;
+    F(radix)(a, tmp, n);
+    free(tmp);
+    return true;
+}
+
+bool F(psort)(T *a, size_t n) {
+    int parts = part_count(n);
+    if (parts == 1 || F(is_sorted)(a, n)) return NS_CAT(F(sort), stable)(a, n);
+    T *tmp = malloc(n * sizeof *tmp);
+    if (!tmp) return false;
+    F(Runs) r = {a, tmp, {0}, parts};
+    for (int k = 0; k <= parts; k++) r.at[k] = n / (size_t)parts * (size_t)k;
+    r.at[parts] = n;
+    run_parts(parts, F(sort_run), &r);
+
+    // An odd run out goes through merge_pair with an empty partner.
+    while (r.runs > 1) {
+        int pairs = (r.runs + 1) / 2;
+        run_parts(pairs, F(merge_pair), &r);
+        for (int k = 0; k < pairs; k++) r.at[k] = r.at[2 * k];
+        r.at[pairs] = n;
+        r.runs = pairs;
+        T *t = r.src; r.src = r.dst; r.dst = t;
+    }
+    if (r.src != a) memcpy(a, r.src, n * sizeof *a);
+    free(tmp);
+    return true;
+}
+
+#undef T
+#undef F
+#undef NS_CAT
+#undef NS_CAT2
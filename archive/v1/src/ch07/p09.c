@@ -1,12 +1,19 @@
+// gcc -std=c23 -O2 p09.c map.c -o p09
 #include <stdio.h>
+#include "map.h"
 
-int square(int x) { return x * x; }
-int cube(int x)   { return x * x * x; }
+MAP_DEFINE(square, int, x * x)
+MAP_DEFINE(cube, int, x * x * x)
 
 int main(void) {
-    int (*fp)(int) = square;
-    printf("square(4)=%d\n", fp(4));
-    fp = cube;
-    printf("cube(3)=%d\n", fp(3));
+    int in[] = {4, 3}, out[2];
+    // Still chosen at run time, but the pointer is called once per block
+    // of up to MAP_BLOCK elements instead of once per element.
+    MapStage fp = {square_block, NULL};
+    map_run(&in[0], &out[0], 1, sizeof(int), &fp, 1);
+    printf("square(4)=%d\n", out[0]);
+    fp.f = cube_block;
+    map_run(&in[1], &out[1], 1, sizeof(int), &fp, 1);
+    printf("cube(3)=%d\n", out[1]);
     return 0;
 }
@@ -1,14 +1,21 @@
+// gcc -std=c23 -O2 p10.c -o p10
 #include <stdio.h>
+#include "map.h"
 
-int square(int x) { return x * x; }
-int cube(int x)   { return x * x * x; }
+// Each defines square(in, out, n) with x * x inlined into the loop.
+MAP_DEFINE(square, int, x * x)
+MAP_DEFINE(cube, int, x * x * x)
 
-void apply(int (*f)(int), int x) {
-    printf("%d\n", f(x));
+static void print_all(const int *a, size_t n) {
+    for (size_t i = 0; i < n; i++) printf("%d\n", a[i]);
 }
 
 int main(void) {
-    apply(square, 5);
-    apply(cube, 4);
+    int in[] = {5}, out[1];
+    square(in, out, 1);
+    print_all(out, 1);
+    in[0] = 4;
+    cube(in, out, 1);
+    print_all(out, 1);
     return 0;
 }
@@ -1,16 +1,19 @@
+// gcc -std=c23 -O2 -I../ch05 p11.c vm.c ../ch05/cpu_dispatch.c -o p11
+#include <inttypes.h>
 #include <stdio.h>
-
-int add(int a,int b){return a+b;}
-int sub(int a,int b){return a-b;}
-int mul(int a,int b){return a*b;}
-int div_int(int a,int b){return a/b;} // assume b!=0 for this exercise
+#include "vm.h"
 
 int main(void) {
-    int (*ops[4])(int,int) = {add, sub, mul, div_int};
-    int a = 12, b = 3;
+    // r0 = a, r1 = b; one two-instruction program per operation.
+    const VmOp ops[4] = {VM_ADD, VM_SUB, VM_MUL, VM_DIV};
     const char *names[4] = {"add","sub","mul","div"};
+    int32_t in[2] = {12, 3};
     for (int i = 0; i < 4; i++) {
-        printf("%s=%d\n", names[i], ops[i](a,b));
+        VmInsn code[] = {{(uint8_t)ops[i], 2, 0, 1}, {VM_RET, 0, 2, 0}};
+        VmProg *p = vm_new(code, 2, NULL, 0, 2);
+        if (!p) return 1;
+        printf("%s=%" PRId32 "\n", names[i], vm_run(p, in));
+        vm_free(p);
     }
     return 0;
 }
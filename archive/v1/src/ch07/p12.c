@@ -1,23 +1,26 @@
+// gcc -std=c23 -O2 -I../ch05 p12.c vm.c ../ch05/cpu_dispatch.c -o p12
+#include <inttypes.h>
 #include <stdio.h>
-
-int add(int a,int b){return a+b;}
-int sub(int a,int b){return a-b;}
-int mul(int a,int b){return a*b;}
-int div_int(int a,int b){return a/b;}
+#include "vm.h"
 
 int main(void) {
-    int a, b; char op;
-    if (scanf("%d %d %c", &a, &b, &op) != 3) return 0;
+    int32_t in[2]; char op;
+    if (scanf("%" SCNd32 " %" SCNd32 " %c", &in[0], &in[1], &op) != 3) return 0;
 
-    int (*f)(int,int) = NULL;
+    VmOp code_op;
     switch (op) {
-        case '+': f = add; break;
-        case '-': f = sub; break;
-        case '*': f = mul; break;
-        case '/': f = div_int; break;
+        case '+': code_op = VM_ADD; break;
+        case '-': code_op = VM_SUB; break;
+        case '*': code_op = VM_MUL; break;
+        case '/': code_op = VM_DIV; break;
         default: puts("unknown op"); return 0;
     }
-    if (op == '/' && b == 0) { puts("divide by zero"); return 0; }
-    printf("%d\n", f(a,b));
+    if (op == '/' && in[1] == 0) { puts("divide by zero"); return 0; }
+
+    VmInsn code[] = {{(uint8_t)code_op, 2, 0, 1}, {VM_RET, 0, 2, 0}};
+    VmProg *p = vm_new(code, 2, NULL, 0, 2);
+    if (!p) return 1;
+    printf("%" PRId32 "\n", vm_run(p, in));
+    vm_free(p);
     return 0;
 }
@@ -1,18 +1,13 @@
+// gcc -std=c23 -O2 -pthread p20.c numsort.c -o p20
 #include <stdio.h>
-#include <stdlib.h>
-
-int cmp_int(const void *a, const void *b) {
-    int x = *(const int*)a;
-    int y = *(const int*)b;
-    // Avoid overflow; return negative/0/positive
-    return (x > y) - (x < y);
-}
+#include "numsort.h"
 
 int main(void) {
-    int arr[] = {4, 2, 5, 1, 3};
+    int32_t arr[] = {4, 2, 5, 1, 3};
     size_t n = sizeof(arr)/sizeof(arr[0]);
 
-    qsort(arr, n, sizeof(arr[0]), cmp_int);
+    // No comparison callback: the compare is inlined for int32_t.
+    sort_i32(arr, n);
 
     for (size_t i = 0; i < n; i++) printf("%d ", arr[i]);
     printf("\n");
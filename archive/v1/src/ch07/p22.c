@@ -0,0 +1,126 @@
+// One arithmetic script over 16M input rows, four ways: a function pointer
+// call per operation as in p11, vm_run per row, vm_run_batch, and the same
+// formula compiled as C. All four must agree.
+// gcc -std=c23 -O2 -I../ch05 p22.c vm.c ../ch05/cpu_dispatch.c -o p22
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vm.h"
+
+#define N (16 << 20)
+
+static const char script[] =
+    "# ((3x + y) * x - y / 7) % 1009 + pow(x % 13, 3), x = r0, y = r1\n"
+    "li  r2 3\n"
+    "mul r2 r2 r0\n"
+    "add r2 r2 r1\n"
+    "mul r2 r2 r0\n"
+    "li  r3 7\n"
+    "div r3 r1 r3\n"
+    "sub r2 r2 r3\n"
+    "li  r3 1009\n"
+    "mod r2 r2 r3\n"
+    "li  r3 13\n"
+    "mod r4 r0 r3\n"
+    "li  r3 3\n"
+    "pow r4 r4 r3\n"
+    "add r2 r2 r4\n"
+    "ret r2\n";
+
+static int32_t native(int32_t x, int32_t y) {
+    uint32_t t = (3u * (uint32_t)x + (uint32_t)y) * (uint32_t)x - (uint32_t)(y / 7);
+    int32_t m = x % 13;
+    return (int32_t)t % 1009 + m * m * m;
+}
+
+// The function pointer version: one call per operation.
+typedef struct Step Step;
+struct Step { void (*f)(int32_t *r, const Step *s); uint8_t d, a, b; int32_t k; };
+
+static void f_li(int32_t *r, const Step *s)  { r[s->d] = s->k; }
+static void f_add(int32_t *r, const Step *s) { r[s->d] = (int32_t)((uint32_t)r[s->a] + (uint32_t)r[s->b]); }
+static void f_sub(int32_t *r, const Step *s) { r[s->d] = (int32_t)((uint32_t)r[s->a] - (uint32_t)r[s->b]); }
+static void f_mul(int32_t *r, const Step *s) { r[s->d] = (int32_t)((uint32_t)r[s->a] * (uint32_t)r[s->b]); }
+static void f_div(int32_t *r, const Step *s) { r[s->d] = r[s->b] ? r[s->a] / r[s->b] : 0; }
+static void f_mod(int32_t *r, const Step *s) { r[s->d] = r[s->b] ? r[s->a] % r[s->b] : 0; }
+static void f_pow(int32_t *r, const Step *s) {
+    uint32_t x = 1, b = (uint32_t)r[s->a];
+    for (int32_t e = r[s->b]; e > 0; e >>= 1) { if (e & 1) x *= b; b *= b; }
+    r[s->d] = r[s->b] < 0 ? 0 : (int32_t)x;
+}
+
+static const Step steps[] = {
+    {f_li, 2, 0, 0, 3}, {f_mul, 2, 2, 0, 0}, {f_add, 2, 2, 1, 0}, {f_mul, 2, 2, 0, 0},
+    {f_li, 3, 0, 0, 7}, {f_div, 3, 1, 3, 0}, {f_sub, 2, 2, 3, 0},
+    {f_li, 3, 0, 0, 1009}, {f_mod, 2, 2, 3, 0},
+    {f_li, 3, 0, 0, 13}, {f_mod, 4, 0, 3, 0}, {f_li, 3, 0, 0, 3}, {f_pow, 4, 4, 3, 0},
+    {f_add, 2, 2, 4, 0}, {NULL, 0, 0, 0, 0}
+};
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int main(void) {
+    int line;
+    VmProg *p = vm_assemble(script, 2, &line);
+    if (!p) { fprintf(stderr, "script: error at line %d\n", line); return 1; }
+
+    int32_t *x = malloc(N * sizeof *x), *y = malloc(N * sizeof *y);
+    int32_t *want = malloc(N * sizeof *want), *got = malloc(N * sizeof *got);
+    if (!x || !y || !want || !got) return 1;
+    for (size_t i = 0; i < N; i++) {
+        x[i] = (int32_t)next_rand();
+        y[i] = (int32_t)(next_rand() % 2000001) - 1000000;
+    }
+
+    double t0 = now_ms();
+    for (size_t i = 0; i < N; i++) want[i] = native(x[i], y[i]);
+    double t_c = now_ms() - t0;
+
+    bool ok = true;
+    t0 = now_ms();
+    for (size_t i = 0; i < N; i++) {
+        int32_t r[VM_REGS] = {x[i], y[i]};
+        const Step *s = steps;
+        for (; s->f; s++) s->f(r, s);
+        got[i] = r[2];
+    }
+    double t_fp = now_ms() - t0;
+    bool same = memcmp(got, want, N * sizeof *got) == 0;
+    ok &= same;
+    printf("function pointer per op %8.1f ms%s\n", t_fp, same ? "" : "  WRONG");
+
+    memset(got, 0, N * sizeof *got);
+    t0 = now_ms();
+    for (size_t i = 0; i < N; i++) got[i] = vm_run(p, (int32_t[]){x[i], y[i]});
+    double ms = now_ms() - t0;
+    same = memcmp(got, want, N * sizeof *got) == 0;
+    ok &= same;
+    printf("vm_run per row          %8.1f ms  %5.1fx%s\n", ms, t_fp / ms, same ? "" : "  WRONG");
+
+    memset(got, 0, N * sizeof *got);
+    t0 = now_ms();
+    vm_run_batch(p, (const int32_t *const[]){x, y}, got, N);
+    ms = now_ms() - t0;
+    same = memcmp(got, want, N * sizeof *got) == 0;
+    ok &= same;
+    printf("vm_run_batch            %8.1f ms  %5.1fx%s\n", ms, t_fp / ms, same ? "" : "  WRONG");
+    printf("compiled C              %8.1f ms  %5.1fx\n", t_c, t_fp / t_c);
+
+    vm_free(p);
+    free(x); free(y); free(want); free(got);
+    puts(ok ? "all results match" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,143 @@
+// map.h against a function pointer called per element, as in p10's
+// apply(), on 16M ints: map, a three-stage pipeline, zip, filter and
+// map-reduce. Every pair must give the same result.
+// gcc -std=c23 -O2 p23.c map.c -o p23
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "map.h"
+
+#define N (16 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// ---- the function pointer versions --------------------------------------------
+// noipa keeps the compiler from cloning them for a known f.
+
+static int poly(int x)   { return x * x + 3 * x; }
+static int scale(int x)  { return x * 3 + 1; }
+static int mix(int x)    { return x ^ (x >> 3); }
+static int mask(int x)   { return x & 0xffff; }
+static int madd(int x, int y) { return x * y + 1; }
+static int every8(int x) { return (x & 7) == 0; }
+static long long sq(int x) { return (long long)x * x; }
+
+__attribute__((noipa))
+static void map_fp(int (*f)(int), const int *in, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = f(in[i]);
+}
+
+__attribute__((noipa))
+static void pipe_fp(int (*const *f)(int), int stages, const int *in, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int x = in[i];
+        for (int s = 0; s < stages; s++) x = f[s](x);
+        out[i] = x;
+    }
+}
+
+__attribute__((noipa))
+static void zip_fp(int (*f)(int, int), const int *xs, const int *ys, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = f(xs[i], ys[i]);
+}
+
+__attribute__((noipa))
+static size_t filter_fp(int (*p)(int), const int *in, int *out, size_t n) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+        if (p(in[i])) out[k++] = in[i];
+    return k;
+}
+
+__attribute__((noipa))
+static long long reduce_fp(long long (*f)(int), const int *in, size_t n) {
+    long long acc = 0;
+    for (size_t i = 0; i < n; i++) acc += f(in[i]);
+    return acc;
+}
+
+// ---- the same with map.h ----------------------------------------------------------
+
+MAP_DEFINE(poly_all, int, x * x + 3 * x)
+MAP_DEFINE(scale_all, int, x * 3 + 1)
+MAP_DEFINE(mix_all, int, x ^ (x >> 3))
+MAP_DEFINE(mask_all, int, x & 0xffff)
+MAP_DEFINE(pipe_all, int, mask_all_f(mix_all_f(scale_all_f(x))))
+ZIP_DEFINE(madd_all, int, x * y + 1)
+FILTER_DEFINE(every8_all, int, (x & 7) == 0)
+MAPREDUCE_DEFINE(sum_sq, int, long long, (long long)x * x, a + b, 0)
+
+static double t0;
+static void start(void) { t0 = now_ms(); }
+static double stop(void) { return now_ms() - t0; }
+
+static bool report(const char *what, double t_fp, double t_map, bool same) {
+    printf("%-30s %8.1f ms %8.1f ms  %5.1fx%s\n", what, t_fp, t_map, t_fp / t_map, same ? "" : "  WRONG");
+    return same;
+}
+
+int main(void) {
+    int *x = malloc(N * sizeof *x), *y = malloc(N * sizeof *y);
+    int *a = malloc(N * sizeof *a), *b = malloc(N * sizeof *b);
+    if (!x || !y || !a || !b) return 1;
+    // Small enough that none of the int expressions overflow.
+    for (size_t i = 0; i < N; i++) {
+        x[i] = (int)(next_rand() % 40000) - 20000;
+        y[i] = (int)(next_rand() % 40000) - 20000;
+    }
+    // One untimed pass first, so no timing includes page faults or the
+    // clock ramping up.
+    map_fp(poly, x, a, N);
+    poly_all(x, b, N);
+    bool ok = true;
+    double t1, t2;
+    printf("%-30s %11s %11s\n", "", "fn pointer", "map.h");
+
+    start(); map_fp(poly, x, a, N); t1 = stop();
+    start(); poly_all(x, b, N); t2 = stop();
+    ok &= report("map", t1, t2, !memcmp(a, b, N * sizeof *a));
+
+    MapStage one = {poly_all_block, NULL};
+    memset(b, 0, N * sizeof *b);
+    start(); map_run(x, b, N, sizeof(int), &one, 1); t2 = stop();
+    ok &= report("map, map_run", t1, t2, !memcmp(a, b, N * sizeof *a));
+
+    int (*const fs[3])(int) = {scale, mix, mask};
+    start(); pipe_fp(fs, 3, x, a, N); t1 = stop();
+    MapStage three[3] = {{scale_all_block, NULL}, {mix_all_block, NULL}, {mask_all_block, NULL}};
+    memset(b, 0, N * sizeof *b);
+    start(); map_run(x, b, N, sizeof(int), three, 3); t2 = stop();
+    ok &= report("3-stage pipeline, map_run", t1, t2, !memcmp(a, b, N * sizeof *a));
+    memset(b, 0, N * sizeof *b);
+    start(); pipe_all(x, b, N); t2 = stop();
+    ok &= report("3-stage pipeline, fused", t1, t2, !memcmp(a, b, N * sizeof *a));
+
+    start(); zip_fp(madd, x, y, a, N); t1 = stop();
+    start(); madd_all(x, y, b, N); t2 = stop();
+    ok &= report("zip", t1, t2, !memcmp(a, b, N * sizeof *a));
+
+    start(); size_t ka = filter_fp(every8, x, a, N); t1 = stop();
+    start(); size_t kb = every8_all(x, b, N); t2 = stop();
+    ok &= report("filter", t1, t2, ka == kb && !memcmp(a, b, ka * sizeof *a));
+
+    start(); long long ra = reduce_fp(sq, x, N); t1 = stop();
+    start(); long long rb = sum_sq(x, N); t2 = stop();
+    ok &= report("map-reduce", t1, t2, ra == rb);
+
+    free(x); free(y); free(a); free(b);
+    puts(ok ? "all results match" : "MISMATCH");
+    return !ok;
+}
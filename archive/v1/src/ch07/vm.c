@@ -0,0 +1,269 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vm.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#endif
+
+// The block loops are meant to vectorize, which -O2's very cheap cost
+// model mostly declines.
+#pragma GCC optimize("vect-cost-model=dynamic")
+
+#define VM_BLOCK 256      // rows per instruction in vm_run_batch
+
+// Threaded code: the handler address and the operands. k is the VM_LI
+// constant, so no pool lookup happens at run time, or for a binary op
+// whose r[b] always holds a known constant (kb), that constant.
+typedef struct { const void *go; uint8_t op, d, a, b; bool kb; int32_t k; } Op;
+
+struct VmProg {
+    Op *code;
+    int nin;
+    unsigned written;     // bit r: some instruction writes r
+};
+
+// ---- arithmetic (ch11/p20_calc.c semantics, without overflow UB) --------------
+
+static inline int32_t add_w(int32_t x, int32_t y) { return (int32_t)((uint32_t)x + (uint32_t)y); }
+static inline int32_t sub_w(int32_t x, int32_t y) { return (int32_t)((uint32_t)x - (uint32_t)y); }
+static inline int32_t mul_w(int32_t x, int32_t y) { return (int32_t)((uint32_t)x * (uint32_t)y); }
+
+static inline int32_t div_w(int32_t x, int32_t y) {
+    if (y == 0) return 0;
+    if (y == -1) return sub_w(0, x);
+    return x / y;
+}
+
+static inline int32_t mod_w(int32_t x, int32_t y) {
+    return y == 0 || y == -1 ? 0 : x % y;
+}
+
+static inline int32_t pow_w(int32_t base, int32_t exp) {
+    if (exp < 0) return 0;
+    uint32_t r = 1, b = (uint32_t)base;
+    while (exp) { if (exp & 1) r *= b; b *= b; exp >>= 1; }
+    return (int32_t)r;
+}
+
+// ---- interpreters ---------------------------------------------------------------
+
+// Handler addresses exist only inside the function that holds the labels,
+// so exec hands its table out when called with ip == NULL.
+static const void *const *labels;
+
+static int32_t exec(const Op *ip, int32_t *r) {
+    static const void *const table[VM_NOPS] = {
+        [VM_LI] = &&li, [VM_MOV] = &&mov, [VM_ADD] = &&add, [VM_SUB] = &&sub,
+        [VM_MUL] = &&mul, [VM_DIV] = &&div, [VM_MOD] = &&mod, [VM_POW] = &&pow,
+        [VM_RET] = &&ret
+    };
+    if (!ip) { labels = table; return 0; }
+
+#define NEXT goto *(++ip)->go
+    goto *ip->go;
+li:  r[ip->d] = ip->k; NEXT;
+mov: r[ip->d] = r[ip->a]; NEXT;
+add: r[ip->d] = add_w(r[ip->a], r[ip->b]); NEXT;
+sub: r[ip->d] = sub_w(r[ip->a], r[ip->b]); NEXT;
+mul: r[ip->d] = mul_w(r[ip->a], r[ip->b]); NEXT;
+div: r[ip->d] = div_w(r[ip->a], r[ip->b]); NEXT;
+mod: r[ip->d] = mod_w(r[ip->a], r[ip->b]); NEXT;
+pow: r[ip->d] = pow_w(r[ip->a], r[ip->b]); NEXT;
+ret: return r[ip->a];
+#undef NEXT
+}
+
+// ---- block interpreter --------------------------------------------------------
+
+// With AVX2 the 32-bit multiplies are one instruction.
+#define VB_ISA base
+#include "vm_block.h"
+#undef VB_ISA
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define VB_ISA avx2
+#include "vm_block.h"
+#undef VB_ISA
+#pragma GCC pop_options
+#endif
+
+static void (*exec_block)(const Op *, int32_t *const *, int32_t *, size_t) = exec_block_base;
+
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar or sse2
+// keeps the baseline block loops.
+__attribute__((constructor))
+static void init(void) {
+    exec(NULL, NULL);
+#ifdef HAVE_X86
+    if (cpu_isa() >= ISA_AVX2) exec_block = exec_block_avx2;
+#endif
+}
+
+// ---- public entry points -------------------------------------------------------
+
+int32_t vm_run(const VmProg *p, const int32_t *in) {
+    int32_t r[VM_REGS];
+    memcpy(r, in, (size_t)p->nin * sizeof *r);
+    return exec(p->code, r);
+}
+
+void vm_run_batch(const VmProg *p, const int32_t *const *in, int32_t *out, size_t n) {
+    int32_t store[VM_REGS][VM_BLOCK];
+    int32_t *col[VM_REGS];
+    for (int r = 0; r < VM_REGS; r++) col[r] = store[r];
+    for (size_t at = 0; at < n; at += VM_BLOCK) {
+        size_t m = n - at < VM_BLOCK ? n - at : VM_BLOCK;
+        // Inputs the program never overwrites are read in place.
+        for (int k = 0; k < p->nin; k++) {
+            if (p->written >> k & 1) memcpy(store[k], in[k] + at, m * sizeof(int32_t));
+            else col[k] = (int32_t *)in[k] + at;
+        }
+        exec_block(p->code, col, out + at, m);
+    }
+}
+
+VmProg *vm_new(const VmInsn *code, size_t n, const int32_t *consts, size_t nconst, int nin) {
+    if (!n || code[n - 1].op != VM_RET || nin < 0 || nin > VM_REGS) return NULL;
+    unsigned defined = (1u << nin) - 1, written = 0;
+    VmProg *p = malloc(sizeof *p);
+    Op *ops = malloc(n * sizeof *ops);
+    if (!p || !ops) { free(p); free(ops); return NULL; }
+
+    // Registers last written by VM_LI hold a known constant.
+    unsigned known = 0;
+    int32_t value[VM_REGS];
+    for (size_t i = 0; i < n; i++) {
+        VmInsn c = code[i];
+        bool reads_a = c.op != VM_LI, reads_b = c.op >= VM_ADD && c.op <= VM_POW;
+        bool writes = c.op != VM_RET;
+        bool bad = c.op >= VM_NOPS || (c.op == VM_LI && c.a >= nconst)
+            || (reads_a && (c.a >= VM_REGS || !(defined >> c.a & 1)))
+            || (reads_b && (c.b >= VM_REGS || !(defined >> c.b & 1)))
+            || (writes && c.d >= VM_REGS);
+        if (bad) { free(p); free(ops); return NULL; }
+
+        Op o = {labels[c.op], c.op, c.d, c.a, c.b, false, 0};
+        if (c.op == VM_LI) o.k = consts[c.a];
+        else if (reads_b && (known >> c.b & 1)) { o.kb = true; o.k = value[c.b]; }
+        if (writes) {
+            defined |= 1u << c.d;
+            written |= 1u << c.d;
+            known &= ~(1u << c.d);
+            if (c.op == VM_LI) { known |= 1u << c.d; value[c.d] = o.k; }
+            if (c.op == VM_MOV && (known >> c.a & 1)) { known |= 1u << c.d; value[c.d] = value[c.a]; }
+        }
+        ops[i] = o;
+    }
+    *p = (VmProg){ops, nin, written};
+    return p;
+}
+
+void vm_free(VmProg *p) {
+    if (!p) return;
+    free(p->code);
+    free(p);
+}
+
+// ---- assembler -----------------------------------------------------------------
+
+static const char *const op_name[VM_NOPS] = {
+    "li", "mov", "add", "sub", "mul", "div", "mod", "pow", "ret"
+};
+
+static const char *skip_blank(const char *s) {
+    while (*s == ' ' || *s == '\t' || *s == '\r') s++;
+    return s;
+}
+
+static bool parse_reg(const char **s, uint8_t *r) {
+    const char *p = skip_blank(*s);
+    if (*p != 'r' || !isdigit((unsigned char)p[1])) return false;
+    char *end;
+    long v = strtol(p + 1, &end, 10);
+    if (v >= VM_REGS) return false;
+    *r = (uint8_t)v;
+    *s = end;
+    return true;
+}
+
+static bool parse_int(const char **s, int32_t *x) {
+    const char *p = skip_blank(*s);
+    if (!isdigit((unsigned char)*p) && !((*p == '-' || *p == '+') && isdigit((unsigned char)p[1])))
+        return false;
+    char *end;
+    long long v = strtoll(p, &end, 10);
+    if (v < INT32_MIN || v > INT32_MAX) return false;
+    *x = (int32_t)v;
+    *s = end;
+    return true;
+}
+
+// One instruction, or none for a blank or comment line.
+static bool parse_line(const char *s, VmInsn *c, int32_t *imm, bool *empty) {
+    s = skip_blank(s);
+    *empty = !*s || *s == '\n' || *s == '#';
+    if (*empty) return true;
+    size_t w = 0;
+    while (isalpha((unsigned char)s[w])) w++;
+    int op = 0;
+    while (op < VM_NOPS && !(strlen(op_name[op]) == w && !memcmp(s, op_name[op], w))) op++;
+    if (op == VM_NOPS) return false;
+    s += w;
+    *c = (VmInsn){(uint8_t)op, 0, 0, 0};
+    bool ok;
+    switch (op) {
+    case VM_LI:  ok = parse_reg(&s, &c->d) && parse_int(&s, imm); break;
+    case VM_MOV: ok = parse_reg(&s, &c->d) && parse_reg(&s, &c->a); break;
+    case VM_RET: ok = parse_reg(&s, &c->a); break;
+    default:     ok = parse_reg(&s, &c->d) && parse_reg(&s, &c->a) && parse_reg(&s, &c->b);
+    }
+    s = skip_blank(s);
+    return ok && (!*s || *s == '\n' || *s == '#');
+}
+
+VmProg *vm_assemble(const char *src, int nin, int *err_line) {
+    int dummy;
+    if (!err_line) err_line = &dummy;
+    *err_line = 0;
+    size_t n = 0, cap = 16, nconst = 0;
+    VmInsn *code = malloc(cap * sizeof *code);
+    int32_t *consts = malloc(256 * sizeof *consts);
+    VmProg *p = NULL;
+    if (!code || !consts) goto done;
+
+    for (int line = 1; *src; line++) {
+        VmInsn c;
+        int32_t imm = 0;
+        bool empty;
+        if (!parse_line(src, &c, &imm, &empty)) { *err_line = line; goto done; }
+        if (!empty) {
+            if (c.op == VM_LI) {
+                size_t k = 0;
+                while (k < nconst && consts[k] != imm) k++;
+                if (k == 256) { *err_line = line; goto done; }
+                if (k == nconst) consts[nconst++] = imm;
+                c.a = (uint8_t)k;
+            }
+            if (n == cap) {
+                VmInsn *t = realloc(code, 2 * cap * sizeof *code);
+                if (!t) goto done;
+                code = t;
+                cap *= 2;
+            }
+            code[n++] = c;
+        }
+        const char *nl = strchr(src, '\n');
+        src = nl ? nl + 1 : src + strlen(src);
+    }
+    p = vm_new(code, n, consts, nconst, nin);
+done:
+    free(code);
+    free(consts);
+    return p;
+}
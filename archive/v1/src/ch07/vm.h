@@ -0,0 +1,61 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A register machine for straight-line integer arithmetic, for scripts
+// that used to call add/sub/mul/div_int through a function-pointer table
+// once per operation. A program is compiled once into threaded code (each
+// instruction holds the address of its handler, reached by computed goto)
+// and can then be run by any number of threads.
+//
+// Arithmetic matches ch11/p20_calc.c: +, - and * wrap mod 2^32, x / 0 and
+// x % 0 are 0, INT32_MIN / -1 wraps to INT32_MIN, and pow with a negative
+// exponent is 0.
+
+#define VM_REGS 16
+
+typedef enum {
+    VM_LI,      // r[d] = consts[a]
+    VM_MOV,     // r[d] = r[a]
+    VM_ADD,     // r[d] = r[a] + r[b]
+    VM_SUB,
+    VM_MUL,
+    VM_DIV,
+    VM_MOD,
+    VM_POW,
+    VM_RET,     // the result is r[a]
+    VM_NOPS
+} VmOp;
+
+// The bytecode: four bytes per instruction.
+typedef struct { uint8_t op, d, a, b; } VmInsn;
+
+typedef struct VmProg VmProg;
+
+// Inputs arrive in r0 .. r[nin-1]; the last instruction must be VM_RET.
+// NULL if the code is malformed (a bad opcode, register or constant
+// index, or a register read before anything was written to it) or memory
+// ran out.
+VmProg *vm_new(const VmInsn *code, size_t n, const int32_t *consts, size_t nconst, int nin);
+
+// The same from text, one instruction per line:
+//   li r2 -7      mov r3 r2      add r2 r0 r1      ret r2
+// with ops li mov add sub mul div mod pow ret and '#' comments, and at
+// most 256 distinct li constants. On error returns NULL and, if err_line
+// is not NULL, sets it to the line that does not parse, or to 0 when
+// vm_new rejects the whole program or memory ran out.
+VmProg *vm_assemble(const char *src, int nin, int *err_line);
+
+void vm_free(VmProg *p);
+
+// One run: in holds the program's nin inputs.
+int32_t vm_run(const VmProg *p, const int32_t *in);
+
+// n runs: input k of run i is in[k][i], and its result goes to out[i].
+// Rows are taken in blocks, each instruction handling a whole block at a
+// time, so dispatch costs once per block and the loops vectorize.
+void vm_run_batch(const VmProg *p, const int32_t *const *in, int32_t *out, size_t n);
+
+#endif
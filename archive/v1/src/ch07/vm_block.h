@@ -0,0 +1,81 @@
+// The block interpreter for vm.c, which includes this file once per
+// instruction set with VB_ISA (name suffix) defined. It needs Op,
+// VM_BLOCK and the *_w helpers from vm.c.
+
+#define VB_CAT2(a, b) a##_##b
+#define VB_CAT(a, b) VB_CAT2(a, b)
+#define VB(name) VB_CAT(name, VB_ISA)
+
+// d[i] = x[i] / k, or x[i] % k when mod, for k > 0. The quotient comes
+// from a multiply by a rounded-up reciprocal of k: for |x| <= 2^31, taking
+// sh = 31 + ceil(log2 k) and mul = ceil(2^sh / k), which fits in 32 bits,
+// gives the exact floor of |x| / k (Granlund and Montgomery); the sign is
+// fixed afterwards. The multiply is 32 x 32 -> 64 bits, which SSE2 has.
+static void VB(div_k)(int32_t *d, const int32_t *x, int32_t k, size_t m, bool mod) {
+    int l = 0;
+    while ((1LL << l) < k) l++;
+    int sh = 31 + l;
+    uint32_t mul = (uint32_t)((((uint64_t)1 << sh) + (uint64_t)k - 1) / (uint64_t)k);
+#define QUOT(v) ((v) < 0 ? 0u - (uint32_t)((uint64_t)(0u - (uint32_t)(v)) * mul >> sh) \
+                         : (uint32_t)((uint64_t)(uint32_t)(v) * mul >> sh))
+    if (mod) for (size_t i = 0; i < m; i++) d[i] = (int32_t)((uint32_t)x[i] - QUOT(x[i]) * (uint32_t)k);
+    else     for (size_t i = 0; i < m; i++) d[i] = (int32_t)QUOT(x[i]);
+#undef QUOT
+}
+
+// d[i] = pow(x[i], e), e >= 0: square-and-multiply with the loop over
+// exponent bits outside the loop over rows.
+static void VB(pow_k)(int32_t *d, const int32_t *x, int32_t e, size_t m) {
+    uint32_t b[VM_BLOCK], r[VM_BLOCK];
+    for (size_t i = 0; i < m; i++) { b[i] = (uint32_t)x[i]; r[i] = 1; }
+    for (; e; e >>= 1) {
+        if (e & 1) for (size_t i = 0; i < m; i++) r[i] *= b[i];
+        if (e > 1) for (size_t i = 0; i < m; i++) b[i] *= b[i];
+    }
+    for (size_t i = 0; i < m; i++) d[i] = (int32_t)r[i];
+}
+
+// m rows at once: col[r] is register r for those rows. Each instruction
+// is a loop over the block, so dispatch goes through the op table. With a
+// constant right operand the loops need no per-row checks: division then
+// costs a multiply, and pow squares the whole block once per exponent bit.
+static void VB(exec_block)(const Op *ip, int32_t *const *col, int32_t *out, size_t m) {
+    static const void *const table[VM_NOPS] = {
+        [VM_LI] = &&li, [VM_MOV] = &&mov, [VM_ADD] = &&add, [VM_SUB] = &&sub,
+        [VM_MUL] = &&mul, [VM_DIV] = &&div, [VM_MOD] = &&mod, [VM_POW] = &&pow,
+        [VM_RET] = &&ret
+    };
+#define NEXT goto *table[(++ip)->op]
+#define EACH(f) do {                                                  \
+        int32_t *d = col[ip->d];                                      \
+        const int32_t *x = col[ip->a], *y = col[ip->b];               \
+        if (ip->kb) {                                                 \
+            int32_t k = ip->k;                                        \
+            for (size_t i = 0; i < m; i++) d[i] = f(x[i], k);         \
+        } else {                                                      \
+            for (size_t i = 0; i < m; i++) d[i] = f(x[i], y[i]);      \
+        }                                                             \
+    } while (0)
+    goto *table[ip->op];
+li:  { int32_t *d = col[ip->d]; for (size_t i = 0; i < m; i++) d[i] = ip->k; } NEXT;
+mov: memmove(col[ip->d], col[ip->a], m * sizeof(int32_t)); NEXT;
+add: EACH(add_w); NEXT;
+sub: EACH(sub_w); NEXT;
+mul: EACH(mul_w); NEXT;
+div: if (ip->kb && ip->k > 0) VB(div_k)(col[ip->d], col[ip->a], ip->k, m, false);
+     else EACH(div_w);
+     NEXT;
+mod: if (ip->kb && ip->k > 0) VB(div_k)(col[ip->d], col[ip->a], ip->k, m, true);
+     else EACH(mod_w);
+     NEXT;
+pow: if (ip->kb && ip->k >= 0) VB(pow_k)(col[ip->d], col[ip->a], ip->k, m);
+     else EACH(pow_w);
+     NEXT;
+ret: memcpy(out, col[ip->a], m * sizeof(int32_t));
+#undef EACH
+#undef NEXT
+}
+
+#undef VB
+#undef VB_CAT
+#undef VB_CAT2
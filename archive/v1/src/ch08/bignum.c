@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "bignum.h"
+
+typedef unsigned long long limb;
+typedef unsigned __int128 dlimb;
+
+#define KARATSUBA_MIN 32   // below this many limbs schoolbook is faster
+#define LEAF_FACTORS  16   // product-tree leaves multiply this many u64s
+#define DEC_BASECASE  32   // limbs converted by repeated division by 10^19
+
+static const limb TEN19 = 10000000000000000000ULL;
+
+static void *xmalloc(size_t n) {
+    void *p = malloc(n ? n : 1);
+    if (!p) { fputs("bignum: out of memory\n", stderr); exit(1); }
+    return p;
+}
+static limb *alloc_limbs(size_t n) { return xmalloc(n * sizeof(limb)); }
+static limb *zalloc_limbs(size_t n) { limb *p = alloc_limbs(n); memset(p, 0, n * sizeof(limb)); return p; }
+
+static size_t trim(const limb *a, size_t n) { while (n && a[n-1] == 0) n--; return n; }
+
+static void reserve(BigInt *a, size_t n) {
+    if (a->cap >= n) return;
+    size_t cap = a->cap ? a->cap : 4;
+    while (cap < n) cap *= 2;
+    limb *d = realloc(a->d, cap * sizeof(limb));
+    if (!d) { fputs("bignum: out of memory\n", stderr); exit(1); }
+    a->d = d; a->cap = cap;
+}
+
+// Take ownership of a limb buffer of length n.
+static void adopt(BigInt *a, limb *d, size_t n) {
+    free(a->d);
+    a->d = d; a->cap = n; a->n = trim(d, n);
+}
+
+void big_init(BigInt *a) { a->d = NULL; a->n = a->cap = 0; }
+void big_free(BigInt *a) { free(a->d); big_init(a); }
+
+void big_set_u64(BigInt *a, unsigned long long v) {
+    reserve(a, 1);
+    a->d[0] = v; a->n = v != 0;
+}
+
+void big_copy(BigInt *dst, const BigInt *src) {
+    if (dst == src) return;
+    reserve(dst, src->n);
+    if (src->n) memcpy(dst->d, src->d, src->n * sizeof(limb));
+    dst->n = src->n;
+}
+
+// ---- limb-array primitives -------------------------------------------
+
+// r[0..rn) += a[0..an), an <= rn. Returns the carry out of r[rn-1].
+static limb add_into(limb *r, size_t rn, const limb *a, size_t an) {
+    limb c = 0;
+    size_t i = 0;
+    for (; i < an; i++) {
+        limb s = r[i] + c;
+        c = s < c;
+        r[i] = s + a[i];
+        c += r[i] < s;
+    }
+    for (; c && i < rn; i++) c = ++r[i] == 0;
+    return c;
+}
+
+// r[0..rn) -= a[0..an), an <= rn, and the result must not go negative.
+static void sub_into(limb *r, size_t rn, const limb *a, size_t an) {
+    limb b = 0;
+    size_t i = 0;
+    for (; i < an; i++) {
+        limb t = r[i] - a[i];
+        limb b1 = r[i] < a[i];
+        r[i] = t - b;
+        b = b1 | (t < b);
+    }
+    for (; b && i < rn; i++) b = r[i]-- == 0;
+}
+
+// Compare trimmed limb arrays: negative, zero or positive like strcmp.
+static int cmp_limbs(const limb *a, size_t an, const limb *b, size_t bn) {
+    if (an != bn) return an < bn ? -1 : 1;
+    for (size_t i = an; i-- > 0;)
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    return 0;
+}
+
+// r[0..n) = a[0..n) * m, returns the high limb.
+static limb mul_1(limb *r, const limb *a, size_t n, limb m) {
+    limb c = 0;
+    for (size_t i = 0; i < n; i++) {
+        dlimb p = (dlimb)a[i] * m + c;
+        r[i] = (limb)p; c = (limb)(p >> 64);
+    }
+    return c;
+}
+
+// a[0..n) /= d in place, returns the remainder.
+static limb div_1(limb *a, size_t n, limb d) {
+    limb rem = 0;
+    for (size_t i = n; i-- > 0;) {
+        dlimb cur = ((dlimb)rem << 64) | a[i];
+        a[i] = (limb)(cur / d); rem = (limb)(cur % d);
+    }
+    return rem;
+}
+
+static void mul_basecase(limb *r, const limb *a, size_t an, const limb *b, size_t bn) {
+    r[an] = mul_1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; j++) {
+        limb c = 0;
+        for (size_t i = 0; i < an; i++) {
+            dlimb p = (dlimb)a[i] * b[j] + r[i+j] + c;
+            r[i+j] = (limb)p; c = (limb)(p >> 64);
+        }
+        r[an+j] = c;
+    }
+}
+
+static void mul_limbs(limb *r, const limb *a, size_t an, const limb *b, size_t bn);
+
+// Karatsuba for bn <= an < 2*bn. With a = a1*B^h + a0, b = b1*B^h + b0:
+// a*b = z2*B^2h + ((a0+a1)(b0+b1) - z0 - z2)*B^h + z0.
+static void mul_karatsuba(limb *r, const limb *a, size_t an, const limb *b, size_t bn) {
+    size_t h = an / 2;                       // bn > h, so b1 is never empty
+    size_t a1n = an - h, b1n = bn - h;
+
+    mul_limbs(r, a, h, b, h);                // z0 -> r[0..2h)
+    mul_limbs(r + 2*h, a + h, a1n, b + h, b1n);  // z2 -> r[2h..an+bn)
+
+    size_t san = a1n + 1, sbn = (b1n > h ? b1n : h) + 1;
+    limb *sa = zalloc_limbs(san), *sb = zalloc_limbs(sbn);
+    memcpy(sa, a + h, a1n * sizeof(limb));
+    add_into(sa, san, a, h);
+    memcpy(sb, b, h * sizeof(limb));
+    add_into(sb, sbn, b + h, b1n);
+
+    size_t zn = san + sbn;
+    limb *z1 = alloc_limbs(zn);
+    mul_limbs(z1, sa, trim(sa, san), sb, trim(sb, sbn));
+    size_t used = trim(sa, san) + trim(sb, sbn);
+    memset(z1 + used, 0, (zn - used) * sizeof(limb));
+    sub_into(z1, zn, r, 2*h);
+    sub_into(z1, zn, r + 2*h, a1n + b1n);
+    add_into(r + h, an + bn - h, z1, trim(z1, zn));
+
+    free(sa); free(sb); free(z1);
+}
+
+// r[0..an+bn) = a * b. r must not overlap a or b.
+static void mul_limbs(limb *r, const limb *a, size_t an, const limb *b, size_t bn) {
+    if (an < bn) { const limb *t = a; a = b; b = t; size_t tn = an; an = bn; bn = tn; }
+    if (bn == 0) { memset(r, 0, an * sizeof(limb)); return; }
+    if (bn < KARATSUBA_MIN) { mul_basecase(r, a, an, b, bn); return; }
+    if (an < 2*bn) { mul_karatsuba(r, a, an, b, bn); return; }
+
+    // Unbalanced: multiply b by bn-sized slices of a and add them up.
+    memset(r, 0, (an + bn) * sizeof(limb));
+    limb *t = alloc_limbs(2*bn);
+    for (size_t i = 0; i < an; i += bn) {
+        size_t c = an - i < bn ? an - i : bn;
+        mul_limbs(t, a + i, c, b, bn);
+        add_into(r + i, an + bn - i, t, c + bn);
+    }
+    free(t);
+}
+
+// Knuth's algorithm D: q = a / b, r = a % b, for bn >= 2 and an >= bn.
+// q gets an-bn+1 limbs, r gets bn limbs.
+static void divmod_limbs(limb *q, limb *r, const limb *a, size_t an, const limb *b, size_t bn) {
+    int s = __builtin_clzll(b[bn-1]);        // normalise so the top bit of b is set
+    limb *v = alloc_limbs(bn), *u = alloc_limbs(an + 1);
+    for (size_t i = bn; i-- > 0;)
+        v[i] = (b[i] << s) | (s && i ? b[i-1] >> (64 - s) : 0);
+    u[an] = s ? a[an-1] >> (64 - s) : 0;
+    for (size_t i = an; i-- > 0;)
+        u[i] = (a[i] << s) | (s && i ? a[i-1] >> (64 - s) : 0);
+
+    limb vtop = v[bn-1], vnext = v[bn-2];
+    for (size_t j = an - bn + 1; j-- > 0;) {
+        dlimb num = ((dlimb)u[j+bn] << 64) | u[j+bn-1];
+        dlimb qhat = num / vtop, rhat = num % vtop;
+        while (qhat >> 64 || qhat * vnext > ((rhat << 64) | u[j+bn-2])) {
+            qhat--; rhat += vtop;
+            if (rhat >> 64) break;
+        }
+
+        // u[j..j+bn] -= qhat * v; the borrow rides along in the carry limb.
+        limb qh = (limb)qhat, carry = 0;
+        for (size_t i = 0; i < bn; i++) {
+            dlimb p = (dlimb)qh * v[i];
+            limb sub = (limb)p + carry;
+            carry = (limb)(p >> 64) + (sub < (limb)p);
+            limb ui = u[i+j];
+            u[i+j] = ui - sub;
+            carry += ui < sub;
+        }
+        limb top = u[j+bn];
+        u[j+bn] = top - carry;
+
+        if (top < carry) {                   // qhat was one too large: add b back
+            qh--;
+            u[j+bn] += add_into(u + j, bn, v, bn);
+        }
+        q[j] = qh;
+    }
+    for (size_t i = 0; i < bn; i++)
+        r[i] = (u[i] >> s) | (s ? u[i+1] << (64 - s) : 0);
+    free(u); free(v);
+}
+
+// ---- multiplication ---------------------------------------------------
+
+void big_mul(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (!a->n || !b->n) { r->n = 0; return; }
+    size_t n = a->n + b->n;
+    limb *d = alloc_limbs(n);
+    mul_limbs(d, a->d, a->n, b->d, b->n);
+    adopt(r, d, n);
+}
+
+void big_mul_u64(BigInt *a, unsigned long long m) {
+    if (!a->n) return;
+    if (!m) { a->n = 0; return; }
+    reserve(a, a->n + 1);
+    limb c = mul_1(a->d, a->d, a->n, m);
+    if (c) a->d[a->n++] = c;
+}
+
+// ---- product trees ----------------------------------------------------
+
+typedef struct { unsigned long long lo, hi; int threads; BigInt out; } ProductJob;
+
+static void product_tree(BigInt *r, unsigned long long lo, unsigned long long hi, int threads);
+
+static void *product_job(void *arg) {
+    ProductJob *j = arg;
+    product_tree(&j->out, j->lo, j->hi, j->threads);
+    return NULL;
+}
+
+// Splitting the range in half keeps both operands of every big_mul the
+// same size, which is where Karatsuba pays off.
+static void product_tree(BigInt *r, unsigned long long lo, unsigned long long hi, int threads) {
+    if (hi - lo < LEAF_FACTORS) {
+        big_set_u64(r, lo);
+        for (unsigned long long k = lo + 1; k <= hi; k++) big_mul_u64(r, k);
+        return;
+    }
+    unsigned long long mid = lo + (hi - lo) / 2;
+    BigInt right; big_init(&right);
+
+    if (threads > 1) {
+        ProductJob job = {lo, mid, threads / 2, {0}};
+        big_init(&job.out);
+        pthread_t t;
+        if (pthread_create(&t, NULL, product_job, &job) == 0) {
+            product_tree(&right, mid + 1, hi, threads - threads / 2);
+            pthread_join(t, NULL);
+            big_mul(r, &job.out, &right);
+            big_free(&job.out); big_free(&right);
+            return;
+        }
+        big_free(&job.out);                  // no thread: fall through serially
+    }
+    product_tree(r, lo, mid, 1);
+    product_tree(&right, mid + 1, hi, 1);
+    big_mul(r, r, &right);
+    big_free(&right);
+}
+
+void big_product_range(BigInt *r, unsigned long long lo, unsigned long long hi, int threads) {
+    if (lo > hi) { big_set_u64(r, 1); return; }
+    product_tree(r, lo, hi, threads < 1 ? 1 : threads);
+}
+
+void big_factorial(BigInt *r, unsigned long long n, int threads) {
+    big_product_range(r, 2, n < 2 ? 1 : n, threads);
+}
+
+// ---- decimal conversion -----------------------------------------------
+
+// 10^e = 5^e * 2^e, so dividing by a power of ten is a shift followed by a
+// division by a power of five -- about 30% fewer limbs in the divisor.
+typedef struct { limb *d; size_t n; size_t e; } Pow5;
+
+static void shift_right(limb *r, const limb *a, size_t an, size_t bits) {
+    size_t w = bits / 64, s = bits % 64;
+    for (size_t i = 0; i + w < an; i++)
+        r[i] = (a[i+w] >> s) | (s && i + w + 1 < an ? a[i+w+1] << (64 - s) : 0);
+}
+
+// Write exactly 19 * 2^k digits of a (< 10^(19*2^k)) to out, zero-padded.
+static void to_dec(char *out, const limb *a, size_t an, const Pow5 *p5, int k) {
+    size_t width = (size_t)19 << k;
+    an = trim(a, an);
+    if (an <= DEC_BASECASE) {
+        limb *t = alloc_limbs(an ? an : 1);
+        memcpy(t, a, an * sizeof(limb));
+        char *end = out + width;
+        while (an) {
+            limb chunk = div_1(t, an, TEN19);
+            an = trim(t, an);
+            for (int i = 0; i < 19; i++) { *--end = (char)('0' + chunk % 10); chunk /= 10; }
+        }
+        memset(out, '0', (size_t)(end - out));
+        free(t);
+        return;
+    }
+
+    // a = q * 10^e + r with e = 19 * 2^(k-1); first split off the low e bits.
+    const Pow5 *d = &p5[k-1];
+    size_t e = d->e, hn = an > e / 64 ? an - e / 64 : 0;
+    limb *hi = zalloc_limbs(hn + 1);
+    shift_right(hi, a, an, e);
+    hn = trim(hi, hn);
+
+    limb *q, *r5;
+    size_t qn, rn = d->n;
+    if (hn < d->n) {                         // quotient is zero
+        q = zalloc_limbs(1); qn = 0;
+        r5 = zalloc_limbs(rn);
+        memcpy(r5, hi, hn * sizeof(limb));
+    } else {
+        qn = hn - d->n + 1;
+        q = alloc_limbs(qn); r5 = alloc_limbs(rn);
+        if (d->n == 1) { memcpy(q, hi, hn * sizeof(limb)); r5[0] = div_1(q, hn, d->d[0]); }
+        else divmod_limbs(q, r5, hi, hn, d->d, d->n);
+    }
+
+    // r = r5 * 2^e + (a mod 2^e)
+    size_t lw = e / 64, ls = e % 64, remn = rn + lw + 1;
+    limb *rem = zalloc_limbs(remn);
+    for (size_t i = 0; i < lw && i < an; i++) rem[i] = a[i];
+    if (ls && lw < an) rem[lw] = a[lw] & ((1ULL << ls) - 1);
+    for (size_t i = 0; i < rn; i++) {
+        rem[i + lw] |= r5[i] << ls;
+        if (ls) rem[i + lw + 1] |= r5[i] >> (64 - ls);
+    }
+
+    to_dec(out, q, qn, p5, k - 1);
+    to_dec(out + width / 2, rem, remn, p5, k - 1);
+    free(hi); free(q); free(r5); free(rem);
+}
+
+char *big_to_dec(const BigInt *a) {
+    if (!a->n) { char *s = xmalloc(2); strcpy(s, "0"); return s; }
+
+    // p5[k] = 5^(19 * 2^k), squared up until 10^(19 * 2^k) exceeds a.
+    Pow5 p5[64];
+    int k = 0;
+    p5[0].d = alloc_limbs(1); p5[0].d[0] = 19073486328125ULL; p5[0].n = 1; p5[0].e = 19;
+    limb *t = alloc_limbs(a->n + 1);
+    for (;;) {
+        size_t e = p5[k].e, tn = a->n > e / 64 ? a->n - e / 64 : 0;
+        shift_right(t, a->d, a->n, e);
+        tn = trim(t, tn);
+        if (cmp_limbs(t, tn, p5[k].d, p5[k].n) < 0) break;   // a>>e < 5^e  <=>  a < 10^e
+        size_t n = 2 * p5[k].n;
+        p5[k+1].d = alloc_limbs(n);
+        mul_limbs(p5[k+1].d, p5[k].d, p5[k].n, p5[k].d, p5[k].n);
+        p5[k+1].n = trim(p5[k+1].d, n);
+        p5[k+1].e = 2 * e;
+        k++;
+    }
+    free(t);
+
+    size_t width = (size_t)19 << k;
+    char *buf = xmalloc(width + 1);
+    to_dec(buf, a->d, a->n, p5, k);
+    buf[width] = '\0';
+    for (int i = 0; i <= k; i++) free(p5[i].d);
+
+    size_t lead = 0;
+    while (buf[lead] == '0') lead++;
+    memmove(buf, buf + lead, width - lead + 1);
+    return buf;
+}
@@ -0,0 +1,31 @@
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stddef.h>
+
+// Unsigned arbitrary-precision integer: d[0..n) are 64-bit limbs, least
+// significant first, with d[n-1] != 0. Zero is n == 0.
+typedef struct {
+    unsigned long long *d;
+    size_t n, cap;
+} BigInt;
+
+void big_init(BigInt *a);
+void big_free(BigInt *a);
+void big_set_u64(BigInt *a, unsigned long long v);
+void big_copy(BigInt *dst, const BigInt *src);
+
+// r = a * b. Schoolbook below a size threshold, Karatsuba above it.
+// r may be the same object as a or b.
+void big_mul(BigInt *r, const BigInt *a, const BigInt *b);
+void big_mul_u64(BigInt *a, unsigned long long m);
+
+// r = lo * (lo+1) * ... * hi (1 when lo > hi), by a binary-splitting
+// product tree. The top levels of the tree run on up to `threads` threads.
+void big_product_range(BigInt *r, unsigned long long lo, unsigned long long hi, int threads);
+void big_factorial(BigInt *r, unsigned long long n, int threads);
+
+// Decimal string by divide-and-conquer over powers of 10. Caller frees.
+char *big_to_dec(const BigInt *a);
+
+#endif
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compact.h"
+
+#define BLOCK     ((size_t)1 << 16)
+#define MAX_BLOCKS ((size_t)1 << 16)
+#define CHUNK     ((size_t)1 << 20)     // arena chunk: 16 blocks
+#define INLINE_MAX 11
+#define PHONE_MAX 16
+
+// ---- string heap ----------------------------------------------------------------
+
+static inline const char *str_at(const CompactBook *b, StrRef r) {
+    return b->block[r >> 16] + (r & 0xFFFF);
+}
+
+static bool add_block(CompactBook *b, char *p) {
+    if (b->nblocks == MAX_BLOCKS) return false;
+    if (b->nblocks == b->bcap) {
+        size_t cap = b->bcap ? 2 * b->bcap : 16;
+        char **t = realloc(b->block, cap * sizeof *t);
+        if (!t) return false;
+        b->block = t;
+        b->bcap = cap;
+    }
+    b->block[b->nblocks++] = p;
+    return true;
+}
+
+// Copies s[0 .. len) and a NUL into the heap; 0 if out of memory. A
+// string too big for a block gets an arena allocation of its own, listed
+// as a block of its own, and the block being filled stays as it was.
+static StrRef store(CompactBook *b, const char *s, size_t len) {
+    char *p;
+    StrRef r;
+    if (len + 1 > BLOCK) {
+        if (!(p = arena_alloc(&b->arena, len + 1)) || !add_block(b, p)) return 0;
+        r = (StrRef)(b->nblocks - 1) << 16;
+        b->heap_alloc += len + 1;
+    } else {
+        if (!b->nblocks || BLOCK - b->used < len + 1) {
+            if (!(p = arena_alloc(&b->arena, BLOCK)) || !add_block(b, p)) return 0;
+            b->cur = b->nblocks - 1;
+            b->used = 0;
+            b->heap_alloc += BLOCK;
+        }
+        p = b->block[b->cur] + b->used;
+        r = (StrRef)b->cur << 16 | (StrRef)b->used;
+        b->used += len + 1;
+    }
+    memcpy(p, s, len);
+    p[len] = '\0';
+    b->heap_used += len + 1;
+    return r;
+}
+
+static void intern_put(InternSlot *t, size_t mask, uint32_t h, StrRef r) {
+    size_t i = h & mask;
+    while (t[i].ref) i = (i + 1) & mask;
+    t[i] = (InternSlot){h, r};
+}
+
+static bool intern_reserve(CompactBook *b, size_t want) {
+    size_t n = b->imask + 1;
+    while (want * 2 > n) n *= 2;
+    if (n == b->imask + 1) return true;
+    InternSlot *t = calloc(n, sizeof *t);
+    if (!t) return false;
+    for (size_t i = 0; i <= b->imask; i++)
+        if (b->intern[i].ref) intern_put(t, n - 1, b->intern[i].hash, b->intern[i].ref);
+    free(b->intern);
+    b->intern = t;
+    b->imask = n - 1;
+    return true;
+}
+
+// The one copy of s[0 .. len) in the heap, made if there is none yet; 0
+// if out of memory. A stored string may be shorter than len, so the
+// compare stops at its NUL.
+static StrRef intern(CompactBook *b, const char *s, size_t len) {
+    uint32_t h = bytes_hash(s, len);
+    for (size_t i = h & b->imask; b->intern[i].ref; i = (i + 1) & b->imask) {
+        const char *t = str_at(b, b->intern[i].ref);
+        if (b->intern[i].hash == h && strncmp(t, s, len) == 0 && !t[len]) return b->intern[i].ref;
+    }
+    if (!intern_reserve(b, b->strings + 1)) return 0;
+    StrRef r = store(b, s, len);
+    if (r) { intern_put(b->intern, b->imask, h, r); b->strings++; }
+    return r;
+}
+
+// ---- phones -----------------------------------------------------------------------
+
+static const char phone_sym[16] = "\0" "0123456789-+() ";
+
+static int phone_code(char c) {
+    if (c >= '0' && c <= '9') return c - '0' + 1;
+    switch (c) {
+    case '-': return 11;
+    case '+': return 12;
+    case '(': return 13;
+    case ')': return 14;
+    case ' ': return 15;
+    default:  return -1;
+    }
+}
+
+// One nibble per symbol, low first; false if s does not fit.
+static bool pack_phone(const char *s, size_t len, uint64_t *out) {
+    if (len > PHONE_MAX) return false;
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        int c = phone_code(s[i]);
+        if (c < 0) return false;
+        v |= (uint64_t)c << (4 * i);
+    }
+    *out = v;
+    return true;
+}
+
+// ---- name index ----------------------------------------------------------------
+
+static const char *row_name(const void *ctx, size_t row) { return cbook_name(ctx, row); }
+
+static long lookup(const CompactBook *b, const char *name, bool nocase) {
+    return name_index_find(b->slot, b->mask, b->n, name, nocase, row_name, b);
+}
+
+// ---- public entry points --------------------------------------------------------
+
+bool cbook_init(CompactBook *b) {
+    *b = (CompactBook){0};
+    arena_init(&b->arena, CHUNK);
+    name_index_init(&b->slot, &b->mask);
+    b->intern = calloc(NAME_INDEX_MIN, sizeof *b->intern);
+    b->imask = NAME_INDEX_MIN - 1;
+    // Ref 0 is taken by an empty string, so no interned string gets it.
+    if (b->slot && b->intern) store(b, "", 0);
+    if (!b->nblocks) { cbook_free(b); return false; }
+    return true;
+}
+
+void cbook_free(CompactBook *b) {
+    free(b->rows);
+    free(b->slot);
+    free(b->intern);
+    free(b->block);
+    arena_free(&b->arena);
+    *b = (CompactBook){0};
+}
+
+bool cbook_add(CompactBook *b, const char *name, const char *phone, int age) {
+    if (b->n == UINT32_MAX - 1) return false;
+    if (b->n == b->cap) {
+        size_t cap = b->cap ? 2 * b->cap : 16;
+        CompactRow *r = realloc(b->rows, cap * sizeof *r);
+        if (!r) return false;
+        b->rows = r;
+        b->cap = cap;
+    }
+    if (!name_index_reserve(&b->slot, &b->mask, b->live + 1)) return false;
+
+    // A string interned here and then not used stays until the next
+    // rebuild; nothing else changes on failure.
+    CompactRow c = {.age = age};
+    size_t nlen = strlen(name), plen = strlen(phone);
+    if (nlen <= INLINE_MAX) memcpy(c.name, name, nlen);
+    else {
+        StrRef r = intern(b, name, nlen);
+        if (!r) return false;
+        memcpy(c.name, &r, sizeof r);
+        c.name[11] = CB_INTERNED;
+    }
+    if (!pack_phone(phone, plen, &c.phone)) {
+        StrRef r = intern(b, phone, plen);
+        if (!r) return false;
+        c.phone = (uint64_t)r << 32;
+    }
+    b->rows[b->n] = c;
+    name_index_put(b->slot, b->mask, name_hash(name, nlen), (uint32_t)++b->n);
+    b->live++;
+    return true;
+}
+
+long cbook_find(const CompactBook *b, const char *name) { return lookup(b, name, false); }
+long cbook_find_nocase(const CompactBook *b, const char *name) { return lookup(b, name, true); }
+
+const char *cbook_name(const CompactBook *b, size_t row) {
+    const CompactRow *c = &b->rows[row];
+    if (c->name[11] != CB_INTERNED) return (const char *)c->name;
+    StrRef r;
+    memcpy(&r, c->name, sizeof r);
+    return str_at(b, r);
+}
+
+// A packed phone has a symbol in its low nibble, unless it is empty; an
+// interned one has its ref in the high half and zeros below.
+const char *cbook_phone(const CompactBook *b, size_t row, char buf[17]) {
+    uint64_t v = b->rows[row].phone;
+    if (v && !(v & 0xF)) return str_at(b, (StrRef)(v >> 32));
+    size_t i = 0;
+    for (; v; v >>= 4) buf[i++] = phone_sym[v & 0xF];
+    buf[i] = '\0';
+    return buf;
+}
+
+// Rows and strings again from the live rows only. Out of memory leaves b
+// as it was.
+static void rebuild(CompactBook *b) {
+    CompactBook nb;
+    if (!cbook_init(&nb)) return;
+    char buf[17];
+    for (size_t r = 0; cbook_next(b, &r); r++)
+        if (!cbook_add(&nb, cbook_name(b, r), cbook_phone(b, r, buf), b->rows[r].age)) {
+            cbook_free(&nb);
+            return;
+        }
+    cbook_free(b);
+    *b = nb;
+}
+
+bool cbook_delete(CompactBook *b, const char *name) {
+    long r = cbook_find(b, name);
+    if (r < 0) return false;
+    uint32_t h = name_hash(name, strlen(name));
+    name_index_remove_at(b->slot, b->mask, name_index_slot(b->slot, b->mask, h, (uint32_t)r + 1));
+    b->rows[r].name[11] = CB_DEAD;
+    b->live--;
+    while (b->n && b->rows[b->n - 1].name[11] == CB_DEAD) b->n--;
+    if ((double)(b->n - b->live) > BOOK_DEAD_MAX * (double)b->n) rebuild(b);
+    return true;
+}
+
+void cbook_print(const CompactBook *b) {
+    char buf[17];
+    for (size_t r = 0; cbook_next(b, &r); r++)
+        printf("%s %s %d\n", cbook_name(b, r), cbook_phone(b, r, buf), b->rows[r].age);
+}
+
+// ContactBook grows each array by doubling from 16 and keeps its index
+// at most half full.
+static size_t doubled(size_t want) {
+    size_t n = 16;
+    while (n < want) n *= 2;
+    return n;
+}
+
+void cbook_memory(const CompactBook *b, CompactMemory *m) {
+    *m = (CompactMemory){.contacts = b->live};
+    m->rows = b->cap * sizeof *b->rows;
+    m->index = (b->mask + 1) * sizeof *b->slot;
+    m->heap = b->heap_alloc + b->bcap * sizeof *b->block;
+    m->intern = (b->imask + 1) * sizeof *b->intern;
+    m->total = m->rows + m->index + m->heap + m->intern;
+    m->strings = b->strings;
+    m->heap_used = b->heap_used;
+    for (size_t r = 0; cbook_next(b, &r); r++) {
+        const CompactRow *c = &b->rows[r];
+        if (c->name[11] == CB_INTERNED) m->interned_names++; else m->inline_names++;
+        if (c->phone && !(c->phone & 0xF)) m->interned_phones++; else m->packed_phones++;
+    }
+    size_t n = b->live;
+    m->plain = doubled(n) * (sizeof(Contact) + sizeof(uint32_t))
+             + doubled(2 * n) * sizeof(NameSlot) + doubled(n) * sizeof(Handle);
+}
+
+void cbook_print_memory(const CompactBook *b) {
+    CompactMemory m;
+    cbook_memory(b, &m);
+    printf("%zu contacts in %zu bytes (%.1f per contact), ContactBook: %zu bytes\n",
+           m.contacts, m.total, m.contacts ? (double)m.total / (double)m.contacts : 0.0, m.plain);
+    printf("  rows %zu, name index %zu, string heap %zu, intern table %zu\n",
+           m.rows, m.index, m.heap, m.intern);
+    printf("  names: %zu inline, %zu interned; phones: %zu packed, %zu interned\n",
+           m.inline_names, m.interned_names, m.packed_phones, m.interned_phones);
+    printf("  %zu distinct strings, %zu heap bytes in use\n", m.strings, m.heap_used);
+}
@@ -0,0 +1,100 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "contacts.h"
+
+// The contact book in smaller rows: ContactBook keeps a 76-byte Contact
+// per row, mostly padding, while here a row is 24 bytes, a third of that.
+// The name index, string heap and intern table come on top, so the whole
+// book is about 69% of a ContactBook (p25, 1M contacts: 71.6 against 104
+// bytes per contact).
+//   name    up to 11 bytes inline in the row; longer ones are interned
+//   phone   up to 16 of 0-9 - + ( ) and space packed 4 bits each into a
+//           uint64_t; anything else is interned
+//   age     as before
+// Interned strings are stored once however many rows use them, in 64 KB
+// blocks from an arena, and rows refer to them by a 32-bit block:offset.
+// Names and phones have no length limit.
+//
+// Deletes leave a dead row behind, as BOOK_TOMBSTONE does. Once over
+// BOOK_DEAD_MAX of the rows are dead the book is rebuilt, which also
+// drops the strings only dead rows used.
+
+// Where an interned string is: block << 16 | offset.
+typedef uint32_t StrRef;
+
+// name[11] of a row whose name is interned (its ref is in name[0..4)),
+// and of a dead row.
+#define CB_INTERNED 0xFF
+#define CB_DEAD     0xFE
+
+typedef struct {
+    uint64_t phone;            // packed symbols, low nibble first, 0 ends;
+                               // or ref << 32 for an interned phone
+    unsigned char name[12];    // inline and NUL-terminated if name[11] is 0
+    int32_t age;
+} CompactRow;
+
+// An interned string; ref 0 marks an empty slot.
+typedef struct { uint32_t hash; StrRef ref; } InternSlot;
+
+typedef struct {
+    CompactRow *rows;          // rows[0 .. n), live and dead, in order added
+    size_t n, cap, live;
+    NameSlot *slot;            // name index, as in ContactBook
+    size_t mask;
+    Arena arena;               // the string blocks
+    char **block;
+    size_t nblocks, bcap;
+    size_t cur, used;          // the block being filled, and its bytes used
+    size_t heap_alloc;         // bytes of blocks
+    size_t heap_used;          // bytes of interned strings and their NULs
+    InternSlot *intern;
+    size_t imask, strings;
+} CompactBook;
+
+typedef struct {
+    size_t contacts;
+    size_t rows, index, heap, intern, total;   // bytes allocated
+    size_t inline_names, interned_names;
+    size_t packed_phones, interned_phones;
+    size_t strings, heap_used;                 // distinct interned strings
+    size_t plain;              // what a ContactBook would allocate
+} CompactMemory;
+
+// false if out of memory.
+bool cbook_init(CompactBook *b);
+void cbook_free(CompactBook *b);
+
+// false if out of memory, with the book unchanged.
+bool cbook_add(CompactBook *b, const char *name, const char *phone, int age);
+
+// Row of the first live contact named name, or -1.
+long cbook_find(const CompactBook *b, const char *name);
+long cbook_find_nocase(const CompactBook *b, const char *name);
+
+// Delete the first contact named name; false if there was none.
+bool cbook_delete(CompactBook *b, const char *name);
+
+// Advance *row to the next live row at or after it; false at the end.
+static inline bool cbook_next(const CompactBook *b, size_t *row) {
+    while (*row < b->n && b->rows[*row].name[11] == CB_DEAD) ++*row;
+    return *row < b->n;
+}
+
+// Fields of a live row. The name points into the book; the phone is
+// unpacked into buf, or points into the book if it was interned.
+const char *cbook_name(const CompactBook *b, size_t row);
+const char *cbook_phone(const CompactBook *b, size_t row, char buf[17]);
+static inline int cbook_age(const CompactBook *b, size_t row) { return b->rows[row].age; }
+
+void cbook_print(const CompactBook *b);
+
+void cbook_memory(const CompactBook *b, CompactMemory *m);
+void cbook_print_memory(const CompactBook *b);
+
+#endif
@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200809L   // posix_madvise
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "contactfile.h"
+#include "lines.h"
+#include "numparse.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "contact files are read and written in place, little-endian only"
+#endif
+
+_Static_assert(sizeof(CfHeader) == 64, "CfHeader is 64 bytes on disk");
+
+#define ALIGN8(x) (((x) + 7) & ~(size_t)7)
+
+// ---- hashing ----------------------------------------------------------------
+// The index hash (names.h) and this checksum are part of the format:
+// changing either means a new version.
+
+static uint64_t checksum(const unsigned char *p, size_t n) {
+    uint64_t x = HASH_SEED ^ n;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) x = hash_mix(hash_load8(p + i) ^ HASH_K1, hash_load8(p + i + 8) ^ x);
+    unsigned char b[16] = {0};
+    memcpy(b, p + i, n - i);
+    return hash_mix(hash_mix(hash_load8(b) ^ HASH_K1, hash_load8(b + 8) ^ x), HASH_K2);
+}
+
+// ---- writing ----------------------------------------------------------------
+
+void cf_writer_init(CfWriter *w) { *w = (CfWriter){0}; }
+
+void cf_writer_free(CfWriter *w) {
+    free(w->rec);
+    free(w->heap);
+    *w = (CfWriter){0};
+}
+
+// Offset of s[0 .. len) and a NUL in the heap, or UINT32_MAX if it does
+// not fit.
+static uint32_t keep(CfWriter *w, const char *s, size_t len) {
+    if (len >= UINT32_MAX - w->heap_size) return UINT32_MAX;
+    if (w->heap_size + len + 1 > w->heap_cap) {
+        size_t cap = w->heap_cap ? w->heap_cap : 1 << 16;
+        while (cap < w->heap_size + len + 1) cap *= 2;
+        char *h = realloc(w->heap, cap);
+        if (!h) return UINT32_MAX;
+        w->heap = h;
+        w->heap_cap = cap;
+    }
+    uint32_t at = (uint32_t)w->heap_size;
+    memcpy(w->heap + at, s, len);
+    w->heap[at + len] = '\0';
+    w->heap_size += len + 1;
+    return at;
+}
+
+static void add_n(CfWriter *w, const char *name, size_t nlen, const char *phone, size_t plen, int age) {
+    if (w->oom) return;
+    if (w->n == w->cap) {
+        size_t cap = w->cap ? 2 * w->cap : 1024;
+        CfRecord *r = w->n < UINT32_MAX - 1 ? realloc(w->rec, cap * sizeof *r) : NULL;
+        if (!r) { w->oom = true; return; }
+        w->rec = r;
+        w->cap = cap;
+    }
+    // Offset 0 is the empty string, where a bad offset is read from.
+    if (!w->heap_size && keep(w, "", 0) == UINT32_MAX) { w->oom = true; return; }
+    uint32_t nm = keep(w, name, nlen), ph = nm == UINT32_MAX ? nm : keep(w, phone, plen);
+    if (ph == UINT32_MAX) { w->oom = true; return; }
+    w->rec[w->n++] = (CfRecord){nm, ph, age};
+}
+
+void cf_writer_add(CfWriter *w, const char *name, const char *phone, int age) {
+    add_n(w, name, strlen(name), phone, strlen(phone), age);
+}
+
+static bool write_all(int fd, const char *p, size_t n) {
+    while (n) {
+        ssize_t r = write(fd, p, n);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += r;
+        n -= (size_t)r;
+    }
+    return true;
+}
+
+CfStatus cf_writer_finish(CfWriter *w, const char *path) {
+    if (w->oom) return CF_NOMEM;
+    if (!w->heap_size && keep(w, "", 0) == UINT32_MAX) return CF_NOMEM;
+    size_t nslots = 16;
+    while (nslots < 2 * w->n) nslots *= 2;
+    size_t rec_bytes = ALIGN8(w->n * sizeof(CfRecord)), slot_bytes = nslots * sizeof(CfSlot);
+    size_t body = rec_bytes + slot_bytes + ALIGN8(w->heap_size);
+
+    // The file is built whole in memory and checksummed before writing.
+    unsigned char *img = calloc(1, sizeof(CfHeader) + body);
+    if (!img) return CF_NOMEM;
+    unsigned char *p = img + sizeof(CfHeader);
+    if (w->n) memcpy(p, w->rec, w->n * sizeof(CfRecord));
+    CfSlot *slot = (CfSlot *)(p + rec_bytes);
+    for (size_t r = 0; r < w->n; r++) {
+        const char *nm = w->heap + w->rec[r].name;
+        name_index_put(slot, nslots - 1, name_hash(nm, strlen(nm)), (uint32_t)r + 1);
+    }
+    memcpy(p + rec_bytes + slot_bytes, w->heap, w->heap_size);
+
+    CfHeader h = {
+        .magic = CF_MAGIC, .version = CF_VERSION, .header_size = sizeof(CfHeader),
+        .count = w->n, .nslots = nslots, .heap_size = w->heap_size,
+        .checksum = checksum(p, body)
+    };
+    memcpy(img, &h, sizeof h);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && write_all(fd, (char *)img, sizeof(CfHeader) + body);
+    int err = errno;
+    if (fd >= 0 && close(fd) != 0 && ok) { ok = false; err = errno; }
+    free(img);
+    errno = err;
+    return ok ? CF_OK : CF_IO;
+}
+
+CfStatus cf_save_book(const ContactBook *b, const char *path) {
+    CfWriter w;
+    cf_writer_init(&w);
+    for (size_t r = 0; book_next(b, &r); r++)
+        cf_writer_add(&w, b->rows[r].name, b->rows[r].phone, b->rows[r].age);
+    CfStatus st = cf_writer_finish(&w, path);
+    cf_writer_free(&w);
+    return st;
+}
+
+// ---- text conversion ----------------------------------------------------------
+
+typedef struct { CfWriter *w; size_t line; bool bad; } Convert;
+
+static inline bool is_blank(char c) { return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t'; }
+
+// One name;phone;age line. Name and phone are non-empty and end at the
+// next ';' (so a name cannot hold one); blanks may come before the age
+// and after it.
+static bool convert_line(void *ctx, const char *s, size_t len) {
+    Convert *c = ctx;
+    c->line++;
+    const char *end = s + len;
+    while (s < end && is_blank(*s)) s++;
+    if (s == end) return true;
+    const char *semi1 = memchr(s, ';', (size_t)(end - s));
+    const char *semi2 = semi1 ? memchr(semi1 + 1, ';', (size_t)(end - semi1 - 1)) : NULL;
+    if (!semi2 || semi1 == s || semi2 == semi1 + 1) { c->bad = true; return false; }
+    const char *a = semi2 + 1;
+    while (a < end && is_blank(*a)) a++;
+    int age;
+    if (parse_i32(a, end, &age, &a) != NUM_OK) { c->bad = true; return false; }
+    while (a < end && is_blank(*a)) a++;
+    if (a != end) { c->bad = true; return false; }
+
+    add_n(c->w, s, (size_t)(semi1 - s), semi1 + 1, (size_t)(semi2 - semi1 - 1), age);
+    return !c->w->oom;
+}
+
+CfStatus cf_convert_text(const char *txt_path, const char *path, size_t *err_line) {
+    LineFile in;
+    if (!lines_open(&in, txt_path)) return CF_IO;
+    CfWriter w;
+    cf_writer_init(&w);
+    Convert c = {&w, 0, false};
+    lines_each(in.data, in.len, convert_line, &c);
+    lines_close(&in);
+    CfStatus st = c.bad ? CF_CORRUPT : cf_writer_finish(&w, path);
+    if (c.bad && err_line) *err_line = c.line;
+    cf_writer_free(&w);
+    return st;
+}
+
+// ---- reading ----------------------------------------------------------------
+
+CfStatus cf_open(ContactFile *f, const char *path) {
+    *f = (ContactFile){0};
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return CF_IO;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { int err = errno; close(fd); errno = err; return CF_IO; }
+    size_t len = (size_t)st.st_size;
+    if (st.st_size < (off_t)sizeof(CfHeader)) { close(fd); return CF_MAGIC_BAD; }
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED) { errno = err; return CF_IO; }
+
+    const CfHeader *h = map;
+    CfStatus bad = CF_OK;
+    if (memcmp(h->magic, CF_MAGIC, sizeof h->magic) != 0) bad = CF_MAGIC_BAD;
+    else if (h->version != CF_VERSION) bad = CF_VERSION_BAD;
+    else if (h->header_size != sizeof(CfHeader) || h->count >= UINT32_MAX
+             || h->nslots < 2 * h->count || h->nslots > (uint64_t)1 << 33
+             || (h->nslots & (h->nslots - 1)) || !h->heap_size || h->heap_size >= UINT32_MAX
+             || len != sizeof(CfHeader) + ALIGN8(h->count * sizeof(CfRecord))
+                       + h->nslots * sizeof(CfSlot) + ALIGN8(h->heap_size))
+        bad = CF_CORRUPT;
+    if (bad) { munmap(map, len); return bad; }
+
+    const char *p = (const char *)map + sizeof(CfHeader);
+    f->hdr = h;
+    f->rec = (const CfRecord *)p;
+    f->slot = (const CfSlot *)(p + ALIGN8(h->count * sizeof(CfRecord)));
+    f->heap = (const char *)(f->slot + h->nslots);
+    f->count = h->count;
+    f->mask = h->nslots - 1;
+    f->heap_size = h->heap_size;
+    f->map = map;
+    f->map_len = len;
+    // Strings run to a NUL inside the heap, whatever the offsets say.
+    if (f->heap[f->heap_size - 1]) { cf_close(f); return CF_CORRUPT; }
+    posix_madvise(map, len, POSIX_MADV_RANDOM);
+    return CF_OK;
+}
+
+void cf_close(ContactFile *f) {
+    if (f->map) munmap(f->map, f->map_len);
+    *f = (ContactFile){0};
+}
+
+CfStatus cf_verify(const ContactFile *f) {
+    const unsigned char *p = (const unsigned char *)f->map + sizeof(CfHeader);
+    return checksum(p, f->map_len - sizeof(CfHeader)) == f->hdr->checksum ? CF_OK : CF_CORRUPT;
+}
+
+static const char *record_name(const void *ctx, size_t r) { return cf_name(ctx, r); }
+
+// As find_contact. Slot ids past count end the walk, so a bad index
+// cannot loop or name a record that is not there.
+static long lookup(const ContactFile *f, const char *name, bool nocase) {
+    return name_index_find(f->slot, f->mask, f->count, name, nocase, record_name, f);
+}
+
+long cf_find(const ContactFile *f, const char *name) { return lookup(f, name, false); }
+long cf_find_nocase(const ContactFile *f, const char *name) { return lookup(f, name, true); }
@@ -0,0 +1,113 @@
+#ifndef CONTACTFILE_H
+#define CONTACTFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "contacts.h"
+
+// A binary contact file that is mapped read-only and answered from in
+// place, for address books too big to parse line by line at startup the
+// way p20 read its name;phone;age text. Opening costs an mmap and a look
+// at the header; nothing is copied or parsed, and pages are read in as
+// lookups touch them.
+//
+// Layout, little-endian, every section 8-byte aligned:
+//   CfHeader                       64 bytes
+//   CfRecord[count]                in the order the contacts were added
+//   CfSlot[nslots]                 name index, as in ContactBook
+//   heap[heap_size]                NUL-terminated names and phones
+// The checksum covers every byte after the header. Fields are not
+// limited to Contact's 49 and 19 characters.
+
+#define CF_MAGIC   "LBCBOOK\0"
+#define CF_VERSION 1
+
+typedef struct {
+    char magic[8];              // CF_MAGIC
+    uint32_t version;           // CF_VERSION
+    uint32_t header_size;       // sizeof(CfHeader)
+    uint64_t count;             // records, under 2^32 - 1
+    uint64_t nslots;            // a power of two, at least 2 * count
+    uint64_t heap_size;         // under 2^32; the last byte is 0
+    uint64_t checksum;
+    uint64_t reserved[2];       // written as 0, not checked
+} CfHeader;
+
+// name and phone are heap offsets.
+typedef struct { uint32_t name, phone; int32_t age; } CfRecord;
+
+// id = record + 1; 0 marks an empty slot. Linear probing from hash.
+typedef NameSlot CfSlot;
+
+typedef enum {
+    CF_OK,
+    CF_IO,          // open, read, mmap or write failed; errno says why
+    CF_MAGIC_BAD,   // not a contact file
+    CF_VERSION_BAD, // a version this code does not read
+    CF_CORRUPT,     // sizes that do not add up, or a checksum mismatch
+    CF_NOMEM
+} CfStatus;
+
+// ---- writing ----------------------------------------------------------------
+
+// Contacts gathered in memory and written out in one go.
+typedef struct {
+    CfRecord *rec;
+    size_t n, cap;
+    char *heap;
+    size_t heap_size, heap_cap;
+    bool oom;
+} CfWriter;
+
+void cf_writer_init(CfWriter *w);
+void cf_writer_free(CfWriter *w);
+// Out of memory, or past the format's limits, is remembered and reported
+// by cf_writer_finish.
+void cf_writer_add(CfWriter *w, const char *name, const char *phone, int age);
+// Builds the index and writes the file. The writer can be freed after.
+CfStatus cf_writer_finish(CfWriter *w, const char *path);
+
+// The live contacts of b, in row order.
+CfStatus cf_save_book(const ContactBook *b, const char *path);
+
+// Converts p20's text (name;phone;age per line; blank lines and leading
+// blanks are skipped, as its fscanf did). On CF_CORRUPT, *err_line (if not
+// NULL) is the 1-based line that does not parse.
+CfStatus cf_convert_text(const char *txt_path, const char *path, size_t *err_line);
+
+// ---- reading ----------------------------------------------------------------
+
+typedef struct {
+    const CfHeader *hdr;
+    const CfRecord *rec;
+    const CfSlot *slot;
+    const char *heap;
+    size_t count, mask, heap_size;
+    void *map;
+    size_t map_len;
+} ContactFile;
+
+// Maps path and checks the header and section sizes, not the checksum,
+// so that opening stays O(1). Whatever the bytes, lookups and the
+// accessors below stay inside the map.
+CfStatus cf_open(ContactFile *f, const char *path);
+void cf_close(ContactFile *f);
+
+// Reads the whole file: CF_OK or CF_CORRUPT.
+CfStatus cf_verify(const ContactFile *f);
+
+// Record of the first contact named name, or -1; the _nocase form
+// compares ASCII letters case-insensitively.
+long cf_find(const ContactFile *f, const char *name);
+long cf_find_nocase(const ContactFile *f, const char *name);
+
+// Pointers into the map, valid until cf_close. i < f->count.
+static inline const char *cf_str(const ContactFile *f, uint32_t off) {
+    return f->heap + (off < f->heap_size ? off : f->heap_size - 1);
+}
+static inline const char *cf_name(const ContactFile *f, size_t i) { return cf_str(f, f->rec[i].name); }
+static inline const char *cf_phone(const ContactFile *f, size_t i) { return cf_str(f, f->rec[i].phone); }
+static inline int cf_age(const ContactFile *f, size_t i) { return f->rec[i].age; }
+
+#endif
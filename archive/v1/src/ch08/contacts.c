@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contacts.h"
+
+#define NAME_MAX_LEN (sizeof ((Contact *)0)->name - 1)
+
+// ---- index -----------------------------------------------------------------
+
+static uint32_t row_hash(const ContactBook *b, size_t row) {
+    return name_hash(b->rows[row].name, strlen(b->rows[row].name));
+}
+
+static size_t index_find_row(const ContactBook *b, size_t row) {
+    return name_index_slot(b->slot, b->mask, row_hash(b, row), (uint32_t)row + 1);
+}
+
+static const char *row_name(const void *ctx, size_t row) {
+    return ((const ContactBook *)ctx)->rows[row].name;
+}
+
+// A name longer than any stored one cannot be in the book.
+static long lookup(const ContactBook *b, const char *name, bool nocase) {
+    for (size_t n = 0; name[n]; n++)
+        if (n == NAME_MAX_LEN) return -1;
+    return name_index_find(b->slot, b->mask, b->n, name, nocase, row_name, b);
+}
+
+// ---- rows and handles ------------------------------------------------------------
+
+#define NO_HANDLE UINT32_MAX
+
+static bool rows_reserve(ContactBook *b) {
+    if (b->n < b->cap) return true;
+    size_t cap = b->cap ? 2 * b->cap : 16;
+    Contact *r = realloc(b->rows, cap * sizeof *r);
+    if (!r) return false;
+    b->rows = r;
+    uint32_t *h = realloc(b->handle_of, cap * sizeof *h);
+    if (!h) return false;
+    b->handle_of = h;
+    b->cap = cap;
+    return true;
+}
+
+static uint32_t handle_new(ContactBook *b, size_t row) {
+    uint32_t h = b->free_handle;
+    if (h != NO_HANDLE) {
+        b->free_handle = b->handle[h].row;
+    } else {
+        if (b->nhandles == NO_HANDLE) return NO_HANDLE;
+        if (b->nhandles == b->hcap) {
+            size_t cap = b->hcap ? 2 * b->hcap : 16;
+            Handle *t = realloc(b->handle, cap * sizeof *t);
+            if (!t) return NO_HANDLE;
+            b->handle = t;
+            b->hcap = cap;
+        }
+        h = (uint32_t)b->nhandles++;
+        b->handle[h].gen = 1;
+    }
+    b->handle[h].row = (uint32_t)row;
+    return h;
+}
+
+// The new generation makes every id given out for h stale.
+static void handle_release(ContactBook *b, uint32_t h) {
+    if (++b->handle[h].gen == 0) b->handle[h].gen = 1;
+    b->handle[h].row = b->free_handle;
+    b->free_handle = h;
+}
+
+// Dead rows at the end are dropped at once, so rows[n - 1] is always live.
+static void trim(ContactBook *b) {
+    while (b->n && b->handle_of[b->n - 1] == BOOK_DEAD) b->n--;
+}
+
+static void maybe_compact(ContactBook *b) {
+    trim(b);
+    if ((double)(b->n - b->live) > BOOK_DEAD_MAX * (double)b->n) book_compact(b);
+}
+
+// Row r is live and in the index.
+static void remove_row(ContactBook *b, size_t r) {
+    name_index_remove_at(b->slot, b->mask, index_find_row(b, r));
+    if (b->prefix) name_trie_remove(b->prefix, b->rows[r].name, contact_id(b, r));
+    handle_release(b, b->handle_of[r]);
+    b->live--;
+    switch (b->mode) {
+    case BOOK_TOMBSTONE:
+        b->handle_of[r] = BOOK_DEAD;
+        maybe_compact(b);
+        break;
+    case BOOK_SWAP: {
+        size_t last = b->n - 1;
+        if (r != last) {
+            b->slot[index_find_row(b, last)].id = (uint32_t)r + 1;
+            b->rows[r] = b->rows[last];
+            b->handle_of[r] = b->handle_of[last];
+            b->handle[b->handle_of[r]].row = (uint32_t)r;
+        }
+        b->n--;
+        trim(b);
+        break;
+    }
+    case BOOK_SHIFT:
+        memmove(&b->rows[r], &b->rows[r + 1], (b->n - r - 1) * sizeof *b->rows);
+        memmove(&b->handle_of[r], &b->handle_of[r + 1], (b->n - r - 1) * sizeof *b->handle_of);
+        b->n--;
+        for (size_t i = r; i < b->n; i++)
+            if (b->handle_of[i] != BOOK_DEAD) b->handle[b->handle_of[i]].row = (uint32_t)i;
+        for (size_t i = 0; i <= b->mask; i++)
+            if (b->slot[i].id > (uint32_t)r + 1) b->slot[i].id--;
+        break;
+    }
+}
+
+// ---- public entry points ------------------------------------------------------
+
+bool book_init(ContactBook *b) {
+    *b = (ContactBook){0};
+    b->free_handle = NO_HANDLE;
+    b->mode = BOOK_TOMBSTONE;
+    return name_index_init(&b->slot, &b->mask);
+}
+
+void book_free(ContactBook *b) {
+    if (b->prefix) name_trie_free(b->prefix);
+    free(b->prefix);
+    free(b->rows);
+    free(b->handle_of);
+    free(b->slot);
+    free(b->handle);
+    *b = (ContactBook){0};
+}
+
+void book_set_delete_mode(ContactBook *b, DeleteMode mode) { b->mode = mode; }
+
+ContactId add_contact(ContactBook *b, const char *name, const char *phone, int age) {
+    if (b->n == UINT32_MAX - 1) return 0;
+    if (!rows_reserve(b) || !name_index_reserve(&b->slot, &b->mask, b->live + 1)) return 0;
+    uint32_t h = handle_new(b, b->n);
+    if (h == NO_HANDLE) return 0;
+    Contact *c = &b->rows[b->n];
+    snprintf(c->name, sizeof c->name, "%s", name);
+    snprintf(c->phone, sizeof c->phone, "%s", phone);
+    c->age = age;
+    ContactId id = (ContactId)b->handle[h].gen << 32 | h;
+    if (b->prefix && !name_trie_add(b->prefix, c->name, id)) {
+        handle_release(b, h);
+        return 0;
+    }
+    b->handle_of[b->n] = h;
+    name_index_put(b->slot, b->mask, row_hash(b, b->n), (uint32_t)b->n + 1);
+    b->n++;
+    b->live++;
+    return id;
+}
+
+long find_contact(const ContactBook *b, const char *name) { return lookup(b, name, false); }
+long find_contact_nocase(const ContactBook *b, const char *name) { return lookup(b, name, true); }
+
+long contact_row(const ContactBook *b, ContactId id) {
+    uint32_t h = (uint32_t)id, gen = (uint32_t)(id >> 32);
+    if (h >= b->nhandles || b->handle[h].gen != gen) return -1;
+    return (long)b->handle[h].row;
+}
+
+ContactId contact_id(const ContactBook *b, size_t row) {
+    uint32_t h = b->handle_of[row];
+    return (ContactId)b->handle[h].gen << 32 | h;
+}
+
+bool delete_contact(ContactBook *b, const char *name) {
+    long r = find_contact(b, name);
+    if (r < 0) return false;
+    remove_row(b, (size_t)r);
+    return true;
+}
+
+bool delete_id(ContactBook *b, ContactId id) {
+    long r = contact_row(b, id);
+    if (r < 0) return false;
+    remove_row(b, (size_t)r);
+    return true;
+}
+
+size_t delete_if(ContactBook *b, bool (*pred)(const Contact *c, void *ctx), void *ctx) {
+    // The index sweep below looks rows up in hash order. A bitmap of the
+    // rows going (n / 8 bytes) stays in cache where handle_of would not;
+    // without memory for it, handle_of is read instead.
+    uint64_t *gone = calloc(b->n / 64 + 1, sizeof *gone);
+    size_t k = 0;
+    for (size_t r = 0; book_next(b, &r); r++) {
+        if (!pred(&b->rows[r], ctx)) continue;
+        if (b->prefix) name_trie_remove(b->prefix, b->rows[r].name, contact_id(b, r));
+        handle_release(b, b->handle_of[r]);
+        b->handle_of[r] = BOOK_DEAD;
+        if (gone) gone[r / 64] |= 1ULL << (r % 64);
+        k++;
+    }
+    if (!k) { free(gone); return 0; }
+    b->live -= k;
+    // One sweep drops the index entries of the rows just marked. A slot
+    // that fills from later in its run is looked at again.
+    for (size_t i = 0; i <= b->mask; i++) {
+        for (;;) {
+            uint32_t id = b->slot[i].id;
+            if (!id) break;
+            size_t r = id - 1;
+            if (gone ? !(gone[r / 64] >> (r % 64) & 1) : b->handle_of[r] != BOOK_DEAD) break;
+            name_index_remove_at(b->slot, b->mask, i);
+        }
+    }
+    free(gone);
+    // Whatever the mode, a bulk delete pays for compaction at once.
+    trim(b);
+    if (b->mode != BOOK_TOMBSTONE) book_compact(b);
+    else maybe_compact(b);
+    return k;
+}
+
+bool book_compact(ContactBook *b) {
+    if (b->live == b->n) return true;
+    uint32_t *to = malloc(b->n * sizeof *to);
+    if (!to) return false;
+    size_t j = 0;
+    for (size_t i = 0; i < b->n; i++) {
+        if (b->handle_of[i] == BOOK_DEAD) continue;
+        to[i] = (uint32_t)j;
+        b->rows[j] = b->rows[i];
+        b->handle_of[j] = b->handle_of[i];
+        b->handle[b->handle_of[j]].row = (uint32_t)j;
+        j++;
+    }
+    for (size_t i = 0; i <= b->mask; i++)
+        if (b->slot[i].id) b->slot[i].id = to[b->slot[i].id - 1] + 1;
+    b->n = j;
+    free(to);
+    return true;
+}
+
+bool book_index_prefixes(ContactBook *b, bool fold) {
+    NameTrie *t = malloc(sizeof *t);
+    if (!t || !name_trie_init(t, fold)) { free(t); return false; }
+    for (size_t r = 0; book_next(b, &r); r++)
+        if (!name_trie_add(t, b->rows[r].name, contact_id(b, r))) {
+            name_trie_free(t);
+            free(t);
+            return false;
+        }
+    if (b->prefix) name_trie_free(b->prefix);
+    free(b->prefix);
+    b->prefix = t;
+    return true;
+}
+
+bool book_copy(ContactBook *dst, const ContactBook *src) {
+    ContactBook b = *src;
+    b.rows = malloc(b.cap * sizeof *b.rows);
+    b.handle_of = malloc(b.cap * sizeof *b.handle_of);
+    b.slot = malloc((b.mask + 1) * sizeof *b.slot);
+    b.handle = malloc(b.hcap * sizeof *b.handle);
+    b.prefix = NULL;
+    bool ok = (!b.cap || (b.rows && b.handle_of)) && b.slot && (!b.hcap || b.handle);
+    if (ok) {
+        if (b.n) {
+            memcpy(b.rows, src->rows, b.n * sizeof *b.rows);
+            memcpy(b.handle_of, src->handle_of, b.n * sizeof *b.handle_of);
+        }
+        memcpy(b.slot, src->slot, (b.mask + 1) * sizeof *b.slot);
+        if (b.nhandles) memcpy(b.handle, src->handle, b.nhandles * sizeof *b.handle);
+        if (src->prefix) ok = book_index_prefixes(&b, src->prefix->fold);
+    }
+    if (!ok) book_free(&b);
+    *dst = b;
+    return ok;
+}
+
+static bool has_prefix(const char *s, const char *prefix) {
+    while (*prefix) if (*s++ != *prefix++) return false;
+    return true;
+}
+
+size_t complete_contact(const ContactBook *b, const char *prefix, size_t *rows, size_t k) {
+    if (!k) return 0;
+    if (b->prefix) {
+        uint64_t small[64], *ids = k <= 64 ? small : malloc(k * sizeof *ids);
+        if (!ids) return 0;
+        size_t m = name_trie_complete(b->prefix, prefix, ids, k);
+        for (size_t i = 0; i < m; i++) rows[i] = (size_t)contact_row(b, ids[i]);
+        if (ids != small) free(ids);
+        return m;
+    }
+    // The k smallest matches so far, kept sorted by insertion.
+    size_t m = 0;
+    for (size_t r = 0; book_next(b, &r); r++) {
+        const char *s = b->rows[r].name;
+        if (!has_prefix(s, prefix)) continue;
+        if (m == k && strcmp(s, b->rows[rows[m - 1]].name) >= 0) continue;
+        size_t i = m < k ? m++ : m - 1;
+        for (; i && strcmp(s, b->rows[rows[i - 1]].name) < 0; i--) rows[i] = rows[i - 1];
+        rows[i] = r;
+    }
+    return m;
+}
+
+void print_contacts(const ContactBook *b) {
+    for (size_t r = 0; book_next(b, &r); r++)
+        printf("%s %s %d\n", b->rows[r].name, b->rows[r].phone, b->rows[r].age);
+}
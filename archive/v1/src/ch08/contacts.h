@@ -0,0 +1,117 @@
+#ifndef CONTACTS_H
+#define CONTACTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "names.h"
+#include "prefix.h"
+
+// The contact book of p16-p20 with an index on name next to the rows, so
+// find_contact costs a hash and a probe or two instead of a strcmp per
+// row. The index is the one in names.h, keyed on the name with ASCII
+// letters folded, so it answers both exact and case-insensitive lookups.
+//
+// Rows move when contacts are deleted (how depends on the delete mode),
+// so a caller that keeps a reference across deletes keeps a ContactId:
+// it stays valid until that contact is deleted, and then never matches
+// another contact.
+
+typedef struct { char name[50]; char phone[20]; int age; } Contact;
+
+// Generation << 32 | handle slot; 0 is never a valid id.
+typedef uint64_t ContactId;
+
+// Where a handle's contact is; gen is bumped when it is deleted.
+typedef struct { uint32_t row, gen; } Handle;
+
+typedef enum {
+    BOOK_TOMBSTONE,   // O(1): the row is marked dead and skipped, order is
+                      // kept, and rows are compacted once over BOOK_DEAD_MAX
+                      // of them are dead (the default)
+    BOOK_SWAP,        // O(1): the last row moves into the hole
+    BOOK_SHIFT        // O(n): later rows move down one, as p19 did
+} DeleteMode;
+
+// Compact when more than this fraction of the rows are dead.
+#define BOOK_DEAD_MAX 0.25
+
+// In handle_of, a dead row.
+#define BOOK_DEAD UINT32_MAX
+
+typedef struct {
+    Contact *rows;         // rows[0 .. n), live and dead, in the order added
+    uint32_t *handle_of;   // row -> handle slot, or BOOK_DEAD
+    size_t n, cap, live;
+    NameSlot *slot;        // open addressing, linear probing, load <= 1/2
+    size_t mask;
+    Handle *handle;        // handle slots; free ones chain through row
+    size_t nhandles, hcap;
+    uint32_t free_handle;  // UINT32_MAX if none
+    DeleteMode mode;
+    NameTrie *prefix;      // NULL unless book_index_prefixes was called
+} ContactBook;
+
+// false if out of memory.
+bool book_init(ContactBook *b);
+void book_free(ContactBook *b);
+
+// Changing modes is allowed at any time.
+void book_set_delete_mode(ContactBook *b, DeleteMode mode);
+
+// Names and phones are cut to fit, as snprintf would. Returns the new
+// contact's id, or 0 if out of memory, with the book unchanged.
+ContactId add_contact(ContactBook *b, const char *name, const char *phone, int age);
+
+// Row of the first live contact (in row order) named name, or -1.
+long find_contact(const ContactBook *b, const char *name);
+// The same with ASCII letters compared case-insensitively.
+long find_contact_nocase(const ContactBook *b, const char *name);
+
+// Current row of id, or -1 once it has been deleted.
+long contact_row(const ContactBook *b, ContactId id);
+// Id of a live row.
+ContactId contact_id(const ContactBook *b, size_t row);
+
+// Delete the first contact named name, or the contact id. false if there
+// was none.
+bool delete_contact(ContactBook *b, const char *name);
+bool delete_id(ContactBook *b, ContactId id);
+
+// Delete every contact for which pred is true, in one pass over the rows
+// and one over the index; returns how many. Much faster than one
+// delete_contact per row when many go at once.
+size_t delete_if(ContactBook *b, bool (*pred)(const Contact *c, void *ctx), void *ctx);
+
+// Squeeze out dead rows now. Rows keep their order; ids stay valid. false
+// if out of memory, with nothing changed.
+bool book_compact(ContactBook *b);
+
+// A copy of src in dst, with the same rows, ids and delete mode; a prefix
+// index is built afresh rather than copied. false if out of memory, with
+// dst empty (book_free on it is a no-op).
+bool book_copy(ContactBook *dst, const ContactBook *src);
+
+// Keep a prefix index on name from now on, case-insensitive for ASCII
+// letters with fold set, kept up to date by every add and delete. false if
+// out of memory, with the book as it was.
+bool book_index_prefixes(ContactBook *b, bool fold);
+
+// Rows of up to k live contacts whose name starts with prefix, in strcmp
+// order of the names; returns how many. Equal names come in the order
+// they were added, except that under BOOK_SWAP the ones already there
+// when the index was made come in row order. For type-ahead; without a
+// prefix index it scans every row, comparing bytes exactly, and equal
+// names come in row order.
+size_t complete_contact(const ContactBook *b, const char *prefix, size_t *rows, size_t k);
+
+// Advance *row to the next live row at or after it; false at the end:
+//   for (size_t r = 0; book_next(b, &r); r++) ... b->rows[r] ...
+static inline bool book_next(const ContactBook *b, size_t *row) {
+    while (*row < b->n && b->handle_of[*row] == BOOK_DEAD) ++*row;
+    return *row < b->n;
+}
+
+void print_contacts(const ContactBook *b);
+
+#endif
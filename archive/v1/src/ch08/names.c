@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include "names.h"
+
+bool name_eq_nocase(const char *a, const char *b) {
+    for (;; a++, b++) {
+        if (name_fold((unsigned char)*a) != name_fold((unsigned char)*b)) return false;
+        if (!*a) return true;
+    }
+}
+
+static uint32_t hash16(const char *s, size_t n, bool folded) {
+    uint64_t x = HASH_SEED ^ n;
+    for (size_t i = 0; i < n; i += 16) {
+        unsigned char b[16] = {0};
+        size_t m = n - i < 16 ? n - i : 16;
+        memcpy(b, s + i, m);
+        if (folded) for (size_t j = 0; j < m; j++) b[j] = name_fold(b[j]);
+        x = hash_mix(hash_load8(b) ^ HASH_K1, hash_load8(b + 8) ^ x);
+    }
+    return (uint32_t)hash_mix(x, HASH_K2);
+}
+
+uint32_t name_hash(const char *s, size_t n) { return hash16(s, n, true); }
+uint32_t bytes_hash(const char *s, size_t n) { return hash16(s, n, false); }
+
+bool name_index_init(NameSlot **slot, size_t *mask) {
+    *slot = calloc(NAME_INDEX_MIN, sizeof **slot);
+    *mask = NAME_INDEX_MIN - 1;
+    return *slot != NULL;
+}
+
+void name_index_put(NameSlot *slot, size_t mask, uint32_t hash, uint32_t id) {
+    size_t i = hash & mask;
+    while (slot[i].id) i = (i + 1) & mask;
+    slot[i] = (NameSlot){hash, id};
+}
+
+bool name_index_reserve(NameSlot **slot, size_t *mask, size_t want) {
+    size_t n = *mask + 1;
+    while (want * 2 > n) n *= 2;
+    if (n == *mask + 1) return true;
+    NameSlot *s = calloc(n, sizeof *s);
+    if (!s) return false;
+    for (size_t i = 0; i <= *mask; i++)
+        if ((*slot)[i].id) name_index_put(s, n - 1, (*slot)[i].hash, (*slot)[i].id);
+    free(*slot);
+    *slot = s;
+    *mask = n - 1;
+    return true;
+}
+
+size_t name_index_slot(const NameSlot *slot, size_t mask, uint32_t hash, uint32_t id) {
+    size_t i = hash & mask;
+    while (slot[i].id != id) i = (i + 1) & mask;
+    return i;
+}
+
+// Only slots after i (cyclically) move, so no run is ever broken by a hole.
+void name_index_remove_at(NameSlot *slot, size_t mask, size_t i) {
+    for (size_t j = (i + 1) & mask; slot[j].id; j = (j + 1) & mask) {
+        size_t home = slot[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            slot[i] = slot[j];
+            i = j;
+        }
+    }
+    slot[i] = (NameSlot){0, 0};
+}
+
+long name_index_find(const NameSlot *slot, size_t mask, size_t count, const char *name, bool nocase,
+                     const char *(*name_of)(const void *ctx, size_t row), const void *ctx) {
+    uint32_t h = name_hash(name, strlen(name));
+    long best = -1;
+    size_t i = h & mask;
+    for (size_t step = 0; step <= mask && slot[i].id; step++, i = (i + 1) & mask) {
+        const NameSlot *e = &slot[i];
+        if (e->id > count) break;
+        long r = (long)e->id - 1;
+        if (e->hash != h || (best >= 0 && r > best)) continue;
+        const char *s = name_of(ctx, (size_t)r);
+        if (nocase ? name_eq_nocase(s, name) : strcmp(s, name) == 0) best = r;
+    }
+    return best;
+}
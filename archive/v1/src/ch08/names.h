@@ -0,0 +1,63 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// The name index that ContactBook, CompactBook and the contact file share.
+// Each slot keeps a hash of the name with ASCII letters folded to lower
+// case, so one table answers both exact and case-insensitive lookups and
+// never rehashes a name when it grows. The table uses open addressing
+// with linear probing, load <= 1/2, and removal that moves later members
+// of a probe run back. The hash is part of the contact file format, so
+// changing it means a new CF_VERSION.
+
+// id = row + 1; 0 marks an empty slot.
+typedef struct { uint32_t hash, id; } NameSlot;
+
+#define NAME_INDEX_MIN 16
+
+static inline unsigned char name_fold(unsigned char c) {
+    return (unsigned)(c - 'A') < 26 ? (unsigned char)(c | 0x20) : c;
+}
+
+bool name_eq_nocase(const char *a, const char *b);
+
+// The multiply-fold step (as in ch06/wordcount.c) under the hashes below,
+// and the contact file's checksum.
+#define HASH_SEED 0x9e3779b97f4a7c15ULL
+#define HASH_K1   0xa0761d6478bd642fULL
+#define HASH_K2   0xe7037ed1a0b428dbULL
+
+static inline uint64_t hash_load8(const unsigned char *p) { uint64_t w; memcpy(&w, p, 8); return w; }
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+    unsigned __int128 r = (unsigned __int128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+// s[0 .. n), 16 bytes per multiply, the last block zero-padded: name_hash
+// with letters folded, for the name index; bytes_hash as they are.
+uint32_t name_hash(const char *s, size_t n);
+uint32_t bytes_hash(const char *s, size_t n);
+
+// An index of NAME_INDEX_MIN empty slots; false if out of memory.
+bool name_index_init(NameSlot **slot, size_t *mask);
+void name_index_put(NameSlot *slot, size_t mask, uint32_t hash, uint32_t id);
+// Room for want names; false if out of memory, with the index unchanged.
+bool name_index_reserve(NameSlot **slot, size_t *mask, size_t want);
+// The slot holding id, which must be in the index under hash.
+size_t name_index_slot(const NameSlot *slot, size_t mask, uint32_t hash, uint32_t id);
+// Empty slot i.
+void name_index_remove_at(NameSlot *slot, size_t mask, size_t i);
+
+// Lowest row whose name, as name_of gives it, is name (strcmp, or ASCII
+// case-insensitive with nocase), or -1. Every lookup walks the whole
+// probe run, since a name may be in several rows. It visits at most
+// mask + 1 slots and stops at an id past count, so an index read from a
+// file cannot make it loop or reach a row that is not there.
+long name_index_find(const NameSlot *slot, size_t mask, size_t count, const char *name, bool nocase,
+                     const char *(*name_of)(const void *ctx, size_t row), const void *ctx);
+
+#endif
@@ -1,26 +1,29 @@
+// gcc -std=c23 -O2 p18.c contacts.c names.c prefix.c -o p18
 #include <stdio.h>
-#include <string.h>
-
-typedef struct { char name[50]; char phone[20]; int age; } Contact;
-
-#define MAXC 10
-
-int find_contact(const Contact a[], int n, const char *name) {
-    for (int i = 0; i < n; i++)
-        if (strcmp(a[i].name, name) == 0) return i;
-    return -1;
-}
+#include "contacts.h"
 
 int main(void) {
-    Contact book[MAXC] = {
-        {"Alice","123-4567",20},
-        {"Bob","555-9876",25},
-        {"Cara","777-0000",30}
-    };
-    int n = 3;
-    char key[50]; scanf("%49s", key);
-    int idx = find_contact(book, n, key);
-    if (idx >= 0) printf("%s %s %d\n", book[idx].name, book[idx].phone, book[idx].age);
-    else puts("Not found");
+    ContactBook book;
+    if (!book_init(&book)) return 1;
+    add_contact(&book, "Alice", "123-4567", 20);
+    add_contact(&book, "Bob",   "555-9876", 25);
+    add_contact(&book, "Cara",  "777-0000", 30);
+    if (!book_index_prefixes(&book, true)) { book_free(&book); return 1; }
+
+    char key[50];
+    if (scanf("%49s", key) != 1) { book_free(&book); return 0; }
+    long idx = find_contact(&book, key);
+    if (idx < 0) idx = find_contact_nocase(&book, key);
+    size_t rows[5], m;
+    if (idx >= 0) {
+        const Contact *c = &book.rows[idx];
+        printf("%s %s %d\n", c->name, c->phone, c->age);
+    } else if ((m = complete_contact(&book, key, rows, 5))) {
+        for (size_t i = 0; i < m; i++) {
+            const Contact *c = &book.rows[rows[i]];
+            printf("%s %s %d\n", c->name, c->phone, c->age);
+        }
+    } else puts("Not found");
+    book_free(&book);
     return 0;
 }
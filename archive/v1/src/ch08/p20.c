@@ -1,9 +1,10 @@
+// gcc -std=c23 -O2 -I../ch05 -I../ch10 p20.c contactfile.c names.c ../ch10/lines.c ../ch10/numparse.c ../ch05/cpu_dispatch.c -o p20
+// p20 in.txt out.cbk converts a name;phone;age file; with no arguments it
+// saves three contacts as text, converts them and reads them back mapped.
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
-
-typedef struct { char name[50]; char phone[20]; int age; } Contact;
-
-#define MAXC 100
+#include "contactfile.h"
 
 void save_contacts(const char *path, const Contact a[], int n) {
     FILE *f = fopen(path, "w");
@@ -13,30 +14,30 @@ void save_contacts(const char *path, const Contact a[], int n) {
     fclose(f);
 }
 
-int load_contacts(const char *path, Contact a[], int maxn) {
-    FILE *f = fopen(path, "r");
-    if (!f) return 0;
-    int n = 0;
-    while (n < maxn &&
-           fscanf(f, " %49[^;];%19[^;];%d", a[n].name, a[n].phone, &a[n].age) == 3) {
-        n++;
-        int ch = fgetc(f); (void)ch; // consume newline if present
-    }
-    fclose(f);
-    return n;
+static int convert(const char *txt, const char *bin) {
+    size_t line = 0;
+    CfStatus st = cf_convert_text(txt, bin, &line);
+    if (st == CF_CORRUPT) fprintf(stderr, "%s:%zu: not name;phone;age\n", txt, line);
+    else if (st != CF_OK)
+        fprintf(stderr, "%s -> %s: %s\n", txt, bin, st == CF_IO ? strerror(errno) : "out of memory");
+    return st != CF_OK;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    if (argc == 3) return convert(argv[1], argv[2]);
+
     Contact out[3] = {
         {"Alice","123-4567",20},
         {"Bob","555-9876",25},
         {"Cara","777-0000",30}
     };
     save_contacts("contacts.txt", out, 3);
+    if (convert("contacts.txt", "contacts.cbk")) return 1;
 
-    Contact in[MAXC];
-    int n = load_contacts("contacts.txt", in, MAXC);
-    for (int i = 0; i < n; i++)
-        printf("%s %s %d\n", in[i].name, in[i].phone, in[i].age);
+    ContactFile f;
+    if (cf_open(&f, "contacts.cbk") != CF_OK || cf_verify(&f) != CF_OK) return 1;
+    for (size_t i = 0; i < f.count; i++)
+        printf("%s %s %d\n", cf_name(&f, i), cf_phone(&f, i), cf_age(&f, i));
+    cf_close(&f);
     return 0;
 }
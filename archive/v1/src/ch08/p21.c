@@ -0,0 +1,36 @@
+// n! of any size with the bignum module (p08.c's BigInt overflows past 20!).
+// gcc -std=c23 -O2 -pthread p21.c bignum.c -o p21
+// echo "100000 4" | ./p21     (n, then threads for the product tree)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bignum.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int main(void) {
+    unsigned long long n; int threads = 1;
+    if (scanf("%llu", &n) != 1) return 0;
+    if (scanf("%d", &threads) != 1) threads = 1;
+
+    BigInt f; big_init(&f);
+    double t0 = now_ms();
+    big_factorial(&f, n, threads);
+    double t1 = now_ms();
+    char *s = big_to_dec(&f);
+    double t2 = now_ms();
+
+    size_t len = strlen(s);
+    if (len <= 60) printf("%llu! = %s\n", n, s);
+    else printf("%llu! = %.20s...%s (%zu digits)\n", n, s, s + len - 20, len);
+    printf("product %.1f ms, decimal %.1f ms\n", t1 - t0, t2 - t1);
+
+    free(s);
+    big_free(&f);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// find_contact through the name index against the old strcmp scan, for
+// books of 10 to 10M contacts: ns per lookup for hits, case-insensitive
+// hits and misses. The scan is only run up to 100k rows.
+// gcc -std=c23 -O2 p22.c contacts.c names.c prefix.c -o p22
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "contacts.h"
+
+#define QUERIES (1 << 20)
+#define SCAN_MAX 100000
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static long scan(const ContactBook *b, const char *name) {
+    for (size_t i = 0; i < b->n; i++)
+        if (strcmp(b->rows[i].name, name) == 0) return (long)i;
+    return -1;
+}
+
+typedef struct { char s[24]; } Name;
+
+// Contact i is "Person <i * 7919 mod 2^32>", so names are distinct and
+// their order has nothing to do with the row order.
+static void name_of(size_t i, char *s, size_t cap, bool upper) {
+    snprintf(s, cap, upper ? "PERSON %u" : "Person %u", (unsigned)(i * 7919));
+}
+
+int main(void) {
+    Name *hit = malloc(QUERIES * sizeof *hit), *up = malloc(QUERIES * sizeof *up);
+    Name *miss = malloc(QUERIES * sizeof *miss);
+    if (!hit || !up || !miss) return 1;
+    bool ok = true;
+    printf("%10s %12s %12s %12s %12s\n", "contacts", "scan", "exact", "nocase", "miss");
+    for (size_t n = 10; n <= 10000000; n *= 10) {
+        ContactBook b;
+        if (!book_init(&b)) return 1;
+        char s[24];
+        for (size_t i = 0; i < n; i++) {
+            name_of(i, s, sizeof s, false);
+            if (!add_contact(&b, s, "555-0100", (int)(i % 100))) return 1;
+        }
+        long *want = malloc(QUERIES * sizeof *want);
+        if (!want) return 1;
+        for (size_t q = 0; q < QUERIES; q++) {
+            size_t i = next_rand() % n;
+            want[q] = (long)i;
+            name_of(i, hit[q].s, sizeof hit[q].s, false);
+            name_of(i, up[q].s, sizeof up[q].s, true);
+            snprintf(miss[q].s, sizeof miss[q].s, "Nobody %u", (unsigned)next_rand());
+        }
+
+        // Enough scanned lookups to time, but not hours of them.
+        double t_scan = 0;
+        if (n <= SCAN_MAX) {
+            size_t m = n <= 1000 ? QUERIES : 1000;
+            double t0 = now_ms();
+            for (size_t q = 0; q < m; q++) ok &= scan(&b, hit[q].s) == want[q];
+            t_scan = (now_ms() - t0) * 1e6 / (double)m;
+        }
+        double t0 = now_ms();
+        for (size_t q = 0; q < QUERIES; q++) ok &= find_contact(&b, hit[q].s) == want[q];
+        double t_hit = (now_ms() - t0) * 1e6 / QUERIES;
+        t0 = now_ms();
+        for (size_t q = 0; q < QUERIES; q++) ok &= find_contact_nocase(&b, up[q].s) == want[q];
+        double t_up = (now_ms() - t0) * 1e6 / QUERIES;
+        t0 = now_ms();
+        for (size_t q = 0; q < QUERIES; q++) ok &= find_contact(&b, miss[q].s) == -1;
+        double t_miss = (now_ms() - t0) * 1e6 / QUERIES;
+
+        if (n <= SCAN_MAX) printf("%10zu %9.1f ns", n, t_scan);
+        else printf("%10zu %12s", n, "-");
+        printf(" %9.1f ns %9.1f ns %9.1f ns\n", t_hit, t_up, t_miss);
+        free(want);
+        book_free(&b);
+    }
+    free(hit); free(up); free(miss);
+    puts(ok ? "all lookups match" : "MISMATCH");
+    return !ok;
+}
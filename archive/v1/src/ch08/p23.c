@@ -0,0 +1,103 @@
+// Deleting 1M of 10M contacts: by name in each delete mode, by id, and in
+// bulk with delete_if. The old shifting delete is timed on a few thousand
+// rows and scaled up. Afterwards every book must hold the same contacts.
+// gcc -std=c23 -O2 p23.c contacts.c names.c prefix.c -o p23
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "contacts.h"
+
+#define N 10000000
+#define DEL (N / 10)
+#define SHIFT_SAMPLE 20
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Contact i is "Person <i * 7919 mod 2^32>"; every tenth one is deleted,
+// in scrambled order.
+static void name_of(size_t i, char *s) { snprintf(s, 24, "Person %u", (unsigned)(i * 7919)); }
+static size_t victim(size_t k) { return (k * 7777777 % DEL) * 10 + 3; }
+
+static bool doomed(const Contact *c, void *ctx) { (void)ctx; return c->age % 10 == 3; }
+
+static ContactId *ids;
+
+static void fill(ContactBook *b) {
+    char s[24];
+    book_init(b);
+    for (size_t i = 0; i < N; i++) {
+        name_of(i, s);
+        ids[i] = add_contact(b, s, "555-0100", (int)i);
+        if (!ids[i]) { fputs("out of memory\n", stderr); exit(1); }
+    }
+}
+
+// The survivors, in row order, must be exactly the rows not deleted.
+static bool check(ContactBook *b, bool ordered) {
+    if (b->live != N - DEL) return false;
+    if (ordered) {
+        size_t i = 0;
+        for (size_t r = 0; book_next(b, &r); r++, i++) {
+            if (i % 10 == 3) i++;
+            if (b->rows[r].age != (int)i) return false;
+        }
+    }
+    char s[24];
+    for (size_t i = 0; i < N; i += 997) {
+        name_of(i, s);
+        long r = find_contact(b, s);
+        if ((r < 0) != (i % 10 == 3) || (r >= 0 && contact_row(b, ids[i]) != r)) return false;
+    }
+    return true;
+}
+
+static bool run(const char *what, DeleteMode mode, int how) {
+    ContactBook b;
+    fill(&b);
+    book_set_delete_mode(&b, mode);
+    char s[24];
+    double t0 = now_ms();
+    if (how == 0) {
+        for (size_t k = 0; k < DEL; k++) { name_of(victim(k), s); delete_contact(&b, s); }
+    } else if (how == 1) {
+        for (size_t k = 0; k < DEL; k++) delete_id(&b, ids[victim(k)]);
+    } else {
+        delete_if(&b, doomed, NULL);
+    }
+    double ms = now_ms() - t0;
+    bool ok = check(&b, mode != BOOK_SWAP);
+    printf("%-34s %10.1f ms%s\n", what, ms, ok ? "" : "  WRONG");
+    book_free(&b);
+    return ok;
+}
+
+int main(void) {
+    ids = malloc(N * sizeof *ids);
+    if (!ids) return 1;
+    bool ok = true;
+    printf("deleting %d of %d contacts\n", DEL, N);
+    ok &= run("delete_contact, tombstones", BOOK_TOMBSTONE, 0);
+    ok &= run("delete_contact, swap", BOOK_SWAP, 0);
+    ok &= run("delete_id, tombstones", BOOK_TOMBSTONE, 1);
+    ok &= run("delete_if, one pass", BOOK_TOMBSTONE, 2);
+
+    ContactBook b;
+    fill(&b);
+    book_set_delete_mode(&b, BOOK_SHIFT);
+    char s[24];
+    double t0 = now_ms();
+    for (size_t k = 0; k < SHIFT_SAMPLE; k++) { name_of(victim(k), s); delete_contact(&b, s); }
+    double ms = (now_ms() - t0) * DEL / SHIFT_SAMPLE;
+    printf("%-34s %10.1f ms  (scaled from %d)\n", "delete_contact, shifting", ms, SHIFT_SAMPLE);
+    book_free(&b);
+
+    free(ids);
+    puts(ok ? "all survivors match" : "MISMATCH");
+    return !ok;
+}
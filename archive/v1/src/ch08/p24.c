@@ -0,0 +1,125 @@
+// Startup cost of a 1M-contact book: p20's fscanf loader against mapping
+// the binary contact file, then ns per lookup in the map against the
+// in-memory ContactBook, with every contact checked to match. The files
+// were just written, so both loads read from the page cache.
+// gcc -std=c23 -O2 -I../ch05 -I../ch10 p24.c contactfile.c contacts.c names.c prefix.c ../ch10/lines.c ../ch10/numparse.c ../ch05/cpu_dispatch.c -o p24
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "contactfile.h"
+
+#define N (1 << 20)
+#define QUERIES (1 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// p20's loader.
+static int load_contacts(const char *path, Contact a[], int maxn) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    int n = 0;
+    while (n < maxn &&
+           fscanf(f, " %49[^;];%19[^;];%d", a[n].name, a[n].phone, &a[n].age) == 3) {
+        n++;
+        int ch = fgetc(f); (void)ch;
+    }
+    fclose(f);
+    return n;
+}
+
+// Names repeat now and then (i / 4 mod N / 2 spread by 7919), so the
+// first-match rule is exercised too.
+static void name_of(size_t i, char *s, size_t cap, bool upper) {
+    unsigned k = (unsigned)((i % 4 == 3 ? i / 4 : i) * 7919);
+    snprintf(s, cap, upper ? "PERSON %u" : "Person %u", k);
+}
+
+int main(void) {
+    FILE *f = fopen("p24.txt", "w");
+    if (!f) return 1;
+    char s[24];
+    for (size_t i = 0; i < N; i++) {
+        name_of(i, s, sizeof s, false);
+        fprintf(f, "%s;555-%04u;%d\n", s, (unsigned)(next_rand() % 10000), (int)(i % 100));
+    }
+    double text_mb = (double)ftell(f) / 1e6;
+    fclose(f);
+
+    Contact *rows = malloc(N * sizeof *rows);
+    if (!rows) return 1;
+    double t0 = now_ms();
+    int n = load_contacts("p24.txt", rows, N);
+    double t_text = now_ms() - t0;
+
+    ContactBook b;
+    if (!book_init(&b)) return 1;
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+        if (!add_contact(&b, rows[i].name, rows[i].phone, rows[i].age)) return 1;
+    double t_book = now_ms() - t0;
+
+    size_t line;
+    t0 = now_ms();
+    if (cf_convert_text("p24.txt", "p24.cbk", &line) != CF_OK) return 1;
+    double t_conv = now_ms() - t0;
+
+    ContactFile cf;
+    t0 = now_ms();
+    if (cf_open(&cf, "p24.cbk") != CF_OK) return 1;
+    long first = cf_find(&cf, b.rows[0].name);
+    double t_open = now_ms() - t0;
+    t0 = now_ms();
+    bool ok = cf_verify(&cf) == CF_OK && first == 0 && cf.count == (size_t)n;
+    double t_verify = now_ms() - t0;
+
+    // Every contact: the map answers as the book does and holds the same fields.
+    for (size_t i = 0; ok && i < (size_t)n; i++) {
+        long r = cf_find(&cf, rows[i].name);
+        ok = r == find_contact(&b, rows[i].name) && strcmp(cf_phone(&cf, i), rows[i].phone) == 0
+             && strcmp(cf_name(&cf, i), rows[i].name) == 0 && cf_age(&cf, i) == rows[i].age;
+    }
+
+    size_t *q = malloc(QUERIES * sizeof *q);
+    if (!q) return 1;
+    for (size_t k = 0; k < QUERIES; k++) q[k] = next_rand() % (size_t)n;
+    t0 = now_ms();
+    for (size_t k = 0; k < QUERIES; k++) ok &= find_contact(&b, rows[q[k]].name) >= 0;
+    double t_bfind = (now_ms() - t0) * 1e6 / QUERIES;
+    t0 = now_ms();
+    for (size_t k = 0; k < QUERIES; k++) ok &= cf_find(&cf, rows[q[k]].name) >= 0;
+    double t_cfind = (now_ms() - t0) * 1e6 / QUERIES;
+    for (size_t k = 0; k < 1000; k++) {
+        name_of(q[k], s, sizeof s, true);
+        ok &= cf_find_nocase(&cf, s) == find_contact_nocase(&b, s) && cf_find(&cf, s) == -1;
+    }
+
+    printf("%d contacts, text %.1f MB, binary %.1f MB\n", n,
+           text_mb, (double)cf.map_len / 1e6);
+    printf("fscanf load          %9.1f ms\n", t_text);
+    printf("  + building a book  %9.1f ms\n", t_book);
+    printf("convert text         %9.1f ms (once)\n", t_conv);
+    printf("open + first lookup  %9.3f ms\n", t_open);
+    printf("verify checksum      %9.1f ms (optional)\n", t_verify);
+    printf("lookup, book         %9.1f ns\n", t_bfind);
+    printf("lookup, mapped file  %9.1f ns\n", t_cfind);
+    cf_close(&cf);
+    book_free(&b);
+    free(rows);
+    free(q);
+    remove("p24.txt");
+    remove("p24.cbk");
+    puts(ok ? "all contacts match" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,119 @@
+// Memory of 1M contacts with names and phones that repeat now and then, in a CompactBook against a ContactBook, with add and find times and
+// every row checked to match, before and after deleting half of them.
+// gcc -std=c23 -O2 -I../ch06 p25.c compact.c contacts.c names.c prefix.c ../ch06/arena.c -o p25
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "compact.h"
+
+#define N (1 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *first[] = {
+    "Alice", "Bob", "Cara", "Dmitri", "Elena", "Farouk", "Grace", "Hiroshi",
+    "Ines", "Jun", "Katarzyna", "Liam", "Maximilian", "Nia", "Oskar", "Priya"
+};
+static const char *last[] = {
+    "Li", "Kim", "Smith", "Garcia", "Nguyen", "Okafor", "Johansson", "Rossi",
+    "Kowalczyk", "Haddad", "Fernandes", "Takahashi", "Van der Berg", "Moreau"
+};
+
+// Names: a first name and a number, or a full name with one, so each
+// repeats a few times at most (both books walk every row of a repeated
+// name on lookup); phones in four formats, one of them not packable.
+static void make(char *name, char *phone) {
+    const char *f = first[next_rand() % 16], *l = last[next_rand() % 14];
+    unsigned k = (unsigned)(next_rand() % 100000);
+    if (next_rand() % 4 == 0) sprintf(name, "%s %u", f, k);
+    else sprintf(name, "%s %s %u", f, l, k);
+    unsigned d = (unsigned)(next_rand() % 10000);
+    switch (next_rand() % 8) {
+    case 0:  sprintf(phone, "555-%04u", d); break;
+    case 1:  sprintf(phone, "ext. %u", d % 100); break;
+    case 2:  sprintf(phone, "+1 555 010 %04u", d); break;
+    default: sprintf(phone, "(555) 010-%04u", d);
+    }
+}
+
+static size_t book_bytes(const ContactBook *b) {
+    return b->cap * (sizeof(Contact) + sizeof(uint32_t)) + (b->mask + 1) * sizeof(NameSlot)
+         + b->hcap * sizeof(Handle);
+}
+
+static bool same(const CompactBook *c, const ContactBook *b) {
+    char buf[17];
+    size_t r = 0, s = 0;
+    for (;; r++, s++) {
+        bool more = cbook_next(c, &r);
+        if (more != book_next(b, &s)) return false;
+        if (!more) return true;
+        if (strcmp(cbook_name(c, r), b->rows[s].name) || strcmp(cbook_phone(c, r, buf), b->rows[s].phone)
+            || cbook_age(c, r) != b->rows[s].age)
+            return false;
+    }
+}
+
+int main(void) {
+    char (*name)[32] = malloc(N * sizeof *name), (*phone)[20] = malloc(N * sizeof *phone);
+    if (!name || !phone) return 1;
+    for (size_t i = 0; i < N; i++) make(name[i], phone[i]);
+
+    CompactBook c;
+    ContactBook b;
+    if (!cbook_init(&c) || !book_init(&b)) return 1;
+    double t0 = now_ms();
+    for (size_t i = 0; i < N; i++)
+        if (!add_contact(&b, name[i], phone[i], (int)(i % 100))) return 1;
+    double t_badd = (now_ms() - t0) * 1e6 / N;
+    t0 = now_ms();
+    for (size_t i = 0; i < N; i++)
+        if (!cbook_add(&c, name[i], phone[i], (int)(i % 100))) return 1;
+    double t_cadd = (now_ms() - t0) * 1e6 / N;
+
+    bool ok = same(&c, &b);
+    t0 = now_ms();
+    for (size_t i = 0; i < N; i++) ok &= find_contact(&b, name[next_rand() % N]) >= 0;
+    double t_bfind = (now_ms() - t0) * 1e6 / N;
+    t0 = now_ms();
+    for (size_t i = 0; i < N; i++) ok &= cbook_find(&c, name[next_rand() % N]) >= 0;
+    double t_cfind = (now_ms() - t0) * 1e6 / N;
+    for (size_t i = 0; i < 1000; i++) {
+        const char *s = name[next_rand() % N];
+        long r = cbook_find(&c, s), q = find_contact(&b, s);
+        ok &= r >= 0 && q >= 0 && strcmp(cbook_name(&c, (size_t)r), s) == 0 && cbook_age(&c, (size_t)r) == b.rows[q].age;
+    }
+
+    printf("add   ContactBook %6.1f ns, CompactBook %6.1f ns\n", t_badd, t_cadd);
+    printf("find  ContactBook %6.1f ns, CompactBook %6.1f ns\n", t_bfind, t_cfind);
+    printf("ContactBook: %zu bytes (%.1f per contact)\n", book_bytes(&b), (double)book_bytes(&b) / N);
+    cbook_print_memory(&c);
+
+    // Deleting half: the compact book rebuilds itself along the way.
+    for (size_t i = 0; i < N / 2; i++) {
+        const char *s = name[next_rand() % N];
+        ok &= cbook_delete(&c, s) == delete_contact(&b, s);
+    }
+    ok &= same(&c, &b);
+    puts("after deleting:");
+    cbook_print_memory(&c);
+
+    cbook_free(&c);
+    book_free(&b);
+    free(name);
+    free(phone);
+    puts(ok ? "all contacts match" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,166 @@
+// Type-ahead over 1M contacts: the first 10 names for prefixes of 1 to 4
+// letters, by scanning the rows, from a sorted NameArray and from the
+// book's radix trie, and the cost of keeping each one up to date as
+// contacts come and go. All three must give the same names.
+// gcc -std=c23 -O2 p26.c contacts.c names.c prefix.c -o p26
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "contacts.h"
+
+#define N (1 << 20)
+#define K 10
+#define QUERIES 100000
+#define SCANS 200
+#define CHURN 10000
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *first[] = {
+    "Alice", "Bob", "Cara", "Dmitri", "Elena", "Farouk", "Grace", "Hiroshi",
+    "Ines", "Jun", "Katarzyna", "Liam", "Maximilian", "Nia", "Oskar", "Priya"
+};
+static const char *last[] = {
+    "Li", "Kim", "Smith", "Garcia", "Nguyen", "Okafor", "Johansson", "Rossi",
+    "Kowalczyk", "Haddad", "Fernandes", "Takahashi", "Van der Berg", "Moreau"
+};
+
+static void make(char *name) {
+    sprintf(name, "%s %s %u", last[next_rand() % 14], first[next_rand() % 16],
+            (unsigned)(next_rand() % 100000));
+}
+
+typedef struct { char s[8]; } Prefix;
+
+static bool same_names(const ContactBook *b, const size_t *x, size_t nx, const size_t *y, size_t ny) {
+    if (nx != ny) return false;
+    for (size_t i = 0; i < nx; i++)
+        if (strcmp(b->rows[x[i]].name, b->rows[y[i]].name) != 0) return false;
+    return true;
+}
+
+int main(void) {
+    char (*name)[32] = malloc(N * sizeof *name);
+    const char **names = malloc(N * sizeof *names);
+    uint64_t *ids = malloc(N * sizeof *ids);
+    Prefix *q = malloc(QUERIES * sizeof *q);
+    if (!name || !names || !ids || !q) return 1;
+    ContactBook b;
+    if (!book_init(&b)) return 1;
+    for (size_t i = 0; i < N; i++) {
+        make(name[i]);
+        names[i] = name[i];
+        if (!(ids[i] = add_contact(&b, name[i], "555-0100", (int)(i % 100)))) return 1;
+    }
+    // Prefixes of real names, 1 to 4 letters, typed as the user would.
+    for (size_t i = 0; i < QUERIES; i++) {
+        size_t len = 1 + next_rand() % 4;
+        memcpy(q[i].s, name[next_rand() % N], len);
+        q[i].s[len] = '\0';
+    }
+
+    size_t want[SCANS][K], nwant[SCANS], rows[K];
+    double t0 = now_ms();
+    for (size_t i = 0; i < SCANS; i++) nwant[i] = complete_contact(&b, q[i].s, want[i], K);
+    double t_scan = (now_ms() - t0) * 1e3 / SCANS;
+
+    NameArray a;
+    name_array_init(&a, false);
+    t0 = now_ms();
+    if (!name_array_add_all(&a, names, ids, N)) return 1;
+    double t_abuild = now_ms() - t0;
+    t0 = now_ms();
+    if (!book_index_prefixes(&b, false)) return 1;
+    double t_tbuild = now_ms() - t0;
+
+    bool ok = true;
+    uint64_t got[K];
+    for (size_t i = 0; i < SCANS; i++) {
+        size_t m = name_array_complete(&a, q[i].s, got, K);
+        for (size_t j = 0; j < m; j++) rows[j] = (size_t)contact_row(&b, got[j]);
+        ok &= same_names(&b, want[i], nwant[i], rows, m);
+        m = complete_contact(&b, q[i].s, rows, K);
+        ok &= same_names(&b, want[i], nwant[i], rows, m);
+    }
+
+    size_t sink = 0;
+    t0 = now_ms();
+    for (size_t i = 0; i < QUERIES; i++) sink += name_array_complete(&a, q[i].s, got, K);
+    double t_array = (now_ms() - t0) * 1e3 / QUERIES;
+    t0 = now_ms();
+    for (size_t i = 0; i < QUERIES; i++) sink += complete_contact(&b, q[i].s, rows, K);
+    double t_trie = (now_ms() - t0) * 1e3 / QUERIES;
+
+    // Churn: a contact goes and a new one comes, with each index kept
+    // current; for the trie that is delete_id and add_contact.
+    size_t *victim = malloc(CHURN * sizeof *victim);
+    char (*fresh)[32] = malloc(CHURN * sizeof *fresh);
+    if (!victim || !fresh) return 1;
+    for (size_t i = 0; i < CHURN; i++) { victim[i] = next_rand() % N; make(fresh[i]); }
+    t0 = now_ms();
+    for (size_t i = 0; i < CHURN; i++) {
+        name_array_remove(&a, name[victim[i]], ids[victim[i]]);
+        if (!name_array_add(&a, fresh[i], UINT64_MAX - i)) return 1;
+    }
+    double t_achurn = (now_ms() - t0) * 1e3 / CHURN;
+    t0 = now_ms();
+    for (size_t i = 0; i < CHURN; i++) {
+        delete_id(&b, ids[victim[i]]);
+        if (!add_contact(&b, fresh[i], "555-0100", 1)) return 1;
+    }
+    double t_tchurn = (now_ms() - t0) * 1e3 / CHURN;
+
+    // After the churn: the trie against a scan of a book without one, and
+    // a case-folded trie against a folded array.
+    NameTrie *t = b.prefix;
+    b.prefix = NULL;
+    NameArray fa;
+    NameTrie ft;
+    name_array_init(&fa, true);
+    if (!name_trie_init(&ft, true)) return 1;
+    size_t live = 0;
+    for (size_t r = 0; book_next(&b, &r); r++) {
+        names[live] = b.rows[r].name;
+        ids[live++] = contact_id(&b, r);
+        if (!name_trie_add(&ft, b.rows[r].name, contact_id(&b, r))) return 1;
+    }
+    if (!name_array_add_all(&fa, names, ids, live)) return 1;
+    for (size_t i = 0; i < SCANS; i++) {
+        size_t m = complete_contact(&b, q[i].s, want[i], K);
+        b.prefix = t;
+        ok &= same_names(&b, want[i], m, rows, complete_contact(&b, q[i].s, rows, K));
+        b.prefix = NULL;
+        char low[8];
+        for (size_t j = 0; j < sizeof low; j++) low[j] = (char)(q[i].s[j] | (q[i].s[j] >= 'A' && q[i].s[j] <= 'Z' ? 0x20 : 0));
+        uint64_t g2[K];
+        m = name_trie_complete(&ft, low, got, K);
+        ok &= m == name_array_complete(&fa, q[i].s, g2, K) && memcmp(got, g2, m * sizeof *got) == 0;
+    }
+    b.prefix = t;
+
+    printf("%d contacts, top %d for 1-4 letter prefixes\n", N, K);
+    printf("scan          %10.1f us per query\n", t_scan);
+    printf("sorted array  %10.2f us per query, built in %.0f ms, %8.2f us per delete + add\n",
+           t_array, t_abuild, t_achurn);
+    printf("radix trie    %10.2f us per query, built in %.0f ms, %8.2f us per delete + add (%zu nodes)\n",
+           t_trie, t_tbuild, t_tchurn, t->nodes);
+    name_array_free(&a);
+    name_array_free(&fa);
+    name_trie_free(&ft);
+    book_free(&b);
+    free(name); free(names); free(ids); free(q); free(victim); free(fresh);
+    puts(ok && sink ? "all completions match" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,284 @@
+// Many readers and a rare writer on one contact book: a stress test of
+// SharedBook, whose readers must only ever see whole versions, then
+// lookups per second against a ContactBook behind a pthread rwlock while
+// a writer commits a batch of changes every 10 ms.
+// gcc -std=c23 -O2 -pthread p27.c shared.c contacts.c names.c prefix.c -o p27
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, nanosleep
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "shared.h"
+
+#define STRESS_N 10000         // contacts in the stress test
+#define STRESS_READERS 4
+#define STRESS_WRITERS 2
+#define STRESS_COMMITS 500     // per writer
+#define BATCH 100              // contacts changed per commit
+
+#define N 100000               // contacts in the benchmark
+#define RUN_MS 500
+#define WRITE_EVERY_MS 10
+#define MAX_THREADS 8
+
+static unsigned long long next_rand_r(unsigned long long *s) {
+    *s ^= *s << 13; *s ^= *s >> 7; *s ^= *s << 17;
+    return *s;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void name_of(char *s, size_t i) { sprintf(s, "c%06zu", i); }
+
+// Delete BATCH contacts in a row from start and add them back with age.
+static bool change(ContactBook *b, size_t n, size_t start, int age) {
+    char name[16];
+    for (size_t j = 0; j < BATCH; j++) {
+        name_of(name, (start + j) % n);
+        if (!delete_contact(b, name) || !add_contact(b, name, "555-0000", age)) return false;
+    }
+    return true;
+}
+
+// ---- stress ------------------------------------------------------------------
+// Every version has STRESS_N contacts and a "version" contact whose age is
+// its version number, and the commit that made it set the age of BATCH
+// contacts to that number. An aborted write sets ages to -1, which no
+// reader may see.
+
+typedef struct {
+    SharedBook *s;
+    unsigned long long seed;
+    size_t reads, full;
+    bool ok;
+} StressJob;
+
+static atomic_bool stress_done;
+
+static bool check_version(const BookVersion *v, unsigned long long *seed, bool full) {
+    const ContactBook *b = &v->book;
+    long m = find_contact(b, "version");
+    if (b->live != STRESS_N + 1 || m < 0 || (uint64_t)b->rows[m].age != v->version) return false;
+    char name[16];
+    for (int i = 0; i < 8; i++) {
+        name_of(name, next_rand_r(seed) % STRESS_N);
+        long r = find_contact(b, name);
+        if (r < 0 || b->rows[r].age < 1 || (uint64_t)b->rows[r].age > v->version) return false;
+    }
+    if (!full || v->version < 3) return true;   // 2 is the first fill
+    size_t newest = 0;
+    for (size_t r = 0; book_next(b, &r); r++)
+        newest += (uint64_t)b->rows[r].age == v->version;
+    return newest == BATCH + 1;
+}
+
+static void *stress_reader(void *arg) {
+    StressJob *j = arg;
+    SharedReader *r = shared_reader_join(j->s);
+    if (!r) { j->ok = false; return NULL; }
+    uint64_t last = 0;
+    while (!atomic_load_explicit(&stress_done, memory_order_relaxed)) {
+        const BookVersion *v = shared_read_begin(r);
+        bool full = j->reads % 64 == 0;
+        j->ok &= v->version >= last && check_version(v, &j->seed, full);
+        last = v->version;
+        shared_read_end(r);
+        j->reads++;
+        j->full += full;
+    }
+    shared_reader_leave(r);
+    return NULL;
+}
+
+static void *stress_writer(void *arg) {
+    StressJob *j = arg;
+    for (size_t c = 0; c < STRESS_COMMITS; c++) {
+        ContactBook *b = shared_write_begin(j->s);
+        if (!b) { j->ok = false; return NULL; }
+        bool abort = c % 16 == 15;
+        int age = abort ? -1 : (int)j->s->draft->version;
+        j->ok &= change(b, STRESS_N, next_rand_r(&j->seed) % STRESS_N, age) &&
+                 delete_contact(b, "version") && add_contact(b, "version", "", age);
+        if (abort) shared_write_abort(j->s);
+        else shared_write_commit(j->s);
+    }
+    return NULL;
+}
+
+static bool stress(void) {
+    SharedBook s;
+    if (!shared_init(&s)) return false;
+    ContactBook *b = shared_write_begin(&s);
+    char name[16];
+    for (size_t i = 0; i < STRESS_N; i++) {
+        name_of(name, i);
+        if (!b || !add_contact(b, name, "555-0000", 2)) return false;
+    }
+    if (!add_contact(b, "version", "", 2)) return false;
+    shared_write_commit(&s);
+
+    StressJob job[STRESS_READERS + STRESS_WRITERS];
+    pthread_t tid[STRESS_READERS + STRESS_WRITERS];
+    bool started[STRESS_READERS + STRESS_WRITERS];
+    for (int k = 0; k < STRESS_READERS + STRESS_WRITERS; k++)
+        job[k] = (StressJob){&s, 88172645463325252ULL + 977 * k, 0, 0, true};
+    double t0 = now_ms();
+    for (int k = 0; k < STRESS_READERS + STRESS_WRITERS; k++)
+        started[k] = pthread_create(&tid[k], NULL, k < STRESS_READERS ? stress_reader : stress_writer,
+                                    &job[k]) == 0;
+    for (int k = STRESS_READERS; k < STRESS_READERS + STRESS_WRITERS; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+    atomic_store(&stress_done, true);
+    for (int k = 0; k < STRESS_READERS; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+    double t = now_ms() - t0;
+
+    bool ok = true;
+    size_t reads = 0, full = 0;
+    for (int k = 0; k < STRESS_READERS + STRESS_WRITERS; k++) {
+        ok &= started[k] && job[k].ok;
+        reads += job[k].reads;
+        full += job[k].full;
+    }
+    shared_synchronize(&s);
+    size_t commits = STRESS_WRITERS * (STRESS_COMMITS - STRESS_COMMITS / 16);
+    const BookVersion *v = atomic_load(&s.current);
+    ok &= s.nretired == 0 && s.freed == commits + 1 && v->version == commits + 2;
+    printf("stress: %d readers, %d writers, %zu commits in %.0f ms, %zu reads (%zu full scans): %s\n",
+           STRESS_READERS, STRESS_WRITERS, commits, t, reads, full, ok ? "ok" : "FAILED");
+    shared_free(&s);
+    return ok;
+}
+
+// ---- throughput ----------------------------------------------------------------
+
+typedef struct {
+    pthread_rwlock_t lock;
+    ContactBook book;
+} LockedBook;
+
+typedef struct {
+    SharedBook *s;             // one of these two
+    LockedBook *l;
+    unsigned long long seed;
+    size_t lookups, misses, commits;
+    double commit_ms;
+} BenchJob;
+
+static atomic_bool bench_done;
+
+static void *bench_reader(void *arg) {
+    BenchJob *j = arg;
+    SharedReader *r = j->s ? shared_reader_join(j->s) : NULL;
+    if (j->s && !r) return NULL;
+    char name[16];
+    while (!atomic_load_explicit(&bench_done, memory_order_relaxed)) {
+        name_of(name, next_rand_r(&j->seed) % N);
+        long m;
+        if (r) {
+            const BookVersion *v = shared_read_begin(r);
+            m = find_contact(&v->book, name);
+            m = m < 0 ? m : v->book.rows[m].age;
+            shared_read_end(r);
+        } else {
+            pthread_rwlock_rdlock(&j->l->lock);
+            m = find_contact(&j->l->book, name);
+            m = m < 0 ? m : j->l->book.rows[m].age;
+            pthread_rwlock_unlock(&j->l->lock);
+        }
+        j->lookups++;
+        j->misses += m < 0;
+    }
+    if (r) shared_reader_leave(r);
+    return NULL;
+}
+
+static void *bench_writer(void *arg) {
+    BenchJob *j = arg;
+    struct timespec pause = {0, WRITE_EVERY_MS * 1000000L};
+    while (!atomic_load_explicit(&bench_done, memory_order_relaxed)) {
+        size_t start = next_rand_r(&j->seed) % N;
+        int age = (int)(j->commits % 100);
+        double t0 = now_ms();
+        if (j->s) {
+            ContactBook *b = shared_write_begin(j->s);
+            if (!b) return NULL;
+            if (!change(b, N, start, age)) j->misses++;
+            shared_write_commit(j->s);
+        } else {
+            pthread_rwlock_wrlock(&j->l->lock);
+            if (!change(&j->l->book, N, start, age)) j->misses++;
+            pthread_rwlock_unlock(&j->l->lock);
+        }
+        j->commit_ms += now_ms() - t0;
+        j->commits++;
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// Lookups per microsecond with readers threads and one writer.
+static double bench(SharedBook *s, LockedBook *l, int readers, double *commit_ms, bool *ok) {
+    BenchJob job[MAX_THREADS + 1];
+    pthread_t tid[MAX_THREADS + 1];
+    bool started[MAX_THREADS + 1];
+    atomic_store(&bench_done, false);
+    for (int k = 0; k <= readers; k++)
+        job[k] = (BenchJob){s, l, 88172645463325252ULL + 31 * k, 0, 0, 0, 0};
+    for (int k = 0; k <= readers; k++)
+        started[k] = pthread_create(&tid[k], NULL, k < readers ? bench_reader : bench_writer, &job[k]) == 0;
+    struct timespec run = {0, RUN_MS * 1000000L};
+    double t0 = now_ms();
+    nanosleep(&run, NULL);
+    atomic_store(&bench_done, true);
+    for (int k = 0; k <= readers; k++)
+        if (started[k]) pthread_join(tid[k], NULL);
+    double t = now_ms() - t0;
+    size_t lookups = 0;
+    for (int k = 0; k <= readers; k++) {
+        *ok &= started[k] && job[k].misses == 0;
+        lookups += job[k].lookups;
+    }
+    *ok &= lookups > 0 && job[readers].commits > 0;
+    *commit_ms = job[readers].commits ? job[readers].commit_ms / job[readers].commits : 0;
+    return lookups / (t * 1000.0);
+}
+
+int main(void) {
+    bool ok = stress();
+
+    SharedBook s;
+    LockedBook l;
+    if (!shared_init(&s) || !book_init(&l.book) || pthread_rwlock_init(&l.lock, NULL) != 0) return 1;
+    ContactBook *b = shared_write_begin(&s);
+    char name[16];
+    for (size_t i = 0; i < N; i++) {
+        name_of(name, i);
+        if (!b || !add_contact(b, name, "555-0000", 0) || !add_contact(&l.book, name, "555-0000", 0))
+            return 1;
+    }
+    shared_write_commit(&s);
+
+    printf("%d contacts, a writer changing %d of them every %d ms, lookups per us:\n",
+           N, BATCH, WRITE_EVERY_MS);
+    printf("readers  %12s %12s   commit ms: %8s %8s\n", "SharedBook", "rwlock", "shared", "rwlock");
+    for (int readers = 1; readers <= MAX_THREADS; readers *= 2) {
+        double cs, cl;
+        double rs = bench(&s, NULL, readers, &cs, &ok);
+        double rl = bench(NULL, &l, readers, &cl, &ok);
+        printf("%7d  %12.2f %12.2f   %19.3f %8.3f\n", readers, rs, rl, cs, cl);
+    }
+    shared_synchronize(&s);
+    ok &= s.nretired == 0;
+    shared_free(&s);
+    book_free(&l.book);
+    pthread_rwlock_destroy(&l.lock);
+    puts(ok ? "all versions consistent" : "MISMATCH");
+    return !ok;
+}
@@ -0,0 +1,345 @@
+#include <stdlib.h>
+#include <string.h>
+#include "prefix.h"
+
+static inline unsigned char fold(unsigned char c) {
+    return (unsigned)(c - 'A') < 26 ? (unsigned char)(c | 0x20) : c;
+}
+
+// A byte of a name or prefix as the index sees it.
+static inline unsigned char key_byte(bool f, char c) {
+    return f ? fold((unsigned char)c) : (unsigned char)c;
+}
+
+// A stored key against a name: <0, 0, >0 as strcmp. prefix: whether key
+// starts with the name instead.
+static int cmp_key(const char *key, const char *name, bool f) {
+    for (size_t i = 0;; i++) {
+        unsigned char a = (unsigned char)key[i], b = key_byte(f, name[i]);
+        if (a != b) return a < b ? -1 : 1;
+        if (!a) return 0;
+    }
+}
+
+static bool has_prefix(const char *key, const char *prefix, bool f) {
+    for (size_t i = 0; prefix[i]; i++)
+        if ((unsigned char)key[i] != key_byte(f, prefix[i])) return false;
+    return true;
+}
+
+static char *key_dup(const char *name, size_t len, bool f) {
+    char *k = malloc(len + 1);
+    if (!k) return NULL;
+    for (size_t i = 0; i < len; i++) k[i] = (char)key_byte(f, name[i]);
+    k[len] = '\0';
+    return k;
+}
+
+// ---- sorted array ---------------------------------------------------------------
+
+void name_array_init(NameArray *a, bool fold) { *a = (NameArray){.fold = fold}; }
+
+void name_array_free(NameArray *a) {
+    for (size_t i = 0; i < a->n; i++) free(a->e[i].key);
+    free(a->e);
+    *a = (NameArray){0};
+}
+
+// First entry whose key is >= name, or > name with after set.
+static size_t bound(const NameArray *a, const char *name, bool after) {
+    size_t lo = 0, hi = a->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = cmp_key(a->e[mid].key, name, a->fold);
+        if (c < 0 || (after && c == 0)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+bool name_array_add(NameArray *a, const char *name, uint64_t id) {
+    if (a->n == a->cap) {
+        size_t cap = a->cap ? 2 * a->cap : 16;
+        NameEntry *e = realloc(a->e, cap * sizeof *e);
+        if (!e) return false;
+        a->e = e;
+        a->cap = cap;
+    }
+    char *key = key_dup(name, strlen(name), a->fold);
+    if (!key) return false;
+    size_t i = bound(a, name, true);
+    memmove(&a->e[i + 1], &a->e[i], (a->n - i) * sizeof *a->e);
+    a->e[i] = (NameEntry){key, id};
+    a->n++;
+    return true;
+}
+
+typedef struct { NameEntry e; size_t seq; } Pending;
+
+static int cmp_pending(const void *x, const void *y) {
+    const Pending *a = x, *b = y;
+    int c = strcmp(a->e.key, b->e.key);
+    return c ? c : (a->seq > b->seq) - (a->seq < b->seq);
+}
+
+bool name_array_add_all(NameArray *a, const char *const *names, const uint64_t *ids, size_t n) {
+    if (a->n + n > a->cap) {
+        size_t cap = a->cap ? a->cap : 16;
+        while (cap < a->n + n) cap *= 2;
+        NameEntry *e = realloc(a->e, cap * sizeof *e);
+        if (!e) return false;
+        a->e = e;
+        a->cap = cap;
+    }
+    Pending *p = malloc(n * sizeof *p);
+    if (!p && n) return false;
+    for (size_t i = 0; i < n; i++) {
+        char *key = key_dup(names[i], strlen(names[i]), a->fold);
+        if (!key) {
+            while (i--) free(p[i].e.key);
+            free(p);
+            return false;
+        }
+        p[i] = (Pending){{key, ids[i]}, i};
+    }
+    qsort(p, n, sizeof *p, cmp_pending);
+    // Merge from the back; on equal keys the ones already there stay first.
+    size_t i = a->n, j = n, w = a->n + n;
+    while (j) {
+        if (i && strcmp(a->e[i - 1].key, p[j - 1].e.key) > 0) a->e[--w] = a->e[--i];
+        else a->e[--w] = p[--j].e;
+    }
+    a->n += n;
+    free(p);
+    return true;
+}
+
+bool name_array_remove(NameArray *a, const char *name, uint64_t id) {
+    for (size_t i = bound(a, name, false); i < a->n && cmp_key(a->e[i].key, name, a->fold) == 0; i++) {
+        if (a->e[i].id != id) continue;
+        free(a->e[i].key);
+        memmove(&a->e[i], &a->e[i + 1], (a->n - i - 1) * sizeof *a->e);
+        a->n--;
+        return true;
+    }
+    return false;
+}
+
+size_t name_array_complete(const NameArray *a, const char *prefix, uint64_t *out, size_t k) {
+    size_t m = 0;
+    for (size_t i = bound(a, prefix, false); m < k && i < a->n && has_prefix(a->e[i].key, prefix, a->fold); i++)
+        out[m++] = a->e[i].id;
+    return m;
+}
+
+// ---- radix trie -------------------------------------------------------------------
+
+// The key of a node is the labels on the path to it. Children are kept
+// in order of their first label byte, so a depth-first walk, ids before
+// children, meets the names in strcmp order.
+struct TrieNode {
+    char *label;                // the edge into the node; NULL at the root
+    uint32_t len;
+    uint32_t nkids, kcap;
+    unsigned char *first;       // first[i] == kids[i]->label[0]
+    TrieNode **kids;
+    uint64_t *ids;              // names that end here, in the order added
+    uint32_t nids, icap;
+};
+
+static TrieNode *node_new(NameTrie *t, char *label, size_t len) {
+    TrieNode *n = calloc(1, sizeof *n);
+    if (!n) return NULL;
+    n->label = label;
+    n->len = (uint32_t)len;
+    t->nodes++;
+    return n;
+}
+
+static void node_free(NameTrie *t, TrieNode *n) {
+    for (uint32_t i = 0; i < n->nkids; i++) node_free(t, n->kids[i]);
+    free(n->label);
+    free(n->first);
+    free(n->kids);
+    free(n->ids);
+    free(n);
+    t->nodes--;
+}
+
+// Index of the child starting with byte c, or where it would go.
+static uint32_t kid_at(const TrieNode *n, unsigned char c) {
+    uint32_t i = 0;
+    while (i < n->nkids && n->first[i] < c) i++;
+    return i;
+}
+
+static bool kid_insert(TrieNode *n, uint32_t i, TrieNode *kid) {
+    if (n->nkids == n->kcap) {
+        uint32_t cap = n->kcap ? 2 * n->kcap : 2;
+        unsigned char *f = realloc(n->first, cap);
+        if (!f) return false;
+        n->first = f;
+        TrieNode **k = realloc(n->kids, cap * sizeof *k);
+        if (!k) return false;
+        n->kids = k;
+        n->kcap = cap;
+    }
+    memmove(&n->first[i + 1], &n->first[i], n->nkids - i);
+    memmove(&n->kids[i + 1], &n->kids[i], (n->nkids - i) * sizeof *n->kids);
+    n->first[i] = (unsigned char)kid->label[0];
+    n->kids[i] = kid;
+    n->nkids++;
+    return true;
+}
+
+static bool id_append(TrieNode *n, uint64_t id) {
+    if (n->nids == n->icap) {
+        uint32_t cap = n->icap ? 2 * n->icap : 1;
+        uint64_t *ids = realloc(n->ids, cap * sizeof *ids);
+        if (!ids) return false;
+        n->ids = ids;
+        n->icap = cap;
+    }
+    n->ids[n->nids++] = id;
+    return true;
+}
+
+bool name_trie_init(NameTrie *t, bool fold) {
+    *t = (NameTrie){.fold = fold};
+    t->root = node_new(t, NULL, 0);
+    return t->root != NULL;
+}
+
+void name_trie_free(NameTrie *t) {
+    if (t->root) node_free(t, t->root);
+    *t = (NameTrie){0};
+}
+
+// Out of memory part way leaves at most a split node with one child and
+// no ids, which is still a valid trie.
+bool name_trie_add(NameTrie *t, const char *name, uint64_t id) {
+    TrieNode *n = t->root;
+    const char *p = name;
+    while (*p) {
+        unsigned char c = key_byte(t->fold, *p);
+        uint32_t i = kid_at(n, c);
+        if (i == n->nkids || n->first[i] != c) {
+            size_t len = strlen(p);
+            char *label = key_dup(p, len, t->fold);
+            TrieNode *leaf = label ? node_new(t, label, len) : NULL;
+            if (!leaf || !id_append(leaf, id) || !kid_insert(n, i, leaf)) {
+                if (leaf) node_free(t, leaf); else free(label);
+                return false;
+            }
+            t->count++;
+            return true;
+        }
+        TrieNode *kid = n->kids[i];
+        uint32_t m = 1;
+        while (m < kid->len && p[m] && (unsigned char)kid->label[m] == key_byte(t->fold, p[m])) m++;
+        if (m < kid->len) {
+            // Split the edge: a new node for the shared part, kid below it.
+            char *head = malloc(m + 1), *tail = malloc(kid->len - m + 1);
+            TrieNode *mid = head && tail ? node_new(t, head, m) : NULL;
+            if (!mid || !(mid->first = malloc(2)) || !(mid->kids = malloc(2 * sizeof *mid->kids))) {
+                if (mid) node_free(t, mid); else free(head);
+                free(tail);
+                return false;
+            }
+            memcpy(head, kid->label, m);
+            head[m] = '\0';
+            memcpy(tail, kid->label + m, kid->len - m + 1);
+            free(kid->label);
+            kid->label = tail;
+            kid->len -= m;
+            mid->kcap = 2;
+            mid->nkids = 1;
+            mid->first[0] = (unsigned char)tail[0];
+            mid->kids[0] = kid;
+            n->kids[i] = mid;
+            kid = mid;
+        }
+        n = kid;
+        p += m;
+    }
+    if (!id_append(n, id)) return false;
+    t->count++;
+    return true;
+}
+
+// n (the i-th child of parent) has no ids and one child: fold the two
+// edges into one.
+static bool merge_down(NameTrie *t, TrieNode *parent, uint32_t i) {
+    TrieNode *n = parent->kids[i], *kid = n->kids[0];
+    char *label = malloc(n->len + kid->len + 1);
+    if (!label) return false;        // the trie stays valid, only larger
+    memcpy(label, n->label, n->len);
+    memcpy(label + n->len, kid->label, kid->len + 1);
+    free(kid->label);
+    kid->label = label;
+    kid->len += n->len;
+    parent->kids[i] = kid;
+    n->nkids = 0;
+    node_free(t, n);
+    return true;
+}
+
+bool name_trie_remove(NameTrie *t, const char *name, uint64_t id) {
+    TrieNode *grand = NULL, *parent = NULL, *n = t->root;
+    uint32_t gi = 0, pi = 0;
+    const char *p = name;
+    while (*p) {
+        unsigned char c = key_byte(t->fold, *p);
+        uint32_t i = kid_at(n, c);
+        if (i == n->nkids || n->first[i] != c) return false;
+        TrieNode *kid = n->kids[i];
+        for (uint32_t m = 1; m < kid->len; m++)
+            if (!p[m] || (unsigned char)kid->label[m] != key_byte(t->fold, p[m])) return false;
+        grand = parent; gi = pi;
+        parent = n; pi = i;
+        n = kid;
+        p += kid->len;
+    }
+    uint32_t j = 0;
+    while (j < n->nids && n->ids[j] != id) j++;
+    if (j == n->nids) return false;
+    memmove(&n->ids[j], &n->ids[j + 1], (n->nids - j - 1) * sizeof *n->ids);
+    n->nids--;
+    t->count--;
+
+    // Keep one node per branch point: a node with no ids goes if it has
+    // no children and is merged into its child if it has one.
+    if (n->nids || !parent) return true;
+    if (n->nkids == 1) { merge_down(t, parent, pi); return true; }
+    if (n->nkids) return true;
+    memmove(&parent->first[pi], &parent->first[pi + 1], parent->nkids - pi - 1);
+    memmove(&parent->kids[pi], &parent->kids[pi + 1], (parent->nkids - pi - 1) * sizeof *parent->kids);
+    parent->nkids--;
+    node_free(t, n);
+    if (grand && !parent->nids && parent->nkids == 1) merge_down(t, grand, gi);
+    return true;
+}
+
+static void collect(const TrieNode *n, uint64_t *out, size_t k, size_t *m) {
+    for (uint32_t i = 0; i < n->nids && *m < k; i++) out[(*m)++] = n->ids[i];
+    for (uint32_t i = 0; i < n->nkids && *m < k; i++) collect(n->kids[i], out, k, m);
+}
+
+size_t name_trie_complete(const NameTrie *t, const char *prefix, uint64_t *out, size_t k) {
+    const TrieNode *n = t->root;
+    const char *p = prefix;
+    while (*p) {
+        unsigned char c = key_byte(t->fold, *p);
+        uint32_t i = kid_at(n, c);
+        if (i == n->nkids || n->first[i] != c) return 0;
+        n = n->kids[i];
+        // The prefix may end inside this edge: everything below matches.
+        uint32_t m = 1;
+        for (; m < n->len && p[m]; m++)
+            if ((unsigned char)n->label[m] != key_byte(t->fold, p[m])) return 0;
+        p += m;
+    }
+    size_t m = 0;
+    collect(n, out, k, &m);
+    return m;
+}
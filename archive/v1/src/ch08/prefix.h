@@ -0,0 +1,56 @@
+#ifndef PREFIX_H
+#define PREFIX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Type-ahead over names: the first k names that start with a prefix, in
+// strcmp order, names that are equal in the order they were added. Each
+// name carries a 64-bit id (a ContactId in the contact book). With fold
+// set, ASCII letters are compared as lower case, both in the names and
+// in the prefix.
+//
+// Two structures with the same operations:
+//   NameArray   the names sorted in one array. Queries are a binary
+//               search, but add and remove move everything after the spot.
+//   NameTrie    a radix trie with one node per branch point. add and remove
+//               touch one path, and a query visits at most the prefix's
+//               length in nodes plus what it returns.
+
+typedef struct { char *key; uint64_t id; } NameEntry;
+
+typedef struct {
+    NameEntry *e;
+    size_t n, cap;
+    bool fold;
+} NameArray;
+
+void name_array_init(NameArray *a, bool fold);
+void name_array_free(NameArray *a);
+// false if out of memory.
+bool name_array_add(NameArray *a, const char *name, uint64_t id);
+// n names at once, as if added in order: one sort and one merge instead
+// of moving the array for each. false if out of memory, with a unchanged.
+bool name_array_add_all(NameArray *a, const char *const *names, const uint64_t *ids, size_t n);
+// false if name was not there with that id.
+bool name_array_remove(NameArray *a, const char *name, uint64_t id);
+// Ids of up to k names starting with prefix into out; returns how many.
+size_t name_array_complete(const NameArray *a, const char *prefix, uint64_t *out, size_t k);
+
+typedef struct TrieNode TrieNode;
+
+typedef struct {
+    TrieNode *root;
+    size_t count, nodes;
+    bool fold;
+} NameTrie;
+
+// false if out of memory.
+bool name_trie_init(NameTrie *t, bool fold);
+void name_trie_free(NameTrie *t);
+bool name_trie_add(NameTrie *t, const char *name, uint64_t id);
+bool name_trie_remove(NameTrie *t, const char *name, uint64_t id);
+size_t name_trie_complete(const NameTrie *t, const char *prefix, uint64_t *out, size_t k);
+
+#endif
@@ -0,0 +1,136 @@
+#include <sched.h>
+#include <stdlib.h>
+#include "shared.h"
+
+// Every atomic here that orders a read against a commit is seq_cst. A
+// reader stores its epoch and then loads the pointer; a writer swaps the
+// pointer, bumps the epoch and then loads the readers' epochs. As all of
+// these are in one total order, a reader the writer saw as idle or as
+// starting after the bump must load the new pointer.
+
+static void version_free(BookVersion *v) {
+    book_free(&v->book);
+    free(v);
+}
+
+bool shared_init(SharedBook *s) {
+    *s = (SharedBook){0};
+    BookVersion *v = malloc(sizeof *v);
+    if (!v) return false;
+    if (!book_init(&v->book)) { free(v); return false; }
+    v->version = 1;
+    v->next = NULL;
+    if (pthread_mutex_init(&s->write, NULL) != 0) { version_free(v); return false; }
+    atomic_init(&s->current, v);
+    atomic_init(&s->epoch, 1);
+    for (size_t i = 0; i < SHARED_READERS_MAX; i++) {
+        atomic_init(&s->reader[i].epoch, 0);
+        atomic_init(&s->reader[i].used, false);
+        s->reader[i].book = s;
+    }
+    return true;
+}
+
+void shared_free(SharedBook *s) {
+    version_free(atomic_load(&s->current));
+    if (s->draft) version_free(s->draft);
+    for (BookVersion *v = s->retired, *next; v; v = next) {
+        next = v->next;
+        version_free(v);
+    }
+    pthread_mutex_destroy(&s->write);
+}
+
+SharedReader *shared_reader_join(SharedBook *s) {
+    for (size_t i = 0; i < SHARED_READERS_MAX; i++) {
+        bool free_slot = false;
+        if (atomic_compare_exchange_strong(&s->reader[i].used, &free_slot, true))
+            return &s->reader[i];
+    }
+    return NULL;
+}
+
+void shared_reader_leave(SharedReader *r) {
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+    atomic_store_explicit(&r->used, false, memory_order_release);
+}
+
+const BookVersion *shared_read_begin(SharedReader *r) {
+    SharedBook *s = r->book;
+    atomic_store(&r->epoch, atomic_load(&s->epoch));
+    return atomic_load(&s->current);
+}
+
+void shared_read_end(SharedReader *r) {
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+}
+
+// ---- writers ---------------------------------------------------------------
+// Called with the write lock held.
+
+// Free the retired versions older than the oldest read in progress.
+static void reclaim(SharedBook *s) {
+    uint64_t oldest = UINT64_MAX;
+    for (size_t i = 0; i < SHARED_READERS_MAX; i++) {
+        uint64_t e = atomic_load(&s->reader[i].epoch);
+        if (e && e < oldest) oldest = e;
+    }
+    BookVersion **p = &s->retired;
+    while (*p) {
+        BookVersion *v = *p;
+        if (v->retired < oldest) {
+            *p = v->next;
+            version_free(v);
+            s->nretired--;
+            s->freed++;
+        } else {
+            p = &v->next;
+        }
+    }
+}
+
+ContactBook *shared_write_begin(SharedBook *s) {
+    pthread_mutex_lock(&s->write);
+    const BookVersion *cur = atomic_load_explicit(&s->current, memory_order_relaxed);
+    BookVersion *v = malloc(sizeof *v);
+    if (!v || !book_copy(&v->book, &cur->book)) {
+        free(v);
+        pthread_mutex_unlock(&s->write);
+        return NULL;
+    }
+    v->version = cur->version + 1;
+    v->next = NULL;
+    s->draft = v;
+    return &v->book;
+}
+
+uint64_t shared_write_commit(SharedBook *s) {
+    BookVersion *v = s->draft;
+    uint64_t version = v->version;
+    s->draft = NULL;
+    BookVersion *old = atomic_exchange(&s->current, v);
+    old->retired = atomic_fetch_add(&s->epoch, 1);
+    old->next = s->retired;
+    s->retired = old;
+    s->nretired++;
+    reclaim(s);
+    pthread_mutex_unlock(&s->write);
+    return version;
+}
+
+void shared_write_abort(SharedBook *s) {
+    version_free(s->draft);
+    s->draft = NULL;
+    pthread_mutex_unlock(&s->write);
+}
+
+void shared_synchronize(SharedBook *s) {
+    for (;;) {
+        pthread_mutex_lock(&s->write);
+        reclaim(s);
+        bool done = s->retired == NULL;
+        pthread_mutex_unlock(&s->write);
+        if (done) return;
+        sched_yield();
+    }
+}
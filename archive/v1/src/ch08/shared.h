@@ -0,0 +1,95 @@
+#ifndef SHARED_H
+#define SHARED_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "contacts.h"
+
+// A contact book for many reader threads and few writes, in the manner of
+// read-copy-update. Readers take no lock: they load the current version
+// through an atomic pointer and read it as an ordinary const ContactBook,
+// which nobody changes while it is current. A writer copies the current
+// version, makes any number of changes to the copy and publishes it with
+// one pointer store. A commit costs a copy of the whole book, so writers
+// should batch their changes.
+//
+// The version a commit replaces is freed once no reader can still be in
+// it (epoch-based reclamation). There is a global epoch that each commit
+// bumps. A reader records the epoch when it starts a read and clears it
+// when it finishes. A version retired in epoch e is freed once every
+// reader is idle or started after e: such a reader loaded the pointer
+// after it was swapped, so it sees a newer version.
+//
+//   SharedReader *r = shared_reader_join(s);      // once per thread
+//   const BookVersion *v = shared_read_begin(r);
+//   long row = find_contact(&v->book, "Alice");   // v stays valid ...
+//   shared_read_end(r);                           // ... until here
+//
+//   ContactBook *b = shared_write_begin(s);       // a private copy
+//   add_contact(b, "Dan", "555-0101", 41);
+//   delete_contact(b, "Bob");
+//   shared_write_commit(s);                       // readers see both, or neither
+
+// Readers at once, each with its own slot.
+#define SHARED_READERS_MAX 64
+
+typedef struct BookVersion BookVersion;
+struct BookVersion {
+    ContactBook book;
+    uint64_t version;          // 1 for the first, then one more per commit
+    uint64_t retired;          // epoch it was replaced in
+    BookVersion *next;         // on the retired list
+};
+
+typedef struct SharedBook SharedBook;
+
+// One reader thread. Each is on its own cache line, so readers starting
+// and ending reads do not slow one another down.
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t epoch;  // 0 while not reading
+    atomic_bool used;
+    SharedBook *book;
+} SharedReader;
+
+struct SharedBook {
+    _Atomic(BookVersion *) current;
+    atomic_uint_fast64_t epoch;   // starts at 1
+    SharedReader reader[SHARED_READERS_MAX];
+    pthread_mutex_t write;        // one writer at a time
+    BookVersion *draft;           // the writer's copy, between begin and commit
+    BookVersion *retired;         // replaced, not yet freed, newest first
+    size_t nretired, freed;       // versions waiting, and freed so far
+};
+
+// An empty book, version 1. false if out of memory.
+bool shared_init(SharedBook *s);
+// Frees every version; no reader or writer may be using s.
+void shared_free(SharedBook *s);
+
+// A slot for the calling thread, or NULL if all are taken. A reader is
+// used by one thread at a time.
+SharedReader *shared_reader_join(SharedBook *s);
+void shared_reader_leave(SharedReader *r);
+
+// The current version, valid until shared_read_end. Reads do not nest.
+const BookVersion *shared_read_begin(SharedReader *r);
+void shared_read_end(SharedReader *r);
+
+// Waits for any other writer, then returns a copy of the current version
+// to change with the usual ContactBook functions; or NULL if out of
+// memory, with no write in progress. Readers go on seeing the current
+// version until the commit.
+ContactBook *shared_write_begin(SharedBook *s);
+// Makes the copy current and frees the versions no reader can be in.
+// Returns the new version number.
+uint64_t shared_write_commit(SharedBook *s);
+// Drops the copy; readers never see it.
+void shared_write_abort(SharedBook *s);
+
+// Waits until every replaced version has been freed. Must not be called
+// from inside a read.
+void shared_synchronize(SharedBook *s);
+
+#endif
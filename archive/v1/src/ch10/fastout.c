@@ -0,0 +1,315 @@
+#define _POSIX_C_SOURCE 200809L   // writev
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "fastout.h"
+#include "numparse_pow10.h"
+
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+// ---- writing --------------------------------------------------------------------
+
+// Writes the whole of iov, resuming after short writes.
+static void write_all(FastOut *o, struct iovec *iov, int n) {
+    while (n > 0 && !o->err) {
+        ssize_t w = writev(o->fd, iov, n);
+        if (w < 0) {
+            if (errno != EINTR) o->err = errno;
+            continue;
+        }
+        size_t left = (size_t)w;
+        for (; n > 0 && left >= iov->iov_len; iov++, n--) left -= iov->iov_len;
+        if (n > 0) { iov->iov_base = (char *)iov->iov_base + left; iov->iov_len -= left; }
+    }
+}
+
+void fo_init(FastOut *o, int fd) {
+    o->fd = fd;
+    o->err = 0;
+    o->len = 0;
+}
+
+bool fo_flush(FastOut *o) {
+    struct iovec iov = {o->buf, o->len};
+    write_all(o, &iov, 1);
+    o->len = 0;
+    return !o->err;
+}
+
+// A block too big to be worth copying goes out in the same writev as the
+// buffered bytes before it.
+void fo_write(FastOut *o, const char *s, size_t n) {
+    if (n <= FO_BUF - o->len) {
+        memcpy(o->buf + o->len, s, n);
+        o->len += n;
+    } else if (n < FO_BUF / 2) {
+        fo_flush(o);
+        memcpy(o->buf, s, n);
+        o->len = n;
+    } else {
+        struct iovec iov[2] = {{o->buf, o->len}, {(void *)s, n}};
+        write_all(o, iov, 2);
+        o->len = 0;
+    }
+}
+
+void fo_char(FastOut *o, char c) {
+    if (o->len == FO_BUF) fo_flush(o);
+    o->buf[o->len++] = c;
+}
+
+void fo_fill(FastOut *o, char c, size_t n) {
+    while (n) {
+        if (o->len == FO_BUF) fo_flush(o);
+        size_t k = FO_BUF - o->len < n ? FO_BUF - o->len : n;
+        memset(o->buf + o->len, c, k);
+        o->len += k;
+        n -= k;
+    }
+}
+
+// s padded to width; straight into the buffer when it fits.
+static void emit(FastOut *o, const char *s, size_t n, int width) {
+    size_t w = width < 0 ? (size_t)-(long long)width : (size_t)width;
+    size_t pad = w > n ? w - n : 0;
+    if (n + pad <= FO_BUF - o->len) {
+        char *p = o->buf + o->len;
+        if (width > 0) { memset(p, ' ', pad); p += pad; }
+        memcpy(p, s, n);
+        if (width < 0) memset(p + n, ' ', pad);
+        o->len += n + pad;
+        return;
+    }
+    if (width > 0) fo_fill(o, ' ', pad);
+    fo_write(o, s, n);
+    if (width < 0) fo_fill(o, ' ', pad);
+}
+
+void fo_str(FastOut *o, const char *s, int width) { emit(o, s, strlen(s), width); }
+
+// ---- integers -------------------------------------------------------------------
+
+static const u64 pow10_u64[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Decimal digits in v: the bit length times log10(2) is the count or one
+// short of it, and a single comparison settles which.
+static inline int dec_len(u64 v) {
+    v |= 1;
+    int t = (64 - __builtin_clzll(v)) * 1233 >> 12;
+    return t + (v >= pow10_u64[t]);
+}
+
+// The digits of v written backwards so that they end just before end, two
+// at a time from the pair table.
+static inline void put_dec(char *end, u64 v) {
+    while (v >= 100) {
+        u64 q = v / 100;
+        end -= 2;
+        memcpy(end, digit_pairs + 2 * (v - 100 * q), 2);
+        v = q;
+    }
+    if (v >= 10) memcpy(end - 2, digit_pairs + 2 * v, 2);
+    else end[-1] = (char)('0' + v);
+}
+
+static inline size_t u64_dec(char *p, u64 v) {
+    int n = dec_len(v);
+    put_dec(p + n, v);
+    return (size_t)n;
+}
+
+void fo_u64(FastOut *o, unsigned long long v, int width) {
+    char tmp[24];
+    emit(o, tmp, u64_dec(tmp, v), width);
+}
+
+void fo_i64(FastOut *o, long long v, int width) {
+    char tmp[24];
+    tmp[0] = '-';
+    size_t neg = v < 0;
+    u64 m = neg ? 0 - (u64)v : (u64)v;
+    emit(o, tmp, neg + u64_dec(tmp + neg, m), width);
+}
+
+// ---- shortest round trip ----------------------------------------------------------
+
+// Giulietti's Schubfach algorithm, as in Java's DoubleToDecimal. v = c*2^q
+// is scaled by 10^-k into a fixed-point value with two fraction bits, as
+// are the ends of its rounding interval; the shortest decimal in the
+// interval is then either a multiple of 10 near v*10^-k or one of the two
+// integers around it. 10^-k comes from the parser's table, one 126-bit
+// value per k.
+#define C_MIN  (1ULL << 52)
+#define Q_MIN  (-1074)
+#define C_TINY 3
+#define MASK63 0x7fffffffffffffffULL
+
+static inline int flog10pow2(int e) { return (int)((long long)e * 661971961083LL >> 41); }
+static inline int flog10_3q_pow2(int e) { return (int)(((long long)e * 661971961083LL - 274743187321LL) >> 41); }
+static inline int flog2pow10(int e) { return (int)((long long)e * 913124641741LL >> 38); }
+
+// (g * cp) >> 127 for g = floor(10^e * 2^-r) + 1 in [2^125, 2^126), held as
+// 63-bit halves, with the low bit set when anything below was dropped.
+static inline u64 rop(u64 g1, u64 g0, u64 cp) {
+    u64 x1 = (u64)((u128)g0 * cp >> 64);
+    u128 y = (u128)g1 * cp;
+    u64 z = ((u64)y >> 1) + x1;
+    u64 vbp = (u64)(y >> 64) + (z >> 63);
+    return vbp | (((z & MASK63) + MASK63) >> 63);
+}
+
+// v = c * 2^q as f * 10^e with the fewest digits; returns e.
+static int shortest(int q, u64 c, int dk, u64 *f) {
+    u64 out = c & 1, cb = c << 2, cbr = cb + 2, cbl;
+    int k;
+    if (c != C_MIN || q == Q_MIN) { cbl = cb - 2; k = flog10pow2(q); }
+    else { cbl = cb - 1; k = flog10_3q_pow2(q); }     // the gap below a power of two is half
+    int h = q + flog2pow10(-k) + 2;
+    const u64 *m = pow10_128[-k - POW10_MIN];
+    u128 g = ((u128)m[0] << 64 | m[1]) >> 2;
+    g++;
+    u64 g1 = (u64)(g >> 63), g0 = (u64)g & MASK63;
+    u64 vb = rop(g1, g0, cb << h), vbl = rop(g1, g0, cbl << h), vbr = rop(g1, g0, cbr << h);
+
+    u64 s = vb >> 2;
+    if (s >= 100) {
+        u64 sp10 = s / 10 * 10, tp10 = sp10 + 10;
+        bool upin = vbl + out <= sp10 << 2, wpin = (tp10 << 2) + out <= vbr;
+        if (upin != wpin) { *f = upin ? sp10 : tp10; return k; }
+    }
+    u64 t = s + 1;
+    bool uin = vbl + out <= s << 2, win = (t << 2) + out <= vbr;
+    if (uin != win) { *f = uin ? s : t; return k + dk; }
+    long long cmp = (long long)(vb - ((s + t) << 1));
+    *f = cmp < 0 || (cmp == 0 && (s & 1) == 0) ? s : t;
+    return k + dk;
+}
+
+// Lays out f * 10^e (f > 0) at p and returns the length, at most 26.
+static size_t layout(char *p, u64 f, int e) {
+    while (f % 10 == 0) { f /= 10; e++; }
+    char dig[20];
+    int n = (int)u64_dec(dig, f), x = n - 1 + e;      // v = d.ddd * 10^x
+    char *s = p;
+    if (x >= 21 || x < -6) {
+        *p++ = dig[0];
+        if (n > 1) { *p++ = '.'; memcpy(p, dig + 1, (size_t)n - 1); p += n - 1; }
+        *p++ = 'e';
+        *p++ = x < 0 ? '-' : '+';
+        p += u64_dec(p, (u64)(x < 0 ? -x : x));
+    } else if (e >= 0) {
+        memcpy(p, dig, (size_t)n); p += n;
+        memset(p, '0', (size_t)e); p += e;
+    } else if (x >= 0) {
+        memcpy(p, dig, (size_t)x + 1); p += x + 1;
+        *p++ = '.';
+        memcpy(p, dig + x + 1, (size_t)(n - x - 1)); p += n - x - 1;
+    } else {
+        *p++ = '0'; *p++ = '.';
+        memset(p, '0', (size_t)(-x - 1)); p += -x - 1;
+        memcpy(p, dig, (size_t)n); p += n;
+    }
+    return (size_t)(p - s);
+}
+
+void fo_f64(FastOut *o, double v, int width) {
+    char tmp[32], *p = tmp;
+    u64 bits;
+    memcpy(&bits, &v, sizeof bits);
+    u64 t = bits & (C_MIN - 1);
+    int bq = (int)(bits >> 52) & 0x7ff;
+    if (bq == 0x7ff) {
+        const char *s = t ? "nan" : bits >> 63 ? "-inf" : "inf";
+        emit(o, s, strlen(s), width);
+        return;
+    }
+    if (bits >> 63) *p++ = '-';
+    if (bq == 0 && t == 0) *p++ = '0';
+    else {
+        u64 f;
+        int e;
+        if (bq) {
+            int mq = 1075 - bq;
+            u64 c = C_MIN | t;
+            if (mq > 0 && mq < 53 && (c >> mq << mq) == c) { f = c >> mq; e = 0; }   // an integer below 2^53
+            else e = shortest(-mq, c, 0, &f);
+        } else if (t < C_TINY) {            // 5e-324, 1e-323: below the proven range
+            f = t == 1 ? 5 : 1;
+            e = t == 1 ? -324 : -323;
+        }
+        else e = shortest(Q_MIN, t, 0, &f);
+        p += layout(p, f, e);
+    }
+    emit(o, tmp, (size_t)(p - tmp), width);
+}
+
+// ---- fixed precision ----------------------------------------------------------------
+
+// Below 2^63 and with at most 17 places, v * 10^prec is an integer times a
+// power of two in 128 bits, so the rounding is exact. Everything else is
+// left to snprintf.
+void fo_fixed(FastOut *o, double v, int prec, int width) {
+    char tmp[64];
+    if (!(fabs(v) < 0x1p63) || prec < 0 || prec > 17) {
+        int n = snprintf(tmp, sizeof tmp, "%*.*f", width, prec, v);
+        if (n < 0) return;
+        if ((size_t)n < sizeof tmp) { fo_write(o, tmp, (size_t)n); return; }
+        char *big = malloc((size_t)n + 1);
+        if (!big) { o->err = ENOMEM; return; }
+        snprintf(big, (size_t)n + 1, "%*.*f", width, prec, v);
+        fo_write(o, big, (size_t)n);
+        free(big);
+        return;
+    }
+    u64 bits;
+    memcpy(&bits, &v, sizeof bits);
+    int bq = (int)(bits >> 52) & 0x7ff;
+    u64 m = bits & (C_MIN - 1);
+    int e2 = bq ? bq - 1075 : Q_MIN;
+    if (bq) m |= C_MIN;
+
+    u128 q, prod = (u128)m * pow10_u64[prec];
+    if (e2 >= 0) q = prod << e2;
+    else if (-e2 >= 128) q = 0;                          // prod < 2^110: under half
+    else {
+        int k = -e2;
+        q = prod >> k;
+        u128 rem = prod - (q << k), half = (u128)1 << (k - 1);
+        q += rem > half || (rem == half && (q & 1));
+    }
+
+    // q < 2^63 * 10^17 needs at most 38 digits; at least prec + 1 are shown.
+    char dig[40], *end = dig + sizeof dig, *d = end;
+    while (q >> 64) {
+        u64 lo = (u64)(q % pow10_u64[19]);
+        q /= pow10_u64[19];
+        memset(d - 19, '0', 19);
+        put_dec(d, lo);
+        d -= 19;
+    }
+    put_dec(d, (u64)q);
+    d -= dec_len((u64)q);
+    while (end - d < prec + 1) *--d = '0';
+
+    char *p = tmp;
+    if (bits >> 63) *p++ = '-';
+    size_t ni = (size_t)(end - d) - (size_t)prec;
+    memcpy(p, d, ni); p += ni;
+    if (prec) { *p++ = '.'; memcpy(p, d + ni, (size_t)prec); p += prec; }
+    emit(o, tmp, (size_t)(p - tmp), width);
+}
@@ -0,0 +1,45 @@
+#ifndef FASTOUT_H
+#define FASTOUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Buffered output straight to a file descriptor, for programs that print
+// tables and reports item by item. Nothing is parsed at run time: each
+// call formats one value into a 64 KB buffer, which goes out in one
+// write(), or one writev() together with a large block. Output from stdio
+// on the same descriptor must be flushed with fflush before these calls.
+//
+// width works as in printf: pad with spaces on the left to at least
+// width characters, or on the right when width is negative; 0 for none.
+#define FO_BUF (64 * 1024)
+
+typedef struct {
+    int fd;
+    int err;           // errno of the first failed write, then nothing is written
+    size_t len;
+    char buf[FO_BUF];
+} FastOut;
+
+void fo_init(FastOut *o, int fd);
+bool fo_flush(FastOut *o);          // false once any write has failed
+
+void fo_write(FastOut *o, const char *s, size_t n);
+void fo_str(FastOut *o, const char *s, int width);
+void fo_char(FastOut *o, char c);
+void fo_fill(FastOut *o, char c, size_t n);        // c repeated n times
+
+void fo_i64(FastOut *o, long long v, int width);   // %*lld
+void fo_u64(FastOut *o, unsigned long long v, int width);
+
+// Shortest digits that read back (strtod) as exactly v, closest to v if
+// there is a choice. Fixed notation for 1e-6 <= |v| < 1e21, otherwise
+// d.ddde+X; no trailing zeros or point: 0.1, 100, 1.5e+300, 5e-324, -0,
+// inf, nan.
+void fo_f64(FastOut *o, double v, int width);
+
+// %*.*f with the same digits as glibc's printf: the exact binary value
+// rounded half to even.
+void fo_fixed(FastOut *o, double v, int prec, int width);
+
+#endif
@@ -0,0 +1,270 @@
+#define _DEFAULT_SOURCE           // MAP_POPULATE, posix_madvise
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "lines.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef unsigned long long u64;
+
+// Positions handed from the kernels to lines_index / lines_each at a time.
+#define BATCH 256
+
+// ---- kernels ----------------------------------------------------------------
+// count: newlines in p[0..n). find: offsets of the first (up to) cap
+// newlines in p[0..n), returns how many.
+
+static size_t count_scalar(const char *p, size_t n) {
+    size_t c = 0;
+    for (const char *e = p + n; (p = memchr(p, '\n', (size_t)(e - p))); p++) c++;
+    return c;
+}
+
+static size_t find_scalar(const char *p, size_t n, size_t *out, size_t cap) {
+    size_t k = 0;
+    for (const char *q = p; k < cap && (q = memchr(q, '\n', n - (size_t)(q - p))); q++)
+        out[k++] = (size_t)(q - p);
+    return k;
+}
+
+// The last n - i < 64 bytes of a SIMD find, k newlines already found.
+static inline size_t find_tail(const char *p, size_t i, size_t n, size_t *out, size_t k, size_t cap) {
+    size_t t = find_scalar(p + i, n - i, out + k, cap - k);
+    for (size_t j = k; j < k + t; j++) out[j] += i;
+    return k + t;
+}
+
+// Bits of m are newlines at base + bit.
+#define TAKE_BITS(m, base)                                         \
+    while (m) {                                                    \
+        if (k == cap) return k;                                    \
+        out[k++] = (base) + (size_t)__builtin_ctzll(m);            \
+        m &= m - 1;                                                \
+    }
+
+#ifdef __SSE2__
+static inline u64 nl_mask_sse2(const char *p) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    u64 m = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        m |= (u64)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(b, nl)) << (16 * i);
+    }
+    return m;
+}
+
+static size_t count_sse2(const char *p, size_t n) {
+    size_t c = 0, i = 0;
+    for (; i + 64 <= n; i += 64) c += (size_t)__builtin_popcountll(nl_mask_sse2(p + i));
+    return c + count_scalar(p + i, n - i);
+}
+
+static size_t find_sse2(const char *p, size_t n, size_t *out, size_t cap) {
+    size_t k = 0, i = 0;
+    for (; i + 64 <= n; i += 64) {
+        u64 m = nl_mask_sse2(p + i);
+        TAKE_BITS(m, i)
+    }
+    return find_tail(p, i, n, out, k, cap);
+}
+#endif
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("avx2,popcnt")
+
+static inline u64 nl_mask_avx2(const char *p) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    __m256i a = _mm256_loadu_si256((const __m256i *)p);
+    __m256i b = _mm256_loadu_si256((const __m256i *)(p + 32));
+    return (u64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, nl))
+         | (u64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, nl)) << 32;
+}
+
+// Compares give -1 per newline, subtracted into byte counters; at most 4
+// per pass, so the counters are folded with sad every 63 passes.
+static size_t count_avx2(const char *p, size_t n) {
+    const __m256i nl = _mm256_set1_epi8('\n'), zero = _mm256_setzero_si256();
+    size_t i = 0;
+    __m256i total = zero;
+    while (i + 128 <= n) {
+        size_t stop = n - i >= 63 * 128 ? i + 63 * 128 : n;
+        __m256i acc = zero;
+        for (; i + 128 <= stop; i += 128) {
+            __m256i c0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), nl);
+            __m256i c1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 32)), nl);
+            __m256i c2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 64)), nl);
+            __m256i c3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 96)), nl);
+            acc = _mm256_sub_epi8(acc, _mm256_add_epi8(_mm256_add_epi8(c0, c1), _mm256_add_epi8(c2, c3)));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+    }
+    u64 t[4];
+    _mm256_storeu_si256((__m256i *)t, total);
+    size_t c = (size_t)(t[0] + t[1] + t[2] + t[3]);
+    for (; i + 64 <= n; i += 64) c += (size_t)__builtin_popcountll(nl_mask_avx2(p + i));
+    return c + count_scalar(p + i, n - i);
+}
+
+static size_t find_avx2(const char *p, size_t n, size_t *out, size_t cap) {
+    size_t k = 0, i = 0;
+    for (; i + 64 <= n; i += 64) {
+        u64 m = nl_mask_avx2(p + i);
+        TAKE_BITS(m, i)
+    }
+    return find_tail(p, i, n, out, k, cap);
+}
+
+#pragma GCC pop_options
+#endif
+
+// ---- kernel choice ------------------------------------------------------------
+
+static size_t (*count_nl)(const char *p, size_t n) = count_scalar;
+static size_t (*find_nl)(const char *p, size_t n, size_t *out, size_t cap) = find_scalar;
+
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar or sse2
+// caps the choice.
+__attribute__((constructor))
+static void pick_kernels(void) {
+    isa_level isa = cpu_isa();
+#ifdef __SSE2__
+    if (isa >= ISA_SSE2) {
+        count_nl = count_sse2;
+        find_nl = find_sse2;
+    }
+#endif
+#ifdef HAVE_X86
+    if (isa >= ISA_AVX2) {
+        count_nl = count_avx2;
+        find_nl = find_avx2;
+    }
+#endif
+}
+
+// ---- scanning -----------------------------------------------------------------
+
+size_t lines_end(const char *buf, size_t len) {
+    size_t pos;
+    return find_nl(buf, len, &pos, 1) ? pos : len;
+}
+
+size_t lines_count(const char *buf, size_t len) {
+    return count_nl(buf, len) + (len && buf[len - 1] != '\n');
+}
+
+bool lines_index(LineIndex *ix, const char *buf, size_t len) {
+    *ix = (LineIndex){buf, len, lines_count(buf, len), NULL, NULL};
+    bool wide = len > UINT32_MAX;
+    void *off = malloc((ix->n + 1) * (wide ? sizeof(uint64_t) : sizeof(uint32_t)));
+    if (!off) return false;
+    if (wide) ix->off64 = off; else ix->off32 = off;
+
+    // Line k + 1 starts after the k-th newline; a newline that ends the
+    // buffer starts nothing, and off[n] = len is written last.
+    size_t pos[BATCH], k = 1, at = 0, m;
+    while (at < len && (m = find_nl(buf + at, len - at, pos, BATCH))) {
+        if (wide) for (size_t j = 0; j < m; j++) ix->off64[k + j] = at + pos[j] + 1;
+        else for (size_t j = 0; j < m; j++) ix->off32[k + j] = (uint32_t)(at + pos[j] + 1);
+        k += m;
+        at += pos[m - 1] + 1;
+    }
+    if (wide) { ix->off64[0] = 0; ix->off64[ix->n] = len; }
+    else { ix->off32[0] = 0; ix->off32[ix->n] = (uint32_t)len; }
+    return true;
+}
+
+void lines_index_free(LineIndex *ix) {
+    free(ix->off32);
+    free(ix->off64);
+    *ix = (LineIndex){0};
+}
+
+size_t lines_each(const char *buf, size_t len,
+                  bool (*fn)(void *ctx, const char *line, size_t len), void *ctx) {
+    size_t pos[BATCH], calls = 0, at = 0, m;
+    while (at < len && (m = find_nl(buf + at, len - at, pos, BATCH))) {
+        for (size_t j = 0, s = at; j < m; j++) {
+            calls++;
+            if (!fn(ctx, buf + s, at + pos[j] - s)) return calls;
+            s = at + pos[j] + 1;
+        }
+        at += pos[m - 1] + 1;
+    }
+    if (at < len) { calls++; fn(ctx, buf + at, len - at); }
+    return calls;
+}
+
+// ---- files --------------------------------------------------------------------
+
+static bool read_all(LineFile *f, int fd) {
+    size_t cap = 1 << 16, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) return false;
+    for (;;) {
+        if (len == cap) {
+            char *g = realloc(buf, cap *= 2);
+            if (!g) { free(buf); errno = ENOMEM; return false; }
+            buf = g;
+        }
+        ssize_t r = read(fd, buf + len, cap - len);
+        if (r == 0) break;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            free(buf);
+            errno = err;
+            return false;
+        }
+        len += (size_t)r;
+    }
+    *f = (LineFile){buf, len, NULL, 0};
+    return true;
+}
+
+bool lines_open_fd(LineFile *f, int fd) {
+    struct stat st;
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (pos < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= pos
+        || (uintmax_t)(st.st_size - pos) > SIZE_MAX / 2)
+        return read_all(f, fd);
+
+    long page = sysconf(_SC_PAGESIZE);
+    off_t base = page > 0 ? pos / page * page : 0;
+    size_t len = (size_t)(st.st_size - base);
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;            // one call fills the page tables, not a fault per page
+#endif
+    char *map = mmap(NULL, len, PROT_READ, flags, fd, base);
+    if (map == MAP_FAILED) return read_all(f, fd);
+    posix_madvise(map, len, POSIX_MADV_SEQUENTIAL);
+    *f = (LineFile){map + (pos - base), len - (size_t)(pos - base), map, len};
+    lseek(fd, st.st_size, SEEK_SET);
+    return true;
+}
+
+bool lines_open(LineFile *f, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = lines_open_fd(f, fd);
+    int err = errno;
+    close(fd);
+    errno = err;
+    return ok;
+}
+
+void lines_close(LineFile *f) {
+    if (f->map) munmap(f->map, f->map_len);
+    else free((char *)f->data);
+    *f = (LineFile){0};
+}
@@ -0,0 +1,64 @@
+#ifndef LINES_H
+#define LINES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Line scanning over a whole file in memory. A line is the bytes up to a
+// '\n' (not included), and a last line without one still counts: "a\nb"
+// and "a\nb\n" both have two lines, "" has none. '\r' is part of the line.
+// Newlines are found 64 bytes at a time, with two AVX2 or four SSE2
+// compares and movemasks (chosen at load time; FORCE_ISA=scalar|sse2 caps
+// the choice).
+
+// A file's bytes: regular files are mapped read-only, anything else (a
+// pipe, a terminal) is read to the end into a malloc'd buffer.
+typedef struct {
+    const char *data;
+    size_t len;
+    void *map;                        // NULL when data is malloc'd
+    size_t map_len;
+} LineFile;
+
+// false on failure with errno set. lines_open_fd starts at fd's current
+// position and leaves fd at its end; the caller still closes fd.
+bool lines_open(LineFile *f, const char *path);
+bool lines_open_fd(LineFile *f, int fd);
+void lines_close(LineFile *f);
+
+// Offset of the first '\n' in buf, or len if there is none.
+size_t lines_end(const char *buf, size_t len);
+// Number of lines; wc -l would give one less for an unterminated last line.
+size_t lines_count(const char *buf, size_t len);
+
+// Where each line starts, n + 1 offsets with off[n] == len. The offsets
+// are 32-bit for buffers under 4 GB and 64-bit from there on.
+typedef struct {
+    const char *buf;
+    size_t len, n;
+    uint32_t *off32;                  // exactly one of these is set
+    uint64_t *off64;
+} LineIndex;
+
+// false when out of memory. Views returned by line_at point into buf.
+bool lines_index(LineIndex *ix, const char *buf, size_t len);
+void lines_index_free(LineIndex *ix);
+
+static inline size_t line_start(const LineIndex *ix, size_t i) {
+    return ix->off32 ? ix->off32[i] : (size_t)ix->off64[i];
+}
+
+// Line i < n, without its '\n'.
+static inline const char *line_at(const LineIndex *ix, size_t i, size_t *len) {
+    size_t s = line_start(ix, i), e = line_start(ix, i + 1);
+    *len = e - s - (e > s && ix->buf[e - 1] == '\n');
+    return ix->buf + s;
+}
+
+// Calls fn on each line in order until it returns false; line[len] is the
+// '\n' except on an unterminated last line. Returns the number of calls.
+size_t lines_each(const char *buf, size_t len,
+                  bool (*fn)(void *ctx, const char *line, size_t len), void *ctx);
+
+#endif
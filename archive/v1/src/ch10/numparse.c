@@ -0,0 +1,482 @@
+#define _POSIX_C_SOURCE 200809L   // fileno, isatty
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+#include "numparse.h"
+#include "numparse_pow10.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+typedef unsigned long long u64;
+typedef unsigned __int128 u128;
+
+#define MAX_DIGITS  19     // decimal digits that always fit in a u64
+#define SLOW_DIGITS 800    // enough to decide any rounding (at most 768 matter)
+
+// The per-number code must inline into the scanning loops; GCC's own
+// heuristics give up on it.
+#define HOT static inline __attribute__((always_inline))
+
+static inline bool is_space(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+static inline bool is_digit(char c) { return (unsigned char)(c - '0') < 10; }
+
+// ---- classification -----------------------------------------------------------
+
+#ifdef __SSE2__
+// Bit i is set when p[i] is a digit / whitespace, for 16 bytes at once.
+// Bytes >= 0x80 compare as negative, so they are never either.
+static inline unsigned digit_mask16(const char *p) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i d = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                              _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    return (unsigned)_mm_movemask_epi8(d);
+}
+static inline unsigned space_mask16(const char *p) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i c = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)),
+                              _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1)));
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(c, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))));
+}
+#endif
+
+// Number of digits starting at p.
+static inline size_t digit_run(const char *p, const char *end) {
+    const char *s = p;
+#ifdef __SSE2__
+    for (; end - p >= 16; p += 16) {
+        unsigned m = ~digit_mask16(p) & 0xffff;
+        if (m) return (size_t)(p - s) + (size_t)__builtin_ctz(m);
+    }
+#endif
+    while (p < end && is_digit(*p)) p++;
+    return (size_t)(p - s);
+}
+
+// Bits i of *ws and *nd are set when p[i] is whitespace / not a digit,
+// for 64 bytes.
+static inline void classify64(const char *p, u64 *ws, u64 *nd) {
+#ifdef __SSE2__
+    *ws = *nd = 0;
+    for (int k = 0; k < 64; k += 16) {
+        *ws |= (u64)space_mask16(p + k) << k;
+        *nd |= (u64)(~digit_mask16(p + k) & 0xffff) << k;
+    }
+#else
+    *ws = *nd = 0;
+    for (int i = 0; i < 64; i++) {
+        *ws |= (u64)is_space(p[i]) << i;
+        *nd |= (u64)!is_digit(p[i]) << i;
+    }
+#endif
+}
+
+static bool any_nonzero(const char *p, size_t n) {
+    for (size_t i = 0; i < n; i++) if (p[i] != '0') return true;
+    return false;
+}
+
+// ---- digits to binary -----------------------------------------------------------
+
+// Eight digits at once: pairs, then quads, then the whole word, each step
+// a multiply that adds a lane times 10^k to its neighbour. Zero bytes
+// count as '0', which lets a shorter number be shifted into place.
+static inline u64 eight_digits_word(u64 v) {
+    v = (v & 0x0f0f0f0f0f0f0f0fULL) * 2561 >> 8;
+    v = (v & 0x00ff00ff00ff00ffULL) * 6553601 >> 16;
+    return (v & 0x0000ffff0000ffffULL) * 42949672960001ULL >> 32;
+}
+
+static inline u64 eight_digits(const char *p) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    u64 v;
+    memcpy(&v, p, 8);
+    return eight_digits_word(v);
+#else
+    u64 v = 0;
+    for (int i = 0; i < 8; i++) v = v * 10 + (u64)(p[i] - '0');
+    return v;
+#endif
+}
+
+// Value of n <= MAX_DIGITS digits at p.
+static inline u64 digits_value(const char *p, size_t n) {
+    u64 v = 0;
+    for (; n >= 8; n -= 8, p += 8) v = v * 100000000 + eight_digits(p);
+    for (; n; n--) v = v * 10 + (u64)(*p++ - '0');
+    return v;
+}
+
+static const u64 pow10_u64[MAX_DIGITS + 1] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+#ifdef __SSE2__
+// n digits at p, 1 <= n <= 16, with 16 bytes readable: one or two
+// eight-byte words, shifted so that bytes outside the number are zero.
+HOT u64 short_digits(const char *p, unsigned n) {
+    u64 a, b;
+    memcpy(&a, p, 8);
+    if (n <= 8) return eight_digits_word(a << (64 - 8 * n));
+    memcpy(&b, p + n - 8, 8);
+    return eight_digits_word(a << (128 - 8 * n)) * 100000000 + eight_digits_word(b);
+}
+#endif
+
+// ---- integers -------------------------------------------------------------------
+
+// Magnitude of the digits at *pp, at most max; *pp moves past all of them.
+HOT NumStatus parse_mag(const char **pp, const char *end, u64 max, u64 *out) {
+    const char *p = *pp;
+    u64 v;
+#ifdef __SSE2__
+    if (end - p >= 16) {
+        unsigned n = (unsigned)__builtin_ctz(~digit_mask16(p));
+        if (n - 1 < 15 && (*p != '0' || n == 1)) {
+            v = short_digits(p, n);
+            *pp = p + n;
+            if (v > max) return NUM_RANGE;
+            *out = v;
+            return NUM_OK;
+        }
+    }
+#endif
+    size_t n = digit_run(p, end);
+    if (n == 0) return NUM_SYNTAX;
+    *pp = p + n;
+    while (n > 1 && *p == '0') { p++; n--; }
+    if (n <= MAX_DIGITS) v = digits_value(p, n);
+    else if (n > MAX_DIGITS + 1 ||
+             __builtin_mul_overflow(digits_value(p, MAX_DIGITS), 10ULL, &v) ||
+             __builtin_add_overflow(v, (u64)(p[MAX_DIGITS] - '0'), &v)) return NUM_RANGE;
+    if (v > max) return NUM_RANGE;
+    *out = v;
+    return NUM_OK;
+}
+
+// The get_ functions are inlined into the scanning loops; parse_ are the
+// same code for callers outside.
+#define DEFINE_PARSE_INT(sfx, T, TMAX) \
+HOT NumStatus get_##sfx(const char *p, const char *end, T *out, const char **next) { \
+    const char *s = p; \
+    u64 neg = p < end && *p == '-'; \
+    p += p < end && (*p == '-' || *p == '+'); \
+    u64 v; \
+    NumStatus st = parse_mag(&p, end, (u64)TMAX + neg, &v); \
+    *next = st == NUM_SYNTAX ? s : p; \
+    if (st == NUM_OK) *out = (T)((v ^ -neg) + neg); \
+    return st; \
+} \
+NumStatus parse_##sfx(const char *p, const char *end, T *out, const char **next) { \
+    return get_##sfx(p, end, out, next); \
+}
+
+DEFINE_PARSE_INT(i32, int, INT_MAX)
+DEFINE_PARSE_INT(i64, long long, LLONG_MAX)
+
+// ---- doubles --------------------------------------------------------------------
+
+// Eisel and Lemire's algorithm, as in Go's strconv: man * 10^q from a
+// 128-bit truncated product with the table mantissa. Gives up (false) when
+// the truncation could change the rounding, and for subnormal or infinite
+// results; the caller then takes the slow path. man != 0.
+static bool eisel_lemire(u64 man, long long q, u64 *bits) {
+    if (q < POW10_MIN || q > POW10_MAX) return false;
+    int clz = __builtin_clzll(man);
+    man <<= clz;
+    u64 exp2 = (u64)(((217706 * q) >> 16) + 64 + 1023) - (u64)clz;   // 217706/2^16 ~ log2(10)
+    const u64 *pw = pow10_128[q - POW10_MIN];
+    u128 x = (u128)man * pw[0];
+    u64 hi = (u64)(x >> 64), lo = (u64)x;
+    if ((hi & 0x1ff) == 0x1ff && lo + man < man) {       // low bits may carry into the result
+        u128 y = (u128)man * pw[1];
+        u64 mhi = hi, mlo = lo + (u64)(y >> 64);
+        if (mlo < lo) mhi++;
+        if ((mhi & 0x1ff) == 0x1ff && mlo + 1 == 0 && (u64)y + man < man) return false;
+        hi = mhi; lo = mlo;
+    }
+    u64 msb = hi >> 63;
+    u64 mant = hi >> (msb + 9);
+    exp2 -= 1 ^ msb;
+    if (lo == 0 && (hi & 0x1ff) == 0 && (mant & 3) == 1) return false;   // exactly halfway?
+    mant += mant & 1;
+    mant >>= 1;
+    if (mant >> 53) { mant >>= 1; exp2++; }
+    if (exp2 - 1 >= 0x7ff - 1) return false;
+    *bits = exp2 << 52 | (mant & 0x000fffffffffffffULL);
+    return true;
+}
+
+// Exact fallback for long mantissas and the rare undecided cases: rewrite
+// the digits as an integer with an exponent, which has no radix character
+// for the locale to interpret, and let strtod round it. Digits past
+// SLOW_DIGITS only matter through whether any is non-zero.
+static double parse_slow(const char *ip, size_t ni, const char *fp, size_t nf, long long e) {
+    char buf[SLOW_DIGITS + 32];
+    size_t k = 0;
+    bool sticky = false;
+    for (size_t i = 0; i < ni + nf; i++) {
+        bool frac = i >= ni;
+        char c = frac ? fp[i - ni] : ip[i];
+        if (k == 0 && c == '0') { e -= frac; continue; }
+        if (k < SLOW_DIGITS) { buf[k++] = c; e -= frac; }
+        else { sticky |= c != '0'; e += !frac; }
+    }
+    if (sticky) { buf[k++] = '1'; e--; }
+    if (e > 100000) e = 100000;
+    if (e < -100000) e = -100000;
+    snprintf(buf + k, sizeof buf - k, "e%lld", e);
+    return strtod(buf, NULL);
+}
+
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Case-insensitive match of a lower-case word.
+static bool match_word(const char *p, const char *end, const char *w) {
+    for (; *w; p++, w++)
+        if (p == end || (*p | 0x20) != *w) return false;
+    return true;
+}
+
+HOT NumStatus get_f64(const char *p, const char *end, double *out, const char **next) {
+    const char *s = p;
+    bool neg = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    const char *ip = p;
+    size_t ni = digit_run(p, end);
+    p += ni;
+    const char *fp = p;
+    size_t nf = 0;
+    if (p < end && *p == '.') { fp = ++p; nf = digit_run(p, end); p += nf; }
+    if (ni + nf == 0) {
+        p = ip;
+        if (match_word(p, end, "infinity")) { *out = neg ? -INFINITY : INFINITY; *next = p + 8; return NUM_OK; }
+        if (match_word(p, end, "inf"))      { *out = neg ? -INFINITY : INFINITY; *next = p + 3; return NUM_OK; }
+        if (match_word(p, end, "nan"))      { *out = neg ? -NAN : NAN; *next = p + 3; return NUM_OK; }
+        *next = s;
+        return NUM_SYNTAX;
+    }
+
+    // "1e" and "1e+" end before the e, as in strtod.
+    long long e10 = 0;
+    if (p < end && (*p | 0x20) == 'e') {
+        const char *q = p + 1;
+        bool eneg = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+')) q++;
+        size_t ne = digit_run(q, end);
+        if (ne) {
+            p = q + ne;
+            while (ne > 1 && *q == '0') { q++; ne--; }
+            e10 = ne > 9 ? 1000000000 : (long long)digits_value(q, ne);
+            if (eneg) e10 = -e10;
+        }
+    }
+    *next = p;
+
+    // The first MAX_DIGITS significant digits as w, value w * 10^q, and
+    // whether any non-zero digit was dropped.
+    const char *d = ip;
+    size_t n = ni;
+    while (n && *d == '0') { d++; n--; }
+    long long q = e10;
+    u64 w;
+    bool trunc;
+    if (n > MAX_DIGITS) {
+        w = digits_value(d, MAX_DIGITS);
+        q += (long long)(n - MAX_DIGITS);
+        trunc = any_nonzero(d + MAX_DIGITS, n - MAX_DIGITS) || any_nonzero(fp, nf);
+    } else if (n) {
+        size_t take = nf < MAX_DIGITS - n ? nf : MAX_DIGITS - n;
+        w = digits_value(d, n) * pow10_u64[take] + digits_value(fp, take);
+        q -= (long long)take;
+        trunc = any_nonzero(fp + take, nf - take);
+    } else {
+        const char *f = fp;
+        size_t m = nf;
+        while (m && *f == '0') { f++; m--; }
+        size_t take = m < MAX_DIGITS ? m : MAX_DIGITS;
+        w = digits_value(f, take);
+        q -= (long long)(nf - m + take);
+        trunc = any_nonzero(f + take, m - take);
+    }
+
+    double v;
+    u64 bits, bits1;
+    if (w == 0) v = 0.0;
+    else if (!trunc && w <= 1ULL << 53 && q >= -22 && q <= 22)
+        v = q < 0 ? (double)w / pow10_exact[-q] : (double)w * pow10_exact[q];   // both exact, one rounding
+    else if (eisel_lemire(w, q, &bits) &&
+             (!trunc || (eisel_lemire(w + 1, q, &bits1) && bits1 == bits)))    // w < value < w+1
+        memcpy(&v, &bits, sizeof v);
+    else
+        v = parse_slow(ip, ni, fp, nf, e10);
+    *out = neg ? -v : v;
+    return isinf(v) ? NUM_RANGE : NUM_OK;
+}
+
+NumStatus parse_f64(const char *p, const char *end, double *out, const char **next) {
+    return get_f64(p, end, out, next);
+}
+
+// ---- buffers and streams --------------------------------------------------------
+
+// Tokens are found from whitespace bitmasks of 64-byte blocks rather than
+// by walking from one number to the next, so where each number starts
+// never waits on the parse of the one before and several are in flight.
+// FAST(p, tlen, nd, out) may take a token lying inside the block, of tlen
+// bytes whose non-digit bits are nd, with 24 bytes readable; anything it
+// declines goes through token_, which also finds the errors.
+#define DEFINE_SCAN(sfx, T, FAST) \
+__attribute__((noinline)) \
+static NumStatus token_##sfx(const char *p, const char *end, T *out) { \
+    const char *next; \
+    NumStatus st = get_##sfx(p, end, out, &next); \
+    return next < end && !is_space(*next) ? NUM_SYNTAX : st; \
+} \
+NumScan scan_##sfx(const char *buf, size_t len, T *out, size_t cap) { \
+    const char *end = buf + len; \
+    NumScan r = {0, len, NUM_OK}; \
+    u64 prev_ws = 1; \
+    for (size_t blk = 0; blk < len; blk += 64) { \
+        u64 ws, nd; \
+        if (len - blk >= 64) classify64(buf + blk, &ws, &nd); \
+        else { \
+            char tail[64]; \
+            memset(tail, ' ', sizeof tail); \
+            memcpy(tail, buf + blk, len - blk); \
+            classify64(tail, &ws, &nd); \
+        } \
+        u64 starts = ~ws & (ws << 1 | prev_ws); \
+        prev_ws = ws >> 63; \
+        for (; starts; starts &= starts - 1) { \
+            unsigned i = (unsigned)__builtin_ctzll(starts); \
+            const char *p = buf + blk + i; \
+            if (r.count == cap) { r.pos = (size_t)(p - buf); return r; } \
+            u64 rest = ws >> i; \
+            if (rest && end - p >= 24 && FAST(p, (unsigned)__builtin_ctzll(rest), nd >> i, &out[r.count])) { \
+                r.count++; \
+                continue; \
+            } \
+            NumStatus st = token_##sfx(p, end, &out[r.count]); \
+            if (st != NUM_OK) { r.status = st; r.pos = (size_t)(p - buf); return r; } \
+            r.count++; \
+        } \
+    } \
+    return r; \
+}
+
+#ifdef __SSE2__
+// A sign and 1 to 19 digits filling the token, in range.
+#define DEFINE_FAST_INT(sfx, T, TMAX) \
+HOT bool fast_##sfx(const char *p, unsigned tlen, u64 nd, T *out) { \
+    u64 neg = *p == '-', v; \
+    unsigned sg = (unsigned)neg | (*p == '+'), d = tlen - sg; \
+    if (d - 1 >= MAX_DIGITS || (nd >> sg & ((1ULL << d) - 1))) return false; \
+    p += sg; \
+    if (d <= 16) v = short_digits(p, d); \
+    else v = (short_digits(p, d - 16) * 100000000 + eight_digits(p + d - 16)) * 100000000 + \
+             eight_digits(p + d - 8); \
+    if (v > (u64)TMAX + neg) return false; \
+    *out = (T)((v ^ -neg) + neg); \
+    return true; \
+}
+
+// A sign and up to 15 digits with at most one '.' among them, filling the
+// token: w < 10^15 and 10^nf are both exact doubles, so w / 10^nf rounds
+// once and is the value get_f64 gives. Exponents, longer mantissas, inf
+// and nan go the long way.
+HOT bool fast_f64(const char *p, unsigned tlen, u64 nd, double *out) {
+    bool neg = *p == '-';
+    unsigned sg = (unsigned)neg | (*p == '+'), len = tlen - sg, ni = len, nf = 0;
+    if (len - 1 >= 16) return false;
+    p += sg;
+    u64 other = nd >> sg & ((1ULL << len) - 1);
+    if (other) {
+        ni = (unsigned)__builtin_ctzll(other);
+        if ((other & (other - 1)) || p[ni] != '.' || len == 1) return false;
+        nf = len - ni - 1;
+    }
+    if (ni + nf > 15) return false;
+    u64 w = (ni ? short_digits(p, ni) : 0) * pow10_u64[nf] + (nf ? short_digits(p + ni + 1, nf) : 0);
+    double v = (double)w / pow10_exact[nf];
+    *out = neg ? -v : v;
+    return true;
+}
+#else
+#define DEFINE_FAST_INT(sfx, T, TMAX) \
+HOT bool fast_##sfx(const char *p, unsigned tlen, u64 nd, T *out) { \
+    (void)p; (void)tlen; (void)nd; (void)out; \
+    return false; \
+}
+HOT bool fast_f64(const char *p, unsigned tlen, u64 nd, double *out) {
+    (void)p; (void)tlen; (void)nd; (void)out;
+    return false;
+}
+#endif
+
+DEFINE_FAST_INT(i32, int, INT_MAX)
+DEFINE_FAST_INT(i64, long long, LLONG_MAX)
+
+DEFINE_SCAN(i32, int, fast_i32)
+DEFINE_SCAN(i64, long long, fast_i64)
+DEFINE_SCAN(f64, double, fast_f64)
+
+size_t scan_whole(const char *buf, size_t len, int at_eof) {
+    if (at_eof) return len;
+    while (len && !is_space(buf[len - 1])) len--;
+    return len;
+}
+
+#define STREAM_BUF (64 * 1024)
+
+// Fills as much of buf as the file gives; from a terminal only a line at
+// a time, so numbers are handled as they are typed.
+static size_t fill(FILE *f, char *buf, size_t room, bool tty, bool *eof) {
+    if (!tty) {
+        size_t got = fread(buf, 1, room, f);
+        *eof = got < room;
+        return got;
+    }
+    *eof = room < 2 || !fgets(buf, (int)room, f);
+    return *eof ? 0 : strlen(buf);
+}
+
+// A number longer than the whole buffer is reported as NUM_SYNTAX.
+#define DEFINE_FSCAN(sfx, T) \
+NumScan fscan_##sfx(FILE *f, T *vals, size_t cap, \
+                    void (*fn)(void *ctx, const T *v, size_t n), void *ctx) { \
+    char buf[STREAM_BUF]; \
+    NumScan total = {0, 0, NUM_OK}; \
+    size_t have = 0; \
+    bool tty = isatty(fileno(f)); \
+    for (bool eof = false; !eof;) { \
+        have += fill(f, buf + have, sizeof buf - have, tty, &eof); \
+        size_t whole = scan_whole(buf, have, eof), off = 0; \
+        if (whole == 0 && have == sizeof buf) { total.status = NUM_SYNTAX; return total; } \
+        while (off < whole) { \
+            NumScan r = scan_##sfx(buf + off, whole - off, vals, cap); \
+            if (r.count) fn(ctx, vals, r.count); \
+            total.count += r.count; \
+            off += r.pos; \
+            if (r.status != NUM_OK) { total.status = r.status; total.pos += off; return total; } \
+        } \
+        memmove(buf, buf + whole, have - whole); \
+        have -= whole; \
+        total.pos += whole; \
+    } \
+    return total; \
+}
+
+DEFINE_FSCAN(i32, int)
+DEFINE_FSCAN(i64, long long)
+DEFINE_FSCAN(f64, double)
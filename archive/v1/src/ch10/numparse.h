@@ -0,0 +1,54 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Locale-independent number parsing straight from a byte buffer, for the
+// places that used scanf("%d") / scanf("%lf") in a loop.
+//   integers  [+-]digits, overflow is an error (no wrap-around)
+//   doubles   [+-]digits[.digits][(e|E)[+-]digits], also .5, 5., inf,
+//             infinity and nan in any case; always correctly rounded,
+//             the same value strtod gives in the "C" locale
+// Hex floats and digit grouping are not accepted.
+typedef enum { NUM_OK, NUM_SYNTAX, NUM_RANGE } NumStatus;
+
+// Parse one number starting exactly at p (no leading whitespace) and
+// reading no further than end. *next is set past the characters used,
+// whatever follows them. On NUM_RANGE a double is set to +-inf; an
+// integer is left unchanged.
+NumStatus parse_i32(const char *p, const char *end, int *out, const char **next);
+NumStatus parse_i64(const char *p, const char *end, long long *out, const char **next);
+NumStatus parse_f64(const char *p, const char *end, double *out, const char **next);
+
+// Whole-buffer tokenization: numbers separated by ASCII whitespace, up to
+// cap of them into out. Stops at the end of the buffer, when out is full
+// (pos is then the next number, to continue from) or at the first bad
+// token (status says why and pos is its offset, e.g. "12x" or "1.5" for
+// the integer versions).
+typedef struct {
+    size_t count;      // values stored
+    size_t pos;        // bytes consumed
+    NumStatus status;
+} NumScan;
+
+NumScan scan_i32(const char *buf, size_t len, int *out, size_t cap);
+NumScan scan_i64(const char *buf, size_t len, long long *out, size_t cap);
+NumScan scan_f64(const char *buf, size_t len, double *out, size_t cap);
+
+// Length of buf up to its last whitespace byte, or len itself when nothing
+// will follow: the part that is safe to scan when the next chunk of a
+// stream may continue a number cut at the boundary.
+size_t scan_whole(const char *buf, size_t len, int at_eof);
+
+// Stream a file through a 64 KB buffer, handing each batch of up to cap
+// (> 0) values to fn. count is the total read and pos a byte offset in
+// the file. A read error ends the stream like end of file; check ferror.
+NumScan fscan_i32(FILE *f, int *vals, size_t cap,
+                  void (*fn)(void *ctx, const int *v, size_t n), void *ctx);
+NumScan fscan_i64(FILE *f, long long *vals, size_t cap,
+                  void (*fn)(void *ctx, const long long *v, size_t n), void *ctx);
+NumScan fscan_f64(FILE *f, double *vals, size_t cap,
+                  void (*fn)(void *ctx, const double *v, size_t n), void *ctx);
+
+#endif
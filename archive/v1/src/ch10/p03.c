@@ -1,10 +1,18 @@
+// gcc -std=c23 -O2 p03.c numparse.c -o p03 -lm
 #include <stdio.h>
+#include "numparse.h"
+
+static void add_all(void *ctx, const int *v, size_t n) {
+    long long *sum = ctx;
+    for (size_t i = 0; i < n; i++) *sum += v[i];
+}
 
 int main(void) {
     FILE *f = fopen("numbers.txt", "r");
     if (!f) { perror("numbers.txt"); return 1; }
-    long long sum = 0; int x;
-    while (fscanf(f, "%d", &x) == 1) sum += x;
+    long long sum = 0; int buf[4096];
+    NumScan r = fscan_i32(f, buf, sizeof buf / sizeof *buf, add_all, &sum);
+    if (r.status != NUM_OK) fprintf(stderr, "numbers.txt: bad number at byte %zu\n", r.pos);
     if (ferror(f)) perror("read");
     if (fclose(f) == EOF) perror("close");
     printf("%lld\n", sum);
@@ -1,20 +1,28 @@
+// gcc -std=c23 -O2 -I../ch05 p05.c lines.c ../ch05/cpu_dispatch.c -o p05
 #include <stdio.h>
-#include <string.h>
+#include "lines.h"
+
+typedef struct { FILE *out; const char *end; bool ok; } Filter;
+
+// Longer than 10 bytes counting the '\n', as strlen of an fgets line.
+static bool keep_long(void *ctx, const char *line, size_t len) {
+    Filter *f = ctx;
+    size_t n = len + (line + len < f->end);
+    if (n > 10) f->ok = fwrite(line, 1, n, f->out) == n;
+    return f->ok;
+}
 
 int main(void) {
-    FILE *in = fopen("input.txt", "r");
-    if (!in) { perror("input.txt"); return 1; }
+    LineFile in;
+    if (!lines_open(&in, "input.txt")) { perror("input.txt"); return 1; }
     FILE *out = fopen("long.txt", "w");
-    if (!out) { perror("long.txt"); fclose(in); return 1; }
+    if (!out) { perror("long.txt"); lines_close(&in); return 1; }
 
-    char line[4096];
-    while (fgets(line, sizeof line, in)) {
-        if (strlen(line) > 10) {
-            if (fputs(line, out) == EOF) { perror("write"); break; }
-        }
-    }
-    if (ferror(in)) perror("read");
+    Filter f = {out, in.data + in.len, true};
+    lines_each(in.data, in.len, keep_long, &f);
+    if (!f.ok) perror("write");
 
-    fclose(in); fclose(out);
+    lines_close(&in);
+    fclose(out);
     return 0;
 }
@@ -1,13 +1,21 @@
+// gcc -std=c23 -O2 p07.c numparse.c -o p07 -lm
 #include <stdio.h>
+#include "numparse.h"
+
+static void print_all(void *ctx, const int *v, size_t n) {
+    (void)ctx;
+    for (size_t i = 0; i < n; i++) printf("%d ", v[i]);
+}
 
 int main(void) {
     // text
     FILE *tx = fopen("ints.txt", "r");
     if (!tx) { perror("ints.txt"); return 1; }
-    int x;
+    int buf[256];
     puts("from text:");
-    while (fscanf(tx, "%d", &x) == 1) printf("%d ", x);
+    NumScan r = fscan_i32(tx, buf, sizeof buf / sizeof *buf, print_all, NULL);
     puts("");
+    if (r.status != NUM_OK) fprintf(stderr, "ints.txt: bad number at byte %zu\n", r.pos);
     fclose(tx);
 
     // binary
@@ -0,0 +1,133 @@
+// numparse.c against strtoll/strtod and fscanf on large generated buffers.
+// gcc -std=c23 -O2 p21.c numparse.c -o p21 -lm
+// Every value scan_ returns is also checked against strtoll / strtod.
+#define _POSIX_C_SOURCE 200809L   // fmemopen
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "numparse.h"
+
+#define N (4 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double secs_since(clock_t t0) { return (double)(clock() - t0) / CLOCKS_PER_SEC; }
+
+static char *text;
+static size_t text_len;
+
+typedef enum { INT32, INT64, F64_SHORT, F64_FULL } Kind;
+
+static void generate(Kind k) {
+    size_t cap = (size_t)N * 26;
+    text = realloc(text, cap);
+    size_t len = 0;
+    for (int i = 0; i < N; i++) {
+        unsigned long long r = next_rand();
+        const char *sep = i % 8 == 7 ? "\n" : " ";
+        switch (k) {
+        case INT32: len += sprintf(text + len, "%d%s", (int)r >> (r >> 59), sep); break;
+        case INT64: len += sprintf(text + len, "%lld%s", (long long)r >> (r >> 58), sep); break;
+        case F64_SHORT: len += sprintf(text + len, "%.3f%s", (double)(long long)(r >> 36) / 1e3 - 1e4, sep); break;
+        case F64_FULL: {
+            double d = (double)(r >> 11) / (1ULL << 53) * 1e6;
+            len += sprintf(text + len, "%.17g%s", d, sep);
+            break;
+        }
+        }
+    }
+    text_len = len;
+}
+
+static void report(const char *what, double s) {
+    printf("  %-22s %7.1f ms  %7.1f MB/s\n", what, s * 1e3, text_len / s / 1e6);
+}
+
+static void bench_int(Kind k) {
+    long long *a = malloc(N * sizeof *a), *b = malloc(N * sizeof *b);
+    int *a32 = malloc(N * sizeof *a32);
+    generate(k);
+    printf("%s, %.1f MB\n", k == INT32 ? "int32" : "int64", text_len / 1e6);
+
+    clock_t t0 = clock();
+    NumScan r = k == INT32 ? scan_i32(text, text_len, a32, N) : scan_i64(text, text_len, a, N);
+    report(k == INT32 ? "scan_i32" : "scan_i64", secs_since(t0));
+    if (k == INT32) for (int i = 0; i < N; i++) a[i] = a32[i];
+
+    t0 = clock();
+    char *p = text;
+    for (int i = 0; i < N; i++) b[i] = strtoll(p, &p, 10);
+    report("strtoll", secs_since(t0));
+
+    FILE *f = fmemopen(text, text_len, "r");
+    t0 = clock();
+    for (int i = 0; i < N; i++) if (fscanf(f, "%lld", &b[i]) != 1) break;
+    report("fscanf", secs_since(t0));
+    fclose(f);
+
+    size_t bad = r.count != N || r.status != NUM_OK;
+    for (int i = 0; i < N; i++) bad += a[i] != b[i];
+    printf("  mismatches: %zu\n", bad);
+    free(a); free(b); free(a32);
+}
+
+static void bench_f64(Kind k) {
+    double *a = malloc(N * sizeof *a), *b = malloc(N * sizeof *b);
+    generate(k);
+    printf("double %s, %.1f MB\n", k == F64_SHORT ? "%.3f" : "%.17g", text_len / 1e6);
+
+    clock_t t0 = clock();
+    NumScan r = scan_f64(text, text_len, a, N);
+    report("scan_f64", secs_since(t0));
+
+    t0 = clock();
+    char *p = text;
+    for (int i = 0; i < N; i++) b[i] = strtod(p, &p);
+    report("strtod", secs_since(t0));
+
+    FILE *f = fmemopen(text, text_len, "r");
+    t0 = clock();
+    for (int i = 0; i < N; i++) if (fscanf(f, "%lf", &b[i]) != 1) break;
+    report("fscanf", secs_since(t0));
+    fclose(f);
+
+    size_t bad = r.count != N || r.status != NUM_OK;
+    for (int i = 0; i < N; i++) bad += memcmp(&a[i], &b[i], sizeof *a) != 0;
+    printf("  mismatches: %zu\n", bad);
+    free(a); free(b);
+}
+
+static void sum_batch(void *ctx, const long long *v, size_t n) {
+    long long *sum = ctx;
+    for (size_t i = 0; i < n; i++) *sum += v[i];
+}
+
+// The streaming reader on a file with a bad token near the end.
+static void stream_demo(void) {
+    FILE *f = tmpfile();
+    if (!f) { perror("tmpfile"); return; }
+    long long want = 0;
+    for (int i = 0; i < 100000; i++) { fprintf(f, "%d\n", i * 37 - 5000); want += i * 37 - 5000; }
+    fputs("12 3,5 7\n", f);
+    rewind(f);
+    long long vals[1000], sum = 0;
+    NumScan r = fscan_i64(f, vals, 1000, sum_batch, &sum);
+    printf("stream: %zu values, sum %lld (expected %lld), ", r.count, sum, want + 12);
+    if (r.status != NUM_OK) printf("%s at byte %zu\n", r.status == NUM_RANGE ? "out of range" : "bad number", r.pos);
+    fclose(f);
+}
+
+int main(void) {
+    bench_int(INT32);
+    bench_int(INT64);
+    bench_f64(F64_SHORT);
+    bench_f64(F64_FULL);
+    stream_demo();
+    free(text);
+    return 0;
+}
@@ -0,0 +1,125 @@
+// fastout.c against fprintf/putc on the output of the table and report programs.
+// gcc -std=c23 -O2 p22.c fastout.c -o p22 -lm
+// Both sides write to temporary files, which are then compared byte for
+// byte; the shortest doubles are also read back with strtod.
+#define _POSIX_C_SOURCE 200809L   // fileno
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fastout.h"
+
+#define N (2 << 20)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double secs_since(clock_t t0) { return (double)(clock() - t0) / CLOCKS_PER_SEC; }
+
+static double vals[N];
+static FastOut out;
+
+typedef enum { TABLE, FACTORIAL, STARS, FIXED3, SHORTEST } Kind;
+static const char *const names[] = { "table %2d %5d %6d", "%2d! = %llu", "rows of '*'", "%10.3f", "shortest double" };
+
+static unsigned long long fact(int n) {
+    unsigned long long f = 1;
+    for (int i = 2; i <= n; i++) f *= (unsigned long long)i;
+    return f;
+}
+
+static void with_stdio(FILE *f, Kind k) {
+    for (int i = 0; i < N; i++) {
+        switch (k) {
+        case TABLE: fprintf(f, "%2d %5d %6d\n", i % 100, i, i * 7); break;
+        case FACTORIAL: fprintf(f, "%2d! = %llu\n", i % 21, fact(i % 21)); break;
+        case STARS:
+            for (int c = 0; c < i % 80; c++) putc('*', f);
+            putc('\n', f);
+            break;
+        case FIXED3: fprintf(f, "%10.3f\n", vals[i]); break;
+        case SHORTEST: fprintf(f, "%.17g\n", vals[i]); break;
+        }
+    }
+    fflush(f);
+}
+
+static void with_fastout(Kind k) {
+    for (int i = 0; i < N; i++) {
+        switch (k) {
+        case TABLE:
+            fo_i64(&out, i % 100, 2);
+            fo_char(&out, ' '); fo_i64(&out, i, 5);
+            fo_char(&out, ' '); fo_i64(&out, i * 7, 6);
+            break;
+        case FACTORIAL:
+            fo_i64(&out, i % 21, 2); fo_write(&out, "! = ", 4);
+            fo_u64(&out, fact(i % 21), 0);
+            break;
+        case STARS: fo_fill(&out, '*', (size_t)(i % 80)); break;
+        case FIXED3: fo_fixed(&out, vals[i], 3, 10); break;
+        case SHORTEST: fo_f64(&out, vals[i], 0); break;
+        }
+        fo_char(&out, '\n');
+    }
+    fo_flush(&out);
+}
+
+static char *slurp(FILE *f, size_t *len) {
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    rewind(f);
+    char *s = malloc(*len + 1);
+    if (!s || fread(s, 1, *len, f) != *len) { free(s); return NULL; }
+    s[*len] = '\0';
+    return s;
+}
+
+// Every line must hold the exact double again, with at most 17 digits.
+static size_t check_round_trip(const char *s) {
+    size_t bad = 0;
+    for (int i = 0; i < N; i++) {
+        char *end;
+        double d = strtod(s, &end);
+        bad += memcmp(&d, &vals[i], sizeof d) != 0 || *end != '\n';
+        s = end + 1;
+    }
+    return bad;
+}
+
+static void bench(Kind k) {
+    FILE *a = tmpfile(), *b = tmpfile();
+    if (!a || !b) { perror("tmpfile"); exit(1); }
+
+    clock_t t0 = clock();
+    with_stdio(a, k);
+    double ts = secs_since(t0);
+
+    fo_init(&out, fileno(b));
+    t0 = clock();
+    with_fastout(k);
+    double tf = secs_since(t0);
+
+    size_t na, nb;
+    char *sa = slurp(a, &na), *sb = slurp(b, &nb);
+    if (!sa || !sb) { perror("read back"); exit(1); }
+    printf("%-20s %6.1f MB  stdio %7.1f ms  fastout %7.1f ms  %5.1fx  ",
+           names[k], na / 1e6, ts * 1e3, tf * 1e3, ts / tf);
+    if (k == SHORTEST) printf("%.1f MB, round-trip errors: %zu\n", nb / 1e6, check_round_trip(sb));
+    else printf("%s\n", na == nb && memcmp(sa, sb, na) == 0 ? "identical" : "DIFFERENT");
+    free(sa); free(sb);
+    fclose(a); fclose(b);
+}
+
+int main(void) {
+    for (int i = 0; i < N; i++) {
+        unsigned long long r = next_rand();
+        vals[i] = i % 2 ? (double)(long long)(r >> 34) / 1e3 - 5e6 : (double)(r >> 11) / (1ULL << 53) * 1e6;
+    }
+    for (Kind k = TABLE; k <= SHORTEST; k++) bench(k);
+    return 0;
+}
@@ -0,0 +1,155 @@
+// lines.c on a generated 512 MB log file: count, index and lines_each
+// against an fgets loop (4 KB buffer) and a memchr loop, from the page
+// cache. p23 [file] uses that file instead and leaves it in place.
+// gcc -std=c23 -O2 -I../ch05 p23.c lines.c ../ch05/cpu_dispatch.c -o p23
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lines.h"
+
+#define MB   (1 << 20)
+#define SIZE ((size_t)512 * MB)
+
+static unsigned long long rng = 88172645463325252ULL;
+static unsigned long long next_rand(void) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Log-like lines of 20-200 bytes, now and then an empty one.
+static bool make_file(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    static char line[256];
+    for (size_t n = 0; n < SIZE;) {
+        unsigned long long r = next_rand();
+        size_t len = r % 64 == 0 ? 0 : 20 + (r >> 8) % 181;
+        for (size_t i = 0; i < len; i++) line[i] = (char)(' ' + (r >> (i % 48)) % 95);
+        line[len] = '\n';
+        fwrite(line, 1, len + 1, f);
+        n += len + 1;
+    }
+    return fclose(f) == 0;
+}
+
+static void report(const char *name, double ms, size_t bytes, size_t lines) {
+    printf("  %-14s %8.1f ms  %7.2f GB/s  %zu lines\n", name, ms, bytes / ms / 1e6, lines);
+}
+
+static size_t total_len;
+static bool add_len(void *ctx, const char *line, size_t len) {
+    (void)ctx; (void)line;
+    total_len += len;
+    return true;
+}
+
+// lines_each must hand over the index's lines, in order.
+typedef struct { const LineIndex *ix; size_t i; bool ok; } EachCheck;
+
+static bool check_line(void *ctx, const char *line, size_t len) {
+    EachCheck *c = ctx;
+    size_t want;
+    c->ok &= c->i < c->ix->n && line == line_at(c->ix, c->i, &want) && len == want;
+    c->i++;
+    return true;
+}
+
+// The index's lines against a second fgets pass, byte for byte. A line
+// longer than the buffer comes in pieces.
+static bool check_fgets(const char *path, const LineIndex *ix) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    static char buf[4096];
+    bool ok = true;
+    size_t i = 0, at = 0, len = 0;        // line i, of len bytes, matched up to at
+    while (ok && fgets(buf, sizeof buf, f)) {
+        size_t got = strlen(buf);
+        bool nl = got && buf[got - 1] == '\n';
+        got -= nl;
+        const char *p = i < ix->n ? line_at(ix, i, &len) : NULL;
+        ok = p && at + got <= len && memcmp(p + at, buf, got) == 0;
+        at += got;
+        if (nl) {
+            ok &= at == len;
+            i++;
+            at = 0;
+        }
+    }
+    if (ok && at) { ok = at == len; i++; }  // a last line without '\n'
+    fclose(f);
+    return ok && i == ix->n;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "p23.log";
+    if (argc < 2 && !make_file(path)) { perror(path); return 1; }
+
+    // fgets reads the file once here, which also puts it in the page cache.
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return 1; }
+    static char buf[4096];
+    size_t want = 0;
+    double t0 = now_ms();
+    while (fgets(buf, sizeof buf, f)) want += strchr(buf, '\n') != NULL || feof(f);
+    double ms = now_ms() - t0;
+    fclose(f);
+
+    LineFile lf;
+    t0 = now_ms();
+    if (!lines_open(&lf, path)) { perror(path); return 1; }
+    double open_ms = now_ms() - t0;
+    printf("%s: %.0f MB, mapped in %.1f ms\n", path, lf.len / (double)MB, open_ms);
+    report("fgets", ms, lf.len, want);
+
+    size_t n = 0;
+    t0 = now_ms();
+    for (const char *p = lf.data, *e = p + lf.len; (p = memchr(p, '\n', (size_t)(e - p))); p++) n++;
+    n += lf.len && lf.data[lf.len - 1] != '\n';
+    report("memchr", now_ms() - t0, lf.len, n);
+    bool ok = n == want;
+
+    t0 = now_ms();
+    n = lines_count(lf.data, lf.len);
+    report("lines_count", now_ms() - t0, lf.len, n);
+    ok &= n == want;
+
+    LineIndex ix;
+    t0 = now_ms();
+    if (!lines_index(&ix, lf.data, lf.len)) { perror("lines_index"); return 1; }
+    report("lines_index", now_ms() - t0, lf.len, ix.n);
+    ok &= ix.n == want;
+
+    t0 = now_ms();
+    n = lines_each(lf.data, lf.len, add_len, NULL);
+    report("lines_each", now_ms() - t0, lf.len, n);
+    ok &= n == want;
+
+    // Every line from the index is the one fgets reads and the one
+    // lines_each hands over, and ends at a '\n' or at the end of the file.
+    size_t sum = 0;
+    for (size_t i = 0; i < ix.n; i++) {
+        size_t len;
+        const char *p = line_at(&ix, i, &len);
+        ok &= memchr(p, '\n', len) == NULL && (p + len == lf.data + lf.len || p[len] == '\n');
+        sum += len;
+    }
+    ok &= sum == total_len;
+    ok &= check_fgets(path, &ix);
+    EachCheck each = {&ix, 0, true};
+    lines_each(lf.data, lf.len, check_line, &each);
+    ok &= each.ok && each.i == ix.n;
+
+    lines_index_free(&ix);
+    lines_close(&lf);
+    if (argc < 2) remove(path);
+    puts(ok ? "all counts and lines agree" : "MISMATCH");
+    return !ok;
+}
@@ -4,7 +4,10 @@ int sub(int a,int b){return a-b;}
 int mul(int a,int b){return a*b;}
 int div_int(int a,int b){return b? a/b:0;}
 int mod(int a,int b){return b? a%b:0;}
+// Exponentiation by squaring: O(log exp) multiplies, wraps mod 2^32.
 int pow_int(int base,int exp){
     if(exp<0) return 0;
-    int r=1; while(exp--) r*=base; return r;
+    unsigned r=1, b=(unsigned)base;
+    while(exp){ if(exp&1) r*=b; b*=b; exp>>=1; }
+    return (int)r;
 }
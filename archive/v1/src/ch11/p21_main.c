@@ -0,0 +1,44 @@
+// gcc -std=c23 -O2 p21_main.c p21_power.c -o p21
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "p21_power.h"
+
+// The old pow_int loop, kept here only to time against.
+static long long ipow_linear(long long base,unsigned exp){
+    unsigned long long r=1;
+    while(exp--) r*=(unsigned long long)base;
+    return (long long)r;
+}
+
+#define N 100000
+
+int main(void){
+    long long v;
+    printf("3^40=%lld\n", ipow(3,40));
+    printf("3^40 checked: %s\n", ipow_checked(3,40,&v)? "ok" : "overflow");
+    if(ipow_checked(3,39,&v)) printf("3^39 checked: ok %lld\n", v);
+    printf("(-2)^63 checked: %s\n", ipow_checked(-2,63,&v)? "ok" : "overflow");
+    printf("2^(10^18) mod 1e9+7 = %llu\n", powmod(2,1000000000000000000ULL,1000000007ULL));
+
+    long long *base=malloc(N*sizeof *base), *out=malloc(N*sizeof *out);
+    unsigned *exp=malloc(N*sizeof *exp);
+    if(!base || !out || !exp){ puts("out of memory"); return 1; }
+    srand(1);
+    for(int i=0;i<N;i++){ base[i]=rand()%7-3; exp[i]=rand()%10000; }
+
+    clock_t t0=clock();
+    volatile long long sink=0;
+    for(int i=0;i<N;i++) sink+=ipow_linear(base[i],exp[i]);
+    clock_t t1=clock();
+    ipow_n(base,exp,out,N);
+    clock_t t2=clock();
+
+    long long s=0;
+    for(int i=0;i<N;i++) s+=out[i];
+    printf("linear %.2f ms, batch squaring %.2f ms, %s\n",
+        1000.0*(t1-t0)/CLOCKS_PER_SEC, 1000.0*(t2-t1)/CLOCKS_PER_SEC,
+        s==sink? "match" : "MISMATCH");
+    free(base); free(out); free(exp);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "p21_power.h"
+
+long long ipow(long long base,unsigned exp){
+    unsigned long long r=1, b=(unsigned long long)base;
+    while(exp){ if(exp&1) r*=b; b*=b; exp>>=1; }
+    return (long long)r;
+}
+
+bool ipow_checked(long long base,unsigned exp,long long *out){
+    // 0, 1 and -1 never overflow, whatever the exponent.
+    if(base==0 || base==1){ *out = exp? base : 1; return true; }
+    if(base==-1){ *out = (exp&1)? -1 : 1; return true; }
+    if(exp>=64) return false;                 // |base|>=2, so |result|>=2^64
+    long long r=1, b=base;
+    for(;;){
+        if((exp&1) && __builtin_mul_overflow(r,b,&r)) return false;
+        exp>>=1;
+        if(!exp) break;
+        if(__builtin_mul_overflow(b,b,&b)) return false;
+    }
+    *out=r;
+    return true;
+}
+
+static unsigned long long mulmod(unsigned long long a,unsigned long long b,unsigned long long m){
+#ifdef __SIZEOF_INT128__
+    return (unsigned long long)((unsigned __int128)a*b%m);
+#else
+    // Double-and-add keeps every intermediate below 2m.
+    unsigned long long r=0; a%=m;
+    while(b){
+        if(b&1) r = r>=m-a? r-(m-a) : r+a;
+        a = a>=m-a? a-(m-a) : a+a;
+        b>>=1;
+    }
+    return r;
+#endif
+}
+
+unsigned long long powmod(unsigned long long base,unsigned long long exp,unsigned long long m){
+    unsigned long long r=1%m, b=base%m;
+    while(exp){ if(exp&1) r=mulmod(r,b,m); b=mulmod(b,b,m); exp>>=1; }
+    return r;
+}
+
+// Blocks of 64 run in lockstep over the bits of the block's largest
+// exponent; the select keeps the inner loops branch-free so they vectorize.
+#define BLOCK 64
+
+void ipow_n(const long long *base,const unsigned *exp,long long *out,size_t n){
+    unsigned long long r[BLOCK], b[BLOCK];
+    for(size_t i=0;i<n;i+=BLOCK){
+        size_t m = n-i<BLOCK? n-i : BLOCK;
+        unsigned top=0;
+        for(size_t j=0;j<m;j++){ r[j]=1; b[j]=(unsigned long long)base[i+j]; top|=exp[i+j]; }
+        for(unsigned bit=0; bit<32 && (top>>bit); bit++){
+            for(size_t j=0;j<m;j++){
+                unsigned long long f = (exp[i+j]>>bit)&1? b[j] : 1;
+                r[j]*=f; b[j]*=b[j];
+            }
+        }
+        for(size_t j=0;j<m;j++) out[i+j]=(long long)r[j];
+    }
+}
+
+size_t ipow_checked_n(const long long *base,const unsigned *exp,long long *out,bool *ovf,size_t n){
+    size_t bad=0;
+    for(size_t i=0;i<n;i++){
+        bool ok=ipow_checked(base[i],exp[i],&out[i]);
+        if(!ok){ out[i]=0; bad++; }
+        if(ovf) ovf[i]=!ok;
+    }
+    return bad;
+}
+
+void powmod_n(const unsigned long long *base,const unsigned long long *exp,
+              unsigned long long m,unsigned long long *out,size_t n){
+    for(size_t i=0;i<n;i++) out[i]=powmod(base[i],exp[i],m);
+}
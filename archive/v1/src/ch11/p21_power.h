@@ -0,0 +1,22 @@
+#ifndef P21_POWER_H
+#define P21_POWER_H
+#include <stdbool.h>
+#include <stddef.h>
+
+// base^exp by squaring, wrapping mod 2^64 like unsigned arithmetic.
+long long ipow(long long base,unsigned exp);
+
+// base^exp into *out; returns false (and leaves *out alone) on overflow.
+bool ipow_checked(long long base,unsigned exp,long long *out);
+
+// base^exp mod m with 128-bit intermediates; m must be nonzero.
+unsigned long long powmod(unsigned long long base,unsigned long long exp,unsigned long long m);
+
+// Batch forms: out[i] = base[i]^exp[i].
+void ipow_n(const long long *base,const unsigned *exp,long long *out,size_t n);
+// ovf[i] (if ovf is not NULL) flags overflow, where out[i] is set to 0.
+// Returns how many elements overflowed.
+size_t ipow_checked_n(const long long *base,const unsigned *exp,long long *out,bool *ovf,size_t n);
+void powmod_n(const unsigned long long *base,const unsigned long long *exp,
+              unsigned long long m,unsigned long long *out,size_t n);
+#endif
@@ -0,0 +1,408 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "multimatch.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef unsigned long long u64;
+
+#define NONE UINT32_MAX
+
+// The automaton scans big texts as LANES regions of LANE_BYTES at once.
+#define LANES 4
+#define LANE_BYTES ((size_t)16 << 10)
+
+// The automaton: states are trie nodes with the root 0, and those that
+// report (a pattern ends there or at one of their suffixes) numbered last,
+// from out_min on. Bytes that occur in no pattern share class 0; the
+// others get classes 1.. in byte order. Row s of delta starts at
+// s << shift, and an entry holds the target's row offset.
+struct MultiMatch {
+    size_t n, maxlen;
+    const char **pat;             // pointers into bytes
+    size_t *len;
+    char *bytes;
+    bool filter;
+    unsigned char cls[256];
+    unsigned shift;
+    uint32_t out_min;
+    uint32_t *delta;
+    uint32_t *first;              // per state: a pattern ending here, or NONE
+    uint32_t *next;               // per pattern: the next one with the same bytes
+    uint32_t *dict;               // per state: longest proper suffix with first != NONE, 0 if none
+};
+
+// A report held back until the lanes before it have been tallied.
+typedef struct { uint32_t state, at; } Held;
+
+struct MmStream {
+    const MultiMatch *m;
+    u64 *counts, *next_ok, base;  // base: offset of the next chunk in the text
+    Held *held;
+    uint32_t state;
+    char *tail;                   // filter: last maxlen - 1 bytes before base
+    size_t tail_len;
+};
+
+static int use_avx2;
+
+#ifdef HAVE_X86
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar or sse2
+// keeps the automaton.
+__attribute__((constructor))
+static void pick_kernels(void) { use_avx2 = cpu_isa() >= ISA_AVX2; }
+#endif
+
+// ---- counting ---------------------------------------------------------------
+
+typedef struct {
+    u64 *counts;
+    u64 *next_ok;                 // MM_DISJOINT: first offset a match may start at
+    Held *held;                   // MM_DISJOINT: (LANES - 1) * LANE_BYTES of them
+    const size_t *len;
+    u64 total;
+} Tally;
+
+// A match of pattern id ending just before offset end. Per pattern, these
+// arrive in text order.
+static inline void tally(Tally *t, uint32_t id, u64 end) {
+    if (t->next_ok) {
+        if (end - t->len[id] < t->next_ok[id]) return;
+        t->next_ok[id] = end;
+    }
+    t->counts[id]++;
+    t->total++;
+}
+
+// Every pattern that ends at state u.
+static void report(const MultiMatch *m, uint32_t u, u64 end, Tally *t) {
+    if (m->first[u] == NONE) u = m->dict[u];
+    for (; u; u = m->dict[u])
+        for (uint32_t id = m->first[u]; id != NONE; id = m->next[id]) tally(t, id, end);
+}
+
+static uint32_t scan_one(const MultiMatch *m, const unsigned char *p, size_t len, uint32_t s,
+                         u64 base, Tally *t) {
+    const uint32_t *d = m->delta;
+    const uint32_t lim = m->out_min << m->shift;
+    for (size_t i = 0; i < len; i++) {
+        s = d[s + m->cls[p[i]]];
+        if (s >= lim) report(m, s >> m->shift, base + i + 1, t);
+    }
+    return s;
+}
+
+// The state after the maxlen - 1 bytes before p, starting from the root.
+static uint32_t warm_up(const MultiMatch *m, const unsigned char *p) {
+    uint32_t s = 0;
+    for (const unsigned char *w = p - (m->maxlen - 1); w < p; w++) s = m->delta[s + m->cls[*w]];
+    return s;
+}
+
+// A report from lane k >= 1, at offset i + 1 in its region.
+static inline void lane_report(const MultiMatch *m, int k, uint32_t u, size_t i, u64 base,
+                               uint32_t *held, Tally *t) {
+    if (t->held) t->held[(k - 1) * LANE_BYTES + held[k]++] = (Held){u, (uint32_t)i + 1};
+    else report(m, u, base + k * LANE_BYTES + i + 1, t);
+}
+
+// One block of LANES regions, each stepped by an automaton of its own so
+// that their table loads overlap instead of waiting on one another. Lane
+// 0 goes on from s; the others start at the root maxlen - 1 bytes before
+// their region, which is enough to see every match that ends in it, and
+// by the region's end to be in the same state as one that read the whole
+// text. In MM_DISJOINT, tally must see each pattern's matches in text
+// order, so lanes 1.. hold their reports until lane 0 is done. The lanes
+// are written out: kept in an array, their states go through memory.
+_Static_assert(LANES == 4, "scan_block steps four lanes");
+
+static uint32_t scan_block(const MultiMatch *m, const unsigned char *p, uint32_t s, u64 base,
+                           Tally *t) {
+    const uint32_t *d = m->delta;
+    const unsigned char *cls = m->cls;
+    const uint32_t lim = m->out_min << m->shift;
+    const unsigned char *p1 = p + LANE_BYTES, *p2 = p1 + LANE_BYTES, *p3 = p2 + LANE_BYTES;
+    uint32_t s1 = warm_up(m, p1), s2 = warm_up(m, p2), s3 = warm_up(m, p3);
+    uint32_t held[LANES] = {0};
+    for (size_t i = 0; i < LANE_BYTES; i++) {
+        s = d[s + cls[p[i]]];
+        s1 = d[s1 + cls[p1[i]]];
+        s2 = d[s2 + cls[p2[i]]];
+        s3 = d[s3 + cls[p3[i]]];
+        if ((s >= lim) | (s1 >= lim) | (s2 >= lim) | (s3 >= lim)) {
+            if (s >= lim) report(m, s >> m->shift, base + i + 1, t);
+            if (s1 >= lim) lane_report(m, 1, s1 >> m->shift, i, base, held, t);
+            if (s2 >= lim) lane_report(m, 2, s2 >> m->shift, i, base, held, t);
+            if (s3 >= lim) lane_report(m, 3, s3 >> m->shift, i, base, held, t);
+        }
+    }
+    for (int k = 1; k < LANES; k++)
+        for (uint32_t j = 0; j < held[k]; j++) {
+            const Held *h = &t->held[(k - 1) * LANE_BYTES + j];
+            report(m, h->state, base + k * LANE_BYTES + h->at, t);
+        }
+    return s3;
+}
+
+// Returns the state to continue from with the next chunk.
+static uint32_t scan_ac(const MultiMatch *m, const char *text, size_t len, uint32_t s,
+                        u64 base, Tally *t) {
+    const unsigned char *p = (const unsigned char *)text;
+    size_t i = 0;
+    if (m->maxlen <= LANE_BYTES)
+        for (; len - i >= LANES * LANE_BYTES; i += LANES * LANE_BYTES) s = scan_block(m, p + i, s, base + i, t);
+    return scan_one(m, p + i, len - i, s, base + i, t);
+}
+
+// Direct comparison at each start in [lo, hi), for matches that end
+// after min_end and within len.
+static void scan_naive(const MultiMatch *m, const char *p, size_t len, size_t lo, size_t hi,
+                       size_t min_end, u64 base, Tally *t) {
+    for (size_t i = lo; i < hi; i++)
+        for (uint32_t j = 0; j < m->n; j++) {
+            size_t l = m->len[j];
+            if (i + l <= len && i + l > min_end && p[i] == m->pat[j][0]
+                && memcmp(p + i, m->pat[j], l) == 0)
+                tally(t, j, base + i + l);
+        }
+}
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("avx2")
+// For each pattern, 32 starts at a time are candidates when the bytes
+// there equal its first two bytes and the byte len - 1 further on its
+// last; only those are compared in full. The last maxlen + 30 starts go
+// to scan_naive so no load runs past the text.
+static void scan_filter(const MultiMatch *m, const char *p, size_t len, u64 base, Tally *t) {
+    __m256i f[MM_FILTER_MAX], s[MM_FILTER_MAX], l[MM_FILTER_MAX];
+    for (size_t j = 0; j < m->n; j++) {
+        size_t n = m->len[j];
+        f[j] = _mm256_set1_epi8(m->pat[j][0]);
+        s[j] = _mm256_set1_epi8(m->pat[j][n > 1]);
+        l[j] = _mm256_set1_epi8(m->pat[j][n - 1]);
+    }
+    size_t i = 0;
+    for (; i + m->maxlen + 31 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)(p + i + 1));
+        for (uint32_t j = 0; j < m->n; j++) {
+            size_t n = m->len[j];
+            __m256i b = _mm256_loadu_si256((const __m256i *)(p + i + n - 1));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, f[j]), _mm256_cmpeq_epi8(b, l[j]));
+            if (n > 2) eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(a1, s[j]));
+            for (unsigned hit = (unsigned)_mm256_movemask_epi8(eq); hit; hit &= hit - 1) {
+                size_t k = i + (size_t)__builtin_ctz(hit);
+                if (n <= 3 || memcmp(p + k + 2, m->pat[j] + 2, n - 3) == 0) tally(t, j, base + k + n);
+            }
+        }
+    }
+    scan_naive(m, p, len, i, len, 0, base, t);
+}
+#pragma GCC pop_options
+#else
+static void scan_filter(const MultiMatch *m, const char *p, size_t len, u64 base, Tally *t) {
+    scan_naive(m, p, len, 0, len, 0, base, t);
+}
+#endif
+
+// ---- building -----------------------------------------------------------------
+
+// Trie edges first (0 = none), then failure links breadth first, filling
+// each missing edge from the failure state's row, which is already
+// complete because that state is shallower. Last the states are
+// renumbered so that the scan loop needs a single compare.
+static bool build_automaton(MultiMatch *m, size_t total) {
+    bool used[256] = {0};
+    for (size_t j = 0; j < m->n; j++)
+        for (size_t k = 0; k < m->len[j]; k++) used[(unsigned char)m->pat[j][k]] = true;
+    unsigned nc = 1;
+    for (int c = 0; c < 256; c++) m->cls[c] = used[c] ? (unsigned char)nc++ : 0;
+    while ((1u << m->shift) < nc) m->shift++;
+
+    size_t cap = total + 1;
+    if (cap > UINT32_MAX >> m->shift) return false;
+    uint32_t *d = calloc(cap << m->shift, sizeof *d);
+    uint32_t *fail = malloc(cap * sizeof *fail), *queue = malloc(cap * sizeof *queue);
+    m->delta = d;
+    m->first = malloc(cap * sizeof *m->first);
+    m->dict = calloc(cap, sizeof *m->dict);
+    m->next = malloc((m->n ? m->n : 1) * sizeof *m->next);
+    bool ok = d && fail && queue && m->first && m->dict && m->next;
+    if (!ok) goto done;
+
+    uint32_t states = 1;
+    memset(m->first, 0xff, cap * sizeof *m->first);
+    for (uint32_t j = 0; j < m->n; j++) {
+        uint32_t s = 0;
+        for (size_t k = 0; k < m->len[j]; k++) {
+            uint32_t *e = &d[((size_t)s << m->shift) + m->cls[(unsigned char)m->pat[j][k]]];
+            if (!*e) *e = states++;
+            s = *e;
+        }
+        m->next[j] = m->first[s];
+        m->first[s] = j;
+    }
+
+    size_t head = 0, tail = 0;
+    for (unsigned c = 0; c < nc; c++)
+        if (d[c]) { fail[d[c]] = 0; queue[tail++] = d[c]; }
+    while (head < tail) {
+        uint32_t u = queue[head++];
+        uint32_t *row = &d[(size_t)u << m->shift];
+        const uint32_t *frow = &d[(size_t)fail[u] << m->shift];
+        for (unsigned c = 0; c < nc; c++) {
+            if (!row[c]) { row[c] = frow[c]; continue; }
+            uint32_t v = row[c], f = frow[c];
+            fail[v] = f;
+            m->dict[v] = m->first[f] != NONE ? f : m->dict[f];
+            queue[tail++] = v;
+        }
+    }
+
+    uint32_t *perm = fail, k = 0;
+    for (int reports = 0; reports < 2; reports++) {
+        if (reports) m->out_min = k;
+        for (uint32_t u = 0; u < states; u++)
+            if ((m->first[u] != NONE || m->dict[u]) == reports) perm[u] = k++;
+    }
+    size_t row = (size_t)1 << m->shift;
+    uint32_t *nd = malloc(states * row * sizeof *nd);
+    if (!nd) { ok = false; goto done; }
+    for (uint32_t u = 0; u < states; u++)
+        for (size_t c = 0; c < row; c++) nd[perm[u] * row + c] = perm[d[u * row + c]] << m->shift;
+    for (uint32_t u = 0; u < states; u++) queue[perm[u]] = m->first[u];
+    memcpy(m->first, queue, states * sizeof *queue);
+    for (uint32_t u = 0; u < states; u++) queue[perm[u]] = perm[m->dict[u]];
+    memcpy(m->dict, queue, states * sizeof *queue);
+    free(d);
+    m->delta = nd;
+done:
+    free(fail);
+    free(queue);
+    return ok;
+}
+
+MultiMatch *mm_new(const char *const *pats, const size_t *lens, size_t n) {
+    if (n >= NONE) return NULL;
+    MultiMatch *m = calloc(1, sizeof *m);
+    if (!m) return NULL;
+    m->n = n;
+    m->pat = malloc(n * sizeof *m->pat);
+    m->len = malloc(n * sizeof *m->len);
+    size_t total = 0;
+    for (size_t j = 0; j < n; j++) {
+        size_t l = lens ? lens[j] : strlen(pats[j]);
+        if (!l || total + l < total) { mm_free(m); return NULL; }
+        if (m->len) m->len[j] = l;
+        total += l;
+        if (l > m->maxlen) m->maxlen = l;
+    }
+    m->bytes = malloc(total ? total : 1);
+    if (!m->pat || !m->len || !m->bytes) { mm_free(m); return NULL; }
+    for (size_t j = 0, at = 0; j < n; j++) {
+        memcpy(m->bytes + at, pats[j], m->len[j]);
+        m->pat[j] = m->bytes + at;
+        at += m->len[j];
+    }
+
+    m->filter = use_avx2 && n && n <= MM_FILTER_MAX;
+    if (!m->filter && !build_automaton(m, total)) { mm_free(m); return NULL; }
+    return m;
+}
+
+void mm_free(MultiMatch *m) {
+    if (!m) return;
+    free(m->pat);
+    free(m->len);
+    free(m->bytes);
+    free(m->delta);
+    free(m->first);
+    free(m->next);
+    free(m->dict);
+    free(m);
+}
+
+unsigned long long mm_count(const MultiMatch *m, const char *text, size_t len,
+                            MmMode mode, unsigned long long *counts) {
+    u64 *next_ok = NULL;
+    Held *held = NULL;
+    if (mode == MM_DISJOINT) {
+        next_ok = calloc(m->n ? m->n : 1, sizeof *next_ok);
+        if (!m->filter && len >= LANES * LANE_BYTES) held = malloc((LANES - 1) * LANE_BYTES * sizeof *held);
+        if (!next_ok || (!m->filter && len >= LANES * LANE_BYTES && !held)) {
+            free(next_ok);
+            free(held);
+            return 0;
+        }
+    }
+    memset(counts, 0, m->n * sizeof *counts);
+    Tally t = {counts, next_ok, held, m->len, 0};
+    if (m->filter) scan_filter(m, text, len, 0, &t);
+    else scan_ac(m, text, len, 0, 0, &t);
+    free(next_ok);
+    free(held);
+    return t.total;
+}
+
+// ---- streams ------------------------------------------------------------------
+
+MmStream *mm_stream_new(const MultiMatch *m, MmMode mode) {
+    MmStream *s = calloc(1, sizeof *s);
+    if (!s) return NULL;
+    s->m = m;
+    s->counts = calloc(m->n ? m->n : 1, sizeof *s->counts);
+    bool held = mode == MM_DISJOINT && !m->filter;
+    if (mode == MM_DISJOINT) s->next_ok = calloc(m->n ? m->n : 1, sizeof *s->next_ok);
+    if (held) s->held = malloc((LANES - 1) * LANE_BYTES * sizeof *s->held);
+    if (m->filter) s->tail = malloc(2 * m->maxlen);
+    if (!s->counts || (mode == MM_DISJOINT && !s->next_ok) || (held && !s->held) || (m->filter && !s->tail)) {
+        mm_stream_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void mm_stream_free(MmStream *s) {
+    if (!s) return;
+    free(s->counts);
+    free(s->next_ok);
+    free(s->held);
+    free(s->tail);
+    free(s);
+}
+
+// The automaton simply carries its state over. The filter looks back
+// instead: matches that start in the kept tail and end in this chunk are
+// found in tail + the chunk's first maxlen - 1 bytes, and come before
+// any match that lies wholly in the chunk.
+void mm_feed(MmStream *s, const char *chunk, size_t len) {
+    const MultiMatch *m = s->m;
+    Tally t = {s->counts, s->next_ok, s->held, m->len, 0};
+    if (!m->filter) {
+        s->state = scan_ac(m, chunk, len, s->state, s->base, &t);
+        s->base += len;
+        return;
+    }
+    size_t keep = m->maxlen - 1, h = len < keep ? len : keep, have = s->tail_len + h;
+    memcpy(s->tail + s->tail_len, chunk, h);
+    scan_naive(m, s->tail, have, 0, s->tail_len, s->tail_len, s->base - s->tail_len, &t);
+    scan_filter(m, chunk, len, s->base, &t);
+    if (len >= keep) {
+        memcpy(s->tail, chunk + len - keep, keep);
+        s->tail_len = keep;
+    } else {
+        size_t drop = have > keep ? have - keep : 0;
+        memmove(s->tail, s->tail + drop, have - drop);
+        s->tail_len = have - drop;
+    }
+    s->base += len;
+}
+
+const unsigned long long *mm_stream_counts(const MmStream *s) { return s->counts; }
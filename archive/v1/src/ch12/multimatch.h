@@ -0,0 +1,48 @@
+#ifndef MULTIMATCH_H
+#define MULTIMATCH_H
+
+#include <stddef.h>
+
+// Counting occurrences of many byte strings in one pass over a text, for
+// the places that called strstr once per pattern. Patterns are compiled
+// once and then shared read-only by any number of scans.
+//   up to MM_FILTER_MAX patterns  AVX2 filter: a position is checked only
+//                                 when its first and last bytes match
+//   more (or no AVX2)             Aho-Corasick automaton with a dense
+//                                 transition table over byte classes,
+//                                 stepping four parts of a big text at once
+// FORCE_ISA=scalar|sse2 keeps the automaton for every pattern set.
+#define MM_FILTER_MAX 8
+
+typedef enum {
+    MM_OVERLAP,        // every occurrence: "aa" is in "aaaa" 3 times
+    MM_DISJOINT        // left to right, each pattern restarting after its
+                       // previous match: "aa" is in "aaaa" 2 times
+} MmMode;
+
+typedef struct MultiMatch MultiMatch;
+
+// n patterns, lens[i] bytes each (NUL is an ordinary byte), or C strings
+// when lens is NULL. Duplicates are counted separately. NULL when a
+// pattern is empty or memory ran out.
+MultiMatch *mm_new(const char *const *pats, const size_t *lens, size_t n);
+void mm_free(MultiMatch *m);
+
+// Occurrences of pattern i in text go to counts[i] (n entries, overwritten).
+// Returns their sum; 0 with counts untouched if memory ran out (only
+// MM_DISJOINT allocates).
+unsigned long long mm_count(const MultiMatch *m, const char *text, size_t len,
+                            MmMode mode, unsigned long long *counts);
+
+// The same over a text fed in chunks: matches that span chunk boundaries
+// are found, and the counts after the last chunk equal mm_count on the
+// whole text. NULL if out of memory.
+typedef struct MmStream MmStream;
+
+MmStream *mm_stream_new(const MultiMatch *m, MmMode mode);
+void mm_stream_free(MmStream *s);
+void mm_feed(MmStream *s, const char *chunk, size_t len);
+// n entries, valid until mm_stream_free.
+const unsigned long long *mm_stream_counts(const MmStream *s);
+
+#endif
@@ -1,7 +1,14 @@
-#include <stdio.h>
+// gcc -std=c23 -O2 -I../ch10 p03.c ../ch10/fastout.c -o p03 -lm
+#include "fastout.h"
 int main(void){
-    puts(" n   n^2   n^3");
-    for(int i=1;i<=10;i++)
-        printf("%2d %5d %6d\n", i, i*i, i*i*i);
-    return 0;
+    static FastOut out;
+    fo_init(&out, 1);
+    fo_str(&out, " n   n^2   n^3\n", 0);
+    for(int i=1;i<=10;i++){
+        fo_i64(&out, i, 2);
+        fo_char(&out, ' '); fo_i64(&out, i*i, 5);
+        fo_char(&out, ' '); fo_i64(&out, i*i*i, 6);
+        fo_char(&out, '\n');
+    }
+    return fo_flush(&out) ? 0 : 1;
 }
@@ -1,13 +1,18 @@
 #include <stdio.h>
 #include <string.h>
-void safe_copy(char *dst, size_t n, const char *src){
-    if (n==0) return;
-    strncpy(dst, src, n-1);
-    dst[n-1] = '\0';
+// Copies what fits and returns strlen(src), so truncation shows (>= n);
+// unlike strncpy it reads and writes only the bytes it keeps.
+size_t safe_copy(char *dst, size_t n, const char *src){
+    size_t len = strlen(src);
+    if (n==0) return len;
+    size_t k = len < n-1 ? len : n-1;
+    memcpy(dst, src, k);
+    dst[k] = '\0';
+    return len;
 }
 int main(void){
     char buf[8];
-    safe_copy(buf,sizeof buf,"helloworld");
+    if (safe_copy(buf,sizeof buf,"helloworld") >= sizeof buf) fputs("safe_copy: truncated\n", stderr);
     printf("%s\n", buf);
     return 0;
 }
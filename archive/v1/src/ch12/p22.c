@@ -1,9 +1,13 @@
+// gcc -std=c23 -O2 -I../ch06 p22.c ../ch06/strbuf.c ../ch06/arena.c -o p22
 #include <stdio.h>
-#include <string.h>
+#include "strbuf.h"
 int main(void){
-    char buf[32] = "Hello";
-    strncat(buf, " ", sizeof buf - strlen(buf) - 1);
-    strncat(buf, "World", sizeof buf - strlen(buf) - 1);
-    puts(buf);
+    StrBuf buf;
+    sb_init(&buf);
+    sb_puts(&buf, "Hello");
+    sb_puts(&buf, " ");
+    sb_puts(&buf, "World");
+    puts(buf.p);
+    sb_free(&buf);
     return 0;
 }
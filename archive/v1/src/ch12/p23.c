@@ -1,10 +1,15 @@
+// gcc -std=c23 -O2 -I../ch05 p23.c multimatch.c ../ch05/cpu_dispatch.c -o p23
 #include <stdio.h>
 #include <string.h>
+#include "multimatch.h"
 int main(void){
     const char *text = "catapult scatter catalog";
     const char *sub  = "cat";
-    int cnt=0;
-    for (const char *p=text; (p=strstr(p,sub)); p++) cnt++;
-    printf("%d\n", cnt); // expected 3
+    MultiMatch *m = mm_new(&sub, NULL, 1);
+    if (!m) { perror("mm_new"); return 1; }
+    unsigned long long cnt;
+    mm_count(m, text, strlen(text), MM_OVERLAP, &cnt);
+    printf("%llu\n", cnt); // expected 3
+    mm_free(m);
     return 0;
 }
@@ -1,7 +1,11 @@
+// gcc -std=c23 -O2 -I../ch05 -I../ch06 p24.c ../ch06/tokenize.c ../ch05/cpu_dispatch.c -o p24
 #include <stdio.h>
 #include <string.h>
+#include "tokenize.h"
 int main(void){
-    char text[]="red,green,blue";
-    for (char *tok=strtok(text,","); tok; tok=strtok(NULL,",")) puts(tok);
+    const char text[]="red,green,blue";
+    TokDelims comma; tok_delims(&comma,",",1);
+    Tokenizer t; tok_init(&t,&comma,text,strlen(text));
+    for (Tok tok; tok_next(&t,&tok); ) printf("%.*s\n",(int)tok.len,tok.p);
     return 0;
 }
@@ -0,0 +1,197 @@
+// Accuracy and speed of vmath.c against glibc's libm.
+// gcc -std=c23 -O2 -I../ch05 p26.c vmath.c ../ch05/cpu_dispatch.c -o p26 -lm
+// Errors are in ULPs of the exact result, taken from glibc's long double
+// functions; FORCE_ISA=scalar|avx2 runs a lower kernel set.
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "vmath.h"
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define N (1 << 20)
+
+static double ms_since(clock_t t0){ return 1000.0 * (clock() - t0) / CLOCKS_PER_SEC; }
+
+static double uniform(double lo, double hi){ return lo + (hi - lo) * (rand() / (RAND_MAX + 1.0)); }
+static double log_uniform(double lo, double hi){ return exp(uniform(log(lo), log(hi))); }
+
+static double ulp_err(double v, long double ref){
+    if (isnan(v) && isnan(ref)) return 0;
+    if (v == ref) return 0;
+    if (!isfinite(ref) || !isfinite(v)) return INFINITY;
+    int e = ref == 0 ? -1074 : ilogbl(ref) - 52;
+    if (e < -1074) e = -1074;
+    return (double)(fabsl((long double)v - ref) / ldexpl(1.0L, e));
+}
+
+static double max_err(const double *v, const long double *ref){
+    double m = 0;
+    for (int i = 0; i < N; i++){ double e = ulp_err(v[i], ref[i]); if (e > m) m = e; }
+    return m;
+}
+
+typedef void (*unary)(const double*, double*, size_t);
+typedef void (*binary)(const double*, const double*, double*, size_t);
+
+static double *x, *y, *out;
+static long double *ref;
+
+static void report(const char *name, const char *range, double libm_ms, double libm_err,
+                   double v_ms, double v_err, double f_ms, double f_err){
+    printf("%-6s %-24s libm %5.1f ms %5.2f ulp | accurate %5.1f ms %5.2f ulp | fast %5.1f ms %7.1f ulp\n",
+           name, range, libm_ms, libm_err, v_ms, v_err, f_ms, f_err);
+}
+
+static void test_unary(const char *name, const char *range, double (*f)(double), long double (*fl)(long double),
+                       unary v, unary vf){
+    clock_t t0 = clock();
+    for (int i = 0; i < N; i++) out[i] = f(x[i]);
+    double libm_ms = ms_since(t0);
+    for (int i = 0; i < N; i++) ref[i] = fl(x[i]);
+    double libm_err = max_err(out, ref);
+    t0 = clock(); v(x, out, N); double v_ms = ms_since(t0);
+    double v_err = max_err(out, ref);
+    t0 = clock(); vf(x, out, N); double f_ms = ms_since(t0);
+    double f_err = max_err(out, ref);
+    report(name, range, libm_ms, libm_err, v_ms, v_err, f_ms, f_err);
+}
+
+static void test_binary(const char *name, const char *range, double (*f)(double, double),
+                        long double (*fl)(long double, long double), binary v, binary vf){
+    clock_t t0 = clock();
+    for (int i = 0; i < N; i++) out[i] = f(x[i], y[i]);
+    double libm_ms = ms_since(t0);
+    for (int i = 0; i < N; i++) ref[i] = fl(x[i], y[i]);
+    double libm_err = max_err(out, ref);
+    t0 = clock(); v(x, y, out, N); double v_ms = ms_since(t0);
+    double v_err = max_err(out, ref);
+    t0 = clock(); vf(x, y, out, N); double f_ms = ms_since(t0);
+    double f_err = max_err(out, ref);
+    report(name, range, libm_ms, libm_err, v_ms, v_err, f_ms, f_err);
+}
+
+// NaNs, infinities, zeros, negatives, subnormals and huge values, mixed
+// with ordinary lanes: wherever libm gives NaN or an infinity both tiers
+// must too, and finite results must stay finite.
+static const double special[] = {
+    NAN, -NAN, INFINITY, -INFINITY, 0.0, -0.0, -1.0, 1.0, 0x1p-1074, -0x1p-1074,
+    0x1p-1022, 1e300, -1e300, 0x1.fffffffffffffp1023, -0x1.fffffffffffffp1023, 1e19, -1e19,
+    710.0, -746.0, 0x1p62, -0x1p63,
+};
+#define NSPECIAL (sizeof special / sizeof *special)
+
+static bool same(double a, double b){ return isnan(a) == isnan(b) && (isfinite(b) ? isfinite(a) : a == b || isnan(b)); }
+
+static bool test_special(void){
+    double v[NSPECIAL], w[NSPECIAL];
+    bool ok = true;
+    struct { unary v, vf; double (*f)(double); } u[] = {
+        {vsin, vsin_fast, sin}, {vcos, vcos_fast, cos}, {vexp, vexp_fast, exp}, {vlog, vlog_fast, log},
+    };
+    for (size_t k = 0; k < sizeof u / sizeof *u; k++){
+        u[k].v(special, v, NSPECIAL);
+        u[k].vf(special, w, NSPECIAL);
+        for (size_t i = 0; i < NSPECIAL; i++){
+            double r = u[k].f(special[i]);
+            ok &= same(v[i], r) && same(w[i], r);
+        }
+    }
+    struct { binary v, vf; double (*f)(double, double); } b[] = {
+        {vpow, vpow_fast, pow}, {vhypot, vhypot_fast, hypot},
+    };
+    for (size_t k = 0; k < sizeof b / sizeof *b; k++)
+        for (size_t j = 0; j < NSPECIAL; j++){
+            double y2[NSPECIAL];
+            for (size_t i = 0; i < NSPECIAL; i++) y2[i] = special[(i + j) % NSPECIAL];
+            b[k].v(special, y2, v, NSPECIAL);
+            b[k].vf(special, y2, w, NSPECIAL);
+            for (size_t i = 0; i < NSPECIAL; i++){
+                double r = b[k].f(special[i], y2[i]);
+                ok &= same(v[i], r) && same(w[i], r);
+            }
+        }
+    printf("special values (NaN, inf, 0, negative, huge): %s\n", ok ? "all match libm" : "MISMATCH");
+    return ok;
+}
+
+// Same bits, or both NaN.
+static bool identical(double a, double b){ return a == b ? signbit(a) == signbit(b) : isnan(a) && isnan(b); }
+
+// out == x (and out == y) must give what separate arrays give, libm lanes included.
+static bool test_in_place(void){
+    static const double extra[] = {1e7, 1000, -1000, 0.5, 800, 0.0, 3.0};
+    enum { K = NSPECIAL + sizeof extra / sizeof *extra };
+    double in[K], v[K], w[K], c[K];
+    for (size_t i = 0; i < K; i++) in[i] = i < NSPECIAL ? special[i] : extra[i - NSPECIAL];
+    bool ok = true;
+    unary u[] = {vsin, vsin_fast, vcos, vcos_fast, vexp, vexp_fast, vlog, vlog_fast};
+    for (size_t k = 0; k < sizeof u / sizeof *u; k++){
+        u[k](in, v, K);
+        memcpy(w, in, sizeof w);
+        u[k](w, w, K);
+        for (size_t i = 0; i < K; i++) ok &= identical(w[i], v[i]);
+    }
+    vsincos(in, v, c, K);
+    memcpy(w, in, sizeof w);
+    double c2[K];
+    vsincos(w, w, c2, K);
+    for (size_t i = 0; i < K; i++) ok &= identical(w[i], v[i]) && identical(c2[i], c[i]);
+    binary b[] = {vpow, vpow_fast, vhypot, vhypot_fast};
+    for (size_t k = 0; k < sizeof b / sizeof *b; k++)
+        for (int side = 0; side < 2; side++){
+            double y2[K];
+            for (size_t i = 0; i < K; i++) y2[i] = in[(i + 3) % K];
+            b[k](in, y2, v, K);
+            memcpy(w, side ? y2 : in, sizeof w);
+            if (side) b[k](in, w, w, K); else b[k](w, y2, w, K);
+            for (size_t i = 0; i < K; i++) ok &= identical(w[i], v[i]);
+        }
+    printf("in place (out == x or y): %s\n", ok ? "match" : "MISMATCH");
+    return ok;
+}
+
+int main(void){
+    x = malloc(N * sizeof *x); y = malloc(N * sizeof *y);
+    out = malloc(N * sizeof *out); ref = malloc(N * sizeof *ref);
+    if (!x || !y || !out || !ref){ puts("out of memory"); return 1; }
+    srand(26);
+
+    for (int i = 0; i < N; i++) x[i] = uniform(-M_PI, M_PI);
+    test_unary("sin", "[-pi, pi]", sin, sinl, vsin, vsin_fast);
+    test_unary("cos", "[-pi, pi]", cos, cosl, vcos, vcos_fast);
+    for (int i = 0; i < N; i++) x[i] = uniform(-1e5, 1e5);
+    test_unary("sin", "[-1e5, 1e5]", sin, sinl, vsin, vsin_fast);
+    test_unary("cos", "[-1e5, 1e5]", cos, cosl, vcos, vcos_fast);
+
+    for (int i = 0; i < N; i++) x[i] = uniform(-1, 1);
+    test_unary("exp", "[-1, 1]", exp, expl, vexp, vexp_fast);
+    for (int i = 0; i < N; i++) x[i] = uniform(-708, 708);
+    test_unary("exp", "[-708, 708]", exp, expl, vexp, vexp_fast);
+
+    for (int i = 0; i < N; i++) x[i] = uniform(0.9, 1.1);
+    test_unary("log", "[0.9, 1.1]", log, logl, vlog, vlog_fast);
+    for (int i = 0; i < N; i++) x[i] = log_uniform(1e-300, 1e300);
+    test_unary("log", "[1e-300, 1e300]", log, logl, vlog, vlog_fast);
+
+    for (int i = 0; i < N; i++){ x[i] = log_uniform(1e-3, 1e3); y[i] = uniform(-50, 50); }
+    test_binary("pow", "x [1e-3, 1e3], |y| < 50", pow, powl, vpow, vpow_fast);
+    for (int i = 0; i < N; i++){ x[i] = uniform(0.99, 1.01); y[i] = uniform(-7e4, 7e4); }
+    test_binary("pow", "x ~ 1, |y| < 7e4", pow, powl, vpow, vpow_fast);
+    for (int i = 0; i < N; i++){ x[i] = uniform(1, 2); y[i] = rand() % 60; }
+    test_binary("pow", "(1 + r)^n as in p10", pow, powl, vpow, vpow_fast);
+
+    for (int i = 0; i < N; i++){ x[i] = uniform(-1e3, 1e3); y[i] = uniform(-1e3, 1e3); }
+    test_binary("hypot", "[-1e3, 1e3]^2", hypot, hypotl, vhypot, vhypot_fast);
+    for (int i = 0; i < N; i++){ x[i] = log_uniform(1e-300, 1e300); y[i] = log_uniform(1e-300, 1e300); }
+    test_binary("hypot", "[1e-300, 1e300]^2", hypot, hypotl, vhypot, vhypot_fast);
+
+    free(x); free(y); free(out); free(ref);
+    bool ok = test_special();
+    ok &= test_in_place();
+    return !ok;
+}
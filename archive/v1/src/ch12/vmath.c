@@ -0,0 +1,308 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vmath.h"
+#include "cpu_dispatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// The error-free sums and products below only work if the compiler does
+// not fuse a*b + c into one rounding, which -march=native would allow.
+#pragma GCC optimize("fp-contract=off")
+
+// ---- constants --------------------------------------------------------------
+
+#define SHIFT      0x1.8p52                 // x + SHIFT rounds x to an integer
+#define SHIFT_BITS 0x4338000000000000ULL
+#define SPLIT      134217729.0              // 2^27 + 1, for Dekker's split
+
+// pi/2 in 33-bit pieces, and 2/pi (fdlibm).
+#define INVPIO2 6.36619772367581382433e-01
+#define PIO2_1  1.57079632673412561417e+00
+#define PIO2_1T 6.07710050650619224932e-11
+#define PIO2_2  6.07710050630396597660e-11
+#define PIO2_2T 2.02226624879595063154e-21
+#define TRIG_MAX 0x1p19
+
+// fdlibm's minimax coefficients for sin and cos on [-pi/4, pi/4].
+#define S1 -1.66666666666666324348e-01
+#define S2  8.33333333332248946124e-03
+#define S3 -1.98412698298579493134e-04
+#define S4  2.75573137070700676789e-06
+#define S5 -2.50507602534068634195e-08
+#define S6  1.58969099521155010221e-10
+#define C1  4.16666666666666019037e-02
+#define C2 -1.38888888888741095749e-03
+#define C3  2.48015872894767294178e-05
+#define C4 -2.75573143513906633035e-07
+#define C5  2.08757232129817482790e-09
+#define C6 -1.13596475577881948265e-11
+
+// ln 2 with 21 trailing zero bits in the high part, so k*LN2HI is exact.
+#define INVLN2  1.44269504088896338700e+00
+#define LN2HI   6.93147180369123816490e-01
+#define LN2LO   1.90821492927058770002e-10
+#define EXP_MAX 708.0
+
+// 1/k! for the exp polynomial.
+#define E3  (1.0 / 6)
+#define E4  (1.0 / 24)
+#define E5  (1.0 / 120)
+#define E6  (1.0 / 720)
+#define E7  (1.0 / 5040)
+#define E8  (1.0 / 40320)
+#define E9  (1.0 / 362880)
+#define E10 (1.0 / 3628800)
+#define E11 (1.0 / 39916800)
+#define E12 (1.0 / 479001600)
+#define E13 (1.0 / 6227020800)
+
+// (-1)^(k+1)/k for log(1 + r).
+#define L3 ( 1.0 / 3)
+#define L4 (-1.0 / 4)
+#define L5 ( 1.0 / 5)
+#define L6 (-1.0 / 6)
+#define L7 ( 1.0 / 7)
+#define L8 (-1.0 / 8)
+#define L9 ( 1.0 / 9)
+
+#define POW_YMAX       0x1p900
+#define HYPOT_FAST_MIN 0x1p-968
+
+// 1/c rounded to 9 bits and -log(1/c) as hi + lo, for the 128 intervals
+// of z starting at LOG_OFF (see log_split). The interval holding 1 uses
+// c = 1 so that log is exact-ish near 1. Generated with Python's decimal.
+#define LOG_OFF 0x3fe6955500000000ULL
+typedef struct { double invc, logc_hi, logc_lo; } LogEntry;
+static const LogEntry log_tab[128] = {
+    {0x1.6ap+0, -0x1.62c82f2b9c795p-2, -0x1.7b7af915300e5p-57},
+    {0x1.68p+0, -0x1.5d1bdbf5809cap-2, -0x1.4236383dc7fe1p-56},
+    {0x1.66p+0, -0x1.5767717455a6cp-2, -0x1.526adb283660cp-56},
+    {0x1.64p+0, -0x1.51aad872df82dp-2, -0x1.3927ac19f55e3p-59},
+    {0x1.62p+0, -0x1.4be5f957778a1p-2, 0x1.259b35b04813dp-57},
+    {0x1.6p+0, -0x1.4618bc21c5ec2p-2, -0x1.f42decdeccf1dp-56},
+    {0x1.5ep+0, -0x1.404308686a7e4p-2, 0x1.0bcfb6082ce6dp-56},
+    {0x1.5cp+0, -0x1.3a64c556945eap-2, 0x1.c68651945f97cp-57},
+    {0x1.5ap+0, -0x1.347dd9a987d55p-2, 0x1.4dd4c580919f8p-57},
+    {0x1.59p+0, -0x1.31871c9544185p-2, 0x1.51acc4c09b379p-60},
+    {0x1.57p+0, -0x1.2b9303ab89d25p-2, 0x1.896b5fd852ad4p-56},
+    {0x1.55p+0, -0x1.2596010df763ap-2, 0x1.0f76c57075e9ep-58},
+    {0x1.53p+0, -0x1.1f8ff9e48a2f3p-2, 0x1.c9fdf9a0c4b07p-56},
+    {0x1.52p+0, -0x1.1c898c16999fbp-2, 0x1.0e5c62aff1c44p-60},
+    {0x1.5p+0, -0x1.1675cababa60ep-2, -0x1.ce63eab883717p-61},
+    {0x1.4ep+0, -0x1.1058bf9ae4ad5p-2, -0x1.89fa0ab4cb31dp-58},
+    {0x1.4cp+0, -0x1.0a324e27390e3p-2, -0x1.7dcfde8061c03p-56},
+    {0x1.4bp+0, -0x1.071b85fcd590dp-2, -0x1.d1707f97bde8p-58},
+    {0x1.49p+0, -0x1.00e6c45ad501dp-2, 0x1.cb9568ff6feadp-57},
+    {0x1.47p+0, -0x1.f550a564b7b37p-3, -0x1.c5f6dfd018c37p-61},
+    {0x1.46p+0, -0x1.ef0adcbdc5936p-3, -0x1.48637950dc20dp-57},
+    {0x1.44p+0, -0x1.e27076e2af2e6p-3, 0x1.61578001e0162p-59},
+    {0x1.43p+0, -0x1.dc1bca0abec7dp-3, -0x1.834c51998b6fcp-57},
+    {0x1.41p+0, -0x1.cf6354e09c5dcp-3, -0x1.239a07d55b695p-57},
+    {0x1.3fp+0, -0x1.c2968558c18c1p-3, 0x1.73dee38a3fb6bp-57},
+    {0x1.3ep+0, -0x1.bc286742d8cd6p-3, -0x1.4fce744870f55p-58},
+    {0x1.3cp+0, -0x1.af3c94e80bff3p-3, 0x1.398cff3641985p-58},
+    {0x1.3bp+0, -0x1.a8becfc882f19p-3, 0x1.e8c37918c39ebp-58},
+    {0x1.39p+0, -0x1.9bb362e7dfb83p-3, -0x1.575e31f003e0cp-57},
+    {0x1.38p+0, -0x1.9525a9cf456b4p-3, -0x1.d904c1d4e2e26p-57},
+    {0x1.36p+0, -0x1.87fa06520c911p-3, 0x1.bf7fdbfa08d9ap-57},
+    {0x1.35p+0, -0x1.815c0a14357ebp-3, 0x1.4be48073a0564p-58},
+    {0x1.33p+0, -0x1.740f8f54037a5p-3, 0x1.b264062a84cdbp-58},
+    {0x1.32p+0, -0x1.6d60fe719d21dp-3, 0x1.caae268ecd179p-57},
+    {0x1.31p+0, -0x1.66acd4272ad51p-3, 0x1.0900e4e1ea8b2p-58},
+    {0x1.2fp+0, -0x1.59338d9982086p-3, 0x1.65d22aa8ad7cfp-58},
+    {0x1.2ep+0, -0x1.526e5e3a1b438p-3, 0x1.746ff8a470d3ap-57},
+    {0x1.2cp+0, -0x1.44d2b6ccb7d1ep-3, -0x1.9f4f6543e1f88p-57},
+    {0x1.2bp+0, -0x1.3dfc2b0ecc62ap-3, 0x1.ab3a8e7d81017p-58},
+    {0x1.2ap+0, -0x1.371fc201e8f74p-3, -0x1.de6cb62af18ap-58},
+    {0x1.28p+0, -0x1.29552f81ff523p-3, -0x1.301771c407dbfp-57},
+    {0x1.27p+0, -0x1.2266f190a5acbp-3, -0x1.f547bf1809e88p-57},
+    {0x1.26p+0, -0x1.1b72ad52f67ap-3, -0x1.483023472cd74p-58},
+    {0x1.24p+0, -0x1.0d77e7cd08e59p-3, -0x1.9a5dc5e9030acp-57},
+    {0x1.23p+0, -0x1.0671512ca596ep-3, -0x1.50c647eb86499p-58},
+    {0x1.22p+0, -0x1.fec9131dbeabbp-4, 0x1.5746b9981b36cp-58},
+    {0x1.2p+0, -0x1.e27076e2af2e6p-4, 0x1.61578001e0162p-60},
+    {0x1.1fp+0, -0x1.d4313d66cb35dp-4, -0x1.790dd951d90fap-58},
+    {0x1.1ep+0, -0x1.c5e548f5bc743p-4, -0x1.5d617ef8161b1p-60},
+    {0x1.1dp+0, -0x1.b78c82bb0eda1p-4, -0x1.0878cf0327e21p-61},
+    {0x1.1cp+0, -0x1.a926d3a4ad563p-4, -0x1.942f48aa70ea9p-58},
+    {0x1.1ap+0, -0x1.8c345d6319b21p-4, 0x1.4a697ab3424a9p-61},
+    {0x1.19p+0, -0x1.7da766d7b12cdp-4, 0x1.eeedfcdd94131p-58},
+    {0x1.18p+0, -0x1.6f0d28ae56b4cp-4, 0x1.906d99184b992p-58},
+    {0x1.17p+0, -0x1.60658a93750c4p-4, 0x1.388458ec21b6ap-58},
+    {0x1.15p+0, -0x1.42edcbea646fp-4, -0x1.ddd4f935996c9p-59},
+    {0x1.14p+0, -0x1.341d7961bd1d1p-4, 0x1.b599f227becbbp-58},
+    {0x1.13p+0, -0x1.253f62f0a1417p-4, 0x1.c125963fc4cfdp-62},
+    {0x1.12p+0, -0x1.16536eea37ae1p-4, 0x1.79da3e8c22cdap-60},
+    {0x1.11p+0, -0x1.075983598e471p-4, -0x1.80da5333c45b8p-59},
+    {0x1.1p+0, -0x1.f0a30c01162a6p-5, -0x1.85f325c5bbacdp-59},
+    {0x1.0fp+0, -0x1.d276b8adb0b52p-5, -0x1.1e3c53257fd47p-61},
+    {0x1.0ep+0, -0x1.b42dd711971bfp-5, 0x1.eb9759c130499p-60},
+    {0x1.0cp+0, -0x1.77458f632dcfcp-5, -0x1.18d3ca87b9296p-59},
+    {0x1.0bp+0, -0x1.58a5bafc8e4d5p-5, 0x1.ce55c2b4e2b72p-59},
+    {0x1.0ap+0, -0x1.39e87b9febd6p-5, 0x1.5bfa937f551bbp-59},
+    {0x1.09p+0, -0x1.1b0d98923d98p-5, 0x1.e9ae889bac481p-60},
+    {0x1.08p+0, -0x1.f829b0e7833p-6, -0x1.33e3f04f1ef23p-60},
+    {0x1.07p+0, -0x1.b9fc027af9198p-6, 0x1.0ae69229dc868p-64},
+    {0x1.06p+0, -0x1.7b91b07d5b11bp-6, 0x1.5b602ace3a51p-60},
+    {0x1.05p+0, -0x1.3cea44346a575p-6, 0x1.0cb5a902b3a1cp-62},
+    {0x1.04p+0, -0x1.fc0a8b0fc03e4p-7, 0x1.83092c59642a1p-62},
+    {0x1.03p+0, -0x1.7dc475f810a77p-7, 0x1.16d7687d3df21p-62},
+    {0x1.02p+0, -0x1.fe02a6b106789p-8, 0x1.e44b7e3711ebfp-67},
+    {0x1.01p+0, -0x1.ff00aa2b10bcp-9, -0x1.2821ad5a6d353p-63},
+    {0x1p+0, 0.0, 0.0},
+    {0x1.fbp-1, 0x1.41929f96832fp-7, -0x1.c5517f64bc223p-61},
+    {0x1.f7p-1, 0x1.228fb1fea2e28p-6, -0x1.cd7b66e01c26dp-61},
+    {0x1.f4p-1, 0x1.8492528c8cabfp-6, -0x1.d192d0619fa67p-60},
+    {0x1.fp-1, 0x1.0415d89e74444p-5, 0x1.c05cf1d753622p-59},
+    {0x1.ecp-1, 0x1.466aed42de3eap-5, -0x1.cdd6f7f4a137ep-59},
+    {0x1.e8p-1, 0x1.894aa149fb343p-5, 0x1.a8be97660a23dp-60},
+    {0x1.e5p-1, 0x1.bbcebfc68f42p-5, 0x1.e5cf3a0f56f72p-60},
+    {0x1.e1p-1, 0x1.ffa6911ab9301p-5, -0x1.cd9f1f95c2eedp-59},
+    {0x1.dep-1, 0x1.1973bd1465567p-4, -0x1.7558367a6acf6p-59},
+    {0x1.dap-1, 0x1.3bdf5a7d1ee64p-4, 0x1.7a976d3b5b45fp-59},
+    {0x1.d7p-1, 0x1.55e10050e0384p-4, -0x1.45f9d61c68c1bp-58},
+    {0x1.d4p-1, 0x1.700d30aeac0e1p-4, -0x1.72566212cdd05p-61},
+    {0x1.dp-1, 0x1.9335e5d594989p-4, -0x1.478a85704ccb7p-58},
+    {0x1.cdp-1, 0x1.adc77ee5aea8cp-4, 0x1.37d8f39bee659p-58},
+    {0x1.cap-1, 0x1.c885801bc4b23p-4, 0x1.a38cb559a6706p-58},
+    {0x1.c7p-1, 0x1.e3707ee30487bp-4, 0x1.09ccecd579d99p-58},
+    {0x1.c3p-1, 0x1.03cdc0a51ec0dp-3, 0x1.39e2d3f8b7d1p-57},
+    {0x1.cp-1, 0x1.1178e8227e47cp-3, -0x1.0e63a5f01c691p-58},
+    {0x1.bdp-1, 0x1.1f3b925f25d41p-3, 0x1.62c9ef939ac5dp-59},
+    {0x1.bap-1, 0x1.2d1610c86813ap-3, -0x1.499a3f25af95fp-58},
+    {0x1.b7p-1, 0x1.3b08b6757f2a9p-3, 0x1.70d6cdf05266cp-60},
+    {0x1.b4p-1, 0x1.4913d8333b561p-3, -0x1.0d5604930f135p-58},
+    {0x1.b2p-1, 0x1.527e5e4a1b58dp-3, -0x1.71a9682395bfdp-61},
+    {0x1.afp-1, 0x1.60b3100b09476p-3, -0x1.5b2623e05016bp-58},
+    {0x1.acp-1, 0x1.6f0128b756abcp-3, -0x1.8de59c21e166cp-57},
+    {0x1.a9p-1, 0x1.7d6903caf5adp-3, -0x1.ac5f0c075b847p-59},
+    {0x1.a6p-1, 0x1.8beafeb38fe8cp-3, 0x1.55aa8b6997a4p-58},
+    {0x1.a4p-1, 0x1.95a5adcf7017fp-3, 0x1.142c507fb7a3dp-58},
+    {0x1.a1p-1, 0x1.a454082e6ab05p-3, 0x1.df207dc5c34c6p-58},
+    {0x1.9ep-1, 0x1.b31d8575bce3dp-3, -0x1.6353ab386a94dp-57},
+    {0x1.9cp-1, 0x1.bd087383bd8adp-3, 0x1.dd355f6a516d7p-60},
+    {0x1.99p-1, 0x1.cc000c9db3c52p-3, 0x1.53d154280394fp-57},
+    {0x1.97p-1, 0x1.d60a17f903515p-3, -0x1.c0df841a71b7ap-57},
+    {0x1.94p-1, 0x1.e530effe71012p-3, 0x1.2276041f43042p-59},
+    {0x1.92p-1, 0x1.ef5ade4dcffe6p-3, -0x1.08ab2ddc708ap-58},
+    {0x1.8fp-1, 0x1.feb2233ea07cdp-3, 0x1.8de00938b4c4p-61},
+    {0x1.8dp-1, 0x1.047e60cde83b8p-2, -0x1.0779634061cbcp-56},
+    {0x1.8ap-1, 0x1.0c42d676162e3p-2, 0x1.162c79d5d11eep-58},
+    {0x1.88p-1, 0x1.1178e8227e47cp-2, -0x1.0e63a5f01c691p-57},
+    {0x1.86p-1, 0x1.16b5ccbacfb73p-2, 0x1.66fbd28b40935p-56},
+    {0x1.83p-1, 0x1.1e9e1678899f4p-2, 0x1.512c3749a1e4ep-56},
+    {0x1.81p-1, 0x1.23ec5991eba49p-2, 0x1.bb75d1addf87p-60},
+    {0x1.7fp-1, 0x1.2941afb186b7cp-2, -0x1.856e61c51574p-57},
+    {0x1.7dp-1, 0x1.2e9e2bce12286p-2, 0x1.8251a3b83d97ap-62},
+    {0x1.7ap-1, 0x1.36b6776be1117p-2, -0x1.324f0e883858ep-58},
+    {0x1.78p-1, 0x1.3c25277333184p-2, -0x1.2ad27e50a8ec6p-56},
+    {0x1.76p-1, 0x1.419b423d5e8c7p-2, 0x1.0dbb243827392p-57},
+    {0x1.74p-1, 0x1.4718dc271c41bp-2, 0x1.8fb4c14c56eefp-60},
+    {0x1.72p-1, 0x1.4c9e09e172c3cp-2, -0x1.123615b147a5dp-58},
+    {0x1.7p-1, 0x1.522ae0738a3d8p-2, -0x1.8f7e9b38a6979p-57},
+    {0x1.6ep-1, 0x1.57bf753c8d1fbp-2, -0x1.0908d15f88b63p-57},
+    {0x1.6cp-1, 0x1.5d5bddf595f3p-2, -0x1.6541148cbb8a2p-56},
+};
+
+// ---- kernels ----------------------------------------------------------------
+
+// The baseline build has two lanes: SSE2 on x86-64, plain code elsewhere.
+#define VM_ISA base
+#define VM_W   2
+#ifdef HAVE_X86
+#define VM_SQRT(v) _mm_sqrt_pd(v)
+#else
+static inline double __attribute__((vector_size(16))) sqrt2_base(double __attribute__((vector_size(16))) v) {
+    v[0] = sqrt(v[0]); v[1] = sqrt(v[1]);
+    return v;
+}
+#define VM_SQRT(v) sqrt2_base(v)
+#endif
+#include "vmath_kernels.h"
+#undef VM_ISA
+#undef VM_W
+#undef VM_SQRT
+
+#ifdef HAVE_X86
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define VM_ISA avx2
+#define VM_W   4
+#define VM_SQRT(v) _mm256_sqrt_pd(v)
+#include "vmath_kernels.h"
+#undef VM_ISA
+#undef VM_W
+#undef VM_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define VM_ISA avx512
+#define VM_W   8
+#define VM_SQRT(v) _mm512_sqrt_pd(v)
+#include "vmath_kernels.h"
+#undef VM_ISA
+#undef VM_W
+#undef VM_SQRT
+#pragma GCC pop_options
+#endif
+
+// ---- kernel choice ----------------------------------------------------------
+
+typedef struct {
+    void (*sincos)(const double*, double*, double*, size_t);
+    void (*sincos_fast)(const double*, double*, double*, size_t);
+    void (*exp)(const double*, double*, size_t);
+    void (*exp_fast)(const double*, double*, size_t);
+    void (*log)(const double*, double*, size_t);
+    void (*log_fast)(const double*, double*, size_t);
+    void (*pow)(const double*, const double*, double*, size_t);
+    void (*pow_fast)(const double*, const double*, double*, size_t);
+    void (*hypot)(const double*, const double*, double*, size_t);
+    void (*hypot_fast)(const double*, const double*, double*, size_t);
+} vmath_kernels;
+
+#define KERNEL_TABLE(isa) { \
+    sincos_n_##isa, sincos_fast_n_##isa, exp_n_##isa, exp_fast_n_##isa, \
+    log_n_##isa, log_fast_n_##isa, pow_n_##isa, pow_fast_n_##isa, \
+    hypot_n_##isa, hypot_fast_n_##isa }
+
+static const vmath_kernels base_table = KERNEL_TABLE(base);
+static const vmath_kernels *k = &base_table;
+
+#ifdef HAVE_X86
+static const vmath_kernels avx2_table = KERNEL_TABLE(avx2);
+static const vmath_kernels avx512_table = KERNEL_TABLE(avx512);
+
+// Chosen once at load time by cpu_isa(), so FORCE_ISA=scalar|sse2|avx2
+// caps the choice.
+__attribute__((constructor))
+static void pick_kernels(void) {
+    isa_level isa = cpu_isa();
+    if (isa >= ISA_AVX512) k = &avx512_table;
+    else if (isa >= ISA_AVX2) k = &avx2_table;
+}
+#endif
+
+// ---- public entry points ----------------------------------------------------
+
+void vsin(const double *x, double *out, size_t n) { k->sincos(x, out, NULL, n); }
+void vcos(const double *x, double *out, size_t n) { k->sincos(x, NULL, out, n); }
+void vsincos(const double *x, double *s, double *c, size_t n) { k->sincos(x, s, c, n); }
+void vexp(const double *x, double *out, size_t n) { k->exp(x, out, n); }
+void vlog(const double *x, double *out, size_t n) { k->log(x, out, n); }
+void vpow(const double *x, const double *y, double *out, size_t n) { k->pow(x, y, out, n); }
+void vhypot(const double *x, const double *y, double *out, size_t n) { k->hypot(x, y, out, n); }
+
+void vsin_fast(const double *x, double *out, size_t n) { k->sincos_fast(x, out, NULL, n); }
+void vcos_fast(const double *x, double *out, size_t n) { k->sincos_fast(x, NULL, out, n); }
+void vsincos_fast(const double *x, double *s, double *c, size_t n) { k->sincos_fast(x, s, c, n); }
+void vexp_fast(const double *x, double *out, size_t n) { k->exp_fast(x, out, n); }
+void vlog_fast(const double *x, double *out, size_t n) { k->log_fast(x, out, n); }
+void vpow_fast(const double *x, const double *y, double *out, size_t n) { k->pow_fast(x, y, out, n); }
+void vhypot_fast(const double *x, const double *y, double *out, size_t n) { k->hypot_fast(x, y, out, n); }
@@ -0,0 +1,42 @@
+#ifndef VMATH_H
+#define VMATH_H
+
+#include <stddef.h>
+
+// Array versions of the libm calls in p06-p10: out[i] = f(x[i]) for i < n.
+// Out-of-range, special and non-finite lanes are passed to libm itself, so
+// those follow C's rules exactly. Every CPU gives the same results. out
+// (or s, or c) may be the same array as x or y.
+//
+// Largest error against the exact result, in units in the last place,
+// as measured by p26 over its sampled ranges (glibc itself: about 0.5):
+//   vsin, vcos, vsincos   0.8 ULP   |x| < 2^19, libm beyond
+//   vexp                  0.8 ULP   |x| <= 708, libm beyond
+//   vlog                  0.5 ULP
+//   vpow                  1 ULP     x > 0 and |y*ln x| <= 708, libm otherwise
+//   vhypot                0.5 ULP
+void vsin(const double *x, double *out, size_t n);
+void vcos(const double *x, double *out, size_t n);
+void vsincos(const double *x, double *s, double *c, size_t n);
+void vexp(const double *x, double *out, size_t n);
+void vlog(const double *x, double *out, size_t n);
+void vpow(const double *x, const double *y, double *out, size_t n);
+void vhypot(const double *x, const double *y, double *out, size_t n);
+
+// Fast tier for hot loops that can spare a few ULPs: no extra-precision
+// steps. Same domains and special cases as above.
+//   vsin_fast, vcos_fast, vsincos_fast    3.5 ULP
+//   vexp_fast                             2.5 ULP
+//   vlog_fast                             2 ULP
+//   vpow_fast                             2 ULP plus about 2*|y*ln x| ULP
+//   vhypot_fast                           1.5 ULP; libm whenever x*x + y*y
+//                                         would overflow or lose precision
+void vsin_fast(const double *x, double *out, size_t n);
+void vcos_fast(const double *x, double *out, size_t n);
+void vsincos_fast(const double *x, double *s, double *c, size_t n);
+void vexp_fast(const double *x, double *out, size_t n);
+void vlog_fast(const double *x, double *out, size_t n);
+void vpow_fast(const double *x, const double *y, double *out, size_t n);
+void vhypot_fast(const double *x, const double *y, double *out, size_t n);
+
+#endif
@@ -0,0 +1,318 @@
+// Kernel bodies for vmath.c, which includes this file once per ISA with
+// VM_ISA (name suffix), VM_W (doubles per vector) and VM_SQRT defined.
+// Everything is written with GCC vector extensions, so each inclusion
+// compiles the same arithmetic for its own target and every ISA returns
+// bit-identical results.
+
+#define VM_CAT2(a, b) a##_##b
+#define VM_CAT(a, b) VM_CAT2(a, b)
+#define F(name) VM_CAT(name, VM_ISA)
+
+typedef double F(vd) __attribute__((vector_size(VM_W * 8)));
+typedef long long F(vi) __attribute__((vector_size(VM_W * 8)));
+typedef unsigned long long F(vu) __attribute__((vector_size(VM_W * 8)));
+#define VD F(vd)
+#define VI F(vi)
+#define VU F(vu)
+
+// ---- helpers ----------------------------------------------------------------
+
+// A partial vector at the end of an array is padded with `pad`.
+static inline VD F(load)(const double *p, size_t m, double pad) {
+    VD v;
+    if (m == VM_W) { memcpy(&v, p, sizeof v); return v; }
+    for (size_t j = 0; j < VM_W; j++) v[j] = j < m ? p[j] : pad;
+    return v;
+}
+static inline void F(store)(double *p, VD v, size_t m) {
+    if (m == VM_W) memcpy(p, &v, sizeof v);
+    else for (size_t j = 0; j < m; j++) p[j] = v[j];
+}
+
+static inline VD F(sel)(VI m, VD a, VD b) { return (VD)((m & (VI)a) | (~m & (VI)b)); }
+static inline VI F(isel)(VI m, VI a, VI b) { return (m & a) | (~m & b); }
+static inline VD F(vabs)(VD x) { return (VD)((VI)x & 0x7fffffffffffffffLL); }
+static inline VD F(from_bits)(VI b) { return (VD)b; }
+// 2^n for -1022 <= n <= 1023. Other n (from NaN, inf and huge lanes that
+// are recomputed anyway) give some other double rather than overflow, as
+// all bit arithmetic here is done unsigned.
+static inline VD F(pow2)(VI n) { return (VD)(((VU)n + 1023) << 52); }
+// The sign bit set where bit 1 of n is.
+static inline VI F(bit1_sign)(VI n) { return (VI)(((VU)n & 2) << 62); }
+
+// Round to the nearest integer for |x| < 2^51; *n gets it as an integer.
+static inline VD F(round_n)(VD x, VI *n) {
+    VD t = x + SHIFT;
+    *n = (VI)((VU)t - SHIFT_BITS);
+    return t - SHIFT;
+}
+
+// Exact sums and products: s + e == a + b and p + e == a * b.
+static inline VD F(two_sum)(VD a, VD b, VD *e) {
+    VD s = a + b, bb = s - a;
+    *e = (a - (s - bb)) + (b - bb);
+    return s;
+}
+static inline void F(split)(VD a, VD *hi, VD *lo) {
+    VD c = SPLIT * a;
+    *hi = c - (c - a);
+    *lo = a - *hi;
+}
+static inline VD F(two_prod)(VD a, VD b, VD *e) {
+    VD p = a * b, ah, al, bh, bl;
+    F(split)(a, &ah, &al);
+    F(split)(b, &bh, &bl);
+    *e = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+    return p;
+}
+
+// ---- sin / cos --------------------------------------------------------------
+
+// x = n*pi/2 + (y0 + y1), |y0| <= pi/4. PIO2_1 and PIO2_2 have 33 bits,
+// so for |x| < 2^19 both products are exact and the only rounding is in
+// the tiny n*PIO2_2T term.
+static inline VI F(rem_pio2)(VD x, VD *y0, VD *y1) {
+    VI n;
+    VD fn = F(round_n)(x * INVPIO2, &n);
+    VD e, hi = F(two_sum)(x - fn * PIO2_1, -(fn * PIO2_2), &e);
+    VD tail = e - fn * PIO2_2T;
+    *y0 = hi + tail;
+    *y1 = (hi - *y0) + tail;
+    return n;
+}
+
+// fdlibm's __kernel_sin and __kernel_cos on [-pi/4, pi/4] with tail y.
+static inline VD F(ksin)(VD x, VD y) {
+    VD z = x * x, w = z * z, v = z * x;
+    VD r = S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6);
+    return x - ((z * (0.5 * y - v * r) - y) - v * S1);
+}
+static inline VD F(kcos)(VD x, VD y) {
+    VD z = x * x, w = z * z;
+    VD r = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+    VD hz = 0.5 * z;
+    w = 1.0 - hz;
+    return w + (((1.0 - w) - hz) + (z * r - x * y));
+}
+
+// Quadrant n: sin is (s, c, -s, -c)[n & 3] and cos is (c, -s, -c, s)[n & 3].
+static inline void F(sincos_v)(VD x, VD *s, VD *c, VI *sp) {
+    VD y0, y1;
+    VI n = F(rem_pio2)(x, &y0, &y1);
+    VD ks = F(ksin)(y0, y1), kc = F(kcos)(y0, y1);
+    VI odd = -(n & 1);
+    *s = (VD)((VI)F(sel)(odd, kc, ks) ^ F(bit1_sign)(n));
+    *c = (VD)((VI)F(sel)(odd, ks, kc) ^ F(bit1_sign)((VI)((VU)n + 1)));
+    *sp = ~(F(vabs)(x) <= TRIG_MAX);
+}
+
+// Fast tier: the reduced argument is rounded to one double, dropping the
+// tail terms from the same kernels.
+static inline void F(sincos_fast_v)(VD x, VD *s, VD *c, VI *sp) {
+    VI n;
+    VD fn = F(round_n)(x * INVPIO2, &n);
+    VD r = (x - fn * PIO2_1) - fn * PIO2_1T, z = r * r, w = z * z;
+    VD ks = r + z * r * (S1 + z * (S2 + z * (S3 + z * S4) + z * w * (S5 + z * S6)));
+    VD kc = (1.0 - 0.5 * z) + z * (z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6)));
+    VI odd = -(n & 1);
+    *s = (VD)((VI)F(sel)(odd, kc, ks) ^ F(bit1_sign)(n));
+    *c = (VD)((VI)F(sel)(odd, ks, kc) ^ F(bit1_sign)((VI)((VU)n + 1)));
+    *sp = ~(F(vabs)(x) <= TRIG_MAX);
+}
+
+// ---- exp --------------------------------------------------------------------
+
+// exp(xh + xl) for |xh| <= EXP_MAX: x = n*ln2 + r, |r| <= ln2/2, then a
+// degree-13 Taylor polynomial (truncation below 2^-57) summed so that the
+// leading 1 + r is exact.
+static inline VD F(exp_dd)(VD xh, VD xl) {
+    VI n;
+    VD fn = F(round_n)(xh * INVLN2, &n);
+    VD r = ((xh - fn * LN2HI) - fn * LN2LO) + xl;
+    VD p = E12 + r * E13;
+    p = E11 + r * p; p = E10 + r * p; p = E9 + r * p;
+    p = E8 + r * p;  p = E7 + r * p;  p = E6 + r * p;  p = E5 + r * p;
+    p = E4 + r * p;  p = E3 + r * p;  p = 0.5 + r * p;
+    VD hi = 1.0 + r, lo = (1.0 - hi) + r;
+    return (hi + (lo + r * r * p)) * F(pow2)(n);
+}
+
+static inline VD F(exp_v)(VD x, VI *sp) {
+    *sp = ~(F(vabs)(x) <= EXP_MAX);
+    return F(exp_dd)(x, (VD){0});
+}
+
+// Fast tier: a degree-12 polynomial in plain Horner form.
+static inline VD F(exp_fast_v)(VD x, VI *sp) {
+    VI n;
+    VD fn = F(round_n)(x * INVLN2, &n);
+    VD r = (x - fn * LN2HI) - fn * LN2LO;
+    VD p = E11 + r * E12;
+    p = E10 + r * p; p = E9 + r * p; p = E8 + r * p; p = E7 + r * p; p = E6 + r * p;
+    p = E5 + r * p;  p = E4 + r * p; p = E3 + r * p; p = 0.5 + r * p;
+    p = 1.0 + r * p; p = 1.0 + r * p;
+    *sp = ~(F(vabs)(x) <= EXP_MAX);
+    return p * F(pow2)(n);
+}
+
+// ---- log --------------------------------------------------------------------
+
+// x = 2^k * z with z in [OFF, 2*OFF), about [0.706, 1.41]; the top 7 bits
+// of z pick a table entry with 1/c and log(c), leaving log(1 + r) with
+// r = z/c - 1, |r| < 2^-7.5. Needs x normal and positive.
+static inline VI F(log_split)(VD x, VD *z, VD *invc, VD *logc_hi, VD *logc_lo) {
+    VU ix = (VU)x, tmp = ix - LOG_OFF;
+    VI k = (VI)tmp >> 52;
+    *z = (VD)(ix - (tmp & (0xfffULL << 52)));
+    for (int j = 0; j < VM_W; j++) {
+        const LogEntry *e = &log_tab[(tmp[j] >> 45) & 127];
+        (*invc)[j] = e->invc; (*logc_hi)[j] = e->logc_hi; (*logc_lo)[j] = e->logc_lo;
+    }
+    return k;
+}
+
+// log(x) as hi + lo with about 2^-66 relative error, for pow. 1/c has 9
+// significant bits, so splitting z into 44 high bits and the rest makes
+// both parts of z/c - 1 exact.
+static inline VD F(log_dd)(VD x, VD *lo) {
+    VD z, invc, lch, lcl;
+    VD kd = __builtin_convertvector(F(log_split)(x, &z, &invc, &lch, &lcl), VD);
+    VD zh = (VD)((VI)z & ~0x1ffLL), zl = z - zh;
+    VD rh = zh * invc - 1.0, rl = zl * invc;
+    VD rt, r = F(two_sum)(rh, rl, &rt);
+
+    // log(1 + r) = r - r^2/2 + r^3 * q(r); -r^2/2 is carried as two parts.
+    VD sq_lo, sq = F(two_prod)(r, r, &sq_lo);
+    VD h2 = -0.5 * sq, h2_lo = -0.5 * sq_lo - r * rt;
+    VD q = L8 + r * L9;
+    q = L7 + r * q; q = L6 + r * q; q = L5 + r * q; q = L4 + r * q; q = L3 + r * q;
+
+    VD e0, e1, e2;
+    VD hi = F(two_sum)(kd * LN2HI, lch, &e0);           // k*LN2HI itself is exact
+    hi = F(two_sum)(hi, r, &e1);
+    hi = F(two_sum)(hi, h2, &e2);
+    VD l = kd * LN2LO + lcl + rt + e0 + e1 + e2 + h2_lo + r * sq * q;
+    VD res = hi + l;
+    *lo = (hi - res) + l;
+    return res;
+}
+
+static inline VD F(log_v)(VD x, VI *sp) {
+    VD lo;
+    *sp = ~((x >= DBL_MIN) & (x <= DBL_MAX));
+    return F(log_dd)(x, &lo) + lo;
+}
+
+static inline VD F(log_fast_v)(VD x, VI *sp) {
+    VD z, invc, lch, lcl;
+    VD kd = __builtin_convertvector(F(log_split)(x, &z, &invc, &lch, &lcl), VD);
+    VD zh = (VD)((VI)z & ~0x1ffLL);
+    VD r = (zh * invc - 1.0) + (z - zh) * invc;         // one rounding, as in log_dd
+    VD q = L7 + r * L8;
+    q = L6 + r * q; q = L5 + r * q; q = L4 + r * q; q = L3 + r * q; q = -0.5 + r * q;
+    *sp = ~((x >= DBL_MIN) & (x <= DBL_MAX));
+    return (kd * LN2HI + lch) + (r + (kd * LN2LO + r * r * q));
+}
+
+// ---- pow / hypot ------------------------------------------------------------
+
+// Positive normal x and moderate y only; signs, zeros, infinities, NaNs
+// and results near overflow or underflow go to libm pow.
+static inline VD F(pow_v)(VD x, VD y, VI *sp) {
+    VD llo, lhi = F(log_dd)(x, &llo);
+    VD zl, zh = F(two_prod)(y, lhi, &zl);
+    zl += y * llo;
+    *sp = ~((x >= DBL_MIN) & (x <= DBL_MAX) & (F(vabs)(y) <= POW_YMAX) & (F(vabs)(zh) <= EXP_MAX));
+    return F(exp_dd)(zh, zl);
+}
+
+static inline VD F(pow_fast_v)(VD x, VD y, VI *sp) {
+    VI s1, s2;
+    VD r = F(exp_fast_v)(y * F(log_fast_v)(x, &s1), &s2);
+    *sp = s1 | s2;
+    return r;
+}
+
+// Scale so the larger magnitude lies in [2, 4), take the square root of
+// the sum of squares and correct it with one Newton step using the exact
+// squares. Both scale factors are normal powers of two.
+static inline VD F(hypot_v)(VD x, VD y, VI *sp) {
+    VD ax = F(vabs)(x), ay = F(vabs)(y);
+    VI swap = ax < ay;
+    VD big = F(sel)(swap, ay, ax), small = F(sel)(swap, ax, ay);
+    VI e = (VI)big >> 52;
+    e = F(isel)(e < 2, (VI){} + 2, F(isel)(e > 2046, (VI){} + 2046, e));
+    VD scale = F(from_bits)((2047 - e) << 52);
+    small = F(sel)(((VI)small >> 52) < e - 480, (VD){}, small);  // too small to matter, and
+    ax = big * scale; ay = small * scale;                          // its square would be subnormal
+    VD s = ax * ax + ay * ay;
+    VD h = VM_SQRT(s);
+    VD e1, e2, e3;
+    VD p1 = F(two_prod)(ax, ax, &e1), p2 = F(two_prod)(ay, ay, &e2), p3 = F(two_prod)(h, h, &e3);
+    VD d = ((p1 - p3) + p2) + ((e1 + e2) - e3);         // p1 >= p2: both differences exact
+    h += d / (2.0 * h);
+    *sp = ~((ax <= 4.0) & (ay <= 4.0) & (s > 0.0));    // inf/NaN in, or both zero
+    return h * F(from_bits)((e - 1) << 52);
+}
+
+static inline VD F(hypot_fast_v)(VD x, VD y, VI *sp) {
+    VD s = x * x + y * y;
+    *sp = ~((s >= HYPOT_FAST_MIN) & (s <= DBL_MAX));
+    return VM_SQRT(s);
+}
+
+// ---- array drivers ----------------------------------------------------------
+
+// Lanes flagged in sp are recomputed with the libm function `ref`. They
+// are patched into the result before it is stored, so out may be x.
+#define VM_UNARY(name, kernel, ref, pad) \
+static void F(name)(const double *x, double *out, size_t n) { \
+    for (size_t i = 0; i < n; i += VM_W) { \
+        size_t m = n - i < VM_W ? n - i : VM_W; \
+        VI sp; \
+        VD r = F(kernel)(F(load)(x + i, m, pad), &sp); \
+        for (size_t j = 0; j < m; j++) if (sp[j]) r[j] = ref(x[i + j]); \
+        F(store)(out + i, r, m); \
+    } \
+}
+#define VM_BINARY(name, kernel, ref) \
+static void F(name)(const double *x, const double *y, double *out, size_t n) { \
+    for (size_t i = 0; i < n; i += VM_W) { \
+        size_t m = n - i < VM_W ? n - i : VM_W; \
+        VI sp; \
+        VD r = F(kernel)(F(load)(x + i, m, 1.0), F(load)(y + i, m, 1.0), &sp); \
+        for (size_t j = 0; j < m; j++) if (sp[j]) r[j] = ref(x[i + j], y[i + j]); \
+        F(store)(out + i, r, m); \
+    } \
+}
+#define VM_SINCOS(name, kernel) \
+static void F(name)(const double *x, double *s, double *c, size_t n) { \
+    for (size_t i = 0; i < n; i += VM_W) { \
+        size_t m = n - i < VM_W ? n - i : VM_W; \
+        VI sp; VD vs, vc; \
+        F(kernel)(F(load)(x + i, m, 0.0), &vs, &vc, &sp); \
+        for (size_t j = 0; j < m; j++) \
+            if (sp[j]) { vs[j] = sin(x[i + j]); vc[j] = cos(x[i + j]); } \
+        if (s) F(store)(s + i, vs, m); \
+        if (c) F(store)(c + i, vc, m); \
+    } \
+}
+
+VM_SINCOS(sincos_n, sincos_v)
+VM_SINCOS(sincos_fast_n, sincos_fast_v)
+VM_UNARY(exp_n, exp_v, exp, 0.0)
+VM_UNARY(exp_fast_n, exp_fast_v, exp, 0.0)
+VM_UNARY(log_n, log_v, log, 1.0)
+VM_UNARY(log_fast_n, log_fast_v, log, 1.0)
+VM_BINARY(pow_n, pow_v, pow)
+VM_BINARY(pow_fast_n, pow_fast_v, pow)
+VM_BINARY(hypot_n, hypot_v, hypot)
+VM_BINARY(hypot_fast_n, hypot_fast_v, hypot)
+
+#undef VM_UNARY
+#undef VM_BINARY
+#undef VM_SINCOS
+#undef VD
+#undef VI
+#undef VU
+#undef F